@@ -0,0 +1,1034 @@
+#pragma once
+
+/*
+ * gplat_coro.h — higplat C++20 协程客户端（单头文件）
+ *
+ * 在单线程 epoll 事件循环上实现非阻塞的 higplat 连接，
+ * readb / writeb / subscribe 都以协程方式 co_await，
+ * 一个线程即可同时承载成千上万个逻辑任务，不再需要
+ * “每个连接一个线程 + 200ms 超时轮询”的写法。
+ *
+ * 用法：
+ *   gplat::EventLoop loop;
+ *   gplat::AsyncConnection conn(loop);
+ *
+ *   loop.spawn([&]() -> gplat::Task<> {
+ *       if (!co_await conn.connect("127.0.0.1", 8777)) co_return;
+ *       auto r = co_await gplat::readb_async<int>(conn, "WATCHDOG");
+ *       if (r) printf("%d\n", r.value);
+ *
+ *       auto sub = conn.subscribe("WATCHDOG");
+ *       while (auto ev = co_await sub.next())
+ *           printf("%s -> %d\n", ev->tagname.c_str(), ev->as<int>());
+ *   }());
+ *   loop.run();
+ *
+ * 说明：
+ *   - C++20 没有 `for co_await`（那是 Coroutines TS 的语法），
+ *     订阅流用 `while (auto ev = co_await sub.next())` 代替。
+ *   - EventLoop、AsyncConnection 只能在运行 run() 的线程中使用，
+ *     stop() 是唯一可以跨线程调用的接口。
+ *   - 同一连接上的请求按发送顺序应答，POST 推送按标签名分发给订阅流。
+ */
+
+#if __cplusplus < 202002L
+#error "gplat_coro.h 需要 C++20（请为目标设置 CXX_STANDARD 20）"
+#endif
+
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <map>
+#include <optional>
+#include <queue>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "gplat_wire.h"
+#include "logging.h"
+
+namespace gplat {
+
+// ============================================================
+//  Task<T>：惰性启动的协程任务，co_await 时才开始执行
+// ============================================================
+template <typename T = void>
+class Task;
+
+namespace coro_detail {
+
+struct FinalAwaiter
+{
+    bool await_ready() noexcept { return false; }
+
+    template <typename P>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept
+    {
+        auto cont = h.promise().continuation;
+        return cont ? cont : std::noop_coroutine();
+    }
+
+    void await_resume() noexcept {}
+};
+
+struct PromiseBase
+{
+    std::coroutine_handle<> continuation;
+    std::exception_ptr      exception;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter        final_suspend() noexcept { return {}; }
+    void                unhandled_exception() { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase
+{
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+    void    return_value(T v) { value.emplace(std::move(v)); }
+
+    T result()
+    {
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase
+{
+    Task<void> get_return_object();
+    void       return_void() {}
+
+    void result()
+    {
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+};
+
+} // namespace coro_detail
+
+template <typename T>
+class Task
+{
+public:
+    using promise_type = coro_detail::Promise<T>;
+    using handle_type  = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    explicit Task(handle_type h) : h_(h) {}
+    Task(Task &&other) noexcept : h_(std::exchange(other.h_, {})) {}
+    Task &operator=(Task &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (h_)
+            {
+                h_.destroy();
+            }
+            h_ = std::exchange(other.h_, {});
+        }
+        return *this;
+    }
+    Task(const Task &)            = delete;
+    Task &operator=(const Task &) = delete;
+    ~Task()
+    {
+        if (h_)
+        {
+            h_.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return !h_ || h_.done(); }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept
+    {
+        h_.promise().continuation = caller;
+        return h_;
+    }
+
+    T await_resume() { return h_.promise().result(); }
+
+private:
+    handle_type h_;
+};
+
+namespace coro_detail {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object()
+{
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object()
+{
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+// spawn() 使用的“发射后不管”协程，结束时自行销毁
+struct Detached
+{
+    struct promise_type
+    {
+        Detached            get_return_object() { return {}; }
+        std::suspend_never  initial_suspend() noexcept { return {}; }
+        std::suspend_never  final_suspend() noexcept { return {}; }
+        void                return_void() {}
+        void                unhandled_exception() { std::terminate(); }
+    };
+};
+
+} // namespace coro_detail
+
+// ============================================================
+//  EventLoop：单线程 epoll 事件循环 + 定时器 + 就绪队列
+// ============================================================
+
+// 注册到事件循环的 fd 处理者
+class IoHandler
+{
+public:
+    virtual ~IoHandler() = default;
+    virtual void onEvents(uint32_t events) = 0;
+    virtual void onStop() {}
+};
+
+class EventLoop
+{
+public:
+    EventLoop()
+    {
+        epfd_   = ::epoll_create1(EPOLL_CLOEXEC);
+        wakefd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event ev{};
+        ev.events   = EPOLLIN;
+        ev.data.ptr = nullptr; // nullptr 代表唤醒 fd
+        ::epoll_ctl(epfd_, EPOLL_CTL_ADD, wakefd_, &ev);
+    }
+
+    ~EventLoop()
+    {
+        ::close(wakefd_);
+        ::close(epfd_);
+    }
+
+    EventLoop(const EventLoop &)            = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    // 启动一个顶层任务，任务在下一轮循环开始执行，结束后自动回收
+    void spawn(Task<void> task)
+    {
+        ++live_tasks_;
+        runDetached(std::move(task));
+    }
+
+    // 运行直到所有顶层任务结束
+    void run()
+    {
+        while (live_tasks_ > 0)
+        {
+            if (stop_requested_.exchange(false))
+            {
+                shutdown();
+            }
+            drainReady();
+            if (live_tasks_ == 0)
+            {
+                break;
+            }
+            pollOnce(nextTimeoutMs());
+            fireTimers();
+        }
+    }
+
+    // 请求停止（可跨线程调用）：关闭所有连接、立即唤醒所有定时等待，
+    // 各任务在收到错误后自行退出，run() 随之返回
+    void stop()
+    {
+        stop_requested_ = true;
+        uint64_t one    = 1;
+        ssize_t n       = ::write(wakefd_, &one, sizeof(one));
+        (void)n;
+    }
+
+    bool stopping() const { return stopping_; }
+
+    // co_await loop.sleep_for(200ms);
+    auto sleep_for(std::chrono::milliseconds d)
+    {
+        struct Awaiter
+        {
+            EventLoop                *loop;
+            std::chrono::milliseconds d;
+            bool await_ready() const noexcept { return d.count() <= 0 || loop->stopping_; }
+            void await_suspend(std::coroutine_handle<> h) { loop->addTimer(Clock::now() + d, h); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{this, d};
+    }
+
+    // co_await loop.yield(); 让出执行权，排到就绪队列尾部
+    auto yield()
+    {
+        struct Awaiter
+        {
+            EventLoop *loop;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) { loop->post(h); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{this};
+    }
+
+    // ---------- 供连接等组件使用 ----------
+    void post(std::coroutine_handle<> h) { ready_.push_back(h); }
+
+    bool watch(int fd, uint32_t events, IoHandler *handler)
+    {
+        epoll_event ev{};
+        ev.events   = events;
+        ev.data.ptr = handler;
+        if (::epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) != 0)
+        {
+            return false;
+        }
+        handlers_.insert(handler);
+        return true;
+    }
+
+    void modify(int fd, uint32_t events, IoHandler *handler)
+    {
+        epoll_event ev{};
+        ev.events   = events;
+        ev.data.ptr = handler;
+        ::epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &ev);
+    }
+
+    void unwatch(int fd, IoHandler *handler)
+    {
+        ::epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, nullptr);
+        handlers_.erase(handler);
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Timer
+    {
+        Clock::time_point       deadline;
+        uint64_t                seq;
+        std::coroutine_handle<> h;
+        bool operator>(const Timer &o) const
+        {
+            return deadline != o.deadline ? deadline > o.deadline : seq > o.seq;
+        }
+    };
+
+    coro_detail::Detached runDetached(Task<void> task)
+    {
+        co_await yield();
+        try
+        {
+            co_await task;
+        }
+        catch (const std::exception &e)
+        {
+            logTaskFailure(e.what());
+        }
+        catch (...)
+        {
+            // 分离的协程没有等待者，任何异常都不能再向外抛
+            logTaskFailure("未知异常");
+        }
+        --live_tasks_;
+    }
+
+    // 通过 logging.h 的全局 logger 输出；logger 未初始化时不输出
+    static void logTaskFailure(const char *what)
+    {
+        auto &logger = getLogger();
+        if (logger)
+        {
+            logger->error("[gplat] 协程任务异常退出: {}", what);
+        }
+    }
+
+    void addTimer(Clock::time_point deadline, std::coroutine_handle<> h)
+    {
+        timers_.push(Timer{deadline, timer_seq_++, h});
+    }
+
+    void drainReady()
+    {
+        // 恢复过程中可能继续投递，逐个取出直到为空
+        while (!ready_.empty())
+        {
+            auto h = ready_.front();
+            ready_.pop_front();
+            h.resume();
+        }
+    }
+
+    int nextTimeoutMs() const
+    {
+        if (!ready_.empty())
+        {
+            return 0;
+        }
+        if (timers_.empty())
+        {
+            return -1;
+        }
+        auto wait = std::chrono::ceil<std::chrono::milliseconds>(timers_.top().deadline - Clock::now());
+        return wait.count() < 0 ? 0 : static_cast<int>(wait.count());
+    }
+
+    void pollOnce(int timeout_ms)
+    {
+        epoll_event events[64];
+        int n = ::epoll_wait(epfd_, events, 64, timeout_ms);
+        for (int i = 0; i < n; ++i)
+        {
+            auto *handler = static_cast<IoHandler *>(events[i].data.ptr);
+            if (handler == nullptr)
+            {
+                uint64_t v;
+                while (::read(wakefd_, &v, sizeof(v)) > 0)
+                {
+                }
+                continue;
+            }
+            // 同一批事件中，前面的回调可能已经注销了后面的处理者
+            if (handlers_.count(handler) != 0)
+            {
+                handler->onEvents(events[i].events);
+            }
+        }
+    }
+
+    void fireTimers()
+    {
+        auto now = Clock::now();
+        while (!timers_.empty() && (stopping_ || timers_.top().deadline <= now))
+        {
+            ready_.push_back(timers_.top().h);
+            timers_.pop();
+        }
+    }
+
+    void shutdown()
+    {
+        stopping_ = true;
+        // onStop() 可能注销自身，先复制一份
+        std::vector<IoHandler *> handlers(handlers_.begin(), handlers_.end());
+        for (auto *handler : handlers)
+        {
+            if (handlers_.count(handler) != 0)
+            {
+                handler->onStop();
+            }
+        }
+        fireTimers();
+    }
+
+    int  epfd_   = -1;
+    int  wakefd_ = -1;
+    long live_tasks_ = 0;
+    bool stopping_   = false;
+    std::atomic<bool> stop_requested_{false};
+
+    std::deque<std::coroutine_handle<>> ready_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    uint64_t timer_seq_ = 0;
+    std::unordered_set<IoHandler *> handlers_;
+};
+
+// ============================================================
+//  结果类型：与 C 接口一致，用 error 码表示失败原因
+// ============================================================
+struct Status
+{
+    unsigned int error = 0;
+    explicit operator bool() const { return error == 0; }
+};
+
+template <typename T>
+struct ReadResult : Status
+{
+    T        value{};
+    timespec timestamp{};
+};
+
+// 订阅推送事件
+struct PostEvent
+{
+    std::string       tagname;
+    std::vector<char> value;
+    timespec          timestamp{};
+
+    // 延迟统计用的时间戳，含义同 gplat_post.h 中的 PostView
+    bool              stamped = false;
+    timespec          writetime{};
+    timespec          dispatchtime{};
+    timespec          recvtime{};
+
+    // 以 SUBOPT_SEQ / SUBOPT_SNAPSHOT 订阅时有效，含义同 PostView
+    unsigned long long seq      = 0;
+    bool               snapshot = false;
+
+    template <typename T>
+    T as() const
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "T 必须可平凡拷贝");
+        T v{};
+        std::memcpy(&v, value.data(), value.size() < sizeof(T) ? value.size() : sizeof(T));
+        return v;
+    }
+};
+
+class AsyncConnection;
+
+// ============================================================
+//  Subscription：订阅流，co_await next() 逐个取出推送事件
+// ============================================================
+class Subscription
+{
+public:
+    Subscription(Subscription &&other) noexcept;
+    Subscription &operator=(Subscription &&) = delete;
+    Subscription(const Subscription &)       = delete;
+    ~Subscription();
+
+    // 取下一个事件；连接断开或订阅失败时返回 std::nullopt
+    auto next();
+
+    const std::string &tagname() const { return tagname_; }
+    unsigned int       error() const { return error_; }
+
+private:
+    friend class AsyncConnection;
+
+    Subscription(AsyncConnection *conn, std::string tagname, int options)
+        : conn_(conn), tagname_(std::move(tagname)), options_(options)
+    {
+    }
+
+    void push(PostEvent ev);
+    void close(unsigned int error);
+
+    AsyncConnection          *conn_;
+    std::string               tagname_;
+    int                       options_   = 0;
+    bool                      requested_ = false;
+    bool                      closed_    = false;
+    unsigned int              error_     = 0;
+    std::deque<PostEvent>     events_;
+    std::coroutine_handle<>   waiter_;
+};
+
+// ============================================================
+//  AsyncConnection：一个非阻塞 higplat 连接
+// ============================================================
+class AsyncConnection : public IoHandler
+{
+public:
+    // 一次请求的应答。body 由调用方提供缓冲时直接拷入，否则存入 body
+    struct Reply
+    {
+        MSGHEAD           head{};
+        std::vector<char> body;
+    };
+
+    explicit AsyncConnection(EventLoop &loop) : loop_(loop) {}
+    ~AsyncConnection() override { closeSocket(ERROR_SOCKET_NOT_CONNECTED); }
+
+    AsyncConnection(const AsyncConnection &)            = delete;
+    AsyncConnection &operator=(const AsyncConnection &) = delete;
+
+    bool connected() const { return fd_ >= 0 && !connecting_; }
+
+    Task<Status> connect(std::string server, int port)
+    {
+        Status st;
+        if (fd_ >= 0)
+        {
+            co_return st;
+        }
+        fd_ = wire::connectTcp(server.c_str(), port, true);
+        if (fd_ < 0)
+        {
+            st.error = ERROR_SOCKET_NOT_CONNECTED;
+            co_return st;
+        }
+        connecting_ = true;
+        loop_.watch(fd_, EPOLLIN | EPOLLOUT | EPOLLRDHUP, this);
+
+        struct ConnectAwaiter
+        {
+            AsyncConnection *conn;
+            bool await_ready() const noexcept { return !conn->connecting_; }
+            void await_suspend(std::coroutine_handle<> h) { conn->connect_waiter_ = h; }
+            void await_resume() const noexcept {}
+        };
+        co_await ConnectAwaiter{this};
+
+        if (fd_ < 0)
+        {
+            st.error = ERROR_SOCKET_NOT_CONNECTED;
+        }
+        co_return st;
+    }
+
+    void close() { closeSocket(ERROR_SOCKET_NOT_CONNECTED); }
+
+    // 发送一个请求并等待应答。recvbuf 非空时应答 body 直接拷入（最多 recvsize 字节）
+    auto request(MSGHEAD head, const void *body, int bodysize, void *recvbuf = nullptr, int recvsize = 0)
+    {
+        struct Awaiter
+        {
+            AsyncConnection *conn;
+            PendingOp        op;
+            MSGHEAD          head;
+            const void      *body;
+            int              bodysize;
+
+            bool await_ready()
+            {
+                if (!conn->connected())
+                {
+                    op.reply.head.error = ERROR_SOCKET_NOT_CONNECTED;
+                    return true;
+                }
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<> h)
+            {
+                op.waiter = h;
+                conn->submit(&op, head, body, bodysize);
+            }
+            Reply await_resume() { return std::move(op.reply); }
+        };
+        Awaiter aw{this, PendingOp{}, head, body, bodysize};
+        aw.op.recvbuf  = recvbuf;
+        aw.op.recvsize = recvsize;
+        return aw;
+    }
+
+    // 创建订阅流，首次 next() 时才向服务端发送 SUBSCRIBE。options 为 SUBOPT_* 订阅选项，
+    // 带 SUBOPT_SNAPSHOT 时第一个事件就是当前值（snapshot = true）。这里按标签名精确分发，不支持通配
+    Subscription subscribe(std::string tagname, int options = 0)
+    {
+        return Subscription(this, std::move(tagname), options);
+    }
+
+    // ---------- IoHandler ----------
+    void onEvents(uint32_t events) override
+    {
+        if (connecting_)
+        {
+            if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP))
+            {
+                finishConnect();
+            }
+            return;
+        }
+        if (events & EPOLLIN)
+        {
+            readAvailable();
+        }
+        if (fd_ >= 0 && (events & (EPOLLERR | EPOLLHUP)))
+        {
+            closeSocket(ERROR_SOCKET_NOT_CONNECTED);
+            return;
+        }
+        if (fd_ >= 0 && (events & EPOLLOUT))
+        {
+            flush();
+        }
+    }
+
+    void onStop() override { closeSocket(ERROR_SOCKET_NOT_CONNECTED); }
+
+private:
+    friend class Subscription;
+
+    struct PendingOp
+    {
+        Reply                   reply;
+        void                   *recvbuf  = nullptr;
+        int                     recvsize = 0;
+        std::coroutine_handle<> waiter;
+    };
+
+    void submit(PendingOp *op, const MSGHEAD &head, const void *body, int bodysize)
+    {
+        wire::appendFrame(out_, head, body, bodysize);
+        pending_.push_back(op);
+        flush();
+    }
+
+    void flush()
+    {
+        while (fd_ >= 0 && out_off_ < out_.size())
+        {
+            ssize_t n = ::send(fd_, out_.data() + out_off_, out_.size() - out_off_, MSG_NOSIGNAL);
+            if (n > 0)
+            {
+                out_off_ += static_cast<std::size_t>(n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                if (!want_write_)
+                {
+                    want_write_ = true;
+                    loop_.modify(fd_, EPOLLIN | EPOLLOUT | EPOLLRDHUP, this);
+                }
+                return;
+            }
+            closeSocket(ERROR_SOCKET_NOT_CONNECTED);
+            return;
+        }
+        out_.clear();
+        out_off_ = 0;
+        if (want_write_ && fd_ >= 0)
+        {
+            want_write_ = false;
+            loop_.modify(fd_, EPOLLIN | EPOLLRDHUP, this);
+        }
+    }
+
+    void finishConnect()
+    {
+        int err       = 0;
+        socklen_t len = sizeof(err);
+        ::getsockopt(fd_, SOL_SOCKET, SO_ERROR, &err, &len);
+        connecting_ = false;
+        if (err != 0)
+        {
+            closeSocket(ERROR_SOCKET_NOT_CONNECTED);
+        }
+        else
+        {
+            loop_.modify(fd_, EPOLLIN | EPOLLRDHUP, this);
+        }
+        if (connect_waiter_)
+        {
+            loop_.post(std::exchange(connect_waiter_, {}));
+        }
+    }
+
+    void readAvailable()
+    {
+        for (;;)
+        {
+            ssize_t n = rx_.readFrom(fd_);
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+            {
+                dispatchFrames();
+                closeSocket(ERROR_SOCKET_NOT_CONNECTED);
+                return;
+            }
+            if (!dispatchFrames())
+            {
+                closeSocket(ERROR_MSGSIZE);
+                return;
+            }
+            if (n < 0)
+            {
+                return; // EAGAIN：本轮已读空
+            }
+        }
+    }
+
+    bool dispatchFrames()
+    {
+        wire::Frame  frame;
+        unsigned int error = 0;
+        while (rx_.next(frame, &error))
+        {
+            if (frame.head.id == POST)
+            {
+                dispatchPost(frame);
+                continue;
+            }
+            if (pending_.empty())
+            {
+                continue; // 没有对应请求的应答，丢弃
+            }
+            PendingOp *op = pending_.front();
+            pending_.pop_front();
+            op->reply.head = frame.head;
+            if (op->recvbuf != nullptr)
+            {
+                int n = frame.head.bodysize < op->recvsize ? frame.head.bodysize : op->recvsize;
+                std::memcpy(op->recvbuf, frame.body, n);
+            }
+            else
+            {
+                op->reply.body.assign(frame.body, frame.body + frame.head.bodysize);
+            }
+            loop_.post(op->waiter);
+        }
+        return error == 0;
+    }
+
+    void dispatchPost(const wire::Frame &frame)
+    {
+        auto range = subs_.equal_range(frame.head.itemname);
+        if (range.first == range.second)
+        {
+            return;
+        }
+
+        timespec recvtime;
+        ::clock_gettime(CLOCK_REALTIME, &recvtime);
+        POSTSEQ   seq;
+        POSTSTAMP stamp;
+        int  valuesize = wire::parsePost(frame.head, frame.body, &seq, &stamp);
+        bool stamped   = valuesize != frame.head.bodysize && (frame.head.eventarg & SUBOPT_STAMP) != 0;
+
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            PostEvent ev;
+            ev.tagname   = frame.head.itemname;
+            ev.value.assign(frame.body, frame.body + valuesize);
+            ev.timestamp    = frame.head.timestamp;
+            ev.stamped      = stamped;
+            ev.writetime    = stamped ? stamp.writetime : frame.head.timestamp;
+            ev.dispatchtime = stamp.dispatchtime;
+            ev.recvtime     = recvtime;
+            ev.seq          = seq.seq;
+            ev.snapshot     = (seq.flags & POSTFLAG_SNAPSHOT) != 0;
+            it->second->push(std::move(ev));
+        }
+    }
+
+    void closeSocket(unsigned int error)
+    {
+        if (fd_ < 0)
+        {
+            return;
+        }
+        loop_.unwatch(fd_, this);
+        ::close(fd_);
+        fd_ = -1;
+        out_.clear();
+        out_off_ = 0;
+        rx_.clear();
+
+        if (connecting_)
+        {
+            connecting_ = false;
+            if (connect_waiter_)
+            {
+                loop_.post(std::exchange(connect_waiter_, {}));
+            }
+        }
+        for (PendingOp *op : pending_)
+        {
+            op->reply.head.id    = FAIL;
+            op->reply.head.error = error;
+            loop_.post(op->waiter);
+        }
+        pending_.clear();
+
+        auto subs = std::move(subs_);
+        subs_.clear();
+        for (auto &kv : subs)
+        {
+            kv.second->close(error);
+        }
+    }
+
+    void attach(Subscription *sub) { subs_.emplace(sub->tagname_, sub); }
+
+    void detach(Subscription *sub)
+    {
+        auto range = subs_.equal_range(sub->tagname_);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second == sub)
+            {
+                subs_.erase(it);
+                return;
+            }
+        }
+    }
+
+    EventLoop                  &loop_;
+    int                         fd_         = -1;
+    bool                        connecting_ = false;
+    bool                        want_write_ = false;
+    std::coroutine_handle<>     connect_waiter_;
+    std::vector<char>           out_;
+    std::size_t                 out_off_ = 0;
+    wire::FrameBuffer           rx_;
+    std::deque<PendingOp *>     pending_;
+    std::multimap<std::string, Subscription *> subs_;
+};
+
+// ============================================================
+//  Subscription 实现
+// ============================================================
+inline Subscription::Subscription(Subscription &&other) noexcept
+    : conn_(other.conn_),
+      tagname_(std::move(other.tagname_)),
+      options_(other.options_),
+      requested_(other.requested_),
+      closed_(other.closed_),
+      error_(other.error_),
+      events_(std::move(other.events_))
+{
+    if (requested_ && !closed_ && conn_ != nullptr)
+    {
+        conn_->detach(&other);
+        conn_->attach(this);
+    }
+    other.conn_   = nullptr;
+    other.closed_ = true;
+}
+
+inline Subscription::~Subscription()
+{
+    if (requested_ && !closed_ && conn_ != nullptr)
+    {
+        conn_->detach(this);
+    }
+}
+
+inline void Subscription::push(PostEvent ev)
+{
+    events_.push_back(std::move(ev));
+    if (waiter_)
+    {
+        conn_->loop_.post(std::exchange(waiter_, {}));
+    }
+}
+
+inline void Subscription::close(unsigned int error)
+{
+    closed_ = true;
+    if (error_ == 0)
+    {
+        error_ = error;
+    }
+    if (waiter_)
+    {
+        conn_->loop_.post(std::exchange(waiter_, {}));
+    }
+}
+
+inline auto Subscription::next()
+{
+    struct Awaiter
+    {
+        Subscription *sub;
+        bool await_ready() const noexcept { return !sub->events_.empty() || sub->closed_; }
+        void await_suspend(std::coroutine_handle<> h) { sub->waiter_ = h; }
+        std::optional<PostEvent> await_resume()
+        {
+            if (sub->events_.empty())
+            {
+                return std::nullopt;
+            }
+            PostEvent ev = std::move(sub->events_.front());
+            sub->events_.pop_front();
+            return ev;
+        }
+    };
+
+    // 首次调用时发送 SUBSCRIBE，应答成功后再开始等待推送
+    auto start = [](Subscription *sub) -> Task<std::optional<PostEvent>> {
+        if (!sub->requested_)
+        {
+            sub->requested_ = true;
+            if (sub->conn_ == nullptr || !sub->conn_->connected())
+            {
+                sub->close(ERROR_SOCKET_NOT_CONNECTED);
+                co_return std::nullopt;
+            }
+            // 先挂到连接上，避免应答与首条推送之间的事件丢失
+            sub->conn_->attach(sub);
+            MSGHEAD head  = wire::makeHead(SUBSCRIBE, "", sub->tagname_.c_str());
+            head.eventarg = sub->options_;
+            auto reply   = co_await sub->conn_->request(head, nullptr, 0);
+            if (!wire::replyOk(reply.head))
+            {
+                if (!sub->closed_)
+                {
+                    sub->conn_->detach(sub);
+                }
+                sub->close(reply.head.error != 0 ? reply.head.error : ERROR_INVALID_RESPONSE);
+                co_return std::nullopt;
+            }
+        }
+        co_return co_await Awaiter{sub};
+    };
+    return start(this);
+}
+
+// ============================================================
+//  便捷接口：与 readb / writeb 对应的协程版本
+// ============================================================
+template <typename T>
+Task<ReadResult<T>> readb_async(AsyncConnection &conn, std::string tagname)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "readb_async<T> 要求 T 可平凡拷贝");
+    ReadResult<T> result;
+    MSGHEAD head  = wire::makeHead(READB, "", tagname.c_str());
+    head.datasize = sizeof(T);
+    auto reply    = co_await conn.request(head, nullptr, 0, &result.value, sizeof(T));
+    if (!wire::replyOk(reply.head))
+    {
+        result.error = reply.head.error != 0 ? reply.head.error : ERROR_INVALID_RESPONSE;
+    }
+    else if (reply.head.bodysize != static_cast<int>(sizeof(T)))
+    {
+        result.error = ERROR_PARAMETER_SIZE;
+    }
+    result.timestamp = reply.head.timestamp;
+    co_return result;
+}
+
+template <typename T>
+Task<Status> writeb_async(AsyncConnection &conn, std::string tagname, T value)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "writeb_async<T> 要求 T 可平凡拷贝");
+    Status st;
+    MSGHEAD head  = wire::makeHead(WRITEB, "", tagname.c_str());
+    head.datasize = sizeof(T);
+    auto reply    = co_await conn.request(head, &value, sizeof(T));
+    if (!wire::replyOk(reply.head))
+    {
+        st.error = reply.head.error != 0 ? reply.head.error : ERROR_INVALID_RESPONSE;
+    }
+    co_return st;
+}
+
+} // namespace gplat
@@ -0,0 +1,61 @@
+#pragma once
+
+/*
+ * gplat_delaypost.h — 延时推送（subscribedelaypost）的取消接口（单头文件）
+ *
+ * 协议约定（服务端延时推送引擎基于 gplat_timerwheel.h 的分层时间轮）：
+ *   SUBSCRIBE        itemname = 标签名，body = 事件名（含 '\0'），timeout = 延时（ms）
+ *                    该标签每被写入一次就挂起一个延时定时器，到期后向订阅者推送
+ *                    itemname = 事件名、body = 写入时标签值的 POST；
+ *   CANCELSUBSCRIBE  itemname = 标签名，body = 事件名
+ *                    取消本连接上该（标签, 事件）所有尚未到期的延时推送，订阅本身保留，
+ *                    下一次写入会重新挂起。该请求不回应答，可以在订阅连接上随时发送，
+ *                    不会与 waitpostdata 争抢应答。
+ *   不带 body 的 CANCELSUBSCRIBE 仍是原来的取消订阅。
+ *
+ * 用法：
+ *   subscribedelaypost(conngplat, "COIL_ARRIVE", "COIL_TIMEOUT", 30000, &error);
+ *   ...
+ *   // 卷到达，撤销超时报警
+ *   gplat::canceldelaypost(conngplat, "COIL_ARRIVE", "COIL_TIMEOUT", &error);
+ */
+
+#include <cstring>
+
+#include "gplat_wire.h"
+
+namespace gplat {
+
+inline bool canceldelaypost(int sockfd, const char *tagname, const char *eventname, unsigned int *error)
+{
+    if (eventname == nullptr || eventname[0] == '\0')
+    {
+        if (error)
+        {
+            *error = ERROR_INVALID_PARAMETER;
+        }
+        return false;
+    }
+
+    int namelen  = static_cast<int>(::strnlen(eventname, sizeof(MSGHEAD::itemname) - 1));
+    char body[sizeof(MSGHEAD::itemname)];
+    std::memcpy(body, eventname, namelen);
+    body[namelen] = '\0';
+
+    MSGHEAD head = wire::makeHead(CANCELSUBSCRIBE, "", tagname);
+    if (!wire::sendFrame(sockfd, head, body, namelen + 1))
+    {
+        if (error)
+        {
+            *error = ERROR_SOCKET_NOT_CONNECTED;
+        }
+        return false;
+    }
+    if (error)
+    {
+        *error = 0;
+    }
+    return true;
+}
+
+} // namespace gplat
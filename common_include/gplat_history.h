@@ -0,0 +1,126 @@
+#pragma once
+
+/*
+ * gplat_history.h — 历史库查询（单头文件）
+ *
+ * gplat_server 把配置中 history_tags 列出的标签的每次变化记入历史库（压缩的时间序列，见 qbdstore.h），
+ * 趋势画面不必再从 PostgreSQL 逐行查询。本文件按 msg.h 的 READHIST 读取：
+ *   - readHistory：[from, to) 内的原始点；
+ *   - downsampleHistory：按 bucket 微秒分桶的 min / max / avg / first / last，几周的数据画一条趋势线
+ *     只需传回几百到几千个桶，服务端对整块落在一个桶内的数据直接用块头汇总，不解码。
+ * 一个报文放不下时自动续读。时刻均为 CLOCK_REALTIME 微秒（historyNow()）。
+ *
+ * 与 wire::call 一样，等待应答期间到达的 POST 留在 rx 中，订阅连接上也可以使用。
+ *
+ * 用法：
+ *   gplat::wire::FrameBuffer rx;
+ *   std::vector<HISTBUCKET>  trend;
+ *   long long now = gplat::historyNow();
+ *   // 最近 7 天的 F1_SPEED，每 10 分钟一个桶
+ *   gplat::downsampleHistory(conngplat, rx, "F1_SPEED", now - 7 * 86400000000LL, now, 600000000LL, trend, &error);
+ */
+
+#include <time.h>
+
+#include <cstring>
+#include <vector>
+
+#include "gplat_wire.h"
+
+namespace gplat {
+
+inline long long historyNow()
+{
+    timespec ts;
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+namespace detail {
+
+inline bool historyCall(int sockfd, wire::FrameBuffer &rx, const char *series, const HISTQUERY &q, MSGHEAD &reply,
+                        std::vector<char> &body, unsigned int *error)
+{
+    MSGHEAD head = wire::makeHead(READHIST, "", series);
+    return wire::call(sockfd, rx, head, &q, sizeof(q), reply, &body, error);
+}
+
+} // namespace detail
+
+// [from, to) 内的原始点追加到 points；maxpoints > 0 时至多读这么多点
+inline bool readHistory(int sockfd, wire::FrameBuffer &rx, const char *series, long long from, long long to,
+                        std::vector<HISTPOINT> &points, unsigned int *error, int maxpoints = 0)
+{
+    HISTQUERY q;
+    std::memset(&q, 0, sizeof(q));
+    q.from = from;
+    q.to   = to;
+    MSGHEAD           reply;
+    std::vector<char> body;
+    int               got = 0;
+    for (;;)
+    {
+        q.limit = maxpoints > 0 ? maxpoints - got : 0;
+        if (!detail::historyCall(sockfd, rx, series, q, reply, body, error))
+        {
+            return false;
+        }
+        int n = static_cast<int>(body.size() / sizeof(HISTPOINT));
+        if (n == 0)
+        {
+            return true;
+        }
+        std::size_t base = points.size();
+        points.resize(base + n);
+        std::memcpy(&points[base], body.data(), n * sizeof(HISTPOINT));
+        got += n;
+        if (reply.readptr == 0 || (maxpoints > 0 && got >= maxpoints))
+        {
+            return true;
+        }
+        // 续读：从最后一点的时刻起，跳过已收到的同一时刻的点
+        long long last = points.back().t;
+        int       same = 0;
+        for (int i = n - 1; i >= 0 && points[base + i].t == last; --i)
+        {
+            ++same;
+        }
+        q.skip = same == n && q.from == last ? q.skip + same : same;
+        q.from = last;
+    }
+}
+
+// 从 from 起每 bucket 微秒一个桶，非空的桶追加到 buckets
+inline bool downsampleHistory(int sockfd, wire::FrameBuffer &rx, const char *series, long long from, long long to,
+                              long long bucket, std::vector<HISTBUCKET> &buckets, unsigned int *error)
+{
+    HISTQUERY q;
+    std::memset(&q, 0, sizeof(q));
+    q.from   = from;
+    q.to     = to;
+    q.bucket = bucket;
+    MSGHEAD           reply;
+    std::vector<char> body;
+    for (;;)
+    {
+        if (!detail::historyCall(sockfd, rx, series, q, reply, body, error))
+        {
+            return false;
+        }
+        int n = static_cast<int>(body.size() / sizeof(HISTBUCKET));
+        if (n == 0)
+        {
+            return true;
+        }
+        std::size_t base = buckets.size();
+        buckets.resize(base + n);
+        std::memcpy(&buckets[base], body.data(), n * sizeof(HISTBUCKET));
+        if (reply.readptr == 0)
+        {
+            return true;
+        }
+        q.from = buckets.back().start + bucket;
+    }
+}
+
+} // namespace gplat
@@ -0,0 +1,624 @@
+#pragma once
+
+/*
+ * gplat_hub.h — 进程内订阅复用器（单头文件）
+ *
+ * 同一进程里常有多个线程关心同一个标签，若各自 connectgplat + subscribe，
+ * 服务端就要把同一条推送发 N 次，进程里也多出 N 个套接字。
+ * SubscriptionHub 对每个服务端只保持一个连接，同一标签只向服务端订阅一次，
+ * 收到的推送只分配一份引用计数的负载（HubEventPtr），再通过无锁队列
+ * 扇出给进程内的各个监听者。
+ *
+ * 用法：
+ *   auto &hub = gplat::SubscriptionHub::GetInstance();
+ *   auto listener = std::make_shared<gplat::HubListener>();
+ *   hub.subscribe(listener, "127.0.0.1", 8777, "WATCHDOG", &error);
+ *
+ *   gplat::HubEventPtr ev;
+ *   while (listener->wait(ev, 200))               // 超时返回 false
+ *       printf("%s -> %d\n", ev->tagname.c_str(), ev->as<int>());
+ *
+ *   hub.unsubscribeAll(listener);
+ *
+ * 说明：
+ *   - 每个服务端连接有一个接收线程，断线后每秒重连一次并自动重新订阅；
+ *   - 监听者队列满时丢弃新事件并计数（dropped()），不会阻塞接收线程，
+ *     以免一个慢消费者拖住同一连接上的所有监听者；
+ *   - 服务端未连通时 subscribe() 只登记订阅并返回 true，连通后自动补发；
+ *     服务端拒绝或 3 秒内没有应答时返回 false，且不保留这次登记。
+ */
+
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "gplat_wire.h"
+
+namespace gplat {
+
+// ============================================================
+//  MpmcQueue：有界无锁队列（Vyukov 算法），容量为 2 的幂
+// ============================================================
+template <typename T>
+class MpmcQueue
+{
+public:
+    explicit MpmcQueue(std::size_t capacity)
+    {
+        std::size_t cap = 2;
+        while (cap < capacity)
+        {
+            cap <<= 1;
+        }
+        mask_  = cap - 1;
+        cells_ = std::make_unique<Cell[]>(cap);
+        for (std::size_t i = 0; i < cap; ++i)
+        {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcQueue(const MpmcQueue &)            = delete;
+    MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+    bool push(T value)
+    {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell      = cells_[pos & mask_];
+            std::size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff   = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.data = std::move(value);
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // 满
+            }
+            else
+            {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(T &value)
+    {
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell      = cells_[pos & mask_];
+            std::size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff   = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    value = std::move(cell.data);
+                    cell.data = T{};
+                    cell.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // 空
+            }
+            else
+            {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> seq{0};
+        T                        data{};
+    };
+
+    std::unique_ptr<Cell[]>  cells_;
+    std::size_t              mask_ = 0;
+    alignas(64) std::atomic<std::size_t> head_{0};
+    alignas(64) std::atomic<std::size_t> tail_{0};
+};
+
+// ============================================================
+//  推送事件：每条推送只分配一次，所有监听者共享
+// ============================================================
+struct HubEvent
+{
+    std::string       tagname;
+    std::vector<char> value;
+    timespec          timestamp{};
+
+    template <typename T>
+    T as() const
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "T 必须可平凡拷贝");
+        T v{};
+        std::memcpy(&v, value.data(), value.size() < sizeof(T) ? value.size() : sizeof(T));
+        return v;
+    }
+};
+
+using HubEventPtr = std::shared_ptr<const HubEvent>;
+
+// ============================================================
+//  HubListener：一个监听者（通常对应一个线程）
+// ============================================================
+class HubListener
+{
+public:
+    explicit HubListener(std::size_t capacity = 1024) : queue_(capacity) {}
+
+    HubListener(const HubListener &)            = delete;
+    HubListener &operator=(const HubListener &) = delete;
+
+    // 非阻塞取一个事件
+    bool poll(HubEventPtr &ev) { return queue_.pop(ev); }
+
+    // 阻塞取一个事件，timeout_ms < 0 表示一直等待；超时返回 false
+    bool wait(HubEventPtr &ev, int timeout_ms)
+    {
+        if (queue_.pop(ev))
+        {
+            return true;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        sleeping_.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst); // 与 push() 中的屏障配对
+        auto ready = [&]() { return queue_.pop(ev); };
+        bool ok;
+        if (timeout_ms < 0)
+        {
+            cv_.wait(lock, ready);
+            ok = true;
+        }
+        else
+        {
+            ok = cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready);
+        }
+        sleeping_.store(false);
+        return ok;
+    }
+
+    // 因队列满而丢弃的事件数
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    friend class SubscriptionHub;
+
+    void push(const HubEventPtr &ev)
+    {
+        if (!queue_.push(ev))
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // 与 wait() 中先置 sleeping_ 再检查队列配对，保证不丢唤醒：
+        // 入队是 release 写，之后的读可能被提前到它之前，两侧都要全屏障
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load())
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_one();
+        }
+    }
+
+    MpmcQueue<HubEventPtr>  queue_;
+    std::atomic<uint64_t>   dropped_{0};
+    std::atomic<bool>       sleeping_{false};
+    std::mutex              mutex_;
+    std::condition_variable cv_;
+};
+
+// ============================================================
+//  SubscriptionHub
+// ============================================================
+class SubscriptionHub
+{
+public:
+    struct Stats
+    {
+        std::size_t servers    = 0; // 服务端连接数
+        std::size_t tags       = 0; // 向服务端订阅的标签数（去重后）
+        std::size_t listeners  = 0; // 监听者订阅数（去重前）
+        uint64_t    posts      = 0; // 从服务端收到的推送数
+        uint64_t    deliveries = 0; // 扇出给监听者的次数
+    };
+
+    // 进程级单例，与 CConfig::GetInstance 用法一致；也可以自行创建独立实例
+    static SubscriptionHub &GetInstance()
+    {
+        static SubscriptionHub instance;
+        return instance;
+    }
+
+    SubscriptionHub() = default;
+    ~SubscriptionHub()
+    {
+        std::map<std::string, std::unique_ptr<ServerConn>> servers;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            servers.swap(servers_);
+        }
+        for (auto &kv : servers)
+        {
+            kv.second->stop();
+        }
+    }
+
+    SubscriptionHub(const SubscriptionHub &)            = delete;
+    SubscriptionHub &operator=(const SubscriptionHub &) = delete;
+
+    // 让 listener 接收 server:port 上 tagname 的推送。同一标签第一次订阅时才发往服务端
+    bool subscribe(const std::shared_ptr<HubListener> &listener, const std::string &server, int port,
+                   const std::string &tagname, unsigned int *error)
+    {
+        return connFor(server, port).add(listener, tagname, error);
+    }
+
+    void unsubscribe(const std::shared_ptr<HubListener> &listener, const std::string &server, int port,
+                     const std::string &tagname)
+    {
+        connFor(server, port).remove(listener, tagname);
+    }
+
+    // 从所有服务端、所有标签上移除该监听者
+    void unsubscribeAll(const std::shared_ptr<HubListener> &listener)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &kv : servers_)
+        {
+            kv.second->removeAll(listener);
+        }
+    }
+
+    Stats stats()
+    {
+        Stats st;
+        std::lock_guard<std::mutex> lock(mutex_);
+        st.servers = servers_.size();
+        for (auto &kv : servers_)
+        {
+            kv.second->collect(st);
+        }
+        return st;
+    }
+
+private:
+    using ListenerList = std::vector<std::shared_ptr<HubListener>>;
+    using TagMap       = std::map<std::string, ListenerList, std::less<>>;
+
+    // 一个服务端连接：接收线程读报文，POST 扇出，其它报文交给等待应答的请求
+    class ServerConn
+    {
+    public:
+        ServerConn(std::string server, int port) : server_(std::move(server)), port_(port)
+        {
+            std::atomic_store(&snapshot_, std::make_shared<const TagMap>());
+            thread_ = std::thread(&ServerConn::run, this);
+        }
+
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                running_ = false;
+                if (fd_ >= 0)
+                {
+                    ::shutdown(fd_, SHUT_RDWR); // 唤醒阻塞在 recv 上的接收线程
+                }
+            }
+            stop_cv_.notify_all();
+            if (thread_.joinable())
+            {
+                thread_.join();
+            }
+        }
+
+        bool add(const std::shared_ptr<HubListener> &listener, const std::string &tagname, unsigned int *error)
+        {
+            std::shared_future<unsigned int> reply;
+            bool                             sender = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto &list = tags_[tagname];
+                for (auto &l : list)
+                {
+                    if (l == listener)
+                    {
+                        setError(error, 0);
+                        return true;
+                    }
+                }
+                list.push_back(listener);
+                publish();
+                auto flight = inflight_.find(tagname);
+                if (flight != inflight_.end())
+                {
+                    reply = flight->second; // 该标签的 SUBSCRIBE 还在等应答，以它的结果为准
+                }
+                else if (list.size() > 1 || fd_ < 0)
+                {
+                    setError(error, 0); // 已订阅过，或等待连通后补发
+                    return true;
+                }
+                else
+                {
+                    reply              = sendLocked(SUBSCRIBE, tagname).share();
+                    inflight_[tagname] = reply;
+                    sender             = true;
+                }
+            }
+
+            unsigned int err = reply.wait_for(std::chrono::seconds(3)) == std::future_status::ready
+                                   ? reply.get()
+                                   : ERROR_SOCKET_NOT_CONNECTED;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (sender)
+                {
+                    inflight_.erase(tagname);
+                }
+                if (err != 0)
+                {
+                    // 服务端没有接受：撤销登记，免得之后的订阅者以为已订阅、重连时又补发
+                    removeLocked(listener, tagname);
+                    publish();
+                }
+            }
+            setError(error, err);
+            return err == 0;
+        }
+
+        void remove(const std::shared_ptr<HubListener> &listener, const std::string &tagname)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            removeLocked(listener, tagname);
+            publish();
+        }
+
+        void removeAll(const std::shared_ptr<HubListener> &listener)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::vector<std::string> names;
+            for (auto &kv : tags_)
+            {
+                names.push_back(kv.first);
+            }
+            for (auto &name : names)
+            {
+                removeLocked(listener, name);
+            }
+            publish();
+        }
+
+        void collect(Stats &st)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            st.tags += tags_.size();
+            for (auto &kv : tags_)
+            {
+                st.listeners += kv.second.size();
+            }
+            st.posts      += posts_.load(std::memory_order_relaxed);
+            st.deliveries += deliveries_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static void setError(unsigned int *error, unsigned int value)
+        {
+            if (error)
+            {
+                *error = value;
+            }
+        }
+
+        void removeLocked(const std::shared_ptr<HubListener> &listener, const std::string &tagname)
+        {
+            auto it = tags_.find(tagname);
+            if (it == tags_.end())
+            {
+                return;
+            }
+            auto &list = it->second;
+            for (auto l = list.begin(); l != list.end(); ++l)
+            {
+                if (*l == listener)
+                {
+                    list.erase(l);
+                    break;
+                }
+            }
+            if (list.empty())
+            {
+                tags_.erase(it);
+                if (fd_ >= 0)
+                {
+                    sendLocked(CANCELSUBSCRIBE, tagname); // 最后一个监听者离开，撤销服务端订阅
+                }
+            }
+        }
+
+        // 发布新的只读快照，接收线程扇出时无需加锁
+        void publish() { std::atomic_store(&snapshot_, std::make_shared<const TagMap>(tags_)); }
+
+        // 调用方持有 mutex_。应答按发送顺序回来，接收线程依次兑现
+        std::future<unsigned int> sendLocked(int id, const std::string &tagname)
+        {
+            std::promise<unsigned int> promise;
+            auto future  = promise.get_future();
+            MSGHEAD head = wire::makeHead(id, "", tagname.c_str());
+            if (!wire::sendFrame(fd_, head, nullptr, 0))
+            {
+                promise.set_value(ERROR_SOCKET_NOT_CONNECTED);
+                return future;
+            }
+            pending_.push_back(std::move(promise));
+            return future;
+        }
+
+        void failPendingLocked()
+        {
+            for (auto &p : pending_)
+            {
+                p.set_value(ERROR_SOCKET_NOT_CONNECTED);
+            }
+            pending_.clear();
+        }
+
+        void run()
+        {
+            wire::FrameBuffer rx(256 * 1024);
+            while (true)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (!running_)
+                    {
+                        return;
+                    }
+                }
+                int fd = wire::connectTcp(server_.c_str(), port_, false);
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    if (!running_)
+                    {
+                        if (fd >= 0)
+                        {
+                            ::close(fd);
+                        }
+                        return;
+                    }
+                    if (fd < 0)
+                    {
+                        stop_cv_.wait_for(lock, std::chrono::seconds(1), [this]() { return !running_; });
+                        continue;
+                    }
+                    fd_ = fd;
+                    // 连通（或重连）后补发全部订阅，应答由下面的读循环消费
+                    for (auto &kv : tags_)
+                    {
+                        sendLocked(SUBSCRIBE, kv.first);
+                    }
+                }
+
+                rx.clear();
+                readLoop(fd, rx);
+
+                std::lock_guard<std::mutex> lock(mutex_);
+                ::close(fd_);
+                fd_ = -1;
+                failPendingLocked();
+            }
+        }
+
+        void readLoop(int fd, wire::FrameBuffer &rx)
+        {
+            wire::Frame frame;
+            unsigned int error = 0;
+            while (rx.readFrom(fd) > 0)
+            {
+                auto snapshot = std::atomic_load(&snapshot_);
+                while (rx.next(frame, &error))
+                {
+                    if (frame.head.id == POST)
+                    {
+                        fanout(*snapshot, frame);
+                        continue;
+                    }
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (!pending_.empty())
+                    {
+                        unsigned int err = wire::replyOk(frame.head)
+                                               ? 0
+                                               : (frame.head.error != 0 ? frame.head.error : ERROR_INVALID_RESPONSE);
+                        pending_.front().set_value(err);
+                        pending_.pop_front();
+                    }
+                }
+                if (error != 0)
+                {
+                    return; // 报文非法，断开重连
+                }
+            }
+        }
+
+        void fanout(const TagMap &snapshot, const wire::Frame &frame)
+        {
+            posts_.fetch_add(1, std::memory_order_relaxed);
+            auto it = snapshot.find(std::string_view(frame.head.itemname, ::strnlen(frame.head.itemname, sizeof(frame.head.itemname))));
+            if (it == snapshot.end() || it->second.empty())
+            {
+                return;
+            }
+            auto ev       = std::make_shared<HubEvent>();
+            ev->tagname   = it->first;
+            int valuesize = wire::parsePost(frame.head, frame.body, nullptr, nullptr);
+            ev->value.assign(frame.body, frame.body + valuesize);
+            ev->timestamp = frame.head.timestamp;
+            HubEventPtr shared = std::move(ev);
+            for (auto &listener : it->second)
+            {
+                listener->push(shared);
+            }
+            deliveries_.fetch_add(it->second.size(), std::memory_order_relaxed);
+        }
+
+        std::string server_;
+        int         port_;
+
+        std::mutex                              mutex_;   // 保护以下成员及套接字写
+        std::condition_variable                 stop_cv_;
+        bool                                    running_ = true;
+        int                                     fd_      = -1;
+        TagMap                                  tags_;
+        std::deque<std::promise<unsigned int>>  pending_;
+        std::map<std::string, std::shared_future<unsigned int>> inflight_; // 已发出、未应答的 SUBSCRIBE
+
+        std::shared_ptr<const TagMap> snapshot_;          // 接收线程读取的只读快照
+        std::atomic<uint64_t>         posts_{0};
+        std::atomic<uint64_t>         deliveries_{0};
+        std::thread                   thread_;
+    };
+
+    ServerConn &connFor(const std::string &server, int port)
+    {
+        std::string key = server + ":" + std::to_string(port);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &conn = servers_[key];
+        if (!conn)
+        {
+            conn = std::make_unique<ServerConn>(server, port);
+        }
+        return *conn;
+    }
+
+    std::mutex                                          mutex_;
+    std::map<std::string, std::unique_ptr<ServerConn>> servers_;
+};
+
+} // namespace gplat
@@ -0,0 +1,304 @@
+#pragma once
+
+/*
+ * gplat_latency.h — writeb → 订阅者 的端到端延迟统计（单头文件）
+ *
+ * 订阅时带上 SUBOPT_STAMP，服务端会在每个 POST 尾部附带写入时刻和分发时刻，
+ * 客户端收到时再记一个接收时刻，于是每条推送可以拆成三段：
+ *   - server   : 写入 → 分发（服务端排队、扇出耗时）
+ *   - network  : 分发 → 接收（网络 + 客户端调度）
+ *   - endtoend : 写入 → 接收
+ * 每段按“全局 + 每个标签”各记一个直方图，可随时取 p50/p99/p999。
+ * 时间戳均为 CLOCK_REALTIME，跨主机统计时需要两端做好时钟同步（NTP/PTP）。
+ *
+ * 用法：
+ *   gplat::PostLatencyRecorder recorder;
+ *   gplat::subscribe_ex(fd, rx, "WATCHDOG", SUBOPT_STAMP, &error);
+ *   int n = gplat::waitpostdata_multi(fd, rx, events, 256, 200, &error);
+ *   for (int i = 0; i < n; ++i) recorder.record(events[i]);
+ *
+ *   for (auto &s : recorder.stats()) printf("%s p99=%.1fus\n", s.tagname.c_str(), s.p99_us);
+ *   gplat::logLatencyStats(recorder);   // 通过 logging.h 的全局 logger 输出
+ */
+
+#include <time.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gplat_post.h"
+#include "logging.h"
+
+namespace gplat {
+
+// ============================================================
+//  LatencyHistogram：对数-线性分桶直方图（纳秒），无锁记录
+// ============================================================
+// 每个 2 的幂区间再均分 8 个子桶，相对误差不超过 12.5%，覆盖 0 ~ 2^63 ns
+class LatencyHistogram
+{
+public:
+    static constexpr int kSubBits    = 3;
+    static constexpr int kSubBuckets = 1 << kSubBits;
+    static constexpr int kBuckets    = 64 * kSubBuckets;
+
+    void record(int64_t ns)
+    {
+        uint64_t v = ns < 0 ? 0 : static_cast<uint64_t>(ns);
+        counts_[bucketOf(v)].fetch_add(1, std::memory_order_relaxed);
+        total_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(v, std::memory_order_relaxed);
+        uint64_t cur = max_.load(std::memory_order_relaxed);
+        while (v > cur && !max_.compare_exchange_weak(cur, v, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    uint64_t count() const { return total_.load(std::memory_order_relaxed); }
+    uint64_t maxNs() const { return max_.load(std::memory_order_relaxed); }
+
+    double meanNs() const
+    {
+        uint64_t n = count();
+        return n == 0 ? 0.0 : static_cast<double>(sum_.load(std::memory_order_relaxed)) / n;
+    }
+
+    // p 取 0~1，返回所在桶的中点（纳秒）
+    double percentileNs(double p) const
+    {
+        uint64_t n = count();
+        if (n == 0)
+        {
+            return 0.0;
+        }
+        uint64_t rank = static_cast<uint64_t>(p * (n - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i)
+        {
+            seen += counts_[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+            {
+                double mid = (static_cast<double>(lowerBound(i)) + static_cast<double>(upperBound(i))) / 2.0;
+                return std::min(mid, static_cast<double>(maxNs()));
+            }
+        }
+        return static_cast<double>(maxNs());
+    }
+
+    void reset()
+    {
+        for (auto &c : counts_)
+        {
+            c.store(0, std::memory_order_relaxed);
+        }
+        total_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static int bucketOf(uint64_t v)
+    {
+        if (v < static_cast<uint64_t>(kSubBuckets))
+        {
+            return static_cast<int>(v);
+        }
+        int msb   = 63 - __builtin_clzll(v);
+        int shift = msb - kSubBits;
+        return (shift + 1) * kSubBuckets + static_cast<int>((v >> shift) & (kSubBuckets - 1));
+    }
+
+    static uint64_t lowerBound(int bucket)
+    {
+        if (bucket < kSubBuckets)
+        {
+            return static_cast<uint64_t>(bucket);
+        }
+        int shift = bucket / kSubBuckets - 1;
+        uint64_t sub = static_cast<uint64_t>(bucket % kSubBuckets) | kSubBuckets;
+        return sub << shift;
+    }
+
+    static uint64_t upperBound(int bucket)
+    {
+        if (bucket < kSubBuckets)
+        {
+            return static_cast<uint64_t>(bucket);
+        }
+        int shift = bucket / kSubBuckets - 1;
+        return lowerBound(bucket) + (uint64_t(1) << shift) - 1;
+    }
+
+    std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+    std::atomic<uint64_t> total_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+// 一段延迟的统计快照（微秒）
+struct LatencySnapshot
+{
+    std::string tagname; // 空串表示全局
+    std::string stage;   // server / network / endtoend
+    uint64_t    count   = 0;
+    double      mean_us = 0;
+    double      p50_us  = 0;
+    double      p99_us  = 0;
+    double      p999_us = 0;
+    double      max_us  = 0;
+};
+
+// ============================================================
+//  PostLatencyRecorder：全局 + 按标签的三段延迟直方图
+// ============================================================
+class PostLatencyRecorder
+{
+public:
+    enum Stage
+    {
+        kServer,   // 写入 → 分发
+        kNetwork,  // 分发 → 接收
+        kEndToEnd, // 写入 → 接收
+        kStageCount
+    };
+
+    // writetime / recvtime 必填；dispatchtime 为空或为 0 时只记录端到端
+    void record(std::string_view tagname, const timespec &writetime, const timespec *dispatchtime,
+                const timespec &recvtime)
+    {
+        Stages &tag = tagStages(tagname);
+        recordStage(tag, kEndToEnd, diffNs(writetime, recvtime));
+        if (dispatchtime != nullptr && (dispatchtime->tv_sec != 0 || dispatchtime->tv_nsec != 0))
+        {
+            recordStage(tag, kServer, diffNs(writetime, *dispatchtime));
+            recordStage(tag, kNetwork, diffNs(*dispatchtime, recvtime));
+        }
+    }
+
+    void record(const PostView &ev)
+    {
+        record(ev.tagname, ev.writetime, ev.stamped ? &ev.dispatchtime : nullptr, ev.recvtime);
+    }
+
+    // per_tag 为 false 时只返回全局统计
+    std::vector<LatencySnapshot> stats(bool per_tag = true) const
+    {
+        std::vector<LatencySnapshot> out;
+        appendStages(out, "", global_);
+        if (per_tag)
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            for (const auto &kv : tags_)
+            {
+                appendStages(out, kv.first, *kv.second);
+            }
+        }
+        return out;
+    }
+
+    void reset()
+    {
+        for (auto &h : global_)
+        {
+            h.reset();
+        }
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        for (auto &kv : tags_)
+        {
+            for (auto &h : *kv.second)
+            {
+                h.reset();
+            }
+        }
+    }
+
+    static const char *stageName(int stage)
+    {
+        static const char *names[kStageCount] = {"server", "network", "endtoend"};
+        return names[stage];
+    }
+
+private:
+    using Stages = std::array<LatencyHistogram, kStageCount>;
+
+    static int64_t diffNs(const timespec &from, const timespec &to)
+    {
+        return (static_cast<int64_t>(to.tv_sec) - from.tv_sec) * 1000000000LL + (to.tv_nsec - from.tv_nsec);
+    }
+
+    void recordStage(Stages &tag, Stage stage, int64_t ns)
+    {
+        global_[stage].record(ns);
+        tag[stage].record(ns);
+    }
+
+    Stages &tagStages(std::string_view tagname)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = tags_.find(tagname);
+            if (it != tags_.end())
+            {
+                return *it->second;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto &slot = tags_[std::string(tagname)];
+        if (!slot)
+        {
+            slot = std::make_unique<Stages>();
+        }
+        return *slot;
+    }
+
+    static void appendStages(std::vector<LatencySnapshot> &out, const std::string &tagname, const Stages &stages)
+    {
+        for (int s = 0; s < kStageCount; ++s)
+        {
+            const LatencyHistogram &h = stages[s];
+            if (h.count() == 0)
+            {
+                continue;
+            }
+            LatencySnapshot snap;
+            snap.tagname = tagname;
+            snap.stage   = stageName(s);
+            snap.count   = h.count();
+            snap.mean_us = h.meanNs() / 1000.0;
+            snap.p50_us  = h.percentileNs(0.50) / 1000.0;
+            snap.p99_us  = h.percentileNs(0.99) / 1000.0;
+            snap.p999_us = h.percentileNs(0.999) / 1000.0;
+            snap.max_us  = static_cast<double>(h.maxNs()) / 1000.0;
+            out.push_back(std::move(snap));
+        }
+    }
+
+    Stages global_;
+    mutable std::shared_mutex mutex_;
+    std::map<std::string, std::unique_ptr<Stages>, std::less<>> tags_;
+};
+
+// 通过 logging.h 的全局 logger 输出统计；logger 未初始化时不输出
+inline void logLatencyStats(const PostLatencyRecorder &recorder, bool per_tag = true)
+{
+    auto &logger = getLogger();
+    if (!logger)
+    {
+        return;
+    }
+    for (const auto &s : recorder.stats(per_tag))
+    {
+        logger->info("[latency] tag={} stage={} count={} mean={:.1f}us p50={:.1f}us p99={:.1f}us p999={:.1f}us max={:.1f}us",
+                     s.tagname.empty() ? "*" : s.tagname, s.stage, s.count, s.mean_us, s.p50_us, s.p99_us,
+                     s.p999_us, s.max_us);
+    }
+}
+
+} // namespace gplat
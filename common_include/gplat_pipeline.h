@@ -0,0 +1,404 @@
+#pragma once
+
+/*
+ * gplat_pipeline.h — 单连接请求流水线（单头文件）
+ *
+ * readb()/writeb()/readq() 都是一问一答，一个连接上同时只有一个请求在途，
+ * 吞吐量被往返时延卡死在 1/RTT。Pipeline 给每个请求分配一个序号
+ * （放在 head.eventid，见 msg.h），连续发出多个请求后再统一收应答，
+ * 单连接吞吐量随流水线深度增长。
+ *
+ * 用法：
+ *   gplat::Pipeline pipe(conngplat, 32);          // 最多 32 个请求在途
+ *   int values[100];
+ *   for (int i = 0; i < 100; ++i)
+ *       pipe.readb(tags[i], &values[i], sizeof(int));  // 返回票据，只是排队
+ *   gplat::PipelineResult results[100];
+ *   int n = 0;
+ *   while (n < 100) {
+ *       int got = pipe.collectInOrder(results + n, 100 - n, 1000, &error);  // 按发出顺序
+ *       if (got <= 0) break;
+ *       n += got;
+ *   }
+ *   // 或 pipe.collect(...)：哪个应答先到先交付
+ *
+ * 说明：
+ *   - 排队的请求在 flush()、collect*() 或在途数达到上限时一次 send 发出；
+ *   - 读请求的结果直接写入发出请求时给出的缓冲区，该缓冲区在应答收到前必须有效；
+ *   - 服务端不带回序号（应答 eventid 为 0）时按发送顺序对应应答，
+ *     对按序处理请求的服务端结果相同；
+ *   - 只用于请求连接，订阅连接上的 POST 会被丢弃；
+ *   - collect() 与 collectInOrder() 可以混用，每个请求只会交付一次。
+ */
+
+#include <poll.h>
+#include <time.h>
+
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "gplat_wire.h"
+
+namespace gplat {
+
+struct PipelineResult
+{
+    unsigned int ticket = 0;    // 发出请求时返回的票据
+    int          id     = 0;    // 请求类型：READB / WRITEB / READQ / WRITEQ
+    bool         ok     = false;
+    unsigned int error  = 0;
+    int          size   = 0;    // 应答数据长度（读请求）
+    timespec     timestamp{};   // 应答报文头中的时间戳
+};
+
+class Pipeline
+{
+public:
+    explicit Pipeline(int sockfd, int max_depth = 64)
+        : fd_(sockfd), max_depth_(max_depth > 0 ? max_depth : 1)
+    {
+    }
+
+    Pipeline(const Pipeline &)            = delete;
+    Pipeline &operator=(const Pipeline &) = delete;
+
+    // 以下请求只排队，返回票据；连接已断开返回 0
+    unsigned int readb(const char *tagname, void *value, int size)
+    {
+        MSGHEAD head  = wire::makeHead(READB, "", tagname);
+        head.datasize = size;
+        return issue(head, nullptr, 0, value, size);
+    }
+
+    unsigned int writeb(const char *tagname, const void *value, int size)
+    {
+        MSGHEAD head  = wire::makeHead(WRITEB, "", tagname);
+        head.datasize = size;
+        return issue(head, value, size, nullptr, 0);
+    }
+
+    unsigned int readq(const char *qname, void *record, int size)
+    {
+        MSGHEAD head  = wire::makeHead(READQ, qname, "");
+        head.datasize = size;
+        return issue(head, nullptr, 0, record, size);
+    }
+
+    unsigned int writeq(const char *qname, const void *record, int size)
+    {
+        MSGHEAD head  = wire::makeHead(WRITEQ, qname, "");
+        head.datasize = size;
+        return issue(head, record, size, nullptr, 0);
+    }
+
+    // 发出所有排队的请求
+    bool flush(unsigned int *error = nullptr)
+    {
+        if (!broken_ && !out_.empty())
+        {
+            if (!wire::sendAll(fd_, out_.data(), out_.size()))
+            {
+                fail(ERROR_SOCKET_NOT_CONNECTED);
+            }
+            out_.clear();
+        }
+        setError(error, broken_ ? error_ : 0);
+        return !broken_;
+    }
+
+    // 乱序收取：交付已完成的请求，先到先交付
+    //   返回 >0 交付个数；0 超时（*error = ETIMEDOUT）或没有未交付的请求（*error = 0）；-1 连接出错
+    int collect(PipelineResult *results, int max, int timeout, unsigned int *error = nullptr)
+    {
+        return collectImpl(results, max, timeout, false, error);
+    }
+
+    // 按发出顺序收取：只交付最早发出的若干个已完成请求
+    int collectInOrder(PipelineResult *results, int max, int timeout, unsigned int *error = nullptr)
+    {
+        return collectImpl(results, max, timeout, true, error);
+    }
+
+    // 发出但尚未收到应答的请求数（含排队未发出的）
+    int inflight() const { return inflight_; }
+
+    // 已发出、尚未交付的请求数
+    std::size_t outstanding() const { return ops_.size(); }
+
+    bool broken() const { return broken_; }
+
+private:
+    struct Op
+    {
+        int            id       = 0;
+        void          *buffer   = nullptr;
+        int            capacity = 0;
+        bool           done     = false;
+        PipelineResult result;
+    };
+
+    static void setError(unsigned int *error, unsigned int value)
+    {
+        if (error)
+        {
+            *error = value;
+        }
+    }
+
+    void fail(unsigned int error)
+    {
+        if (broken_)
+        {
+            return;
+        }
+        broken_ = true;
+        error_  = error;
+        // 在途请求全部以连接错误完成
+        for (auto &kv : ops_)
+        {
+            if (!kv.second.done)
+            {
+                complete(kv.first, kv.second, error);
+            }
+        }
+        sent_.clear();
+        inflight_ = 0;
+    }
+
+    unsigned int issue(MSGHEAD &head, const void *body, int bodysize, void *buffer, int capacity)
+    {
+        if (broken_)
+        {
+            return 0;
+        }
+        // 在途数已满：先发出排队的请求，再收应答腾出位置
+        while (inflight_ >= max_depth_)
+        {
+            if (!flush() || !receive(-1))
+            {
+                return 0;
+            }
+        }
+
+        unsigned int ticket = ++next_;
+        if (ticket == 0)
+        {
+            ticket = ++next_; // 回绕时跳过 0
+        }
+        wire::setSeqno(head, ticket);
+        wire::appendFrame(out_, head, body, bodysize);
+
+        Op &op      = ops_[ticket];
+        op.id       = head.id;
+        op.buffer   = buffer;
+        op.capacity = capacity;
+        sent_.push_back(ticket);
+        order_.push_back(ticket);
+        ++inflight_;
+        return ticket;
+    }
+
+    void complete(unsigned int ticket, Op &op, unsigned int error)
+    {
+        op.done          = true;
+        op.result.ticket = ticket;
+        op.result.id     = op.id;
+        op.result.error  = error;
+        op.result.ok     = error == 0;
+        done_.push_back(ticket);
+    }
+
+    void onReply(const wire::Frame &frame)
+    {
+        unsigned int ticket = wire::seqnoOf(frame.head);
+        auto it = ticket != 0 ? ops_.find(ticket) : ops_.end();
+        if (it == ops_.end() || it->second.done)
+        {
+            // 服务端没有带回序号：对应最早发出、尚未应答的请求
+            while (!sent_.empty())
+            {
+                auto front = ops_.find(sent_.front());
+                if (front != ops_.end() && !front->second.done)
+                {
+                    break;
+                }
+                sent_.pop_front();
+            }
+            if (sent_.empty())
+            {
+                return; // 多余的应答
+            }
+            ticket = sent_.front();
+            it     = ops_.find(ticket);
+        }
+
+        Op &op              = it->second;
+        op.result.size      = frame.head.bodysize;
+        op.result.timestamp = frame.head.timestamp;
+        if (op.buffer && frame.head.bodysize > 0)
+        {
+            int n = frame.head.bodysize < op.capacity ? frame.head.bodysize : op.capacity;
+            std::memcpy(op.buffer, frame.body, n);
+        }
+        unsigned int error = 0;
+        if (!wire::replyOk(frame.head))
+        {
+            error = frame.head.error != 0 ? frame.head.error : ERROR_INVALID_RESPONSE;
+        }
+        else if (op.buffer && frame.head.bodysize > op.capacity)
+        {
+            error = ERROR_BUFFER_SIZE;
+        }
+        complete(ticket, op, error);
+        --inflight_;
+        while (!sent_.empty())
+        {
+            auto front = ops_.find(sent_.front());
+            if (front != ops_.end() && !front->second.done)
+            {
+                break;
+            }
+            sent_.pop_front();
+        }
+    }
+
+    // 收一次数据并处理其中的应答；timeout 为毫秒，-1 一直等待
+    // 返回 false 表示超时（*timed_out = true）或连接出错
+    bool receive(int timeout, bool *timed_out = nullptr)
+    {
+        pollfd pfd;
+        pfd.fd      = fd_;
+        pfd.events  = POLLIN;
+        pfd.revents = 0;
+        int ready;
+        do
+        {
+            ready = ::poll(&pfd, 1, timeout);
+        } while (ready < 0 && errno == EINTR);
+        if (ready == 0)
+        {
+            if (timed_out)
+            {
+                *timed_out = true;
+            }
+            return false;
+        }
+
+        ssize_t n = ready < 0 ? -1 : rx_.readFrom(fd_);
+        if (n <= 0)
+        {
+            fail(ERROR_SOCKET_NOT_CONNECTED);
+            return false;
+        }
+
+        unsigned int err = 0;
+        wire::Frame  frame;
+        while (rx_.next(frame, &err))
+        {
+            if (frame.head.id != POST)
+            {
+                onReply(frame);
+            }
+        }
+        if (err != 0)
+        {
+            fail(err);
+            return false;
+        }
+        return true;
+    }
+
+    int take(PipelineResult *results, int max, bool in_order)
+    {
+        int count = 0;
+        std::deque<unsigned int> &queue = in_order ? order_ : done_;
+        while (count < max && !queue.empty())
+        {
+            auto it = ops_.find(queue.front());
+            if (it == ops_.end())
+            {
+                queue.pop_front(); // 已由另一种方式交付
+                continue;
+            }
+            if (!it->second.done)
+            {
+                break; // 按序收取时，最早的请求还没完成
+            }
+            results[count++] = it->second.result;
+            ops_.erase(it);
+            queue.pop_front();
+        }
+        // 另一条队列头部已交付的票据一并清掉，避免只用一种方式收取时无限增长
+        std::deque<unsigned int> &other = in_order ? done_ : order_;
+        while (!other.empty() && ops_.find(other.front()) == ops_.end())
+        {
+            other.pop_front();
+        }
+        return count;
+    }
+
+    int collectImpl(PipelineResult *results, int max, int timeout, bool in_order, unsigned int *error)
+    {
+        if (max <= 0)
+        {
+            setError(error, ERROR_PARAMETER_SIZE);
+            return -1;
+        }
+        flush();
+
+        timespec start;
+        ::clock_gettime(CLOCK_MONOTONIC, &start);
+        for (;;)
+        {
+            int count = take(results, max, in_order);
+            if (count > 0)
+            {
+                setError(error, 0);
+                return count;
+            }
+            if (broken_)
+            {
+                setError(error, error_);
+                return -1;
+            }
+            if (inflight_ == 0)
+            {
+                setError(error, 0);
+                return 0;
+            }
+
+            int remain = timeout;
+            if (timeout > 0)
+            {
+                timespec now;
+                ::clock_gettime(CLOCK_MONOTONIC, &now);
+                long elapsed = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+                remain       = elapsed >= timeout ? 0 : timeout - static_cast<int>(elapsed);
+            }
+            bool timed_out = false;
+            if (!receive(remain, &timed_out) && timed_out)
+            {
+                setError(error, ETIMEDOUT);
+                return 0;
+            }
+        }
+    }
+
+    int                                    fd_;
+    int                                    max_depth_;
+    std::vector<char>                      out_;       // 排队待发的报文
+    wire::FrameBuffer                      rx_;
+    std::unordered_map<unsigned int, Op>   ops_;       // 未交付的请求
+    std::deque<unsigned int>               sent_;      // 发出顺序，用于无序号应答的对应
+    std::deque<unsigned int>               order_;     // 发出顺序，按序收取
+    std::deque<unsigned int>               done_;      // 完成顺序，乱序收取
+    unsigned int                           next_     = 0;
+    int                                    inflight_ = 0;
+    bool                                   broken_   = false;
+    unsigned int                           error_    = 0;
+};
+
+} // namespace gplat
@@ -0,0 +1,174 @@
+#pragma once
+
+/*
+ * gplat_plcbatch.h — PLC 批量写（单头文件）
+ *
+ * higplat 的 write_plc_bool / write_plc_short / ... / write_plc_string 每个值发一个 WRITEBPLC /
+ * WRITEBSTRINGPLC 报文并等待应答，下发一套几百个设定值就是几百次往返。
+ * PlcBatch 先收集多个标签、不同类型的写入，send() 时按 msg.h 的 PLCWRITE 布局打包进一个 WRITEBPLC 报文
+ * （head.arraysize = 项数），服务端一次处理完全部各项；超过 MAXMSGLEN 时拆成尽量少的几个报文依次发送。
+ * 各项相互独立：某个标签写入失败不影响其余各项，errorOf(i) 给出每项的结果。
+ *
+ * 与 wire::call 一样，等待应答期间到达的 POST 留在 rx 中，订阅连接上也可以使用。
+ *
+ * 用法：
+ *   gplat::PlcBatch batch;
+ *   batch.add("F1_SPEED_REF", 2.35f).add("F1_GAP_REF", 12.6f).add("F1_BEND_ON", true);
+ *   batch.addString("F1_GRADE", grade);
+ *
+ *   gplat::wire::FrameBuffer rx;
+ *   if (!batch.send(conngplat, rx, &error))
+ *   {
+ *       for (std::size_t i = 0; i < batch.size(); ++i)
+ *           if (batch.errorOf(i) != 0) ...
+ *   }
+ */
+
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "gplat_wire.h"
+
+namespace gplat {
+
+class PlcBatch
+{
+public:
+    // 与 write_plc_* 一样只接受这几种类型，其它类型（含可隐式转换的）编译报错
+    PlcBatch &add(const char *tagname, bool value) { return put(tagname, PLCVAL_BOOL, &value, sizeof(value)); }
+    PlcBatch &add(const char *tagname, short value) { return put(tagname, PLCVAL_SHORT, &value, sizeof(value)); }
+    PlcBatch &add(const char *tagname, unsigned short value)
+    {
+        return put(tagname, PLCVAL_USHORT, &value, sizeof(value));
+    }
+    PlcBatch &add(const char *tagname, int value) { return put(tagname, PLCVAL_INT, &value, sizeof(value)); }
+    PlcBatch &add(const char *tagname, unsigned int value) { return put(tagname, PLCVAL_UINT, &value, sizeof(value)); }
+    PlcBatch &add(const char *tagname, float value) { return put(tagname, PLCVAL_FLOAT, &value, sizeof(value)); }
+    template <typename T>
+    PlcBatch &add(const char *tagname, T value) = delete;
+
+    // 字符串中不能含 '\0'（服务端按 C 字符串保存）
+    PlcBatch &addString(const char *tagname, std::string_view value)
+    {
+        return put(tagname, PLCVAL_STRING, value.data(), static_cast<int>(value.size()), true);
+    }
+
+    std::size_t size() const { return offsets_.size(); }
+    bool        empty() const { return offsets_.empty(); }
+
+    void clear()
+    {
+        body_.clear();
+        offsets_.clear();
+        errors_.clear();
+        invalid_  = 0;
+        messages_ = 0;
+    }
+
+    // 发送全部各项并等待应答，全部写入成功返回 true。
+    // 失败时 *error 为第一个失败项的错误码（连接断开时为 ERROR_SOCKET_NOT_CONNECTED），errorOf(i) 为各项的错误码
+    bool send(int sockfd, wire::FrameBuffer &rx, unsigned int *error)
+    {
+        messages_ = 0;
+        errors_.assign(offsets_.size(), 0);
+        if (invalid_ != 0)
+        {
+            setError(error, invalid_);
+            return false;
+        }
+        unsigned int      first = 0;
+        std::vector<char> rbody;
+        std::size_t       i = 0;
+        while (i < offsets_.size())
+        {
+            // 从第 i 项起尽量多地装进一个报文
+            std::size_t j = i + 1;
+            while (j < offsets_.size() && endOf(j) - offsets_[i] <= static_cast<std::size_t>(MAXMSGLEN))
+            {
+                ++j;
+            }
+            MSGHEAD head   = wire::makeHead(WRITEBPLC, "", "");
+            head.arraysize = static_cast<int>(j - i);
+            int          bytes = static_cast<int>(endOf(j - 1) - offsets_[i]);
+            MSGHEAD      reply;
+            unsigned int e = 0;
+            if (!wire::call(sockfd, rx, head, body_.data() + offsets_[i], bytes, reply, &rbody, &e) &&
+                (e == ERROR_SOCKET_NOT_CONNECTED || e == ERROR_MSGSIZE))
+            {
+                setError(error, e);
+                return false;
+            }
+            ++messages_;
+            bool perItem = rbody.size() == (j - i) * sizeof(unsigned int);
+            for (std::size_t k = i; k < j; ++k)
+            {
+                if (perItem)
+                {
+                    std::memcpy(&errors_[k], rbody.data() + (k - i) * sizeof(unsigned int), sizeof(unsigned int));
+                }
+                else
+                {
+                    errors_[k] = wire::replyOk(reply) ? 0 : (reply.error != 0 ? reply.error : ERROR_INVALID_RESPONSE);
+                }
+                if (first == 0)
+                {
+                    first = errors_[k];
+                }
+            }
+            i = j;
+        }
+        setError(error, first);
+        return first == 0;
+    }
+
+    // 上一次 send() 中第 i 项的错误码，0 为成功
+    unsigned int errorOf(std::size_t i) const { return i < errors_.size() ? errors_[i] : 0; }
+    // 上一次 send() 用了几个报文
+    int messages() const { return messages_; }
+
+private:
+    static void setError(unsigned int *error, unsigned int code)
+    {
+        if (error)
+        {
+            *error = code;
+        }
+    }
+
+    // 第 k 项在 body_ 中的结束位置
+    std::size_t endOf(std::size_t k) const { return k + 1 < offsets_.size() ? offsets_[k + 1] : body_.size(); }
+
+    // nul 为 true 时在值后补结尾 '\0'（字符串）
+    PlcBatch &put(const char *tagname, int valtype, const void *value, int size, bool nul = false)
+    {
+        int valuesize = size + (nul ? 1 : 0);
+        if (sizeof(PLCWRITE) + valuesize > static_cast<std::size_t>(MAXMSGLEN))
+        {
+            invalid_ = ERROR_PARAMETER_SIZE; // 单项放不进一个报文，send() 时报告
+            return *this;
+        }
+        PLCWRITE w;
+        std::memset(&w, 0, sizeof(w));
+        wire::copyName(w.tagname, tagname);
+        w.valtype   = valtype;
+        w.valuesize = valuesize;
+        offsets_.push_back(body_.size());
+        const char *p = reinterpret_cast<const char *>(&w);
+        body_.insert(body_.end(), p, p + sizeof(w));
+        body_.insert(body_.end(), static_cast<const char *>(value), static_cast<const char *>(value) + size);
+        if (nul)
+        {
+            body_.push_back('\0');
+        }
+        return *this;
+    }
+
+    std::vector<char>         body_;    // 按 PLCWRITE + 值依次排列的全部各项
+    std::vector<std::size_t>  offsets_; // 各项在 body_ 中的起始位置
+    std::vector<unsigned int> errors_;
+    unsigned int              invalid_  = 0;
+    int                       messages_ = 0;
+};
+
+} // namespace gplat
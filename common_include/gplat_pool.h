@@ -0,0 +1,373 @@
+#pragma once
+
+/*
+ * gplat_pool.h — higplat 连接池（单头文件）
+ *
+ * connectgplat() 返回的套接字不能多线程共用，于是每个工作线程各开一个连接，
+ * 服务端上挂着几百个大部分时间空闲的套接字。ConnectionPool 让一组工作线程
+ * 共享少量连接：借出（checkout）时独占，用完由 RAII 的 Lease 自动归还。
+ *
+ * 用法：
+ *   gplat::PoolOptions opt;
+ *   opt.server = "127.0.0.1"; opt.port = 8777;
+ *   opt.min_size = 2; opt.max_size = 8;
+ *   gplat::ConnectionPool pool(opt, connectgplat, disconnectgplat);
+ *
+ *   // 工作线程中
+ *   if (auto conn = pool.checkout(&error))
+ *   {
+ *       if (!readb(conn.fd(), "WATCHDOG", &hb, sizeof(hb), &error) && error == ERROR_SOCKET_NOT_CONNECTED)
+ *           conn.invalidate();             // 连接已坏，归还时关闭而不是放回池中
+ *   }                                      // 离开作用域自动归还
+ *
+ * 说明：
+ *   - 空闲连接按后进先出复用，热连接留在前面，多余的连接自然空闲下来，
+ *     由 maintain() 按 max_idle 关闭，并把连接数补足到 min_size；
+ *   - 空闲超过 health_check_after 的连接借出前先做健康检查，默认检查是对套接字
+ *     做一次零超时 poll：空闲的请求连接上不应有可读数据，可读即对端关闭或协议错乱；
+ *   - 连接数已达 max_size 时 checkout 最多等待 checkout_timeout，超时返回空 Lease，
+ *     *error = ETIMEDOUT；
+ *   - 订阅连接会收到服务端主动推送，不要放进连接池。
+ */
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gplat_wire.h"
+
+namespace gplat {
+
+struct PoolOptions
+{
+    std::string               server = "127.0.0.1";
+    int                       port   = 8777;
+    std::size_t               min_size = 1;   // 常驻连接数，构造时预先建立
+    std::size_t               max_size = 8;   // 连接数上限
+    std::chrono::milliseconds checkout_timeout{1000};
+    std::chrono::milliseconds health_check_after{5000}; // 空闲超过该时长，借出前先做健康检查
+    std::chrono::milliseconds max_idle{60000};          // maintain() 关闭空闲超过该时长的多余连接
+};
+
+struct PoolStats
+{
+    std::size_t   total     = 0; // 当前连接数（空闲 + 借出）
+    std::size_t   idle      = 0;
+    std::uint64_t checkouts = 0;
+    std::uint64_t waits     = 0; // 因连接数已满而等待的次数
+    std::uint64_t timeouts  = 0;
+    std::uint64_t created   = 0;
+    std::uint64_t destroyed = 0; // 含健康检查失败和 invalidate()
+};
+
+class ConnectionPool
+{
+public:
+    using ConnectFn    = std::function<int(const char *server, int port)>;
+    using DisconnectFn = std::function<void(int fd)>;
+    using HealthFn     = std::function<bool(int fd)>;
+
+    // ============================================================
+    //  Lease：借出的连接，析构时归还
+    // ============================================================
+    class Lease
+    {
+    public:
+        Lease() = default;
+        Lease(Lease &&other) noexcept : pool_(other.pool_), fd_(other.fd_), broken_(other.broken_)
+        {
+            other.pool_ = nullptr;
+            other.fd_   = -1;
+        }
+        Lease &operator=(Lease &&other) noexcept
+        {
+            if (this != &other)
+            {
+                release();
+                pool_       = other.pool_;
+                fd_         = other.fd_;
+                broken_     = other.broken_;
+                other.pool_ = nullptr;
+                other.fd_   = -1;
+            }
+            return *this;
+        }
+        Lease(const Lease &)            = delete;
+        Lease &operator=(const Lease &) = delete;
+        ~Lease() { release(); }
+
+        int fd() const { return fd_; }
+        explicit operator bool() const { return fd_ >= 0; }
+
+        // 标记连接已损坏（如返回 ERROR_SOCKET_NOT_CONNECTED），归还时关闭
+        void invalidate() { broken_ = true; }
+
+        // 提前归还
+        void release()
+        {
+            if (pool_ && fd_ >= 0)
+            {
+                pool_->giveBack(fd_, broken_);
+            }
+            pool_   = nullptr;
+            fd_     = -1;
+            broken_ = false;
+        }
+
+    private:
+        friend class ConnectionPool;
+        Lease(ConnectionPool *pool, int fd) : pool_(pool), fd_(fd) {}
+
+        ConnectionPool *pool_   = nullptr;
+        int             fd_     = -1;
+        bool            broken_ = false;
+    };
+
+    // connect/disconnect 默认直接建立/关闭 TCP 连接，也可以传入 connectgplat/disconnectgplat
+    explicit ConnectionPool(PoolOptions options, ConnectFn connect = nullptr, DisconnectFn disconnect = nullptr,
+                            HealthFn health = nullptr)
+        : options_(std::move(options)),
+          connect_(connect ? std::move(connect) : ConnectFn(defaultConnect)),
+          disconnect_(disconnect ? std::move(disconnect) : DisconnectFn(defaultDisconnect)),
+          health_(health ? std::move(health) : HealthFn(defaultHealthCheck))
+    {
+        if (options_.max_size == 0)
+        {
+            options_.max_size = 1;
+        }
+        if (options_.min_size > options_.max_size)
+        {
+            options_.min_size = options_.max_size;
+        }
+        maintain();
+    }
+
+    ConnectionPool(const ConnectionPool &)            = delete;
+    ConnectionPool &operator=(const ConnectionPool &) = delete;
+
+    // 析构前所有 Lease 必须已归还
+    ~ConnectionPool()
+    {
+        std::vector<Idle> idle;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            idle.swap(idle_);
+            total_ -= idle.size();
+        }
+        for (const auto &c : idle)
+        {
+            disconnect_(c.fd);
+        }
+    }
+
+    Lease checkout(unsigned int *error = nullptr) { return checkout(options_.checkout_timeout, error); }
+
+    Lease checkout(std::chrono::milliseconds timeout, unsigned int *error = nullptr)
+    {
+        auto deadline = Clock::now() + timeout;
+        std::unique_lock<std::mutex> lock(mutex_);
+        bool waited = false;
+        for (;;)
+        {
+            if (!idle_.empty())
+            {
+                Idle c = idle_.back();
+                idle_.pop_back();
+                if (Clock::now() - c.since < options_.health_check_after)
+                {
+                    ++checkouts_;
+                    return Lease(this, c.fd);
+                }
+                // 健康检查在锁外进行
+                lock.unlock();
+                bool healthy = health_(c.fd);
+                if (!healthy)
+                {
+                    disconnect_(c.fd);
+                }
+                lock.lock();
+                if (healthy)
+                {
+                    ++checkouts_;
+                    return Lease(this, c.fd);
+                }
+                --total_;
+                ++destroyed_;
+                continue;
+            }
+
+            if (total_ < options_.max_size)
+            {
+                ++total_; // 先占位，连接在锁外建立
+                lock.unlock();
+                int fd = connect_(options_.server.c_str(), options_.port);
+                lock.lock();
+                if (fd < 0)
+                {
+                    --total_;
+                    cv_.notify_one();
+                    setError(error, ERROR_SOCKET_NOT_CONNECTED);
+                    return Lease();
+                }
+                ++created_;
+                ++checkouts_;
+                return Lease(this, fd);
+            }
+
+            if (!waited)
+            {
+                waited = true;
+                ++waits_;
+            }
+            if (cv_.wait_until(lock, deadline) == std::cv_status::timeout && idle_.empty() &&
+                total_ >= options_.max_size)
+            {
+                ++timeouts_;
+                setError(error, ETIMEDOUT);
+                return Lease();
+            }
+        }
+    }
+
+    // 关闭空闲过久的多余连接，并把连接数补足到 min_size；可由后台线程周期调用
+    void maintain()
+    {
+        std::vector<int> expired;
+        std::size_t      missing = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto now = Clock::now();
+            // idle_ 尾部是最近归还的，从头部（最久未用）开始淘汰
+            std::size_t n = 0;
+            while (n < idle_.size() && total_ - n > options_.min_size && now - idle_[n].since >= options_.max_idle)
+            {
+                expired.push_back(idle_[n].fd);
+                ++n;
+            }
+            idle_.erase(idle_.begin(), idle_.begin() + static_cast<std::ptrdiff_t>(n));
+            total_ -= n;
+            destroyed_ += n;
+            if (total_ < options_.min_size)
+            {
+                missing = options_.min_size - total_;
+                total_ += missing;
+            }
+        }
+        for (int fd : expired)
+        {
+            disconnect_(fd);
+        }
+        for (std::size_t i = 0; i < missing; ++i)
+        {
+            int fd = connect_(options_.server.c_str(), options_.port);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (fd < 0)
+            {
+                --total_;
+                continue;
+            }
+            ++created_;
+            idle_.insert(idle_.begin(), Idle{fd, Clock::now()});
+            cv_.notify_one();
+        }
+    }
+
+    PoolStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        PoolStats s;
+        s.total     = total_;
+        s.idle      = idle_.size();
+        s.checkouts = checkouts_;
+        s.waits     = waits_;
+        s.timeouts  = timeouts_;
+        s.created   = created_;
+        s.destroyed = destroyed_;
+        return s;
+    }
+
+    const PoolOptions &options() const { return options_; }
+
+    // 默认健康检查：空闲的请求连接上不应有可读数据或挂断事件
+    static bool defaultHealthCheck(int fd)
+    {
+        pollfd pfd;
+        pfd.fd      = fd;
+        pfd.events  = POLLIN;
+        pfd.revents = 0;
+        int ready;
+        do
+        {
+            ready = ::poll(&pfd, 1, 0);
+        } while (ready < 0 && errno == EINTR);
+        return ready == 0;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Idle
+    {
+        int               fd;
+        Clock::time_point since;
+    };
+
+    static int  defaultConnect(const char *server, int port) { return wire::connectTcp(server, port, false); }
+    static void defaultDisconnect(int fd) { ::close(fd); }
+
+    static void setError(unsigned int *error, unsigned int value)
+    {
+        if (error)
+        {
+            *error = value;
+        }
+    }
+
+    void giveBack(int fd, bool broken)
+    {
+        if (broken)
+        {
+            disconnect_(fd);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (broken)
+            {
+                --total_;
+                ++destroyed_;
+            }
+            else
+            {
+                idle_.push_back(Idle{fd, Clock::now()});
+            }
+        }
+        cv_.notify_one();
+    }
+
+    PoolOptions  options_;
+    ConnectFn    connect_;
+    DisconnectFn disconnect_;
+    HealthFn     health_;
+
+    mutable std::mutex      mutex_;
+    std::condition_variable cv_;
+    std::vector<Idle>       idle_;       // 尾部为最近归还
+    std::size_t             total_     = 0;
+    std::uint64_t           checkouts_ = 0;
+    std::uint64_t           waits_     = 0;
+    std::uint64_t           timeouts_  = 0;
+    std::uint64_t           created_   = 0;
+    std::uint64_t           destroyed_ = 0;
+};
+
+} // namespace gplat
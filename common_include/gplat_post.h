@@ -0,0 +1,400 @@
+#pragma once
+
+/*
+ * gplat_post.h — 订阅推送的批量接收（单头文件）
+ *
+ * waitpostdata() 每次只返回一个 (tagname, value)，突发写入时订阅者要调用
+ * 成千上万次，每次都是一次系统调用外加 std::string 赋值。
+ * waitpostdata_multi() 用一次 recv 把套接字缓冲区中已到达的数据全部读入
+ * 调用方持有的 PostReceiver，再就地拆出尽可能多的 POST 报文，
+ * 填入调用方提供的 PostView 数组。事件只是指向接收缓冲区的视图，
+ * 整个过程没有逐事件的堆分配。
+ *
+ * 用法：
+ *   gplat::PostReceiver rx;                 // 每个连接一个，循环外创建
+ *   gplat::PostView events[256];
+ *   int n = gplat::waitpostdata_multi(conngplat, rx, events, 256, 200, &error);
+ *   for (int i = 0; i < n; ++i)
+ *       if (events[i].tagname == "WATCHDOG") hb = events[i].as<int>();
+ *
+ * 注意：
+ *   - PostView 中的指针只在下一次调用 waitpostdata_multi 之前有效；
+ *   - 同一个 fd 不要再混用 waitpostdata()，否则已读入 PostReceiver 的数据
+ *     对方是看不到的；
+ *   - 需要在订阅连接上继续订阅时用 subscribe_ex()，等待应答期间到达的推送
+ *     会留在 PostReceiver 中；选项 SUBOPT_STAMP 让服务端在推送尾部附带
+ *     写入/分发时间戳，配合 gplat_latency.h 统计端到端延迟；
+ *   - SUBOPT_SNAPSHOT 订阅时服务端先推送当前值再推送后续变化，不必再单独 readb，
+ *     也不存在"先读后订"之间漏掉写入的窗口。subscribe_batch() 一次订阅多个标签
+ *     或通配模式，SeqTracker 跟踪每个标签的序号、发现丢失，断线重连后用它续订，
+ *     服务端只补发序号有变化的标签。
+ */
+
+#include <time.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <poll.h>
+
+#include "gplat_wire.h"
+
+namespace gplat {
+
+// 一个推送事件的只读视图，指向 PostReceiver 内部
+struct PostView
+{
+    std::string_view tagname;
+    const char      *value = nullptr;
+    int              size  = 0;       // 数值长度（不含 POSTSTAMP 尾部）
+    timespec         timestamp{};
+    int              eventid = 0;
+
+    // 延迟统计用的时间戳（CLOCK_REALTIME）。服务端未附带 POSTSTAMP 时
+    // writetime 取报文头中的标签写入时间，dispatchtime 为 0
+    bool             stamped = false;
+    timespec         writetime{};
+    timespec         dispatchtime{};
+    timespec         recvtime{};     // 本地读到该报文的时刻
+
+    // 以 SUBOPT_SEQ / SUBOPT_SNAPSHOT 订阅时有效：标签的写入序号，0 表示服务端未附带
+    unsigned long long seq      = 0;
+    bool               snapshot = false; // 订阅/续订时补发的当前值
+
+    // 按定长类型取值，size 不足时高位补零
+    template <typename T>
+    T as() const
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "T 必须可平凡拷贝");
+        T v{};
+        std::memcpy(&v, value, size < static_cast<int>(sizeof(T)) ? size : sizeof(T));
+        return v;
+    }
+};
+
+// 每个连接一个的接收缓冲区。容量越大，一次 recv 能取到的事件越多
+class PostReceiver
+{
+public:
+    explicit PostReceiver(std::size_t capacity = 256 * 1024) : rx_(capacity) {}
+
+    PostReceiver(const PostReceiver &)            = delete;
+    PostReceiver &operator=(const PostReceiver &) = delete;
+
+private:
+    friend int  waitpostdata_multi(int, PostReceiver &, PostView *, int, int, unsigned int *);
+    friend bool subscribe_ex(int, PostReceiver &, const char *, int, unsigned int *);
+    friend bool subscribe_batch(int, PostReceiver &, const SUBENTRY *, int, int, unsigned int *);
+
+    wire::FrameBuffer rx_;
+    timespec          recvtime_{};   // 最近一次 recv 的时刻
+};
+
+// 从缓冲区中拆出尽可能多的 POST 报文，返回填入的个数；报文长度非法返回 -1
+inline int drainPosts(wire::FrameBuffer &rx, const timespec &recvtime, PostView *events, int maxevents,
+                      unsigned int *error)
+{
+    int count = 0;
+    wire::Frame frame;
+    while (count < maxevents && rx.next(frame, error))
+    {
+        if (frame.head.id != POST)
+        {
+            continue; // 订阅连接上不应出现其它应答，直接丢弃
+        }
+        // 标签名直接指向缓冲区中的报文头，避免拷贝
+        const char *raw_head = frame.body - wire::kHeadSize;
+        const char *tag      = raw_head + offsetof(MSGHEAD, itemname);
+
+        PostView &ev = events[count++];
+        ev.tagname   = std::string_view(tag, ::strnlen(tag, sizeof(frame.head.itemname)));
+        ev.value     = frame.body;
+        ev.size      = frame.head.bodysize;
+        ev.timestamp = frame.head.timestamp;
+        ev.eventid   = frame.head.eventid;
+        ev.recvtime  = recvtime;
+
+        POSTSEQ   seq;
+        POSTSTAMP stamp;
+        ev.size     = wire::parsePost(frame.head, frame.body, &seq, &stamp);
+        ev.seq      = seq.seq;
+        ev.snapshot = (seq.flags & POSTFLAG_SNAPSHOT) != 0;
+        ev.stamped  = ev.size != frame.head.bodysize && (frame.head.eventarg & SUBOPT_STAMP) != 0;
+        if (ev.stamped)
+        {
+            ev.writetime    = stamp.writetime;
+            ev.dispatchtime = stamp.dispatchtime;
+        }
+        else
+        {
+            ev.writetime    = frame.head.timestamp;
+            ev.dispatchtime = timespec{};
+        }
+    }
+    if (error && *error != 0)
+    {
+        return -1;
+    }
+    return count;
+}
+
+// 等待并批量取出推送事件
+//   timeout   : 毫秒，-1 表示一直等待，0 表示只取已到达的数据
+//   返回值    : >0 取到的事件数；0 超时（*error = ETIMEDOUT，与 waitpostdata 一致）；-1 出错
+inline int waitpostdata_multi(int sockfd, PostReceiver &receiver, PostView *events, int maxevents,
+                              int timeout, unsigned int *error)
+{
+    unsigned int err = 0;
+    if (maxevents <= 0)
+    {
+        err = ERROR_PARAMETER_SIZE;
+        if (error)
+        {
+            *error = err;
+        }
+        return -1;
+    }
+
+    wire::FrameBuffer &rx = receiver.rx_;
+
+    // 上次剩下的完整报文先交付，不做系统调用
+    int count = drainPosts(rx, receiver.recvtime_, events, maxevents, &err);
+    if (count != 0)
+    {
+        if (error)
+        {
+            *error = err;
+        }
+        return count;
+    }
+
+    pollfd pfd;
+    pfd.fd     = sockfd;
+    pfd.events = POLLIN;
+
+    // 一次 recv 可能只读到半个报文或只有非 POST 报文，在超时之前继续等待
+    timespec start;
+    ::clock_gettime(CLOCK_MONOTONIC, &start);
+    int remain = timeout;
+    for (;;)
+    {
+        pfd.revents = 0;
+        int ready;
+        do
+        {
+            ready = ::poll(&pfd, 1, remain);
+        } while (ready < 0 && errno == EINTR);
+
+        if (ready == 0)
+        {
+            if (error)
+            {
+                *error = ETIMEDOUT;
+            }
+            return 0;
+        }
+
+        // 一次 recv 读入所有已到达的数据
+        ssize_t n = ready < 0 ? -1 : rx.readFrom(sockfd);
+        if (n <= 0)
+        {
+            if (error)
+            {
+                *error = ERROR_SOCKET_NOT_CONNECTED;
+            }
+            return -1;
+        }
+        ::clock_gettime(CLOCK_REALTIME, &receiver.recvtime_);
+
+        count = drainPosts(rx, receiver.recvtime_, events, maxevents, &err);
+        if (count != 0 || err != 0)
+        {
+            if (error)
+            {
+                *error = err;
+            }
+            return count;
+        }
+
+        if (timeout > 0)
+        {
+            timespec now;
+            ::clock_gettime(CLOCK_MONOTONIC, &now);
+            long elapsed = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+            remain       = elapsed >= timeout ? 0 : timeout - static_cast<int>(elapsed);
+        }
+        if (remain == 0)
+        {
+            if (error)
+            {
+                *error = ETIMEDOUT; // 时间已到，半个报文留在缓冲区中，下次继续拼接
+            }
+            return 0;
+        }
+    }
+}
+
+// 在订阅连接上订阅标签并指定订阅选项（SUBOPT_*），等待应答期间到达的推送保留在 receiver 中
+inline bool subscribe_ex(int sockfd, PostReceiver &receiver, const char *tagname, int options,
+                         unsigned int *error)
+{
+    MSGHEAD head  = wire::makeHead(SUBSCRIBE, "", tagname);
+    head.eventarg = options;
+    MSGHEAD reply;
+    bool ok = wire::call(sockfd, receiver.rx_, head, nullptr, 0, reply, nullptr, error);
+    ::clock_gettime(CLOCK_REALTIME, &receiver.recvtime_);
+    return ok;
+}
+
+// 一个 SUBSCRIBE 报文最多携带的条目数
+constexpr int kMaxSubEntries = MAXMSGLEN / static_cast<int>(sizeof(SUBENTRY));
+
+inline SUBENTRY makeSubEntry(std::string_view tagname, unsigned long long lastseq = 0)
+{
+    SUBENTRY e;
+    std::memset(&e, 0, sizeof(e));
+    std::size_t n = tagname.size() < sizeof(e.tagname) - 1 ? tagname.size() : sizeof(e.tagname) - 1;
+    std::memcpy(e.tagname, tagname.data(), n);
+    e.lastseq = lastseq;
+    return e;
+}
+
+// 批量/通配订阅（见 msg.h 中 SUBENTRY 的说明），条目超过一个报文的容量时分多次发送。
+// 带 SUBOPT_SNAPSHOT 时，服务端在应答之后、任何新变化之前推送各标签的当前值
+inline bool subscribe_batch(int sockfd, PostReceiver &receiver, const SUBENTRY *entries, int count,
+                            int options, unsigned int *error)
+{
+    if (count <= 0)
+    {
+        if (error)
+        {
+            *error = ERROR_PARAMETER_SIZE;
+        }
+        return false;
+    }
+    for (int done = 0; done < count;)
+    {
+        int n = count - done < kMaxSubEntries ? count - done : kMaxSubEntries;
+        MSGHEAD head  = wire::makeHead(SUBSCRIBE, "", "");
+        head.count    = n;
+        head.eventarg = options;
+        MSGHEAD reply;
+        bool ok = wire::call(sockfd, receiver.rx_, head, reinterpret_cast<const char *>(entries + done),
+                             n * static_cast<int>(sizeof(SUBENTRY)), reply, nullptr, error);
+        ::clock_gettime(CLOCK_REALTIME, &receiver.recvtime_);
+        if (!ok)
+        {
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+// 跟踪每个标签最后收到的序号：发现丢失的变化，并在重连后生成续订条目
+class SeqTracker
+{
+public:
+    enum Result
+    {
+        kInOrder,   // 正好是下一个序号
+        kSnapshot,  // 订阅/续订补发的当前值，已与服务端对齐
+        kGap,       // 中间丢了变化（值本身仍是最新的）
+        kStale,     // 序号不大于已收到的，重复或过期，调用方应丢弃（补发的当前值除外）
+        kUntracked, // 没有序号（未以 SUBOPT_SEQ 订阅）
+    };
+
+    // 订阅的标签名或通配模式，续订时原样带上
+    void addPattern(std::string_view pattern) { patterns_.emplace_back(pattern); }
+
+    Result update(const PostView &ev)
+    {
+        if (ev.seq == 0)
+        {
+            return kUntracked;
+        }
+        auto it = last_.find(ev.tagname);
+        if (it == last_.end())
+        {
+            last_.emplace(std::string(ev.tagname), ev.seq);
+            return ev.snapshot ? kSnapshot : kInOrder;
+        }
+        unsigned long long prev = it->second;
+        if (ev.snapshot)
+        {
+            // 补发的当前值以服务端为准：服务端重启（看板在匿名内存中）或标签删除重建后序号从头计数，
+            // 比已收到的小也照收，之后的变化按新序号跟踪
+            if (ev.seq > prev + 1)
+            {
+                gaps_ += ev.seq - prev - 1;
+            }
+            it->second = ev.seq;
+            return kSnapshot;
+        }
+        if (ev.seq <= prev)
+        {
+            return kStale;
+        }
+        it->second = ev.seq;
+        if (ev.seq == prev + 1)
+        {
+            return kInOrder;
+        }
+        gaps_ += ev.seq - prev - 1;
+        return kGap;
+    }
+
+    unsigned long long lastSeq(std::string_view tagname) const
+    {
+        auto it = last_.find(tagname);
+        return it == last_.end() ? 0 : it->second;
+    }
+
+    // 累计丢失（合并到后续值里）的变化数
+    unsigned long long gaps() const { return gaps_; }
+
+    // 续订条目：每个模式一条（lastseq = 0），已跟踪的标签各一条带上最后序号，
+    // 服务端对同一标签取最大的 lastseq，只补发序号有变化的标签
+    std::vector<SUBENTRY> resumeEntries() const
+    {
+        std::vector<SUBENTRY> entries;
+        entries.reserve(patterns_.size() + last_.size());
+        for (const auto &p : patterns_)
+        {
+            entries.push_back(makeSubEntry(p));
+        }
+        for (const auto &kv : last_)
+        {
+            entries.push_back(makeSubEntry(kv.first, kv.second));
+        }
+        return entries;
+    }
+
+    void clear()
+    {
+        last_.clear();
+        gaps_ = 0;
+    }
+
+private:
+    std::vector<std::string>                                  patterns_;
+    std::map<std::string, unsigned long long, std::less<>>    last_;
+    unsigned long long                                        gaps_ = 0;
+};
+
+// 按 tracker 中记录的模式和序号订阅（首次订阅与断线重连后的续订是同一个调用）
+inline bool subscribe_resume(int sockfd, PostReceiver &receiver, const SeqTracker &tracker, int options,
+                             unsigned int *error)
+{
+    std::vector<SUBENTRY> entries = tracker.resumeEntries();
+    return subscribe_batch(sockfd, receiver, entries.data(), static_cast<int>(entries.size()),
+                           options | SUBOPT_SNAPSHOT, error);
+}
+
+} // namespace gplat
@@ -0,0 +1,126 @@
+#pragma once
+
+/*
+ * gplat_range.h — 大标签的部分读写（单头文件）
+ *
+ * higplat 的 readb / writeb 总是收发整个标签：改 12 KB 结构体标签中的一个字段要发 12 KB，
+ * 读其中一个元素也要收 12 KB。本文件按 msg.h 的"部分读写"用 head.offset / head.subsize 只收发其中一段：
+ *   - readb_range：应答 body 直接 recv 进调用方缓冲区；
+ *   - writeb_range：报文头和数据用一次 sendmsg 从调用方内存发出；
+ *   - applyPost：订阅时带 SUBOPT_RANGE，POST 只带本次改变的字节，把它合并进本地副本。
+ *
+ * 与 gplat_string.h 一样只用于不带订阅的请求连接（等待应答期间收到的 POST 会被丢弃），
+ * 订阅连接上请用 gplat_wire.h 的 wire::call 自行填 offset / subsize。
+ *
+ * 用法：
+ *   // 只改 MILL_SETUP 中第 3 机架的辊缝
+ *   gplat::writeb_range(conngplat, "MILL_SETUP", offsetof(MillSetup, stands[3].gap), &gap, sizeof(gap), &error);
+ *
+ *   float speed;
+ *   gplat::readb_range(conngplat, "MILL_SETUP", offsetof(MillSetup, stands[3].speed), &speed, sizeof(speed),
+ *                      &error);
+ *
+ *   // 订阅连接上收到 POST 后
+ *   gplat::applyPost(frame.head, frame.body, &mirror, sizeof(mirror));
+ */
+
+#include <time.h>
+
+#include <cstring>
+
+#include "gplat_string.h"
+
+namespace gplat {
+
+// 读标签中 [offset, offset + len) 到 buf；itemsize 非空时给出标签长度
+inline bool readb_range(int sockfd, const char *tagname, int offset, void *buf, int len, unsigned int *error,
+                        timespec *timestamp = nullptr, int *itemsize = nullptr)
+{
+    if (len <= 0 || len > MAXMSGLEN)
+    {
+        detail::setStringError(error, ERROR_PARAMETER_SIZE);
+        return false;
+    }
+    MSGHEAD head = wire::makeHead(READB, "", tagname);
+    head.offset  = offset;
+    head.subsize = len;
+    if (!wire::sendFrame(sockfd, head, nullptr, 0))
+    {
+        detail::setStringError(error, ERROR_SOCKET_NOT_CONNECTED);
+        return false;
+    }
+    MSGHEAD reply;
+    if (!detail::recvReplyHead(sockfd, reply, error))
+    {
+        return false;
+    }
+    if (!wire::replyOk(reply) || reply.bodysize != len)
+    {
+        detail::discardBody(sockfd, reply.bodysize);
+        detail::setStringError(error, reply.error != 0 ? reply.error : ERROR_INVALID_RESPONSE);
+        return false;
+    }
+    if (!wire::recvAll(sockfd, buf, len))
+    {
+        detail::setStringError(error, ERROR_SOCKET_NOT_CONNECTED);
+        return false;
+    }
+    if (timestamp)
+    {
+        *timestamp = reply.timestamp;
+    }
+    if (itemsize)
+    {
+        *itemsize = reply.datasize;
+    }
+    detail::setStringError(error, 0);
+    return true;
+}
+
+// 只改标签中 [offset, offset + len) 这一段，其余字节不变；标签须已存在
+inline bool writeb_range(int sockfd, const char *tagname, int offset, const void *data, int len,
+                         unsigned int *error)
+{
+    if (len <= 0 || len > MAXMSGLEN)
+    {
+        detail::setStringError(error, ERROR_PARAMETER_SIZE);
+        return false;
+    }
+    MSGHEAD head = wire::makeHead(WRITEB, "", tagname);
+    head.offset  = offset;
+    head.subsize = len;
+    iovec part   = {const_cast<void *>(data), static_cast<std::size_t>(len)};
+    if (!wire::sendFrameParts(sockfd, head, &part, 1))
+    {
+        detail::setStringError(error, ERROR_SOCKET_NOT_CONNECTED);
+        return false;
+    }
+    MSGHEAD reply;
+    if (!detail::recvReplyHead(sockfd, reply, error))
+    {
+        return false;
+    }
+    if (!detail::discardBody(sockfd, reply.bodysize))
+    {
+        detail::setStringError(error, ERROR_SOCKET_NOT_CONNECTED);
+        return false;
+    }
+    detail::setStringError(error, reply.error);
+    return wire::replyOk(reply);
+}
+
+// 把一条 POST 合并进本地副本 mirror：带 SUBOPT_RANGE 时写到 head.offset 处，否则为整个值。
+// 超出 mirrorsize 时不合并并返回 false（副本长度与标签长度不符，应重新读取整个标签）
+inline bool applyPost(const MSGHEAD &head, const char *body, void *mirror, int mirrorsize)
+{
+    int offset = (head.eventarg & SUBOPT_RANGE) != 0 ? head.offset : 0;
+    int size   = wire::parsePost(head, body, nullptr, nullptr);
+    if (offset < 0 || size < 0 || size > mirrorsize - offset)
+    {
+        return false;
+    }
+    std::memcpy(static_cast<char *>(mirror) + offset, body, size);
+    return true;
+}
+
+} // namespace gplat
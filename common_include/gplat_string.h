@@ -0,0 +1,234 @@
+#pragma once
+
+/*
+ * gplat_string.h — 字符串标签的零拷贝读写（单头文件）
+ *
+ * higplat 的 writeb_string2 按值接收 std::string，readb_string2 写入 std::string&，
+ * 每次调用至少一次堆分配和一次拷贝；跟踪类标签（卷号、钢种、操作工号……）读写频繁，这部分开销很可观。
+ * 本文件按 msg.h 协议直接收发 WRITEBSTRING / WRITEBSTRINGPLC / READBSTRING：
+ *   - 写：接收 std::string_view，报文头、字符串和结尾 '\0' 用一次 sendmsg 从调用方内存发出，不分配、不拷贝；
+ *   - 读：应答 body 直接 recv 进调用方提供的缓冲区，或复用 std::string 已有的容量（容量够时不分配）。
+ *
+ * 与 higplat 的同步接口一样，只用于不带订阅的请求连接：等待应答期间收到的 POST 报文会被丢弃，
+ * 订阅连接上请用 gplat_wire.h 的 wire::call。字符串中不能含 '\0'（服务端按 C 字符串保存）。
+ *
+ * 用法：
+ *   gplat::writeb_string(conngplat, "COIL_ID", std::string_view(coil, n), &error);
+ *
+ *   char buf[64];
+ *   int  len = 0;
+ *   gplat::readb_string(conngplat, "COIL_ID", buf, sizeof(buf), &len, &error);
+ *
+ *   std::string grade;                          // 循环外定义，容量跨调用复用
+ *   gplat::readb_string(conngplat, "GRADE", grade, &error);
+ */
+
+#include <time.h>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "gplat_wire.h"
+
+#ifndef ERROR_BUFFER_TOO_SMALL
+#define ERROR_BUFFER_TOO_SMALL          41
+#endif
+
+namespace gplat {
+
+namespace detail {
+
+inline void setStringError(unsigned int *error, unsigned int code)
+{
+    if (error)
+    {
+        *error = code;
+    }
+}
+
+// 丢弃 n 字节报文内容
+inline bool discardBody(int sockfd, int n)
+{
+    char scratch[1024];
+    while (n > 0)
+    {
+        int chunk = n < static_cast<int>(sizeof(scratch)) ? n : static_cast<int>(sizeof(scratch));
+        if (!wire::recvAll(sockfd, scratch, chunk))
+        {
+            return false;
+        }
+        n -= chunk;
+    }
+    return true;
+}
+
+// 收下一个应答的报文头，跳过其间的 POST；body 留在套接字中由调用方读取
+inline bool recvReplyHead(int sockfd, MSGHEAD &head, unsigned int *error)
+{
+    for (;;)
+    {
+        if (!wire::recvAll(sockfd, &head, wire::kHeadSize))
+        {
+            setStringError(error, ERROR_SOCKET_NOT_CONNECTED);
+            return false;
+        }
+        if (head.bodysize < 0 || head.bodysize > MAXMSGLEN)
+        {
+            setStringError(error, ERROR_MSGSIZE);
+            return false;
+        }
+        if (head.id != POST)
+        {
+            return true;
+        }
+        if (!discardBody(sockfd, head.bodysize))
+        {
+            setStringError(error, ERROR_SOCKET_NOT_CONNECTED);
+            return false;
+        }
+    }
+}
+
+inline bool writeString(int sockfd, int id, const char *tagname, std::string_view value, unsigned int *error)
+{
+    if (value.size() + 1 > static_cast<std::size_t>(MAXMSGLEN))
+    {
+        setStringError(error, ERROR_PARAMETER_SIZE);
+        return false;
+    }
+    MSGHEAD head  = wire::makeHead(id, "", tagname);
+    head.datasize = static_cast<int>(value.size());
+
+    static const char kNul = '\0';
+    iovec parts[2] = {
+        {const_cast<char *>(value.data()), value.size()},
+        {const_cast<char *>(&kNul), 1},
+    };
+    if (!wire::sendFrameParts(sockfd, head, parts, 2))
+    {
+        setStringError(error, ERROR_SOCKET_NOT_CONNECTED);
+        return false;
+    }
+
+    MSGHEAD reply;
+    if (!recvReplyHead(sockfd, reply, error))
+    {
+        return false;
+    }
+    if (!discardBody(sockfd, reply.bodysize))
+    {
+        setStringError(error, ERROR_SOCKET_NOT_CONNECTED);
+        return false;
+    }
+    setStringError(error, reply.error);
+    return wire::replyOk(reply);
+}
+
+// 发出 READBSTRING 并收下应答头；成功时 body（字符串 + '\0'）留在套接字中
+inline bool requestString(int sockfd, const char *tagname, MSGHEAD &reply, unsigned int *error)
+{
+    MSGHEAD head = wire::makeHead(READBSTRING, "", tagname);
+    if (!wire::sendFrame(sockfd, head, nullptr, 0))
+    {
+        setStringError(error, ERROR_SOCKET_NOT_CONNECTED);
+        return false;
+    }
+    if (!recvReplyHead(sockfd, reply, error))
+    {
+        return false;
+    }
+    if (!wire::replyOk(reply))
+    {
+        setStringError(error, reply.error);
+        discardBody(sockfd, reply.bodysize);
+        return false;
+    }
+    return true;
+}
+
+} // namespace detail
+
+// ============================================================
+//  写
+// ============================================================
+
+inline bool writeb_string(int sockfd, const char *tagname, std::string_view value, unsigned int *error)
+{
+    return detail::writeString(sockfd, WRITEBSTRING, tagname, value, error);
+}
+
+inline bool write_plc_string(int sockfd, const char *tagname, std::string_view value, unsigned int *error)
+{
+    return detail::writeString(sockfd, WRITEBSTRINGPLC, tagname, value, error);
+}
+
+// ============================================================
+//  读
+// ============================================================
+
+// 读入调用方缓冲区（含结尾 '\0'），*length 为字符串长度。
+// 缓冲区放不下时返回 false、*error = ERROR_BUFFER_TOO_SMALL，*length 给出实际长度
+inline bool readb_string(int sockfd, const char *tagname, char *buf, int bufsize, int *length,
+                         unsigned int *error, timespec *timestamp = nullptr)
+{
+    MSGHEAD reply;
+    if (!detail::requestString(sockfd, tagname, reply, error))
+    {
+        return false;
+    }
+    int n = reply.bodysize;
+    if (length)
+    {
+        *length = n > 0 ? n - 1 : 0;
+    }
+    if (n > bufsize)
+    {
+        detail::discardBody(sockfd, n);
+        detail::setStringError(error, ERROR_BUFFER_TOO_SMALL);
+        return false;
+    }
+    if (!wire::recvAll(sockfd, buf, n))
+    {
+        detail::setStringError(error, ERROR_SOCKET_NOT_CONNECTED);
+        return false;
+    }
+    if (n == 0 && bufsize > 0)
+    {
+        buf[0] = '\0';
+    }
+    if (timestamp)
+    {
+        *timestamp = reply.timestamp;
+    }
+    detail::setStringError(error, 0);
+    return true;
+}
+
+// 读入 value，复用其已有容量：容量足够时不分配内存
+inline bool readb_string(int sockfd, const char *tagname, std::string &value, unsigned int *error,
+                         timespec *timestamp = nullptr)
+{
+    MSGHEAD reply;
+    if (!detail::requestString(sockfd, tagname, reply, error))
+    {
+        return false;
+    }
+    int n = reply.bodysize;
+    value.resize(n > 0 ? n : 0); // body 含结尾 '\0'，std::string 自带一个，读完再截掉
+    if (n > 0 && !wire::recvAll(sockfd, &value[0], n))
+    {
+        value.clear();
+        detail::setStringError(error, ERROR_SOCKET_NOT_CONNECTED);
+        return false;
+    }
+    value.resize(::strnlen(value.data(), value.size()));
+    if (timestamp)
+    {
+        *timestamp = reply.timestamp;
+    }
+    detail::setStringError(error, 0);
+    return true;
+}
+
+} // namespace gplat
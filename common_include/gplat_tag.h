@@ -0,0 +1,139 @@
+#pragma once
+
+/*
+ * gplat_tag.h — 强类型标签（单头文件）
+ *
+ * higplat 的接口都是 void* value + int actsize，类型和长度全靠调用方自觉；
+ * write_plc_int / write_plc_float ... 每个函数还要配一个 = delete 的模板挡住隐式转换。
+ * gplat::Tag<T> 把标签名和值类型绑在一起：
+ *   - 编译期检查：T 必须可平凡拷贝、不是指针、长度不超过一个报文，标签名不超过 39 个字符；
+ *   - 长度取 sizeof(T)，是编译期常量，调用方不再传 actsize；
+ *   - 写入只接受 T 本身，其它类型（包括可隐式转换的）在编译期报错；
+ *   - 所有成员都是对 C 接口的内联转发，与直接调用 readb/writeb 生成相同的代码。
+ *
+ * 用法：
+ *   constexpr gplat::Tag<int>   kWatchdog{"WATCHDOG"};
+ *   constexpr gplat::Tag<float> kSpeed{"SPEED"};
+ *
+ *   int hb = 0;
+ *   kWatchdog.read(conngplat, hb, &error);
+ *   kWatchdog.write(conngplat, hb + 1, &error);
+ *   kSpeed.write(conngplat, 1.5, &error);     // 编译错误：double 不是 float
+ *   kSpeed.writePlc(conngplat, 1.5f, &error); // 选择 write_plc_float
+ */
+
+#include <time.h>
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+
+#include "higplat.h"
+#include "msg.h"
+
+namespace gplat {
+
+template <typename T>
+class Tag
+{
+    static_assert(std::is_trivially_copyable_v<T>, "标签值类型必须可平凡拷贝，字符串请用 std::array<char, N>");
+    static_assert(!std::is_pointer_v<T>, "标签值类型不能是指针");
+    static_assert(sizeof(T) <= MAXMSGLEN, "标签值超过一个报文的长度");
+
+public:
+    using value_type = T;
+
+    static constexpr int kSize = static_cast<int>(sizeof(T));
+    static constexpr std::size_t kMaxName = sizeof(MSGHEAD::itemname); // 含结尾 '\0'
+
+    // 只接受字符串字面量（或 constexpr 字符数组），长度在编译期检查
+    template <std::size_t N>
+    constexpr Tag(const char (&name)[N]) : name_(name), length_(N - 1)
+    {
+        static_assert(N <= kMaxName, "标签名超过 39 个字符");
+    }
+
+    constexpr const char      *name() const { return name_; }
+    constexpr std::string_view view() const { return std::string_view(name_, length_); }
+
+    // ---------------- 远程（经 higplat 服务端） ----------------
+
+    bool read(int sockfd, T &value, unsigned int *error, timespec *timestamp = nullptr) const
+    {
+        return ::readb(sockfd, name_, std::addressof(value), kSize, error, timestamp);
+    }
+
+    bool write(int sockfd, const T &value, unsigned int *error) const
+    {
+        // writeb 的参数不是 const，但不会修改数据
+        return ::writeb(sockfd, name_, const_cast<T *>(std::addressof(value)), kSize, error);
+    }
+    template <typename U>
+    bool write(int sockfd, const U &value, unsigned int *error) const = delete;
+
+    // 按 T 在编译期选择对应的 write_plc_*，不支持的类型编译报错
+    bool writePlc(int sockfd, T value, unsigned int *error) const
+    {
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            return ::write_plc_bool(sockfd, name_, value, error);
+        }
+        else if constexpr (std::is_same_v<T, short>)
+        {
+            return ::write_plc_short(sockfd, name_, value, error);
+        }
+        else if constexpr (std::is_same_v<T, unsigned short>)
+        {
+            return ::write_plc_ushort(sockfd, name_, value, error);
+        }
+        else if constexpr (std::is_same_v<T, int>)
+        {
+            return ::write_plc_int(sockfd, name_, value, error);
+        }
+        else if constexpr (std::is_same_v<T, unsigned int>)
+        {
+            return ::write_plc_uint(sockfd, name_, value, error);
+        }
+        else if constexpr (std::is_same_v<T, float>)
+        {
+            return ::write_plc_float(sockfd, name_, value, error);
+        }
+        else
+        {
+            static_assert(sizeof(T) == 0, "PLC 写入只支持 bool/short/ushort/int/uint/float");
+            return false;
+        }
+    }
+    template <typename U>
+    bool writePlc(int sockfd, U value, unsigned int *error) const = delete;
+
+    bool create(int sockfd, unsigned int *error) const
+    {
+        return ::createtag(sockfd, name_, kSize, nullptr, 0, error);
+    }
+
+    bool subscribe(int sockfd, unsigned int *error) const { return ::subscribe(sockfd, name_, error); }
+
+    // ---------------- 本地（进程内直接访问看板） ----------------
+
+    bool readLocal(const char *board, T &value, timespec *timestamp = nullptr) const
+    {
+        return ::ReadB(board, name_, std::addressof(value), kSize, timestamp);
+    }
+
+    bool writeLocal(const char *board, const T &value) const
+    {
+        return ::WriteB(board, name_, const_cast<T *>(std::addressof(value)), kSize);
+    }
+    template <typename U>
+    bool writeLocal(const char *board, const U &value) const = delete;
+
+    bool createLocal(const char *board) const { return ::CreateItem(board, name_, kSize); }
+
+private:
+    const char *name_;
+    std::size_t length_;
+};
+
+} // namespace gplat
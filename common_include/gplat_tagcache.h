@@ -0,0 +1,651 @@
+#pragma once
+
+/*
+ * gplat_tagcache.h — 由订阅保持一致的本地标签缓存（单头文件，按需启用）
+ *
+ * 不少服务每秒上千次 readb 同一批变化很慢的配置标签，每次都是一次网络往返。
+ * TagCache 在第一次读某个标签时在后台订阅它（SUBOPT_SNAPSHOT | SUBOPT_SEQ，服务端先推送当前值），
+ * 之后的读直接从进程内存返回，标签的变化经订阅推送进来，读路径上没有任何服务端交互。
+ *
+ * 陈旧度上限 max_age：
+ *   订阅只在标签变化时才有推送，"没收到推送"既可能是没变，也可能是连接卡住了。
+ *   接收线程每 heartbeat 发一个 WATCHDOG 请求，服务端按序处理，收到其应答说明发出时刻之前的写入
+ *   都已推送到位，缓存的全部值至少新到该时刻。读的时候若 max(最近一次推送, 最近一次确认) 距今超过
+ *   max_age（或连接断开），这次读不走缓存，而是等下一次确认（最多 read_timeout）后再返回。
+ *
+ * 用法：
+ *   gplat::TagCacheOptions opt;
+ *   opt.server = "127.0.0.1"; opt.port = 8777; opt.max_age_ms = 500;
+ *   gplat::TagCache cache(opt);
+ *
+ *   double limit = 0;
+ *   cache.read("CFG_SPEED_LIMIT", limit, &error);      // 首次：订阅并等待快照
+ *   cache.read("CFG_SPEED_LIMIT", limit, &error);      // 之后：进程内存，几十纳秒
+ *   auto s = cache.stats();                             // 命中 / 未命中 / 过期等待 / 推送次数
+ *
+ * 说明：
+ *   - 读路径只在查表时取一次共享锁；值的拷贝用每个标签一个的顺序锁（seqlock），接收线程是唯一的写者，
+ *     读者拷贝后校验版本号，不与推送互斥；
+ *   - 标签不存在时同样缓存"不存在"（ERROR_ITEM_NOT_EXIST），之后创建并写入会经推送变为可读；
+ *   - 断线后每秒重连，按各标签最后的序号批量续订，服务端只补发有变化的标签；
+ *   - 服务端删除标签不会推送，缓存保留最后的值，直到 forget() 或重新创建写入。
+ */
+
+#include <poll.h>
+#include <time.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "gplat_wire.h"
+
+#ifndef ERROR_RECORDSIZE
+#define ERROR_RECORDSIZE                14
+#endif
+#ifndef ERROR_ITEM_NOT_EXIST
+#define ERROR_ITEM_NOT_EXIST            28
+#endif
+
+namespace gplat {
+
+struct TagCacheOptions
+{
+    std::string server          = "127.0.0.1";
+    int         port            = 8777;
+    int         max_age_ms      = 1000; // 缓存值的最大陈旧度
+    int         heartbeat_ms    = 0;    // 确认间隔，0 为 max_age_ms / 2
+    int         read_timeout_ms = 1000; // 首次读等快照、过期后等确认的超时
+};
+
+struct TagCacheStats
+{
+    uint64_t    hits       = 0; // 直接从缓存返回
+    uint64_t    misses     = 0; // 第一次读，订阅并等待快照
+    uint64_t    stale      = 0; // 超过 max_age，等待确认后返回
+    uint64_t    timeouts   = 0; // 等待快照 / 确认超时
+    uint64_t    posts      = 0; // 收到的推送
+    uint64_t    reconnects = 0; // 订阅连接断开次数
+    std::size_t tags       = 0; // 已缓存的标签数
+};
+
+class TagCache
+{
+public:
+    explicit TagCache(TagCacheOptions options) : options_(std::move(options))
+    {
+        if (options_.max_age_ms <= 0)
+        {
+            options_.max_age_ms = 1;
+        }
+        if (options_.heartbeat_ms <= 0)
+        {
+            options_.heartbeat_ms = options_.max_age_ms / 2 > 10 ? options_.max_age_ms / 2 : 10;
+        }
+        thread_ = std::thread(&TagCache::run, this);
+    }
+
+    ~TagCache()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+            if (fd_ >= 0)
+            {
+                ::shutdown(fd_, SHUT_RDWR); // 唤醒接收线程
+            }
+        }
+        cv_.notify_all();
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
+
+    TagCache(const TagCache &)            = delete;
+    TagCache &operator=(const TagCache &) = delete;
+
+    // 读标签值，actsize 须等于标签长度（与 READB 的长度检查一致）
+    bool readb(const char *tagname, void *value, int actsize, unsigned int *error, timespec *timestamp = nullptr)
+    {
+        Entry *e = find(tagname);
+        if (e != nullptr)
+        {
+            int r = probe(*e, value, actsize, timestamp, error);
+            if (r != kNotFresh)
+            {
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return r == kFresh;
+            }
+        }
+        return readSlow(tagname, value, actsize, timestamp, error);
+    }
+
+    template <typename T>
+    bool read(const char *tagname, T &value, unsigned int *error, timespec *timestamp = nullptr)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "T 必须可平凡拷贝");
+        return readb(tagname, &value, static_cast<int>(sizeof(T)), error, timestamp);
+    }
+
+    // 不再缓存该标签，撤销订阅
+    void forget(const char *tagname)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::unique_lock<std::shared_mutex> map_lock(map_mutex_);
+        auto it = map_.find(tagname);
+        if (it == map_.end())
+        {
+            return;
+        }
+        map_.erase(it); // Entry 本身保留到析构，读者可能仍持有指针
+        if (fd_ >= 0)
+        {
+            // 应答按普通请求排队，免得与后续应答错位
+            MSGHEAD head = wire::makeHead(CANCELSUBSCRIBE, "", tagname);
+            if (wire::sendFrame(fd_, head, nullptr, 0))
+            {
+                pending_.push_back(Pending{Pending::kOther, nullptr, 0});
+            }
+        }
+    }
+
+    TagCacheStats stats() const
+    {
+        TagCacheStats s;
+        s.hits       = hits_.load(std::memory_order_relaxed);
+        s.misses     = misses_.load(std::memory_order_relaxed);
+        s.stale      = stale_.load(std::memory_order_relaxed);
+        s.timeouts   = timeouts_.load(std::memory_order_relaxed);
+        s.posts      = posts_.load(std::memory_order_relaxed);
+        s.reconnects = reconnects_.load(std::memory_order_relaxed);
+        std::shared_lock<std::shared_mutex> lock(map_mutex_);
+        s.tags = map_.size();
+        return s;
+    }
+
+private:
+    enum State
+    {
+        kPending = 0, // 已订阅，等待快照
+        kReady,       // 有值
+        kAbsent,      // 服务端确认标签不存在
+    };
+
+    enum Probe
+    {
+        kFresh,
+        kFreshAbsent,
+        kNotFresh,
+    };
+
+    struct Entry
+    {
+        std::string            name;
+        std::atomic<uint32_t>  version{0}; // 顺序锁版本号，奇数表示正在写
+        std::atomic<char *>    data{nullptr};
+        std::atomic<int>       size{0};
+        timespec               timestamp{};
+        std::atomic<int>       state{kPending};
+        std::atomic<int64_t>   updated_ns{0}; // 最近一次收到推送（或确认不存在）的时刻
+        int64_t                created_ns = 0; // 建立时刻，持 mutex_ 访问
+
+        // 以下只由接收线程访问
+        unsigned long long                   lastseq  = 0;
+        int                                  capacity = 0;
+        std::vector<std::unique_ptr<char[]>> buffers; // 扩容后旧缓冲保留，读者可能仍在拷贝
+    };
+
+    struct Pending
+    {
+        enum Kind
+        {
+            kSubscribe, // 单个标签订阅
+            kHeartbeat, // WATCHDOG 确认
+            kResume,    // 重连后批量续订的最后一帧，应答同样是一次确认
+            kOther,
+        };
+        Kind    kind;
+        Entry  *entry;
+        int64_t sent_ns;
+    };
+
+    static int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    static void setError(unsigned int *error, unsigned int value)
+    {
+        if (error)
+        {
+            *error = value;
+        }
+    }
+
+    Entry *find(const char *tagname) const
+    {
+        // 查表键复用线程内的 std::string，命中路径上不分配内存
+        thread_local std::string key;
+        key.assign(tagname);
+        std::shared_lock<std::shared_mutex> lock(map_mutex_);
+        auto it = map_.find(key);
+        return it == map_.end() ? nullptr : it->second;
+    }
+
+    bool fresh(const Entry &e) const
+    {
+        if (!connected_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        int64_t updated   = e.updated_ns.load(std::memory_order_acquire);
+        int64_t confirmed = confirmed_ns_.load(std::memory_order_acquire);
+        int64_t since     = updated > confirmed ? updated : confirmed;
+        return nowNs() - since <= static_cast<int64_t>(options_.max_age_ms) * 1000000;
+    }
+
+    // 无锁读：顺序锁拷贝，版本号前后一致才算成功
+    int probe(const Entry &e, void *value, int actsize, timespec *timestamp, unsigned int *error) const
+    {
+        int state = e.state.load(std::memory_order_acquire);
+        if (state == kPending || !fresh(e))
+        {
+            return kNotFresh;
+        }
+        if (state == kAbsent)
+        {
+            setError(error, ERROR_ITEM_NOT_EXIST);
+            return kFreshAbsent;
+        }
+        for (;;)
+        {
+            uint32_t v1 = e.version.load(std::memory_order_acquire);
+            if (v1 & 1u)
+            {
+                continue;
+            }
+            int size = e.size.load(std::memory_order_relaxed);
+            if (size != actsize)
+            {
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (e.version.load(std::memory_order_relaxed) != v1)
+                {
+                    continue;
+                }
+                setError(error, ERROR_RECORDSIZE);
+                return kFreshAbsent;
+            }
+            std::memcpy(value, e.data.load(std::memory_order_relaxed), size);
+            timespec ts = e.timestamp;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (e.version.load(std::memory_order_relaxed) == v1)
+            {
+                if (timestamp)
+                {
+                    *timestamp = ts;
+                }
+                setError(error, 0);
+                return kFresh;
+            }
+        }
+    }
+
+    bool readSlow(const char *tagname, void *value, int actsize, timespec *timestamp,
+                  unsigned int *error)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Entry *e = find(tagname); // 持锁重查：可能刚被其它线程建立，或已被 forget()
+        if (e == nullptr)
+        {
+            if (std::strlen(tagname) >= sizeof(MSGHEAD::itemname))
+            {
+                setError(error, ERROR_INVALID_PARAMETER);
+                return false;
+            }
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            auto owned  = std::make_unique<Entry>();
+            owned->name       = tagname;
+            owned->created_ns = nowNs();
+            e           = owned.get();
+            entries_.push_back(std::move(owned));
+            {
+                std::unique_lock<std::shared_mutex> map_lock(map_mutex_);
+                map_.emplace(e->name, e);
+            }
+            if (fd_ >= 0)
+            {
+                sendSubscribeLocked(e); // 未连通时由重连后的批量续订补上
+            }
+        }
+        else
+        {
+            stale_.fetch_add(1, std::memory_order_relaxed);
+            if (fd_ >= 0 && !confirm_outstanding_)
+            {
+                sendConfirmLocked();
+            }
+        }
+
+        int  result   = kNotFresh;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options_.read_timeout_ms);
+        cv_.wait_until(lock, deadline, [&]() {
+            result = probe(*e, value, actsize, timestamp, error);
+            return result != kNotFresh || !running_;
+        });
+        if (result == kNotFresh)
+        {
+            timeouts_.fetch_add(1, std::memory_order_relaxed);
+            setError(error, fd_ >= 0 ? static_cast<unsigned int>(ETIMEDOUT) : ERROR_SOCKET_NOT_CONNECTED);
+            return false;
+        }
+        return result == kFresh;
+    }
+
+    // ---------------- 发送（调用方持有 mutex_） ----------------
+
+    void sendSubscribeLocked(Entry *e)
+    {
+        MSGHEAD head  = wire::makeHead(SUBSCRIBE, "", e->name.c_str());
+        head.eventarg = SUBOPT_SNAPSHOT | SUBOPT_SEQ;
+        int64_t sent  = nowNs();
+        if (wire::sendFrame(fd_, head, nullptr, 0))
+        {
+            pending_.push_back(Pending{Pending::kSubscribe, e, sent});
+        }
+    }
+
+    void sendConfirmLocked()
+    {
+        MSGHEAD head = wire::makeHead(WATCHDOG, "", "");
+        int64_t sent = nowNs();
+        if (wire::sendFrame(fd_, head, nullptr, 0))
+        {
+            pending_.push_back(Pending{Pending::kHeartbeat, nullptr, sent});
+            confirm_outstanding_ = true;
+        }
+    }
+
+    // 重连后按最后的序号批量续订；最后一帧的应答同样作为一次确认
+    void resubscribeAllLocked()
+    {
+        constexpr int kPerFrame = MAXMSGLEN / static_cast<int>(sizeof(SUBENTRY));
+        std::vector<SUBENTRY> batch;
+        {
+            std::shared_lock<std::shared_mutex> map_lock(map_mutex_);
+            batch.reserve(map_.size());
+            for (auto &kv : map_)
+            {
+                SUBENTRY s;
+                std::memset(&s, 0, sizeof(s));
+                wire::copyName(s.tagname, kv.first.c_str());
+                s.lastseq = kv.second->state.load() == kReady ? kv.second->lastseq : 0;
+                batch.push_back(s);
+            }
+        }
+        for (std::size_t i = 0; i < batch.size(); i += kPerFrame)
+        {
+            int     n     = static_cast<int>(std::min<std::size_t>(kPerFrame, batch.size() - i));
+            MSGHEAD head  = wire::makeHead(SUBSCRIBE, "", "");
+            head.eventarg = SUBOPT_SNAPSHOT | SUBOPT_SEQ;
+            head.count    = n;
+            int64_t sent  = nowNs();
+            if (!wire::sendFrame(fd_, head, batch.data() + i, n * static_cast<int>(sizeof(SUBENTRY))))
+            {
+                return;
+            }
+            // 只有最后一帧的应答到达时，全部续订的补发才都已收到
+            bool last = i + n >= batch.size();
+            pending_.push_back(Pending{last ? Pending::kResume : Pending::kOther, nullptr, sent});
+        }
+        if (batch.empty())
+        {
+            sendConfirmLocked();
+        }
+    }
+
+    // ---------------- 接收线程 ----------------
+
+    void run()
+    {
+        wire::FrameBuffer rx(256 * 1024);
+        while (true)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!running_)
+                {
+                    return;
+                }
+            }
+            int fd = wire::connectTcp(options_.server.c_str(), options_.port, false);
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (!running_)
+                {
+                    if (fd >= 0)
+                    {
+                        ::close(fd);
+                    }
+                    return;
+                }
+                if (fd < 0)
+                {
+                    cv_.wait_for(lock, std::chrono::seconds(1), [this]() { return !running_; });
+                    continue;
+                }
+                fd_ = fd;
+                resubscribeAllLocked();
+            }
+            // 续订的应答到达前 confirmed_ns_ 还停在断线前：缓存值至少新到那一刻，超过 max_age 的读会等这次确认
+            connected_.store(true, std::memory_order_release);
+
+            rx.clear();
+            readLoop(fd, rx);
+
+            connected_.store(false, std::memory_order_release);
+            std::lock_guard<std::mutex> lock(mutex_);
+            ::close(fd_);
+            fd_ = -1;
+            pending_.clear();
+            confirm_outstanding_ = false;
+            if (running_)
+            {
+                reconnects_.fetch_add(1, std::memory_order_relaxed);
+            }
+            cv_.notify_all();
+        }
+    }
+
+    void readLoop(int fd, wire::FrameBuffer &rx)
+    {
+        int64_t     next_confirm = nowNs() + static_cast<int64_t>(options_.heartbeat_ms) * 1000000;
+        wire::Frame frame;
+        unsigned int error = 0;
+        while (true)
+        {
+            int64_t now = nowNs();
+            if (now >= next_confirm)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!confirm_outstanding_)
+                {
+                    sendConfirmLocked();
+                }
+                next_confirm = now + static_cast<int64_t>(options_.heartbeat_ms) * 1000000;
+            }
+            pollfd  pfd{fd, POLLIN, 0};
+            int64_t wait_ns = next_confirm - now;
+            timespec ts{static_cast<time_t>(wait_ns / 1000000000), static_cast<long>(wait_ns % 1000000000)};
+            int r = ::ppoll(&pfd, 1, &ts, nullptr);
+            if (r < 0 && errno != EINTR)
+            {
+                return;
+            }
+            if (r <= 0)
+            {
+                continue;
+            }
+            if (rx.readFrom(fd) <= 0)
+            {
+                return;
+            }
+            bool changed = false;
+            while (rx.next(frame, &error))
+            {
+                if (frame.head.id == POST)
+                {
+                    onPost(frame);
+                }
+                else
+                {
+                    onReply(frame);
+                }
+                changed = true;
+            }
+            if (error != 0)
+            {
+                return; // 报文非法，断开重连
+            }
+            if (changed)
+            {
+                // 与 readSlow() 中 wait 的谓词检查配对，持锁通知以免丢唤醒
+                std::lock_guard<std::mutex> lock(mutex_);
+                cv_.notify_all();
+            }
+        }
+    }
+
+    void onPost(const wire::Frame &frame)
+    {
+        posts_.fetch_add(1, std::memory_order_relaxed);
+        char name[sizeof(frame.head.itemname) + 1];
+        std::size_t n = ::strnlen(frame.head.itemname, sizeof(frame.head.itemname));
+        std::memcpy(name, frame.head.itemname, n);
+        name[n]  = '\0';
+        Entry *e = find(name);
+        if (e == nullptr)
+        {
+            return;
+        }
+        POSTSEQ seq{};
+        int     size = wire::parsePost(frame.head, frame.body, &seq, nullptr);
+
+        char *buf = e->data.load(std::memory_order_relaxed);
+        if (size > e->capacity)
+        {
+            int cap = e->capacity > 0 ? e->capacity : 16;
+            while (cap < size)
+            {
+                cap *= 2;
+            }
+            e->buffers.push_back(std::make_unique<char[]>(cap));
+            buf         = e->buffers.back().get();
+            e->capacity = cap;
+        }
+
+        uint32_t v = e->version.load(std::memory_order_relaxed);
+        e->version.store(v + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(buf, frame.body, size);
+        e->data.store(buf, std::memory_order_relaxed);
+        e->size.store(size, std::memory_order_relaxed);
+        e->timestamp = frame.head.timestamp;
+        e->version.store(v + 2, std::memory_order_release);
+
+        e->lastseq = seq.seq;
+        e->updated_ns.store(nowNs(), std::memory_order_release);
+        e->state.store(kReady, std::memory_order_release);
+    }
+
+    void onReply(const wire::Frame &frame)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.empty())
+        {
+            return;
+        }
+        Pending p = pending_.front();
+        pending_.pop_front();
+        switch (p.kind)
+        {
+        case Pending::kSubscribe:
+            // 快照（若有）排在应答之前；应答到达时仍没有值，说明标签不存在
+            if (p.entry->state.load(std::memory_order_relaxed) == kPending)
+            {
+                p.entry->state.store(kAbsent, std::memory_order_release);
+            }
+            if (p.entry->updated_ns.load(std::memory_order_relaxed) < p.sent_ns)
+            {
+                p.entry->updated_ns.store(p.sent_ns, std::memory_order_release);
+            }
+            break;
+        case Pending::kResume:
+            // 续订前建立、至今没有值的标签不存在；续订之后新建的标签等各自的订阅应答
+            {
+                std::shared_lock<std::shared_mutex> map_lock(map_mutex_);
+                for (auto &kv : map_)
+                {
+                    Entry *e = kv.second;
+                    if (e->created_ns <= p.sent_ns && e->state.load(std::memory_order_relaxed) == kPending)
+                    {
+                        e->updated_ns.store(p.sent_ns, std::memory_order_release);
+                        e->state.store(kAbsent, std::memory_order_release);
+                    }
+                }
+            }
+            [[fallthrough]];
+        case Pending::kHeartbeat:
+            if (p.kind == Pending::kHeartbeat)
+            {
+                confirm_outstanding_ = false;
+            }
+            if (wire::replyOk(frame.head))
+            {
+                confirmed_ns_.store(p.sent_ns, std::memory_order_release);
+            }
+            break;
+        case Pending::kOther:
+            break;
+        }
+    }
+
+    TagCacheOptions options_;
+
+    mutable std::shared_mutex               map_mutex_; // 保护 map_
+    std::unordered_map<std::string, Entry *> map_;
+
+    std::mutex                          mutex_; // 保护以下成员及套接字写
+    std::condition_variable             cv_;
+    bool                                running_             = true;
+    int                                 fd_                  = -1;
+    bool                                confirm_outstanding_ = false;
+    std::deque<Pending>                 pending_;
+    std::deque<std::unique_ptr<Entry>>  entries_;
+
+    std::atomic<bool>     connected_{false};
+    std::atomic<int64_t>  confirmed_ns_{0};
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> stale_{0};
+    std::atomic<uint64_t> timeouts_{0};
+    std::atomic<uint64_t> posts_{0};
+    std::atomic<uint64_t> reconnects_{0};
+    std::thread           thread_;
+};
+
+} // namespace gplat
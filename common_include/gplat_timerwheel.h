@@ -0,0 +1,316 @@
+#pragma once
+
+/*
+ * gplat_timerwheel.h — 分层时间轮（单头文件）
+ *
+ * subscribedelaypost 的延时推送引擎。几万个逐卷（per-coil）超时同时挂起时，
+ * 有序链表/红黑树的插入和取消都是 O(log n) 甚至 O(n)，而时间轮：
+ *   - 插入、取消都是 O(1)（槽位下标直接由到期 tick 计算，槽内为侵入式双向链表）；
+ *   - 到期处理按 tick 批量进行，一个槽里的定时器一次性取出；
+ *   - 4 层轮（256 + 3 × 64 槽），1ms 一个 tick 时可覆盖约 18.6 小时，
+ *     更远的到期时间先放在最高层，随级联逐步下沉。
+ *
+ * 时间轮本身不读时钟，也不加锁：调用方用自己的时钟换算 tick，
+ * 在同一线程中调用 schedule / cancel / advance。
+ *
+ * 用法：
+ *   gplat::TimerWheel<Event> wheel(nowTick());
+ *   auto id = wheel.scheduleAfter(500, Event{...});   // 500 个 tick 后到期
+ *   wheel.cancel(id);                                  // O(1) 取消
+ *
+ *   std::vector<Event> fired;
+ *   wheel.advance(nowTick(), fired);                   // 批量取出已到期的定时器
+ *   for (auto &ev : fired) post(ev);
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace gplat {
+
+template <typename T>
+class TimerWheel
+{
+public:
+    using TimerId = uint64_t; // 0 表示无效 id
+
+    static constexpr TimerId kInvalidTimer = 0;
+
+    explicit TimerWheel(uint64_t start_tick = 0) : now_(start_tick)
+    {
+        for (auto &head : slots_)
+        {
+            head = kNil;
+        }
+    }
+
+    TimerWheel(const TimerWheel &)            = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+
+    // 在绝对 tick expire 到期；已过期的时间在下一个 tick 触发
+    TimerId schedule(uint64_t expire, T payload)
+    {
+        uint32_t idx = allocNode();
+        Node &node   = nodes_[idx];
+        node.expire  = expire;
+        node.payload = std::move(payload);
+        node.active  = true;
+        place(idx, now_ + 1);
+        ++size_;
+        return makeId(idx, node.gen);
+    }
+
+    // 相对当前 tick 延后 delay 个 tick 到期
+    TimerId scheduleAfter(uint64_t delay, T payload)
+    {
+        return schedule(now_ + (delay == 0 ? 1 : delay), std::move(payload));
+    }
+
+    // 取消定时器。已触发、已取消或无效的 id 返回 false
+    bool cancel(TimerId id)
+    {
+        if (id == kInvalidTimer)
+        {
+            return false;
+        }
+        uint32_t idx = static_cast<uint32_t>(id & 0xffffffffu) - 1;
+        uint32_t gen = static_cast<uint32_t>(id >> 32);
+        if (idx >= nodes_.size() || nodes_[idx].gen != gen || !nodes_[idx].active)
+        {
+            return false;
+        }
+        unlink(idx);
+        freeNode(idx);
+        --size_;
+        return true;
+    }
+
+    // 未到期定时器的负载，用于挂起后补填（如负载自身需要记下 id）；已触发、已取消或无效的 id 返回 nullptr
+    T *get(TimerId id)
+    {
+        if (id == kInvalidTimer)
+        {
+            return nullptr;
+        }
+        uint32_t idx = static_cast<uint32_t>(id & 0xffffffffu) - 1;
+        uint32_t gen = static_cast<uint32_t>(id >> 32);
+        if (idx >= nodes_.size() || nodes_[idx].gen != gen || !nodes_[idx].active)
+        {
+            return nullptr;
+        }
+        return &nodes_[idx].payload;
+    }
+
+    // 推进到 tick now（含），把到期的负载按到期顺序追加到 out，返回本次到期个数
+    std::size_t advance(uint64_t now, std::vector<T> &out)
+    {
+        std::size_t fired = 0;
+        while (now_ < now)
+        {
+            if (size_ == 0)
+            {
+                now_ = now; // 空轮直接跳到目标时刻
+                break;
+            }
+            uint64_t t = now_ + 1;
+            if ((t & kL0Mask) == 0)
+            {
+                cascadeAt(t);
+            }
+            uint32_t &head = slots_[t & kL0Mask];
+            while (head != kNil)
+            {
+                uint32_t idx = head;
+                unlink(idx);
+                out.push_back(std::move(nodes_[idx].payload));
+                freeNode(idx);
+                --size_;
+                ++fired;
+            }
+            now_ = t;
+        }
+        return fired;
+    }
+
+    // 距下一个可能到期的 tick 还有多少 tick（保守估计，可能提前醒来但不会错过），
+    // 没有定时器时返回 UINT64_MAX
+    uint64_t ticksToNext() const
+    {
+        if (size_ == 0)
+        {
+            return std::numeric_limits<uint64_t>::max();
+        }
+        for (uint64_t d = 1; d <= kL0Size; ++d)
+        {
+            uint64_t t = now_ + d;
+            if ((t & kL0Mask) == 0 || slots_[t & kL0Mask] != kNil)
+            {
+                return d; // 遇到级联边界也要醒来，高层的定时器可能落入低层
+            }
+        }
+        return kL0Size;
+    }
+
+    uint64_t    now() const { return now_; }
+    std::size_t size() const { return size_; }
+    bool        empty() const { return size_ == 0; }
+
+private:
+    static constexpr uint32_t kNil     = std::numeric_limits<uint32_t>::max();
+    static constexpr int      kL0Bits  = 8;
+    static constexpr int      kLnBits  = 6;
+    static constexpr int      kLevels  = 4;
+    static constexpr uint64_t kL0Size  = uint64_t(1) << kL0Bits;
+    static constexpr uint64_t kLnSize  = uint64_t(1) << kLnBits;
+    static constexpr uint64_t kL0Mask  = kL0Size - 1;
+    static constexpr uint64_t kLnMask  = kLnSize - 1;
+    static constexpr std::size_t kSlotCount = kL0Size + (kLevels - 1) * kLnSize;
+    // 最高层能表示的最大跨度，超出部分先放在最高层最远的槽
+    static constexpr uint64_t kMaxSpan = (uint64_t(1) << (kL0Bits + (kLevels - 1) * kLnBits)) - 1;
+
+    struct Node
+    {
+        uint64_t expire = 0;
+        uint32_t prev   = kNil;
+        uint32_t next   = kNil;
+        uint32_t slot   = kNil;
+        uint32_t gen    = 1;
+        bool     active = false;
+        T        payload{};
+    };
+
+    static TimerId makeId(uint32_t idx, uint32_t gen) { return (uint64_t(gen) << 32) | (uint64_t(idx) + 1); }
+
+    // 第 level 层（>=1）第 i 个槽在 slots_ 中的下标
+    static std::size_t slotIndex(int level, uint64_t i) { return kL0Size + (level - 1) * kLnSize + i; }
+
+    uint32_t allocNode()
+    {
+        if (free_ != kNil)
+        {
+            uint32_t idx = free_;
+            free_        = nodes_[idx].next;
+            nodes_[idx].next = kNil;
+            return idx;
+        }
+        nodes_.emplace_back();
+        return static_cast<uint32_t>(nodes_.size() - 1);
+    }
+
+    void freeNode(uint32_t idx)
+    {
+        Node &node  = nodes_[idx];
+        node.active = false;
+        node.payload = T{};
+        ++node.gen;
+        if (node.gen == 0)
+        {
+            node.gen = 1; // 回绕时跳过 0，保证 id 不为 0
+        }
+        node.prev = kNil;
+        node.slot = kNil;
+        node.next = free_;
+        free_     = idx;
+    }
+
+    // 以 base 为当前时刻，按剩余时长选择层级和槽位
+    void place(uint32_t idx, uint64_t base)
+    {
+        Node &node     = nodes_[idx];
+        uint64_t expire = node.expire < base ? base : node.expire;
+        uint64_t delta  = expire - base;
+        std::size_t slot;
+        if (delta < kL0Size)
+        {
+            slot = expire & kL0Mask;
+        }
+        else if (delta < (uint64_t(1) << (kL0Bits + kLnBits)))
+        {
+            slot = slotIndex(1, (expire >> kL0Bits) & kLnMask);
+        }
+        else if (delta < (uint64_t(1) << (kL0Bits + 2 * kLnBits)))
+        {
+            slot = slotIndex(2, (expire >> (kL0Bits + kLnBits)) & kLnMask);
+        }
+        else
+        {
+            if (delta > kMaxSpan)
+            {
+                expire = base + kMaxSpan;
+            }
+            slot = slotIndex(3, (expire >> (kL0Bits + 2 * kLnBits)) & kLnMask);
+        }
+        link(idx, static_cast<uint32_t>(slot));
+    }
+
+    void link(uint32_t idx, uint32_t slot)
+    {
+        Node &node = nodes_[idx];
+        node.slot  = slot;
+        node.prev  = kNil;
+        node.next  = slots_[slot];
+        if (node.next != kNil)
+        {
+            nodes_[node.next].prev = idx;
+        }
+        slots_[slot] = idx;
+    }
+
+    void unlink(uint32_t idx)
+    {
+        Node &node = nodes_[idx];
+        if (node.prev != kNil)
+        {
+            nodes_[node.prev].next = node.next;
+        }
+        else
+        {
+            slots_[node.slot] = node.next;
+        }
+        if (node.next != kNil)
+        {
+            nodes_[node.next].prev = node.prev;
+        }
+        node.prev = node.next = kNil;
+    }
+
+    // 把高层一个槽里的定时器按新的剩余时长重新放置
+    void cascadeSlot(std::size_t slot, uint64_t base)
+    {
+        uint32_t idx  = slots_[slot];
+        slots_[slot]  = kNil;
+        while (idx != kNil)
+        {
+            uint32_t next = nodes_[idx].next;
+            place(idx, base);
+            idx = next;
+        }
+    }
+
+    // t 是第 0 层的回绕点：先从高层往低层逐级下沉
+    void cascadeAt(uint64_t t)
+    {
+        uint64_t i1 = (t >> kL0Bits) & kLnMask;
+        if (i1 == 0)
+        {
+            uint64_t i2 = (t >> (kL0Bits + kLnBits)) & kLnMask;
+            if (i2 == 0)
+            {
+                cascadeSlot(slotIndex(3, (t >> (kL0Bits + 2 * kLnBits)) & kLnMask), t);
+            }
+            cascadeSlot(slotIndex(2, i2), t);
+        }
+        cascadeSlot(slotIndex(1, i1), t);
+    }
+
+    uint64_t          now_;
+    std::size_t       size_ = 0;
+    uint32_t          free_ = kNil;
+    std::vector<Node> nodes_;
+    uint32_t          slots_[kSlotCount];
+};
+
+} // namespace gplat
@@ -0,0 +1,534 @@
+#pragma once
+
+/*
+ * gplat_typecache.h — 标签类型描述的客户端缓存（单头文件）
+ *
+ * readtype 每次都从服务端取回整段类型（最多 TYPEMAXSIZE 字节），客户端再逐字段解析，
+ * 而标签的类型只有在删除重建时才会变。本文件把取回的类型编译成 TypeLayout（字段名、种类、偏移、元素数），
+ * 按标签名缓存，之后解码一个结构体标签只是一次 memcpy 加按偏移取字段。
+ *
+ * 失效：服务端在 READB / READBSTRING / READTYPE 的应答 head.datatype 中带回类型戳（见 msg.h），
+ * 类型戳随标签长度和类型内容变化。readTyped() 每次读值时比对类型戳，不一致才重新 READTYPE；
+ * 服务端不提供类型戳（为 0）时只按标签长度校验，重定义为同长度的其它类型需调用 invalidate()。
+ *
+ * 类型描述格式（TYPE 区的内容，由建标签的一方写入）：
+ *   "id:int32;width:float;grade:char[16];temps:float[8]"
+ *   字段以 ';' 或换行分隔，"名称:种类[元素数]"，元素数省略为 1；可在末尾加 "@偏移" 指定字节偏移，
+ *   否则按 C 的自然对齐排布，结构体长度按最大对齐补齐 —— 与同样字段顺序的 C 结构体一致。
+ *   种类：bool int8 uint8 int16 uint16 int32 uint32 int64 uint64 float double char（char[N] 为定长字符串）
+ *   也接受 short / ushort / int / uint / long long 等别名。
+ *   其它格式的类型可以自行实现 TypeCompiler 传给 TypeCache。
+ *
+ * 用法：
+ *   gplat::TypeCache cache;
+ *   gplat::wire::FrameBuffer rx;
+ *   char value[256];
+ *   std::shared_ptr<const gplat::TypeLayout> layout;
+ *   if (gplat::readTyped(fd, rx, cache, "ROLL_DATA", value, sizeof(value), &layout, &error))
+ *   {
+ *       int    f  = layout->indexOf("width");
+ *       double w  = layout->number(value, f);
+ *       auto   gr = layout->text(value, layout->indexOf("grade"));
+ *   }
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "gplat_wire.h"
+
+namespace gplat {
+
+// ============================================================
+//  编译后的类型布局
+// ============================================================
+
+enum class FieldKind : std::uint8_t
+{
+    Bool,
+    Int8,
+    UInt8,
+    Int16,
+    UInt16,
+    Int32,
+    UInt32,
+    Int64,
+    UInt64,
+    Float,
+    Double,
+    Char, // char[N]：定长字符串
+};
+
+struct FieldDesc
+{
+    std::string name;
+    FieldKind   kind     = FieldKind::UInt8;
+    int         offset   = 0; // 相对值起始的字节偏移
+    int         count    = 1; // 元素数
+    int         elemsize = 1; // 单个元素的字节数
+};
+
+class TypeLayout;
+inline bool compileFieldList(const char *type, int typesize, int itemsize, TypeLayout &out, std::string *error);
+
+class TypeLayout
+{
+public:
+    int  size() const { return size_; }
+    unsigned int stamp() const { return stamp_; }
+    const std::vector<FieldDesc> &fields() const { return fields_; }
+
+    // 字段序号，找不到返回 -1。热路径上先取一次序号，之后按序号访问
+    int indexOf(std::string_view name) const
+    {
+        for (std::size_t i = 0; i < fields_.size(); ++i)
+        {
+            if (fields_[i].name == name)
+            {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    // 按字段种类取第 elem 个元素，转换为 double；越界返回 0
+    double number(const char *value, int field, int elem = 0) const
+    {
+        if (field < 0 || field >= static_cast<int>(fields_.size()))
+        {
+            return 0;
+        }
+        const FieldDesc &f = fields_[field];
+        if (elem < 0 || elem >= f.count)
+        {
+            return 0;
+        }
+        const char *p = value + f.offset + elem * f.elemsize;
+        switch (f.kind)
+        {
+        case FieldKind::Bool:   return load<bool>(p) ? 1 : 0;
+        case FieldKind::Int8:   return load<std::int8_t>(p);
+        case FieldKind::UInt8:  return load<std::uint8_t>(p);
+        case FieldKind::Char:   return load<char>(p);
+        case FieldKind::Int16:  return load<std::int16_t>(p);
+        case FieldKind::UInt16: return load<std::uint16_t>(p);
+        case FieldKind::Int32:  return load<std::int32_t>(p);
+        case FieldKind::UInt32: return load<std::uint32_t>(p);
+        case FieldKind::Int64:  return static_cast<double>(load<std::int64_t>(p));
+        case FieldKind::UInt64: return static_cast<double>(load<std::uint64_t>(p));
+        case FieldKind::Float:  return load<float>(p);
+        case FieldKind::Double: return load<double>(p);
+        }
+        return 0;
+    }
+
+    // char[N] 字段，到第一个 '\0' 或字段末尾为止
+    std::string_view text(const char *value, int field) const
+    {
+        if (field < 0 || field >= static_cast<int>(fields_.size()))
+        {
+            return {};
+        }
+        const FieldDesc &f = fields_[field];
+        const char      *p = value + f.offset;
+        const void      *z = std::memchr(p, '\0', f.count * f.elemsize);
+        return std::string_view(p, z ? static_cast<const char *>(z) - p : f.count * f.elemsize);
+    }
+
+    // 已知字段的 C++ 类型时直接按偏移取（调用方保证 T 与字段种类一致）
+    template <typename T>
+    T get(const char *value, int field, int elem = 0) const
+    {
+        const FieldDesc &f = fields_[field];
+        return load<T>(value + f.offset + elem * f.elemsize);
+    }
+
+private:
+    template <typename T>
+    static T load(const char *p)
+    {
+        T v;
+        std::memcpy(&v, p, sizeof(T));
+        return v;
+    }
+
+    friend bool compileFieldList(const char *, int, int, TypeLayout &, std::string *);
+    friend class TypeCache;
+
+    int                    size_  = 0;
+    unsigned int           stamp_ = 0;
+    std::vector<FieldDesc> fields_;
+};
+
+// ============================================================
+//  类型描述编译
+// ============================================================
+
+namespace detail {
+
+struct KindName
+{
+    const char *name;
+    FieldKind   kind;
+    int         size;
+};
+
+inline bool kindOf(std::string_view name, FieldKind &kind, int &size)
+{
+    static const KindName kinds[] = {
+        {"bool", FieldKind::Bool, 1},       {"int8", FieldKind::Int8, 1},
+        {"uint8", FieldKind::UInt8, 1},     {"byte", FieldKind::UInt8, 1},
+        {"int16", FieldKind::Int16, 2},     {"short", FieldKind::Int16, 2},
+        {"uint16", FieldKind::UInt16, 2},   {"ushort", FieldKind::UInt16, 2},
+        {"int32", FieldKind::Int32, 4},     {"int", FieldKind::Int32, 4},
+        {"uint32", FieldKind::UInt32, 4},   {"uint", FieldKind::UInt32, 4},
+        {"int64", FieldKind::Int64, 8},     {"long long", FieldKind::Int64, 8},
+        {"uint64", FieldKind::UInt64, 8},   {"unsigned long long", FieldKind::UInt64, 8},
+        {"float", FieldKind::Float, 4},     {"float32", FieldKind::Float, 4},
+        {"double", FieldKind::Double, 8},   {"float64", FieldKind::Double, 8},
+        {"char", FieldKind::Char, 1},
+    };
+    for (const auto &k : kinds)
+    {
+        if (name == k.name)
+        {
+            kind = k.kind;
+            size = k.size;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline std::string_view trim(std::string_view s)
+{
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '\r'))
+    {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r'))
+    {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+inline bool toInt(std::string_view s, int &out)
+{
+    std::string str(trim(s));
+    char       *end = nullptr;
+    long        v   = std::strtol(str.c_str(), &end, 10);
+    if (str.empty() || *end != '\0' || v < 0 || v > MAXMSGLEN)
+    {
+        return false;
+    }
+    out = static_cast<int>(v);
+    return true;
+}
+
+} // namespace detail
+
+// 编译 "名称:种类[元素数]@偏移;..." 格式的类型描述。itemsize > 0 时要求布局不超出标签长度
+inline bool compileFieldList(const char *type, int typesize, int itemsize, TypeLayout &out, std::string *error)
+{
+    auto fail = [error](std::string msg) {
+        if (error)
+        {
+            *error = std::move(msg);
+        }
+        return false;
+    };
+
+    out.fields_.clear();
+    out.size_ = 0;
+    std::string_view text(type, typesize);
+    // 类型区内容可能以 '\0' 结尾
+    if (auto z = text.find('\0'); z != std::string_view::npos)
+    {
+        text = text.substr(0, z);
+    }
+
+    int end      = 0;
+    int maxalign = 1;
+    while (!text.empty())
+    {
+        std::size_t      sep  = text.find_first_of(";\n");
+        std::string_view item = detail::trim(text.substr(0, sep));
+        text.remove_prefix(sep == std::string_view::npos ? text.size() : sep + 1);
+        if (item.empty())
+        {
+            continue;
+        }
+
+        FieldDesc f;
+        auto colon = item.find(':');
+        if (colon == std::string_view::npos)
+        {
+            return fail("字段缺少种类: " + std::string(item));
+        }
+        f.name = std::string(detail::trim(item.substr(0, colon)));
+        std::string_view rest = item.substr(colon + 1);
+
+        int explicit_offset = -1;
+        if (auto at = rest.find('@'); at != std::string_view::npos)
+        {
+            if (!detail::toInt(rest.substr(at + 1), explicit_offset))
+            {
+                return fail("偏移非法: " + std::string(item));
+            }
+            rest = rest.substr(0, at);
+        }
+        if (auto lb = rest.find('['); lb != std::string_view::npos)
+        {
+            auto rb = rest.find(']', lb);
+            if (rb == std::string_view::npos || !detail::toInt(rest.substr(lb + 1, rb - lb - 1), f.count) ||
+                f.count <= 0)
+            {
+                return fail("元素数非法: " + std::string(item));
+            }
+            rest = rest.substr(0, lb);
+        }
+        if (f.name.empty() || !detail::kindOf(detail::trim(rest), f.kind, f.elemsize))
+        {
+            return fail("未知的字段种类: " + std::string(item));
+        }
+
+        if (explicit_offset >= 0)
+        {
+            f.offset = explicit_offset;
+        }
+        else
+        {
+            f.offset = (end + f.elemsize - 1) / f.elemsize * f.elemsize;
+            maxalign = f.elemsize > maxalign ? f.elemsize : maxalign;
+        }
+        int fend = f.offset + f.count * f.elemsize;
+        end      = fend > end ? fend : end;
+        out.fields_.push_back(std::move(f));
+    }
+
+    out.size_ = (end + maxalign - 1) / maxalign * maxalign;
+    // 按 C 结构体补齐后的长度可能超过用 @ 紧凑排布的标签，只要求字段本身不越界
+    if (itemsize > 0 && end > itemsize)
+    {
+        return fail("类型布局 " + std::to_string(end) + " 字节，超出标签长度 " + std::to_string(itemsize));
+    }
+    if (itemsize > 0)
+    {
+        out.size_ = itemsize;
+    }
+    return true;
+}
+
+// ============================================================
+//  缓存
+// ============================================================
+
+// 把类型区内容编译为布局；itemsize 为标签长度（未知时为 0）
+using TypeCompiler = bool (*)(const char *type, int typesize, int itemsize, TypeLayout &out, std::string *error);
+
+struct TypeCacheStats
+{
+    std::uint64_t hits          = 0; // 类型戳一致，直接使用缓存的布局
+    std::uint64_t misses        = 0; // 未缓存，取回并编译
+    std::uint64_t invalidations = 0; // 类型戳或长度变化，重新取回
+    std::uint64_t errors        = 0; // 取回或编译失败
+};
+
+class TypeCache
+{
+public:
+    explicit TypeCache(TypeCompiler compiler = compileFieldList) : compiler_(compiler) {}
+
+    TypeCache(const TypeCache &)            = delete;
+    TypeCache &operator=(const TypeCache &) = delete;
+
+    // 查缓存：stamp 为 READB 应答中的类型戳，itemsize 为标签长度。
+    // 命中返回布局；未缓存或已失效返回空，由调用方 fetch()
+    std::shared_ptr<const TypeLayout> lookup(std::string_view tag, unsigned int stamp, int itemsize)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = entries_.find(keyOf(tag));
+            if (it == entries_.end())
+            {
+                misses_.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            const TypeLayout &l = *it->second;
+            if (l.stamp_ == stamp && (itemsize <= 0 || l.size_ == itemsize))
+            {
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return it->second;
+            }
+        }
+        invalidations_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    // 经 READTYPE 取回类型并编译，放入缓存（同步请求，等待期间到达的 POST 留在 rx 中）
+    std::shared_ptr<const TypeLayout> fetch(int sockfd, wire::FrameBuffer &rx, const char *board, const char *tag,
+                                            int itemsize, unsigned int *error)
+    {
+        MSGHEAD           req = wire::makeHead(READTYPE, board, tag);
+        MSGHEAD           rep;
+        std::vector<char> body;
+        if (!wire::call(sockfd, rx, req, nullptr, 0, rep, &body, error))
+        {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        if (!wire::replyOk(rep))
+        {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+            setError(error, rep.error);
+            return nullptr;
+        }
+        return insert(tag, body.data(), static_cast<int>(body.size()), itemsize, wire::typestampOf(rep), error);
+    }
+
+    // 已有类型内容时直接编译入缓存（例如建标签的一方，或用 higplat 的 readtype 取回）
+    std::shared_ptr<const TypeLayout> insert(std::string_view tag, const char *type, int typesize, int itemsize,
+                                             unsigned int stamp, unsigned int *error)
+    {
+        auto        layout = std::make_shared<TypeLayout>();
+        std::string msg;
+        if (!compiler_(type, typesize, itemsize, *layout, &msg))
+        {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+            setError(error, ERROR_INVALID_RESPONSE); // 类型内容无法解析
+            return nullptr;
+        }
+        layout->stamp_ = stamp;
+
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        entries_[std::string(tag)] = layout;
+        setError(error, 0);
+        return layout;
+    }
+
+    void invalidate(std::string_view tag)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        entries_.erase(std::string(tag));
+    }
+
+    void clear()
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        entries_.clear();
+    }
+
+    std::size_t size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+    TypeCacheStats stats() const
+    {
+        TypeCacheStats s;
+        s.hits          = hits_.load(std::memory_order_relaxed);
+        s.misses        = misses_.load(std::memory_order_relaxed);
+        s.invalidations = invalidations_.load(std::memory_order_relaxed);
+        s.errors        = errors_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    static void setError(unsigned int *error, unsigned int code)
+    {
+        if (error)
+        {
+            *error = code;
+        }
+    }
+
+    // C++17 的 unordered_map 不支持异构查找，查表键复用线程内的 std::string，热路径上不分配内存
+    static const std::string &keyOf(std::string_view tag)
+    {
+        thread_local std::string key;
+        key.assign(tag.data(), tag.size());
+        return key;
+    }
+
+    TypeCompiler                                                  compiler_;
+    mutable std::shared_mutex                                     mutex_;
+    std::unordered_map<std::string, std::shared_ptr<TypeLayout>> entries_;
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> invalidations_{0};
+    std::atomic<std::uint64_t> errors_{0};
+};
+
+// ============================================================
+//  带类型的读
+// ============================================================
+
+// READB 读值，并按应答中的类型戳从缓存取布局，缓存未命中或失效时再 READTYPE 一次。
+// value 至少 bufsize 字节；标签长于 bufsize 时失败（ERROR_BUFFER_SIZE）。
+// board 为空串时读服务端默认看板
+inline bool readTyped(int sockfd, wire::FrameBuffer &rx, TypeCache &cache, const char *tag, void *value,
+                      int bufsize, std::shared_ptr<const TypeLayout> *layout, unsigned int *error,
+                      timespec *timestamp = nullptr, const char *board = "")
+{
+    // 每个线程复用一个应答缓冲，稳定后读值不再分配内存
+    thread_local std::vector<char> body;
+
+    MSGHEAD req = wire::makeHead(READB, board, tag);
+    MSGHEAD rep;
+    if (!wire::call(sockfd, rx, req, nullptr, 0, rep, &body, error))
+    {
+        return false;
+    }
+    if (!wire::replyOk(rep))
+    {
+        if (error)
+        {
+            *error = rep.error;
+        }
+        return false;
+    }
+    int size = static_cast<int>(body.size());
+    if (size > bufsize)
+    {
+        if (error)
+        {
+            *error = ERROR_BUFFER_SIZE;
+        }
+        return false;
+    }
+    std::memcpy(value, body.data(), size);
+    if (timestamp)
+    {
+        *timestamp = rep.timestamp;
+    }
+
+    unsigned int stamp = wire::typestampOf(rep);
+    auto         l     = cache.lookup(tag, stamp, size);
+    if (!l)
+    {
+        l = cache.fetch(sockfd, rx, board, tag, size, error);
+        if (!l)
+        {
+            return false;
+        }
+    }
+    *layout = std::move(l);
+    if (error)
+    {
+        *error = 0;
+    }
+    return true;
+}
+
+} // namespace gplat
@@ -0,0 +1,106 @@
+#pragma once
+
+/*
+ * gplat_waitmulti.h — 多路等待队列和标签（单头文件）
+ *
+ * 一个消费线程服务多个队列时，只能每个队列一个线程阻塞，或者轮询 READQ 再 sleep：
+ * 前者线程数随队列数增长，后者要么浪费请求、要么增加时延。
+ * WaitSet 按 msg.h 的 WAITMULTI 把一组队列和默认看板标签交给服务端，阻塞到其中任何一个就绪才应答，
+ * 类似 epoll_wait：返回就绪的条目（队列的未读记录数、标签的当前写入序号），再去 READQ / READB。
+ *   - 队列是水平触发的：没读走就一直就绪；多个消费者等同一队列时都会被唤醒，READQ 没拿到的一方再等即可；
+ *   - 标签按写入序号：wait() 返回后自动把就绪标签的已知序号更新为当前序号，下次只等新的写入。
+ *
+ * 与 wire::call 一样，等待应答期间到达的 POST 留在 rx 中；但等待期间连接被 WAITMULTI 占住，
+ * 需要同时发其它请求的程序应为等待单独开一个连接。
+ *
+ * 用法：
+ *   gplat::WaitSet set;
+ *   set.addQueue("L1_CMD").addQueue("L2_CMD").addTag("F1_SPEED");
+ *   std::vector<WAITREADY> ready;
+ *   while (set.wait(conngplat, rx, 1000, ready, &error))
+ *   {
+ *       for (const WAITREADY &r : ready)
+ *           if (r.kind == WAIT_QUEUE) ... READQ set.name(r.index) ...
+ *   }
+ */
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gplat_wire.h"
+
+namespace gplat {
+
+class WaitSet
+{
+public:
+    // 队列名、标签名不超过 39 个字符，总条目数不超过 WAITMAX
+    WaitSet &addQueue(const char *qname) { return add(qname, WAIT_QUEUE, 0); }
+    // lastseq 为已知的写入序号（如 SUBOPT_SEQ 推送中的 POSTSEQ.seq）；0 表示等 wait() 登记之后的下一次写入，
+    // 该标签就绪一次后即有了序号，两次 wait() 之间的写入不再漏掉
+    WaitSet &addTag(const char *tagname, unsigned long long lastseq = 0) { return add(tagname, WAIT_TAG, lastseq); }
+
+    std::size_t size() const { return entries_.size(); }
+    const char *name(std::size_t i) const { return entries_[i].name; }
+    void        clear() { entries_.clear(); }
+
+    // 等待任一条目就绪，timeout_ms 为 0 只检查不等待，< 0 一直等待；超时返回 true 且 ready 为空
+    bool wait(int sockfd, wire::FrameBuffer &rx, int timeout_ms, std::vector<WAITREADY> &ready, unsigned int *error)
+    {
+        ready.clear();
+        if (entries_.empty() || entries_.size() > WAITMAX)
+        {
+            setError(error, ERROR_INVALID_PARAMETER);
+            return false;
+        }
+        MSGHEAD head   = wire::makeHead(WAITMULTI, "", "");
+        head.arraysize = static_cast<int>(entries_.size());
+        head.timeout   = timeout_ms;
+        MSGHEAD           reply;
+        std::vector<char> body;
+        if (!wire::call(sockfd, rx, head, entries_.data(), static_cast<int>(entries_.size() * sizeof(WAITENTRY)),
+                        reply, &body, error))
+        {
+            return false;
+        }
+        std::size_t n = body.size() / sizeof(WAITREADY);
+        ready.resize(n);
+        if (n > 0)
+        {
+            std::memcpy(ready.data(), body.data(), n * sizeof(WAITREADY));
+        }
+        for (const WAITREADY &r : ready)
+        {
+            if (r.kind == WAIT_TAG && r.index >= 0 && static_cast<std::size_t>(r.index) < entries_.size())
+            {
+                entries_[r.index].lastseq = r.value;
+            }
+        }
+        return true;
+    }
+
+private:
+    static void setError(unsigned int *error, unsigned int code)
+    {
+        if (error)
+        {
+            *error = code;
+        }
+    }
+
+    WaitSet &add(const char *name, int kind, unsigned long long lastseq)
+    {
+        WAITENTRY e;
+        std::memset(&e, 0, sizeof(e));
+        std::strncpy(e.name, name, sizeof(e.name) - 1);
+        e.kind    = kind;
+        e.lastseq = lastseq;
+        entries_.push_back(e);
+        return *this;
+    }
+
+    std::vector<WAITENTRY> entries_;
+};
+
+} // namespace gplat
@@ -0,0 +1,525 @@
+#pragma once
+
+/*
+ * gplat_wire.h — higplat 报文收发辅助（单头文件）
+ *
+ * higplat 的每个报文都是一个 MSGHEAD 紧跟 head.bodysize 字节的 body，
+ * 请求和应答使用同一格式，服务端主动推送的订阅数据为 id == POST 的报文。
+ * 本文件只负责报文的组装、拆分与套接字读写，不关心具体业务，
+ * 供异步客户端、批量接收、连接池等上层封装共用。
+ *
+ * 用法：
+ *   int fd = gplat::wire::connectTcp("127.0.0.1", 8777, false);
+ *   MSGHEAD head = gplat::wire::makeHead(READB, "", "WATCHDOG");
+ *   head.datasize = sizeof(int);
+ *   gplat::wire::sendFrame(fd, head, nullptr, 0);
+ *
+ *   gplat::wire::FrameBuffer rx;
+ *   gplat::wire::Frame frame;
+ *   while (!rx.next(frame, &error)) rx.readFrom(fd);
+ */
+
+#include <time.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "msg.h"
+
+#ifndef ERROR_SOCKET_NOT_CONNECTED
+#define ERROR_SOCKET_NOT_CONNECTED      31
+#endif
+#ifndef ERROR_MSGSIZE
+#define ERROR_MSGSIZE                   32
+#endif
+#ifndef ERROR_BUFFER_SIZE
+#define ERROR_BUFFER_SIZE               33
+#endif
+#ifndef ERROR_PARAMETER_SIZE
+#define ERROR_PARAMETER_SIZE            34
+#endif
+#ifndef ERROR_INVALID_PARAMETER
+#define ERROR_INVALID_PARAMETER         39
+#endif
+#ifndef ERROR_INVALID_RESPONSE
+#define ERROR_INVALID_RESPONSE          40
+#endif
+
+namespace gplat {
+namespace wire {
+
+constexpr int kHeadSize  = static_cast<int>(sizeof(MSGHEAD));
+constexpr int kFrameMax  = kHeadSize + MAXMSGLEN;
+
+// ============================================================
+//  报文头组装
+// ============================================================
+
+// 名称写入定长字段，超长截断并保证以 '\0' 结尾
+template <std::size_t N>
+inline void copyName(char (&dst)[N], const char *src)
+{
+    if (src == nullptr)
+    {
+        dst[0] = '\0';
+        return;
+    }
+    std::strncpy(dst, src, N - 1);
+    dst[N - 1] = '\0';
+}
+
+inline MSGHEAD makeHead(int id, const char *qname, const char *itemname)
+{
+    MSGHEAD head;
+    std::memset(&head, 0, sizeof(head));
+    head.id = id;
+    copyName(head.qname, qname);
+    copyName(head.itemname, itemname);
+    return head;
+}
+
+// 应答是否成功：服务端以 SUCCEED/FAIL 作为应答 id，并在 error 中给出错误码
+inline bool replyOk(const MSGHEAD &head)
+{
+    return head.id == SUCCEED && head.error == 0;
+}
+
+// 请求流水线序号（见 msg.h），借用非 POST 报文的 eventid 字段
+inline void setSeqno(MSGHEAD &head, unsigned int seqno)
+{
+    head.eventid = static_cast<int>(seqno);
+}
+
+inline unsigned int seqnoOf(const MSGHEAD &head)
+{
+    return head.id == POST ? 0u : static_cast<unsigned int>(head.eventid);
+}
+
+// READB / READBSTRING / READTYPE 应答中的类型戳（见 msg.h），0 表示服务端不提供
+inline unsigned int typestampOf(const MSGHEAD &reply)
+{
+    return reply.id == SUCCEED ? static_cast<unsigned int>(reply.datatype) : 0u;
+}
+
+// 拆分 POST 的 body：数值 + 可选的 POSTSEQ / POSTSTAMP 尾部（见 msg.h）
+// 返回数值长度；尾部与 head.datasize 对不上时整个 body 都视为数值
+inline int parsePost(const MSGHEAD &head, const char *body, POSTSEQ *seq, POSTSTAMP *stamp)
+{
+    int datasize = head.datasize;
+    int trailer  = 0;
+    bool has_seq   = (head.eventarg & (SUBOPT_SEQ | SUBOPT_SNAPSHOT)) != 0;
+    bool has_stamp = (head.eventarg & SUBOPT_STAMP) != 0;
+    trailer += has_seq ? static_cast<int>(sizeof(POSTSEQ)) : 0;
+    trailer += has_stamp ? static_cast<int>(sizeof(POSTSTAMP)) : 0;
+
+    if (seq)
+    {
+        std::memset(seq, 0, sizeof(*seq));
+    }
+    if (stamp)
+    {
+        std::memset(stamp, 0, sizeof(*stamp));
+    }
+    if (trailer == 0 || datasize < 0 || head.bodysize != datasize + trailer)
+    {
+        return head.bodysize;
+    }
+
+    const char *p = body + datasize;
+    if (has_seq)
+    {
+        if (seq)
+        {
+            std::memcpy(seq, p, sizeof(POSTSEQ));
+        }
+        p += sizeof(POSTSEQ);
+    }
+    if (has_stamp && stamp)
+    {
+        std::memcpy(stamp, p, sizeof(POSTSTAMP));
+    }
+    return datasize;
+}
+
+// 将一个完整报文追加到发送缓冲区，head.bodysize 以实际长度为准
+inline void appendFrame(std::vector<char> &out, MSGHEAD head, const void *body, int bodysize)
+{
+    head.bodysize = bodysize;
+    std::size_t pos = out.size();
+    out.resize(pos + kHeadSize + bodysize);
+    std::memcpy(out.data() + pos, &head, kHeadSize);
+    if (bodysize > 0)
+    {
+        std::memcpy(out.data() + pos + kHeadSize, body, bodysize);
+    }
+}
+
+// ============================================================
+//  套接字辅助
+// ============================================================
+
+inline bool setNonBlocking(int fd, bool enable)
+{
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    if (flags < 0)
+    {
+        return false;
+    }
+    flags = enable ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return ::fcntl(fd, F_SETFL, flags) == 0;
+}
+
+// 解析地址，优先按点分十进制处理，失败时再走 DNS
+inline bool resolveAddress(const char *server, int port, sockaddr_in &addr)
+{
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(static_cast<uint16_t>(port));
+    if (::inet_pton(AF_INET, server, &addr.sin_addr) == 1)
+    {
+        return true;
+    }
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *result = nullptr;
+    if (::getaddrinfo(server, nullptr, &hints, &result) != 0 || result == nullptr)
+    {
+        return false;
+    }
+    addr.sin_addr = reinterpret_cast<sockaddr_in *>(result->ai_addr)->sin_addr;
+    ::freeaddrinfo(result);
+    return true;
+}
+
+// 建立 TCP 连接。nonblocking 为 true 时立即返回，连接可能仍处于 EINPROGRESS 状态
+// 返回 fd，失败返回 -1
+inline int connectTcp(const char *server, int port, bool nonblocking)
+{
+    sockaddr_in addr;
+    if (!resolveAddress(server, port, addr))
+    {
+        return -1;
+    }
+
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (nonblocking && !setNonBlocking(fd, true))
+    {
+        ::close(fd);
+        return -1;
+    }
+
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 &&
+        !(nonblocking && errno == EINPROGRESS))
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 阻塞写满 len 字节
+inline bool sendAll(int fd, const void *data, std::size_t len)
+{
+    const char *p = static_cast<const char *>(data);
+    while (len > 0)
+    {
+        ssize_t n = ::send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        len -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// 阻塞发送一个报文（头和 body 合并为一次 send）
+inline bool sendFrame(int fd, MSGHEAD head, const void *body, int bodysize)
+{
+    char buf[kFrameMax];
+    if (bodysize < 0 || bodysize > MAXMSGLEN)
+    {
+        return false;
+    }
+    head.bodysize = bodysize;
+    std::memcpy(buf, &head, kHeadSize);
+    if (bodysize > 0)
+    {
+        std::memcpy(buf + kHeadSize, body, bodysize);
+    }
+    return sendAll(fd, buf, kHeadSize + bodysize);
+}
+
+// 阻塞发送一个报文，body 由 parts 依次拼成；用 sendmsg 直接从调用方内存发出，不经中间缓冲
+inline bool sendFrameParts(int fd, MSGHEAD head, const iovec *parts, int nparts)
+{
+    constexpr int kMaxParts = 8;
+    if (nparts < 0 || nparts > kMaxParts - 1)
+    {
+        return false;
+    }
+    iovec       iov[kMaxParts];
+    std::size_t total = 0;
+    for (int i = 0; i < nparts; ++i)
+    {
+        iov[i + 1] = parts[i];
+        total += parts[i].iov_len;
+    }
+    if (total > static_cast<std::size_t>(MAXMSGLEN))
+    {
+        return false;
+    }
+    head.bodysize = static_cast<int>(total);
+    iov[0]        = iovec{&head, static_cast<std::size_t>(kHeadSize)};
+
+    msghdr msg{};
+    msg.msg_iov    = iov;
+    msg.msg_iovlen = static_cast<std::size_t>(nparts + 1);
+    std::size_t remain = kHeadSize + total;
+    while (remain > 0)
+    {
+        ssize_t n = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        remain -= static_cast<std::size_t>(n);
+        // 部分发送：跳过已发出的段
+        while (n > 0 && msg.msg_iovlen > 0)
+        {
+            if (static_cast<std::size_t>(n) >= msg.msg_iov->iov_len)
+            {
+                n -= static_cast<ssize_t>(msg.msg_iov->iov_len);
+                ++msg.msg_iov;
+                --msg.msg_iovlen;
+            }
+            else
+            {
+                msg.msg_iov->iov_base = static_cast<char *>(msg.msg_iov->iov_base) + n;
+                msg.msg_iov->iov_len -= static_cast<std::size_t>(n);
+                n = 0;
+            }
+        }
+    }
+    return true;
+}
+
+// 阻塞读满 len 字节，对端关闭或出错返回 false
+inline bool recvAll(int fd, void *data, std::size_t len)
+{
+    char *p = static_cast<char *>(data);
+    while (len > 0)
+    {
+        ssize_t n = ::recv(fd, p, len, 0);
+        if (n <= 0)
+        {
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        len -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// ============================================================
+//  接收缓冲：一次 read 尽量多取，再逐帧拆分
+// ============================================================
+
+// 拆出的报文。body 指向 FrameBuffer 内部，下一次 readFrom() 之前有效
+struct Frame
+{
+    MSGHEAD     head;
+    const char *body = nullptr;
+};
+
+class FrameBuffer
+{
+public:
+    explicit FrameBuffer(std::size_t capacity = 4 * kFrameMax)
+        : buf_(capacity < static_cast<std::size_t>(kFrameMax) ? kFrameMax : capacity)
+    {
+    }
+
+    // 读一次套接字，把数据追加到缓冲尾部
+    // 返回 >0 读到的字节数；0 对端关闭；-1 出错（EAGAIN 时 errno 保持不变）
+    ssize_t readFrom(int fd)
+    {
+        compact();
+        std::size_t space = buf_.size() - wpos_;
+        if (space == 0)
+        {
+            errno = ENOBUFS;
+            return -1;
+        }
+        ssize_t n;
+        do
+        {
+            n = ::recv(fd, buf_.data() + wpos_, space, 0);
+        } while (n < 0 && errno == EINTR);
+        if (n > 0)
+        {
+            wpos_ += static_cast<std::size_t>(n);
+        }
+        return n;
+    }
+
+    // 取出下一个完整报文；数据不足返回 false
+    // 报文长度非法时返回 false 并置 *error = ERROR_MSGSIZE，此时连接应当关闭
+    bool next(Frame &frame, unsigned int *error)
+    {
+        if (error)
+        {
+            *error = 0;
+        }
+        if (wpos_ - rpos_ < static_cast<std::size_t>(kHeadSize))
+        {
+            return false;
+        }
+        std::memcpy(&frame.head, buf_.data() + rpos_, kHeadSize);
+        int bodysize = frame.head.bodysize;
+        if (bodysize < 0 || bodysize > MAXMSGLEN)
+        {
+            if (error)
+            {
+                *error = ERROR_MSGSIZE;
+            }
+            return false;
+        }
+        if (wpos_ - rpos_ < static_cast<std::size_t>(kHeadSize + bodysize))
+        {
+            return false;
+        }
+        frame.body = buf_.data() + rpos_ + kHeadSize;
+        rpos_ += kHeadSize + bodysize;
+        return true;
+    }
+
+    // 从缓冲区中摘出第一个非 POST 报文（请求的应答），其前后的 POST 报文原样保留，
+    // 供订阅连接上的同步请求使用。body 非空时拷贝应答 body
+    bool takeReply(MSGHEAD &head, std::vector<char> *body)
+    {
+        std::size_t pos = rpos_;
+        while (wpos_ - pos >= static_cast<std::size_t>(kHeadSize))
+        {
+            MSGHEAD h;
+            std::memcpy(&h, buf_.data() + pos, kHeadSize);
+            if (h.bodysize < 0 || h.bodysize > MAXMSGLEN)
+            {
+                return false;
+            }
+            std::size_t len = kHeadSize + static_cast<std::size_t>(h.bodysize);
+            if (wpos_ - pos < len)
+            {
+                return false;
+            }
+            if (h.id != POST)
+            {
+                head = h;
+                if (body)
+                {
+                    body->assign(buf_.data() + pos + kHeadSize, buf_.data() + pos + len);
+                }
+                std::memmove(buf_.data() + pos, buf_.data() + pos + len, wpos_ - pos - len);
+                wpos_ -= len;
+                return true;
+            }
+            pos += len;
+        }
+        return false;
+    }
+
+    // 缓冲区中是否还留有未拆出的字节
+    std::size_t pending() const { return wpos_ - rpos_; }
+
+    void clear() { rpos_ = wpos_ = 0; }
+
+private:
+    // 已消费的数据前移，腾出尾部空间
+    void compact()
+    {
+        if (rpos_ == 0)
+        {
+            return;
+        }
+        std::size_t remain = wpos_ - rpos_;
+        if (remain > 0)
+        {
+            std::memmove(buf_.data(), buf_.data() + rpos_, remain);
+        }
+        rpos_ = 0;
+        wpos_ = remain;
+    }
+
+    std::vector<char> buf_;
+    std::size_t       rpos_ = 0;
+    std::size_t       wpos_ = 0;
+};
+
+// 同步请求：发送一个报文并等待应答，等待期间到达的 POST 留在 rx 中不丢失
+// 返回 false 时 *error 给出原因（连接断开、报文非法）
+inline bool call(int fd, FrameBuffer &rx, const MSGHEAD &head, const void *body, int bodysize,
+                 MSGHEAD &reply, std::vector<char> *replybody, unsigned int *error)
+{
+    if (!sendFrame(fd, head, body, bodysize))
+    {
+        if (error)
+        {
+            *error = ERROR_SOCKET_NOT_CONNECTED;
+        }
+        return false;
+    }
+    while (!rx.takeReply(reply, replybody))
+    {
+        ssize_t n = rx.readFrom(fd);
+        if (n <= 0)
+        {
+            if (error)
+            {
+                *error = (n < 0 && errno == ENOBUFS) ? ERROR_MSGSIZE : ERROR_SOCKET_NOT_CONNECTED;
+            }
+            return false;
+        }
+    }
+    if (error)
+    {
+        *error = replyOk(reply) ? 0 : (reply.error != 0 ? reply.error : ERROR_INVALID_RESPONSE);
+    }
+    return replyOk(reply);
+}
+
+} // namespace wire
+} // namespace gplat
@@ -54,6 +54,14 @@ enum MSGID
 	WRITEBPLC,
 	WRITEBSTRINGPLC,
 	READBOARDINFO,
+	CHECKPOINTB,		// 看板检查点（gplat_server 扩展），见下方说明
+	CREATEINDEX,		// 数据库表二级索引（gplat_server 扩展），见下方说明
+	DELETEINDEX,
+	SCANTB,				// 数据库表谓词扫描（gplat_server 扩展），见下方说明
+	OPENSNAPSHOT,		// 数据库表快照（gplat_server 扩展），见下方说明
+	CLOSESNAPSHOT,
+	READHIST,			// 历史库查询（gplat_server 扩展），见下方说明
+	WAITMULTI,			// 多路等待队列 / 标签（gplat_server 扩展），见下方说明
 };
 
 #pragma pack( push, enter_MSG_H_, 1)
@@ -90,6 +98,221 @@ typedef struct {
 	char    body[MAXMSGLEN];
 } MSGSTRUCT, *PMSGSTRUCT;
 
+// 请求流水线：非 POST 报文的 head.eventid 兼作请求序号，服务端在应答中原样带回，
+// 客户端据此把应答对应到请求，同一连接可以连续发出多个请求再收应答（MSGHEAD 布局不变）。
+// 序号为 0 表示不使用；服务端不带回序号时，客户端按发送顺序对应应答
+
+// 类型戳：READB / READBSTRING / READTYPE 的应答在 head.datatype 中带回标签的类型戳，
+// 由标签长度和类型内容算出，标签被删除后以不同的长度或类型重建时改变，客户端据此判断缓存的类型是否失效。
+// 0 表示服务端不提供类型戳
+
+// 检查点：CHECKPOINTB 请求服务端把看板（qname 为空时为默认看板）的一致映像写入检查点目录，
+// 写完后应答 head.count = 标签数，head.datasize = 映像字节数；服务端重启时由映像恢复看板。
+// 映像在后台线程写出，同一连接上其后的请求可能先得到应答（按 eventid 对应）
+
+// 数据库表：qname 为数据库名（为空时为服务端的默认数据库），itemname 为表名，记录定长、按行号（从 0 起）访问。
+//   CREATETABLE  head.recsize = 记录长度，head.count = 最大记录数，body 为类型描述（可为空，格式见 gplat_typecache.h）
+//   INSERTTB     body 为若干条整记录（bodysize 为记录长度的整数倍），追加在表尾；
+//                应答 head.start = 第一条的行号，head.count = 条数
+//   REFRESHTB    body 同上，覆盖从 head.start 起的各行
+//   SELECTTB     body 为空时读从 head.start 起的至多 head.count 条记录；
+//                body 为 TBKEY 时按键选择，先查索引，未指定索引时服务端扫描全表（见 TBKEY）。
+//                应答 head.count = 返回条数，head.recsize = 记录长度，head.datasize = 表中现有记录数
+//   CLEARTB / DELETETABLE / CLEARDB  清空表 / 删除表 / 清空数据库
+// 二级索引（CREATEINDEX / DELETEINDEX，body 为 TBINDEX）：在记录的一个字段上建哈希索引（等值查找）
+// 或有序索引（等值、范围查找），插入和更新记录时由服务端维护；CREATEINDEX 应答 head.count = 已索引的记录数。
+// 索引只在服务端内存中，服务端重启后需重新声明
+
+#define TBIDX_HASH		0
+#define TBIDX_ORDERED	1
+
+// 键类型：INT / UINT 为 1、2、4、8 字节整数，FLOAT 为 float / double，CHAR 为 char[N]（比较到 '\0'），BYTES 按字节比较
+#define TBKEY_INT		0
+#define TBKEY_UINT		1
+#define TBKEY_FLOAT		2
+#define TBKEY_CHAR		3
+#define TBKEY_BYTES		4
+
+// 字段：field 非空时按表的类型描述中的字段名解析，忽略 keytype / offset / size
+typedef struct {
+	char   name[40];		// 索引名（DELETEINDEX 只用此项）
+	char   field[40];
+	int    kind;			// TBIDX_*
+	int    keytype;			// TBKEY_*
+	int    offset;
+	int    size;
+} TBINDEX;
+
+#define TBSEL_RANGE		0x01	// [lo, hi] 范围查找（只限有序索引或扫描），否则等值查找
+#define TBSEL_ROWIDS	0x02	// 应答只带行号，不带记录
+
+// 按键 SELECTTB 的 body：TBKEY + lo[keysize] + hi[keysize]（TBSEL_RANGE 时）。
+// index 为空时按 field 或 keytype / offset / size 扫描全表。键为字段的原始字节，CHAR 键可短于字段长度。
+// 跳过前 head.start 条匹配，至多返回 head.count 条（0 为放得下的全部）。
+// 应答 body 为 int 行号[head.count] + 记录[head.count]，head.readptr 为 1 表示其后还有匹配（再以 start 递增分页）
+typedef struct {
+	char   index[40];
+	char   field[40];
+	int    keytype;
+	int    offset;
+	int    size;
+	int    flags;			// TBSEL_*
+	int    keysize;
+	int    reserved;
+} TBKEY;
+
+// 谓词扫描（SCANTB）：body 为 TBSCAN + TBPRED[npred]，各谓词同时成立的记录匹配，只限数值字段
+// （TBKEY_INT / UINT / FLOAT）；服务端按 64 条一块求值。
+// 从 head.start 行起扫描，至多返回 head.count 条（0 为放得下的全部）。
+// 应答 body 同按键 SELECTTB，head.start = 续扫的起始行，head.readptr 为 1 表示未扫到表尾（以 head.start 续扫）
+#define TBOP_EQ			0
+#define TBOP_NE			1
+#define TBOP_LT			2
+#define TBOP_LE			3
+#define TBOP_GT			4
+#define TBOP_GE			5
+#define TBOP_BETWEEN	6	// value <= x <= value2
+
+typedef struct {
+	int    npred;
+	int    flags;			// TBSEL_ROWIDS
+	int    reserved[2];
+} TBSCAN;
+
+// 字段的确定方式同 TBINDEX；value / value2 为字段的原始字节（前 size 字节有效）
+typedef struct {
+	char   field[40];
+	int    keytype;
+	int    offset;
+	int    size;
+	int    op;				// TBOP_*
+	char   value[8];
+	char   value2[8];
+} TBPRED;
+
+// 快照：OPENSNAPSHOT 打开表的一个快照，应答 head.writeptr = 快照号，head.recsize = 记录长度，
+// head.datasize = 快照中的记录数；之后 SELECTTB（body 为空）、SCANTB 请求的 head.writeptr 填快照号时
+// 读该快照（打开时刻的表内容，不受其后的插入、更新、清空影响，读时也不阻塞写者）。
+// CLOSESNAPSHOT 以 head.writeptr 关闭快照；快照属于打开它的连接，连接断开时全部关闭。
+// 表被删除后读快照返回 ERROR_TABLE_NOT_EXIST
+
+// PLC 批量写：WRITEBPLC 的 head.arraysize > 0 且 head.itemname 为空时，body 为 arraysize 项依次排列，
+// 每项为 PLCWRITE 紧跟 valuesize 字节的值（数值为该类型的原始字节，字符串含结尾 '\0'），项间不留空隙。
+// 服务端先校验整个 body，不合法时一项也不写（ERROR_INVALID_PARAMETER）；合法时一次处理完全部各项，
+// 应答 head.count = 写入成功的项数，body 为 unsigned int 错误码[arraysize]（0 为成功），
+// 有失败项时应答为 FAIL，head.error 为第一个失败项的错误码
+#define PLCVAL_BOOL		0
+#define PLCVAL_SHORT	1
+#define PLCVAL_USHORT	2
+#define PLCVAL_INT		3
+#define PLCVAL_UINT		4
+#define PLCVAL_FLOAT	5
+#define PLCVAL_STRING	6
+
+typedef struct {
+	char   tagname[40];
+	int    valtype;			// PLCVAL_*
+	int    valuesize;
+} PLCWRITE;
+
+// 历史库（READHIST）：服务端把配置中 history_tags 列出的标签（或其中一个数值字段）的每次变化记入历史库，
+// itemname 为序列名（标签名，字段带偏移时为"标签@偏移"），body 为 HISTQUERY，时刻为 CLOCK_REALTIME 微秒。
+//   bucket 为 0   原始点：[from, to) 内跳过前 skip 点，应答 body 为 HISTPOINT[head.count]
+//   bucket > 0   降采样：从 from 起每 bucket 微秒一个桶，应答 body 为 HISTBUCKET[head.count]，只含有点的桶
+// 每次至多 limit 项（0 为一个报文放得下的全部），head.readptr 为 1 表示其后还有：原始点以最后一点的时刻为 from、
+// 跳过已收到的同一时刻的点续读；降采样以最后一个桶的下一个桶起点为 from 续读（gplat_history.h 已处理）。
+// 序列不存在返回 ERROR_DQ_NOT_OPEN
+typedef struct {
+	long long from;
+	long long to;
+	long long bucket;
+	int       skip;
+	int       limit;
+} HISTQUERY;
+
+typedef struct {
+	long long t;
+	double    value;
+} HISTPOINT;
+
+typedef struct {
+	long long start;		// 桶的起始时刻
+	int       count;		// 桶内点数
+	int       reserved;
+	double    min;
+	double    max;
+	double    avg;
+	double    first;
+	double    last;
+} HISTBUCKET;
+
+// 多路等待（WAITMULTI）：一个请求登记一组队列和标签，阻塞到其中任何一个就绪再应答（类似 epoll_wait），
+// 一个线程即可服务多个队列，不必每个队列一个线程或轮询 READQ。
+// head.arraysize 为条目数（1 ~ WAITMAX），body 为 WAITENTRY[arraysize]；head.timeout 为等待的毫秒数，
+// 0 为只检查不等待，< 0 为一直等待。
+//   WAIT_QUEUE  队列 name 中有未读记录即就绪（水平触发：不读走就一直就绪），队列尚不存在视为空
+//   WAIT_TAG    默认看板标签 name 的写入序号（POSTSEQ.seq）与 lastseq 不同即就绪，
+//               lastseq 为 0 表示登记之后的下一次写入；标签尚不存在时写入（自动创建）即就绪
+// 应答 head.count 为就绪条目数，body 为 WAITREADY[head.count]（按条目顺序）；超时时 head.count 为 0，仍为 SUCCEED。
+// 登记时已有就绪条目则立即应答；否则在第一次有条目就绪时应答，并一并检查其余条目。
+// 多个连接等待同一队列时都会被唤醒，READQ 没有拿到记录的一方再次 WAITMULTI 即可。
+// 等待期间同一连接上的其它请求照常处理（其应答可能先于 WAITMULTI 的应答到达）；连接断开时登记自动撤销
+#define WAITMAX		256
+#define WAIT_QUEUE	1
+#define WAIT_TAG	2
+
+typedef struct {
+	char               name[40];	// 队列名或标签名
+	int                kind;		// WAIT_QUEUE / WAIT_TAG
+	int                reserved;
+	unsigned long long lastseq;		// WAIT_TAG：客户端已知的写入序号
+} WAITENTRY;
+
+typedef struct {
+	int                index;		// 在请求的 WAITENTRY 中的下标
+	int                kind;
+	unsigned long long value;		// WAIT_TAG：当前写入序号（下次等待的 lastseq）；WAIT_QUEUE：未读记录数
+} WAITREADY;
+
+// SUBSCRIBE 请求的订阅选项，放在 head.eventarg 中；服务端在 POST 的 head.eventarg 中回带实际生效的选项
+#define SUBOPT_STAMP	0x01	// POST 的 body 尾部附带 POSTSTAMP
+#define SUBOPT_SNAPSHOT	0x02	// 订阅成功后先推送当前值，再推送后续变化（隐含 SUBOPT_SEQ）
+#define SUBOPT_SEQ		0x04	// POST 的 body 尾部附带 POSTSEQ
+#define SUBOPT_RANGE	0x08	// POST 只带本次写入改变的字节（见下方"部分读写"）
+
+// POST 的 body 布局：数值[head.datasize] + POSTSEQ（含 SUBOPT_SEQ 时）+ POSTSTAMP（含 SUBOPT_STAMP 时）
+// 不带任何选项时 body 只有数值，与原协议一致
+
+// 部分读写：READB / WRITEB 的 head.subsize > 0 时只读写标签中 [head.offset, head.offset + head.subsize) 这一段，
+// 超出标签长度时返回 ERROR_ITEM_OVERFLOW。READB 应答 body 为这一段，head.datasize 仍为标签长度；
+// WRITEB 的 body 为这一段（bodysize 须等于 subsize），标签不存在时不自动创建。
+// 带 SUBOPT_RANGE 的订阅：POST 的数值只是本次改变的字节，head.offset 为其在标签中的位置，
+// head.datasize = head.subsize = 字节数。部分写入时为写入的一段，整体写入时为与原值不同的最小区间
+// （与原值相同时为 0 字节），补发的快照为整个值（offset 为 0）；客户端把它合并进本地副本即得当前值
+
+// POST 报文尾部的时间戳（CLOCK_REALTIME）
+typedef struct {
+	timespec writetime;		// 服务端处理 writeb 的时刻
+	timespec dispatchtime;	// 服务端发出该 POST 的时刻
+} POSTSTAMP;
+
+// POST 报文尾部的序号。每个标签各自计数，每次写入加 1，客户端据此发现丢失的变化
+#define POSTFLAG_SNAPSHOT	0x01	// 该 POST 是订阅（或续订）时补发的当前值，而不是一次新的写入
+typedef struct {
+	unsigned long long seq;
+	int                flags;
+	int                reserved;
+} POSTSEQ;
+
+// 批量/通配/续订的 SUBSCRIBE：head.count > 0 时 body 为 SUBENTRY[head.count]，忽略 head.itemname。
+// tagname 可含通配符 '*'（匹配任意串）和 '?'（匹配单个字符）。
+// 带 SUBOPT_SNAPSHOT 续订时，lastseq 与服务端当前序号相同的标签不再补发，
+// 不同（或为 0）的补发当前值 —— 看板只保存最新值，中间丢失的变化合并为当前值
+typedef struct {
+	char               tagname[40];
+	unsigned long long lastseq;		// 客户端已收到的最后序号，0 表示没有
+} SUBENTRY;
+
 #pragma pack( pop, enter_MSG_H_ )
 
 #endif	/*MSG_H_*/
\ No newline at end of file
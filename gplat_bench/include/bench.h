@@ -0,0 +1,101 @@
+#pragma once
+
+/*
+ * bench.h — gplat_bench 负载发生器
+ *
+ * N 个连接 × M 个标签，按配置的比例混合发出 readb / writeb / readq / writeq / subscribe 请求，
+ * 另可开 S 个订阅连接订阅全部标签，统计 writeb → POST 的端到端延迟。
+ *
+ *   闭环（closed）：每个连接保持 depth 个请求在途，收到一个应答再发下一个，测的是“能跑多快”；
+ *   开环（open）  ：按总速率 rate 均分到各连接，按计划时刻发出（均匀或泊松到达），
+ *                   延迟从计划时刻算起，服务端排队造成的等待也计入，不会因客户端被拖慢而少算
+ *                   （coordinated omission）。
+ *
+ * 请求直接按 msg.h 协议组包（gplat_wire.h），head.eventid 带请求序号，应答可乱序；
+ * 服务端不带回序号时按发送顺序对应。结果输出为表格，--json 时另输出 JSON，便于不同服务端版本、
+ * 客户端特性之间对比。
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gplat_latency.h"
+
+namespace gplat {
+namespace bench {
+
+enum Op
+{
+    OP_READB = 0,
+    OP_WRITEB,
+    OP_READQ,
+    OP_WRITEQ,
+    OP_SUBSCRIBE, // 同一连接上对同一标签交替 SUBSCRIBE / CANCELSUBSCRIBE
+    OP_COUNT
+};
+
+const char *opName(int op);
+
+struct BenchOptions
+{
+    std::string server      = "127.0.0.1";
+    int         port        = 8777;
+    int         connections = 8;             // 请求连接数 N
+    int         tags        = 64;            // 标签数 M
+    std::string tag_prefix  = "BENCH_";      // 标签名 = 前缀 + 序号
+    int         value_size  = 4;             // 标签 / 队列记录长度（字节）
+    int         queues      = 1;             // 队列数
+    std::string queue_prefix = "BENCHQ";
+    int         mix[OP_COUNT] = {80, 20, 0, 0, 0}; // 各操作的权重
+    int         subscribers = 0;             // 订阅连接数 S
+
+    bool        open_loop    = false;
+    double      rate         = 10000;        // 开环：总请求速率（次/秒）
+    bool        poisson      = false;        // 开环：泊松到达（否则均匀）
+    int         depth        = 1;            // 闭环：每连接在途请求数
+    int         max_inflight = 4096;         // 开环：每连接在途上限，超过后推迟发送并计数
+
+    double      duration = 10;               // 统计时长（秒）
+    double      warmup   = 2;                // 预热时长（秒），不计入统计
+    bool        progress = true;             // 每秒在 stderr 打印一次吞吐
+    std::string json;                        // JSON 输出文件，"-" 为标准输出
+    std::string label;                       // 写入 JSON 的标签，区分不同服务端版本 / 配置
+    unsigned    seed = 1;
+};
+
+bool parseArgs(int argc, char *argv[], BenchOptions &opt, std::string *error);
+void printUsage(const char *prog);
+
+struct OpStats
+{
+    LatencyHistogram      latency;
+    std::atomic<uint64_t> ok{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<uint64_t> empty{0}; // readq 遇到空队列（不算错误）
+    std::atomic<uint64_t> full{0};  // writeq 遇到满队列（不算错误）
+};
+
+struct BenchResult
+{
+    OpStats               ops[OP_COUNT];
+    LatencyHistogram      posts;               // writeb → 订阅者收到 的端到端延迟
+    std::atomic<uint64_t> post_count{0};
+    std::atomic<uint64_t> deferred{0};         // 开环：因在途达到上限而推迟的发送
+    std::atomic<uint64_t> connect_failures{0};
+    std::atomic<uint64_t> issued{0};           // 预热之后发出的请求（进度输出用）
+    double                elapsed = 0;         // 实际统计时长（秒）
+};
+
+// 建标签、队列并写入初值（标签已存在不算失败）
+bool prepare(const BenchOptions &opt, std::string *error);
+
+// 启动所有连接，运行 warmup + duration 秒后返回
+void run(const BenchOptions &opt, BenchResult &result);
+
+void printTable(const BenchOptions &opt, const BenchResult &result);
+std::string toJson(const BenchOptions &opt, const BenchResult &result);
+
+} // namespace bench
+} // namespace gplat
@@ -0,0 +1,66 @@
+// gplat_bench —— higplat 服务端负载发生器
+// N 个连接 × M 个标签，按比例混合 readb/writeb/readq/writeq/subscribe，闭环或开环，
+// 输出各操作吞吐和延迟百分位（表格，--json 时另输出 JSON）
+//
+// 例：
+//   gplat_bench --connections=16 --depth=8 --mix=readb:70,writeb:30 --duration=30
+//   gplat_bench --mode=open --rate=50000 --arrival=poisson --subscribers=4 --json=result.json --label=v2
+
+#include <signal.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include "bench.h"
+
+int main(int argc, char *argv[])
+{
+    gplat::bench::BenchOptions opt;
+    std::string error;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--help" || std::string(argv[i]) == "-h")
+        {
+            gplat::bench::printUsage(argv[0]);
+            return 0;
+        }
+    }
+    if (!gplat::bench::parseArgs(argc, argv, opt, &error))
+    {
+        std::fprintf(stderr, "%s\n\n", error.c_str());
+        gplat::bench::printUsage(argv[0]);
+        return 2;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    if (!gplat::bench::prepare(opt, &error))
+    {
+        std::fprintf(stderr, "准备失败: %s\n", error.c_str());
+        return 1;
+    }
+
+    gplat::bench::BenchResult result;
+    gplat::bench::run(opt, result);
+    gplat::bench::printTable(opt, result);
+
+    if (!opt.json.empty())
+    {
+        std::string json = gplat::bench::toJson(opt, result);
+        if (opt.json == "-")
+        {
+            std::cout << json << std::endl;
+        }
+        else
+        {
+            std::ofstream out(opt.json);
+            out << json << std::endl;
+            if (!out)
+            {
+                std::fprintf(stderr, "写入 %s 失败\n", opt.json.c_str());
+                return 1;
+            }
+        }
+    }
+    return result.connect_failures.load() > 0 ? 1 : 0;
+}
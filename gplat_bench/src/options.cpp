@@ -0,0 +1,215 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include "bench.h"
+
+namespace gplat {
+namespace bench {
+
+namespace {
+
+bool toInt(const std::string &s, int &out)
+{
+    char *end = nullptr;
+    long  v   = std::strtol(s.c_str(), &end, 10);
+    if (end == s.c_str() || *end != '\0')
+    {
+        return false;
+    }
+    out = static_cast<int>(v);
+    return true;
+}
+
+bool toDouble(const std::string &s, double &out)
+{
+    char  *end = nullptr;
+    double v   = std::strtod(s.c_str(), &end);
+    if (end == s.c_str() || *end != '\0')
+    {
+        return false;
+    }
+    out = v;
+    return true;
+}
+
+// "readb:70,writeb:20,readq:5,writeq:5"
+bool parseMix(const std::string &s, int (&mix)[OP_COUNT], std::string *error)
+{
+    int parsed[OP_COUNT] = {0};
+    std::stringstream ss(s);
+    std::string       item;
+    while (std::getline(ss, item, ','))
+    {
+        auto pos = item.find(':');
+        int  w   = 0;
+        if (pos == std::string::npos || !toInt(item.substr(pos + 1), w) || w < 0)
+        {
+            *error = "--mix 格式应为 op:权重,...，错误项: " + item;
+            return false;
+        }
+        std::string name  = item.substr(0, pos);
+        bool        found = false;
+        for (int op = 0; op < OP_COUNT; ++op)
+        {
+            if (name == opName(op))
+            {
+                parsed[op] = w;
+                found      = true;
+            }
+        }
+        if (!found)
+        {
+            *error = "--mix 中未知的操作: " + name;
+            return false;
+        }
+    }
+    std::memcpy(mix, parsed, sizeof(parsed));
+    return true;
+}
+
+} // namespace
+
+void printUsage(const char *prog)
+{
+    std::printf(
+        "用法: %s [选项]\n"
+        "  --server=ADDR          服务端地址（127.0.0.1）\n"
+        "  --port=N               端口（8777）\n"
+        "  --connections=N        请求连接数（8）\n"
+        "  --tags=M               标签数（64）\n"
+        "  --tag-prefix=S         标签名前缀（BENCH_）\n"
+        "  --value-size=B         标签 / 队列记录长度，字节（4）\n"
+        "  --queues=K             队列数（1）\n"
+        "  --mix=OP:W,...         操作权重，OP 为 readb/writeb/readq/writeq/subscribe（readb:80,writeb:20）\n"
+        "  --subscribers=S        订阅全部标签的连接数，统计 writeb → POST 延迟（0）\n"
+        "  --mode=closed|open     闭环 / 开环（closed）\n"
+        "  --depth=D              闭环：每连接在途请求数（1）\n"
+        "  --rate=R               开环：总请求速率，次/秒（10000）\n"
+        "  --arrival=uniform|poisson  开环：到达间隔分布（uniform）\n"
+        "  --max-inflight=N       开环：每连接在途上限（4096）\n"
+        "  --duration=SEC         统计时长（10）\n"
+        "  --warmup=SEC           预热时长，不计入统计（2）\n"
+        "  --json=FILE|-          另输出 JSON 结果到文件或标准输出\n"
+        "  --label=S              写入 JSON 的标签\n"
+        "  --seed=N               随机种子（1）\n"
+        "  --quiet                不打印每秒进度\n",
+        prog);
+}
+
+bool parseArgs(int argc, char *argv[], BenchOptions &opt, std::string *error)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--quiet")
+        {
+            opt.progress = false;
+            continue;
+        }
+        auto eq = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos)
+        {
+            *error = "无法识别的参数: " + arg;
+            return false;
+        }
+        std::string key = arg.substr(2, eq - 2);
+        std::string val = arg.substr(eq + 1);
+        bool        ok  = true;
+
+        if (key == "server")
+            opt.server = val;
+        else if (key == "port")
+            ok = toInt(val, opt.port);
+        else if (key == "connections")
+            ok = toInt(val, opt.connections);
+        else if (key == "tags")
+            ok = toInt(val, opt.tags);
+        else if (key == "tag-prefix")
+            opt.tag_prefix = val;
+        else if (key == "value-size")
+            ok = toInt(val, opt.value_size);
+        else if (key == "queues")
+            ok = toInt(val, opt.queues);
+        else if (key == "mix")
+        {
+            if (!parseMix(val, opt.mix, error))
+            {
+                return false;
+            }
+        }
+        else if (key == "subscribers")
+            ok = toInt(val, opt.subscribers);
+        else if (key == "mode")
+        {
+            ok             = val == "open" || val == "closed";
+            opt.open_loop  = val == "open";
+        }
+        else if (key == "depth")
+            ok = toInt(val, opt.depth);
+        else if (key == "rate")
+            ok = toDouble(val, opt.rate);
+        else if (key == "arrival")
+        {
+            ok          = val == "uniform" || val == "poisson";
+            opt.poisson = val == "poisson";
+        }
+        else if (key == "max-inflight")
+            ok = toInt(val, opt.max_inflight);
+        else if (key == "duration")
+            ok = toDouble(val, opt.duration);
+        else if (key == "warmup")
+            ok = toDouble(val, opt.warmup);
+        else if (key == "json")
+            opt.json = val;
+        else if (key == "label")
+            opt.label = val;
+        else if (key == "seed")
+        {
+            int seed = 0;
+            ok       = toInt(val, seed);
+            opt.seed = static_cast<unsigned>(seed);
+        }
+        else
+        {
+            *error = "未知参数: --" + key;
+            return false;
+        }
+        if (!ok)
+        {
+            *error = "参数值非法: " + arg;
+            return false;
+        }
+    }
+
+    int weight = 0;
+    for (int op = 0; op < OP_COUNT; ++op)
+    {
+        weight += opt.mix[op];
+    }
+    if (opt.connections <= 0 || opt.tags <= 0 || opt.queues <= 0 || opt.depth <= 0 || opt.max_inflight <= 0 ||
+        opt.duration <= 0 || opt.warmup < 0 || opt.subscribers < 0 || opt.rate <= 0)
+    {
+        *error = "连接数、标签数、队列数、深度、时长、速率必须为正数";
+        return false;
+    }
+    if (opt.value_size <= 0 || opt.value_size > MAXMSGLEN)
+    {
+        *error = "--value-size 须在 1~" + std::to_string(MAXMSGLEN) + " 之间";
+        return false;
+    }
+    if (weight <= 0 && opt.subscribers == 0)
+    {
+        *error = "--mix 的权重之和为 0，且没有订阅连接";
+        return false;
+    }
+    if (weight <= 0)
+    {
+        opt.connections = 0; // 只测推送
+    }
+    return true;
+}
+
+} // namespace bench
+} // namespace gplat
@@ -0,0 +1,178 @@
+#include <cstdio>
+#include <sstream>
+
+#include "bench.h"
+
+namespace gplat {
+namespace bench {
+
+namespace {
+
+struct Row
+{
+    const char *name;
+    uint64_t    ok;
+    uint64_t    errors;
+    uint64_t    empty;
+    uint64_t    full;
+    const LatencyHistogram *latency;
+};
+
+void printRow(const Row &r, double elapsed)
+{
+    const LatencyHistogram &h = *r.latency;
+    uint64_t n = h.count();
+    std::printf("%-10s %10llu %11.0f %8llu %8llu %8llu %9.1f %9.1f %9.1f %9.1f %9.1f %10.1f\n", r.name,
+                static_cast<unsigned long long>(n), n / elapsed, static_cast<unsigned long long>(r.errors),
+                static_cast<unsigned long long>(r.empty), static_cast<unsigned long long>(r.full), h.meanNs() / 1e3,
+                h.percentileNs(0.50) / 1e3, h.percentileNs(0.90) / 1e3, h.percentileNs(0.99) / 1e3, h.percentileNs(0.999) / 1e3,
+                static_cast<double>(h.maxNs()) / 1e3);
+}
+
+void jsonLatency(std::ostringstream &os, const LatencyHistogram &h)
+{
+    os << "{\"mean\":" << h.meanNs() / 1e3 << ",\"p50\":" << h.percentileNs(0.50) / 1e3
+       << ",\"p90\":" << h.percentileNs(0.90) / 1e3 << ",\"p99\":" << h.percentileNs(0.99) / 1e3
+       << ",\"p999\":" << h.percentileNs(0.999) / 1e3 << ",\"max\":" << static_cast<double>(h.maxNs()) / 1e3
+       << "}";
+}
+
+std::string jsonString(const std::string &s)
+{
+    std::string out = "\"";
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        }
+        else
+        {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+} // namespace
+
+void printTable(const BenchOptions &opt, const BenchResult &result)
+{
+    double elapsed = result.elapsed > 0 ? result.elapsed : opt.duration;
+
+    std::printf("\n服务端 %s:%d，%s，连接 %d，标签 %d，值 %d 字节，订阅连接 %d，统计 %.1f 秒\n",
+                opt.server.c_str(), opt.port,
+                opt.open_loop ? (opt.poisson ? "开环（泊松到达）" : "开环（均匀到达）") : "闭环", opt.connections,
+                opt.tags, opt.value_size, opt.subscribers, elapsed);
+    if (opt.open_loop)
+    {
+        std::printf("目标速率 %.0f 次/秒，每连接在途上限 %d\n", opt.rate, opt.max_inflight);
+    }
+    else
+    {
+        std::printf("每连接在途 %d\n", opt.depth);
+    }
+    std::printf("\n%-10s %10s %11s %8s %8s %8s %9s %9s %9s %9s %9s %10s\n", "op", "count", "ops/s", "errors",
+                "empty", "full", "mean(us)", "p50", "p90", "p99", "p99.9", "max");
+
+    uint64_t total_errors = 0;
+    uint64_t total_empty  = 0;
+    uint64_t total_full   = 0;
+    for (int op = 0; op < OP_COUNT; ++op)
+    {
+        const OpStats &st = result.ops[op];
+        if (opt.mix[op] == 0)
+        {
+            continue;
+        }
+        Row r{opName(op), st.ok.load(), st.errors.load(), st.empty.load(), st.full.load(), &st.latency};
+        printRow(r, elapsed);
+        total_errors += r.errors;
+        total_empty += r.empty;
+        total_full += r.full;
+    }
+    // 合计行只给请求数和吞吐，延迟按操作分别看
+    uint64_t count = 0;
+    for (int op = 0; op < OP_COUNT; ++op)
+    {
+        count += result.ops[op].latency.count();
+    }
+    std::printf("%-10s %10llu %11.0f %8llu %8llu %8llu\n", "total", static_cast<unsigned long long>(count),
+                count / elapsed, static_cast<unsigned long long>(total_errors),
+                static_cast<unsigned long long>(total_empty), static_cast<unsigned long long>(total_full));
+
+    if (opt.subscribers > 0)
+    {
+        Row r{"post", result.post_count.load(), 0, 0, 0, &result.posts};
+        printRow(r, elapsed);
+    }
+    if (result.deferred.load() > 0)
+    {
+        std::printf("\n注意：%llu 次发送因在途达到上限而推迟，服务端跟不上目标速率\n",
+                    static_cast<unsigned long long>(result.deferred.load()));
+    }
+    if (result.connect_failures.load() > 0)
+    {
+        std::printf("注意：%llu 个连接建立失败\n", static_cast<unsigned long long>(result.connect_failures.load()));
+    }
+}
+
+std::string toJson(const BenchOptions &opt, const BenchResult &result)
+{
+    double elapsed = result.elapsed > 0 ? result.elapsed : opt.duration;
+
+    std::ostringstream os;
+    os << "{\"label\":" << jsonString(opt.label);
+    os << ",\"config\":{\"server\":" << jsonString(opt.server) << ",\"port\":" << opt.port
+       << ",\"mode\":\"" << (opt.open_loop ? "open" : "closed") << "\",\"connections\":" << opt.connections
+       << ",\"tags\":" << opt.tags << ",\"value_size\":" << opt.value_size << ",\"queues\":" << opt.queues
+       << ",\"subscribers\":" << opt.subscribers << ",\"depth\":" << opt.depth << ",\"rate\":" << opt.rate
+       << ",\"arrival\":\"" << (opt.poisson ? "poisson" : "uniform") << "\",\"duration\":" << opt.duration
+       << ",\"warmup\":" << opt.warmup << ",\"mix\":{";
+    for (int op = 0; op < OP_COUNT; ++op)
+    {
+        os << (op ? "," : "") << "\"" << opName(op) << "\":" << opt.mix[op];
+    }
+    os << "}}";
+
+    uint64_t count = 0;
+    os << ",\"ops\":{";
+    bool first = true;
+    for (int op = 0; op < OP_COUNT; ++op)
+    {
+        if (opt.mix[op] == 0)
+        {
+            continue;
+        }
+        const OpStats &st = result.ops[op];
+        uint64_t       n  = st.latency.count();
+        count += n;
+        os << (first ? "" : ",") << "\"" << opName(op) << "\":{\"count\":" << n << ",\"ops_per_sec\":" << n / elapsed
+           << ",\"errors\":" << st.errors.load() << ",\"empty\":" << st.empty.load()
+           << ",\"full\":" << st.full.load() << ",\"latency_us\":";
+        jsonLatency(os, st.latency);
+        os << "}";
+        first = false;
+    }
+    os << "},\"total\":{\"count\":" << count << ",\"ops_per_sec\":" << count / elapsed << "}";
+    if (opt.subscribers > 0)
+    {
+        os << ",\"posts\":{\"count\":" << result.post_count.load()
+           << ",\"per_sec\":" << result.post_count.load() / elapsed << ",\"latency_us\":";
+        jsonLatency(os, result.posts);
+        os << "}";
+    }
+    os << ",\"deferred\":" << result.deferred.load() << ",\"connect_failures\":" << result.connect_failures.load()
+       << "}";
+    return os.str();
+}
+
+} // namespace bench
+} // namespace gplat
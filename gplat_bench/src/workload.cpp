@@ -0,0 +1,560 @@
+#include "bench.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+
+#include "higplat.h" // 错误码
+#include "gplat_post.h"
+#include "gplat_wire.h"
+
+namespace gplat {
+namespace bench {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int64_t kMaxWaitNs = 100000000; // 无事可做时最长等待 100ms
+
+int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+std::string tagName(const BenchOptions &opt, int i)
+{
+    return opt.tag_prefix + std::to_string(i);
+}
+
+std::string queueName(const BenchOptions &opt, int i)
+{
+    return opt.queue_prefix + std::to_string(i);
+}
+
+int connect(const BenchOptions &opt)
+{
+    int fd = wire::connectTcp(opt.server.c_str(), opt.port, false);
+    if (fd >= 0)
+    {
+        int on = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+    return fd;
+}
+
+// 一个请求连接：序号环记录在途请求的类型和计时起点
+class Worker
+{
+public:
+    Worker(const BenchOptions &opt, BenchResult &result, int index, int64_t start_ns)
+        : opt_(opt), result_(result), rng_(opt.seed * 7919u + static_cast<unsigned>(index)),
+          start_ns_(start_ns)
+    {
+        cap_ = opt.open_loop ? opt.max_inflight : opt.depth;
+        cap_ = cap_ > 0 ? cap_ : 1;
+        slots_.resize(static_cast<std::size_t>(cap_));
+        subscribed_.assign(static_cast<std::size_t>(opt.tags), false);
+        for (int op = 0; op < OP_COUNT; ++op)
+        {
+            total_weight_ += opt.mix[op];
+        }
+        value_.assign(static_cast<std::size_t>(opt.value_size), static_cast<char>(index));
+        warm_ns_ = start_ns + static_cast<int64_t>(opt.warmup * 1e9);
+        end_ns_  = warm_ns_ + static_cast<int64_t>(opt.duration * 1e9);
+        if (opt.open_loop)
+        {
+            double per_conn = opt.rate / opt.connections;
+            interval_ns_    = per_conn > 0 ? 1e9 / per_conn : 1e9;
+        }
+    }
+
+    void operator()()
+    {
+        fd_ = connect(opt_);
+        if (fd_ < 0)
+        {
+            result_.connect_failures.fetch_add(1);
+            return;
+        }
+        if (opt_.open_loop)
+        {
+            runOpen();
+        }
+        else
+        {
+            runClosed();
+        }
+        drain();
+        ::close(fd_);
+    }
+
+private:
+    struct Slot
+    {
+        unsigned int seqno = 0; // 0 表示空闲
+        int          op    = 0;
+        int64_t      t0    = 0; // 计时起点：闭环为发送时刻，开环为计划时刻
+    };
+
+    void runClosed()
+    {
+        for (;;)
+        {
+            int64_t now = nowNs();
+            if (now >= end_ns_)
+            {
+                break;
+            }
+            while (inflight_ < cap_)
+            {
+                issue(nowNs());
+            }
+            if (!flush() || !receive(kMaxWaitNs))
+            {
+                return;
+            }
+        }
+    }
+
+    void runOpen()
+    {
+        double next = static_cast<double>(start_ns_) + firstOffset();
+        for (;;)
+        {
+            int64_t now = nowNs();
+            if (now >= end_ns_)
+            {
+                break;
+            }
+            // 补发所有已到计划时刻的请求；在途已满时推迟，计划时刻不变，延迟照常从计划时刻算起
+            while (next <= static_cast<double>(now))
+            {
+                if (inflight_ >= cap_)
+                {
+                    if (static_cast<int64_t>(next) >= warm_ns_)
+                    {
+                        result_.deferred.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    break;
+                }
+                issue(static_cast<int64_t>(next));
+                next += nextGap();
+            }
+            if (!flush())
+            {
+                return;
+            }
+            int64_t wait_ns = inflight_ >= cap_ ? kMaxWaitNs : static_cast<int64_t>(next) - nowNs();
+            if (!receive(wait_ns))
+            {
+                return;
+            }
+        }
+    }
+
+    // 结束后等在途请求的应答，最多 1 秒，超过统计窗口的应答不计入
+    void drain()
+    {
+        int64_t deadline = nowNs() + 1000000000;
+        while (inflight_ > 0 && nowNs() < deadline)
+        {
+            if (!receive(kMaxWaitNs))
+            {
+                return;
+            }
+        }
+    }
+
+    double firstOffset()
+    {
+        std::uniform_real_distribution<double> u(0.0, interval_ns_);
+        return u(rng_); // 各连接错开起点
+    }
+
+    double nextGap()
+    {
+        if (!opt_.poisson)
+        {
+            return interval_ns_;
+        }
+        std::exponential_distribution<double> e(1.0 / interval_ns_);
+        return e(rng_);
+    }
+
+    int pickOp()
+    {
+        int r = std::uniform_int_distribution<int>(0, total_weight_ - 1)(rng_);
+        for (int op = 0; op < OP_COUNT; ++op)
+        {
+            if (r < opt_.mix[op])
+            {
+                return op;
+            }
+            r -= opt_.mix[op];
+        }
+        return OP_READB;
+    }
+
+    void issue(int64_t t0)
+    {
+        int     op  = pickOp();
+        MSGHEAD head;
+        const void *body = nullptr;
+        int         size = 0;
+        switch (op)
+        {
+        case OP_READB:
+            head          = wire::makeHead(READB, "", randomTag().c_str());
+            head.datasize = opt_.value_size;
+            break;
+        case OP_WRITEB:
+            head          = wire::makeHead(WRITEB, "", randomTag().c_str());
+            head.datasize = opt_.value_size;
+            body          = value_.data();
+            size          = opt_.value_size;
+            break;
+        case OP_READQ:
+            head          = wire::makeHead(READQ, randomQueue().c_str(), "");
+            head.datasize = opt_.value_size;
+            break;
+        case OP_WRITEQ:
+            head          = wire::makeHead(WRITEQ, randomQueue().c_str(), "");
+            head.datasize = opt_.value_size;
+            body          = value_.data();
+            size          = opt_.value_size;
+            break;
+        default:
+        {
+            int  i     = std::uniform_int_distribution<int>(0, opt_.tags - 1)(rng_);
+            bool on    = subscribed_[static_cast<std::size_t>(i)];
+            head       = wire::makeHead(on ? CANCELSUBSCRIBE : SUBSCRIBE, "", tagName(opt_, i).c_str());
+            subscribed_[static_cast<std::size_t>(i)] = !on;
+            break;
+        }
+        }
+
+        unsigned int seqno = nextSeqno();
+        wire::setSeqno(head, seqno);
+        Slot &slot = slots_[seqno % static_cast<unsigned>(cap_)];
+        slot.seqno = seqno;
+        slot.op    = op;
+        slot.t0    = t0;
+        ++inflight_;
+        wire::appendFrame(out_, head, body, size);
+    }
+
+    unsigned int nextSeqno()
+    {
+        // 序号环按 cap_ 取模，在途不超过 cap_ 个，因此同一槽位不会被两个在途请求占用
+        do
+        {
+            ++seqno_;
+        } while (seqno_ == 0 || slots_[seqno_ % static_cast<unsigned>(cap_)].seqno != 0);
+        return seqno_;
+    }
+
+    bool flush()
+    {
+        if (out_.empty())
+        {
+            return true;
+        }
+        bool ok = wire::sendAll(fd_, out_.data(), out_.size());
+        out_.clear();
+        return ok;
+    }
+
+    // 等待最多 timeout_ns，处理读到的全部应答；连接断开返回 false。
+    // 开环下两次发送的间隔常不足 1ms，用 ppoll 精确等待而不是忙等，免得和服务端抢 CPU
+    bool receive(int64_t timeout_ns)
+    {
+        timeout_ns = timeout_ns > 0 ? timeout_ns : 0;
+        timespec ts{static_cast<time_t>(timeout_ns / 1000000000), static_cast<long>(timeout_ns % 1000000000)};
+        pollfd   pfd{fd_, POLLIN, 0};
+        int      ready = ::ppoll(&pfd, 1, &ts, nullptr);
+        if (ready <= 0)
+        {
+            return ready == 0 || errno == EINTR;
+        }
+        ssize_t n = rx_.readFrom(fd_);
+        if (n <= 0)
+        {
+            return n < 0 && (errno == EAGAIN || errno == EINTR);
+        }
+        int64_t      now = nowNs();
+        wire::Frame  frame;
+        unsigned int err = 0;
+        while (rx_.next(frame, &err))
+        {
+            if (frame.head.id == POST)
+            {
+                continue; // subscribe 操作带来的推送，只丢弃
+            }
+            complete(frame.head, now);
+        }
+        return err == 0;
+    }
+
+    void complete(const MSGHEAD &reply, int64_t now)
+    {
+        Slot *slot = nullptr;
+        unsigned int seqno = wire::seqnoOf(reply);
+        if (seqno != 0)
+        {
+            Slot &s = slots_[seqno % static_cast<unsigned>(cap_)];
+            slot    = s.seqno == seqno ? &s : nullptr;
+        }
+        else
+        {
+            // 服务端不带回序号：按发送顺序对应，取最早的在途请求
+            for (unsigned int i = fifo_ + 1; i != seqno_ + 1; ++i)
+            {
+                Slot &s = slots_[i % static_cast<unsigned>(cap_)];
+                if (s.seqno == i)
+                {
+                    slot  = &s;
+                    fifo_ = i;
+                    break;
+                }
+            }
+        }
+        if (slot == nullptr)
+        {
+            return;
+        }
+
+        int     op = slot->op;
+        int64_t t0 = slot->t0;
+        slot->seqno = 0;
+        --inflight_;
+
+        if (t0 < warm_ns_ || now > end_ns_)
+        {
+            return; // 预热期间发出或统计窗口之后完成
+        }
+        OpStats &st = result_.ops[op];
+        if (reply.id == SUCCEED)
+        {
+            st.ok.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (op == OP_READQ && reply.error == ERROR_DQ_EMPTY)
+        {
+            st.empty.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (op == OP_WRITEQ && reply.error == ERROR_DQ_FULL)
+        {
+            st.full.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            st.errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        st.latency.record(now - t0);
+        result_.issued.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::string randomTag()
+    {
+        return tagName(opt_, std::uniform_int_distribution<int>(0, opt_.tags - 1)(rng_));
+    }
+
+    std::string randomQueue()
+    {
+        return queueName(opt_, std::uniform_int_distribution<int>(0, opt_.queues - 1)(rng_));
+    }
+
+    const BenchOptions &opt_;
+    BenchResult        &result_;
+    std::mt19937        rng_;
+    wire::FrameBuffer   rx_;
+    std::vector<char>   out_;
+    std::vector<Slot>   slots_;
+    std::vector<bool>   subscribed_;
+    std::vector<char>   value_;
+    int                 fd_           = -1;
+    int                 cap_          = 1;
+    int                 inflight_     = 0;
+    int                 total_weight_ = 0;
+    unsigned int        seqno_        = 0;
+    unsigned int        fifo_         = 0;
+    double              interval_ns_  = 0;
+    int64_t             start_ns_;
+    int64_t             warm_ns_;
+    int64_t             end_ns_;
+};
+
+// 订阅连接：订阅全部标签（SUBOPT_STAMP），统计 写入 → 收到 的端到端延迟
+void subscriber(const BenchOptions &opt, BenchResult &result, int64_t start_ns)
+{
+    int fd = connect(opt);
+    if (fd < 0)
+    {
+        result.connect_failures.fetch_add(1);
+        return;
+    }
+    PostReceiver          rx;
+    std::vector<SUBENTRY> entries;
+    for (int i = 0; i < opt.tags; ++i)
+    {
+        entries.push_back(makeSubEntry(tagName(opt, i)));
+    }
+    unsigned int error = 0;
+    if (!subscribe_batch(fd, rx, entries.data(), static_cast<int>(entries.size()), SUBOPT_STAMP, &error))
+    {
+        std::fprintf(stderr, "subscribe failed, error=%u\n", error);
+        ::close(fd);
+        return;
+    }
+
+    int64_t  warm_ns = start_ns + static_cast<int64_t>(opt.warmup * 1e9);
+    int64_t  end_ns  = warm_ns + static_cast<int64_t>(opt.duration * 1e9);
+    PostView events[256];
+    while (nowNs() < end_ns)
+    {
+        int n = waitpostdata_multi(fd, rx, events, 256, 100, &error);
+        if (n < 0)
+        {
+            break;
+        }
+        if (nowNs() < warm_ns)
+        {
+            continue;
+        }
+        for (int i = 0; i < n; ++i)
+        {
+            const PostView &ev = events[i];
+            int64_t ns = (ev.recvtime.tv_sec - ev.writetime.tv_sec) * 1000000000LL +
+                         (ev.recvtime.tv_nsec - ev.writetime.tv_nsec);
+            result.posts.record(ns);
+        }
+        result.post_count.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+    }
+    ::close(fd);
+}
+
+} // namespace
+
+const char *opName(int op)
+{
+    static const char *names[OP_COUNT] = {"readb", "writeb", "readq", "writeq", "subscribe"};
+    return op >= 0 && op < OP_COUNT ? names[op] : "?";
+}
+
+bool prepare(const BenchOptions &opt, std::string *error)
+{
+    int fd = connect(opt);
+    if (fd < 0)
+    {
+        *error = "无法连接 " + opt.server + ":" + std::to_string(opt.port);
+        return false;
+    }
+    wire::FrameBuffer rx;
+    std::vector<char> value(static_cast<std::size_t>(opt.value_size), 0);
+    MSGHEAD           reply;
+    unsigned int      err = 0;
+
+    for (int i = 0; i < opt.tags; ++i)
+    {
+        std::string tag  = tagName(opt, i);
+        MSGHEAD     head = wire::makeHead(CREATEITEM, "", tag.c_str());
+        head.datasize    = opt.value_size;
+        if (!wire::call(fd, rx, head, nullptr, 0, reply, nullptr, &err) && err != ERROR_ITEM_ALREADY_EXIST)
+        {
+            *error = "创建标签 " + tag + " 失败，错误码 " + std::to_string(err);
+            ::close(fd);
+            return false;
+        }
+        head          = wire::makeHead(WRITEB, "", tag.c_str());
+        head.datasize = opt.value_size;
+        if (!wire::call(fd, rx, head, value.data(), opt.value_size, reply, nullptr, &err))
+        {
+            *error = "写标签 " + tag + " 失败，错误码 " + std::to_string(err);
+            ::close(fd);
+            return false;
+        }
+    }
+
+    // 队列：各写入一条记录确认可写（服务端自动创建），readq 比例高时空队列计入 empty
+    if (opt.mix[OP_READQ] > 0 || opt.mix[OP_WRITEQ] > 0)
+    {
+        for (int i = 0; i < opt.queues; ++i)
+        {
+            std::string q    = queueName(opt, i);
+            MSGHEAD     head = wire::makeHead(WRITEQ, q.c_str(), "");
+            head.datasize    = opt.value_size;
+            if (!wire::call(fd, rx, head, value.data(), opt.value_size, reply, nullptr, &err) &&
+                err != ERROR_DQ_FULL)
+            {
+                *error = "写队列 " + q + " 失败，错误码 " + std::to_string(err);
+                ::close(fd);
+                return false;
+            }
+        }
+    }
+    ::close(fd);
+    return true;
+}
+
+void run(const BenchOptions &opt, BenchResult &result)
+{
+    int64_t start = nowNs() + 100000000; // 留出连接建立的时间
+    int64_t warm  = start + static_cast<int64_t>(opt.warmup * 1e9);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < opt.subscribers; ++i)
+    {
+        threads.emplace_back(subscriber, std::cref(opt), std::ref(result), start);
+    }
+    for (int i = 0; i < opt.connections; ++i)
+    {
+        threads.emplace_back(Worker(opt, result, i, start));
+    }
+
+    std::atomic<bool> done{false};
+    std::thread       progress;
+    if (opt.progress)
+    {
+        progress = std::thread([&] {
+            uint64_t last = 0;
+            int      sec  = 0;
+            while (!done.load())
+            {
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+                if (nowNs() < warm)
+                {
+                    std::fprintf(stderr, "预热中...\n");
+                    continue;
+                }
+                uint64_t cur = result.issued.load(std::memory_order_relaxed);
+                std::fprintf(stderr, "[%3d s] %10llu ops/s\n", ++sec, static_cast<unsigned long long>(cur - last));
+                last = cur;
+            }
+        });
+    }
+
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+    done.store(true);
+    if (progress.joinable())
+    {
+        progress.join();
+    }
+    result.elapsed = opt.duration;
+}
+
+} // namespace bench
+} // namespace gplat
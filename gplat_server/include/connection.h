@@ -0,0 +1,89 @@
+#pragma once
+
+/*
+ * connection.h — 服务端的一个客户端连接
+ *
+ * 连接归属于一个 IO 线程，请求只在该线程中处理；推送可能来自任意线程（写标签的 IO 线程、
+ * 延时推送线程），因此发送缓冲区由互斥量保护：
+ *   - 缓冲区为空时直接 sendmsg，发不完的部分留在缓冲区并关注 EPOLLOUT；
+ *   - 缓冲区非空时只追加，保证报文顺序；
+ *   - IO 线程处理一批请求时以 cork 方式只追加应答，整批处理完再 flush，一次系统调用发出。
+ * 缓冲区超过上限（订阅者太慢）时关闭连接，而不是无限占用内存。
+ */
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gplat_wire.h"
+#include "qbdstore.h"
+
+namespace gplat {
+namespace server {
+
+class Connection : public std::enable_shared_from_this<Connection>
+{
+public:
+    Connection(int fd, int epfd, uint64_t id, std::string peer, std::size_t max_out);
+    ~Connection();
+
+    Connection(const Connection &)            = delete;
+    Connection &operator=(const Connection &) = delete;
+
+    // 发送报文：head 之后依次拼接 parts；cork 为 true 时只追加，等 flush 统一发出
+    bool write(const MSGHEAD &head, const iovec *parts, int nparts, bool cork);
+    bool write(const MSGHEAD &head, const void *body, int size, bool cork)
+    {
+        iovec part{const_cast<void *>(body), static_cast<std::size_t>(size)};
+        return write(head, &part, size > 0 ? 1 : 0, cork);
+    }
+
+    // 发出缓冲区中的数据（IO 线程在批处理结束和 EPOLLOUT 时调用），返回 false 表示连接已坏
+    bool flush();
+
+    // 关闭套接字（IO 线程调用），之后的 write 全部失败
+    void close();
+
+    int                fd() const { return fd_; }
+    uint64_t           id() const { return id_; }
+    const std::string &peer() const { return peer_; }
+    bool               closed() const { return closed_.load(std::memory_order_acquire); }
+
+    wire::FrameBuffer &rx() { return rx_; }
+
+    // 该连接打开的表快照，键为快照号（只在所属 IO 线程中访问），连接关闭时释放
+    std::unordered_map<int, qbd::Snapshot> &snapshots() { return snapshots_; }
+    int                                     nextSnapshotId() { return ++snapshot_id_; }
+
+private:
+    bool flushLocked();
+    void armOutput(bool on);
+
+    int               fd_;
+    int               epfd_;
+    uint64_t          id_;
+    std::string       peer_;
+    std::size_t       max_out_;
+    wire::FrameBuffer rx_;
+
+    std::unordered_map<int, qbd::Snapshot> snapshots_;
+    int                                    snapshot_id_ = 0;
+
+    std::mutex        out_mutex_;
+    std::vector<char> out_;
+    std::size_t       out_off_   = 0;
+    bool              out_armed_ = false;
+    std::atomic<bool> closed_{false};
+};
+
+using ConnectionPtr = std::shared_ptr<Connection>;
+
+} // namespace server
+} // namespace gplat
@@ -0,0 +1,47 @@
+#pragma once
+
+/*
+ * qbdhash.h — qbd.h 中声明为 inline 的散列和时间函数的定义
+ *
+ * hash1 给出起始位置，hash2 给出探测步长，调用方再按表长取模：
+ *   pos  = hash1(s) % size;
+ *   step = 1 + hash2(s) % (size - 1);   // size 为素数时可遍历整张表
+ */
+
+#include <time.h>
+
+#include <cstdio>
+
+#include "qbd.h"
+
+inline int hash1(const char *s)
+{
+    // FNV-1a
+    unsigned int h = 2166136261u;
+    for (int i = 0; i < MAXDQNAMELENTH && s[i] != '\0'; ++i)
+    {
+        h ^= static_cast<unsigned char>(s[i]);
+        h *= 16777619u;
+    }
+    return static_cast<int>(h & 0x7fffffff);
+}
+
+inline int hash2(const char *s)
+{
+    // djb2
+    unsigned int h = 5381;
+    for (int i = 0; i < MAXDQNAMELENTH && s[i] != '\0'; ++i)
+    {
+        h = h * 33 + static_cast<unsigned char>(s[i]);
+    }
+    return static_cast<int>(h & 0x7fffffff);
+}
+
+// 当前时间写成 "YYYY-MM-DD HH:MM:SS"，timebuf 至少 20 字节
+inline void gettime(const char *timebuf)
+{
+    time_t now = ::time(nullptr);
+    tm     local;
+    ::localtime_r(&now, &local);
+    ::strftime(const_cast<char *>(timebuf), 20, "%Y-%m-%d %H:%M:%S", &local);
+}
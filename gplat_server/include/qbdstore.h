@@ -0,0 +1,482 @@
+#pragma once
+
+/*
+ * qbdstore.h — 看板 / 队列 / 数据库表存储（gplat_store 静态库）
+ *
+ * 数据结构沿用 qbd.h 的内存布局，每个看板、队列是数据目录下的一个文件，
+ * 以 MAP_SHARED 映射进进程，已打开的对象登记在 TABLE_MSG 表中（inserttab / fetchtab）。
+ *
+ * 看板文件：
+ *   [BOARD_HEAD][数据区 datasize][类型区 typesize][序号区 INDEXSIZE × uint64]
+ *   BOARD_INDEX_STRUCT 按标签名双重散列（hash1 / hash2）定位，startpos / typeaddr 均为相对文件头的偏移；
+ *   每个标签的读写由 mutex_rw_tag[slot % MUTEXSIZE] 保护，建删标签由 mutex_rw 保护；
+ *   序号区保存每个标签的写入序号（msg.h 中的 POSTSEQ），随文件持久化；
+ *   类型区中每个标签的类型前有 8 字节前缀，存放建标签时算出的类型戳（见 msg.h），typeaddr 指向前缀之后。
+ *
+ * 队列文件：
+ *   [QUEUE_HEAD][类型区 typesize][(RECORD_HEAD + 记录) × (num + 1)]
+ *   环形缓冲，多留一个槽区分空和满；SHIFT_MODE 队列满时覆盖最旧的记录。
+ *
+ * 数据库文件：
+ *   [DB_HEAD][记录区 datasize][类型区 typesize]
+ *   DB_INDEX_STRUCT 按表名双重散列定位，每张表在记录区占一段 maxcount × recordsize 的连续空间，
+ *   记录按行号（从 0 起）访问；读写记录由 mutex_rw_tag[slot % MUTEXSIZE] 保护，建删表由 mutex_rw 保护。
+ *
+ * 历史序列：见下方"历史库"，每个序列若干个只追加的段文件。
+ *
+ * 派生标签：见下方"派生标签"，由其它标签按表达式在服务端算出。
+ *
+ * data_dir 为空时看板和队列都建在匿名内存中，进程退出即丢失。
+ *
+ * 大页（setHugePages）：完整的 BOARD_HEAD 连同 7177 个索引项约 600 KB，数据区常达数十 MB，
+ * 按 4 KB 页映射时随机访问标签几乎每次都 TLB 未命中；改用 2 MB 页后整个看板只占几十个 TLB 项。
+ */
+
+#include <pthread.h>
+#include <time.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "qbd.h"
+
+namespace qbd {
+
+// 设置数据目录，需在创建/打开任何对象之前调用
+void setDataDir(const std::string &dir);
+const std::string &dataDir();
+
+// 大页：作用于之后创建或打开的看板 / 队列，退回时不报错，实际方式见 mappingInfo()
+//   Off         4 KB 页（默认）
+//   Transparent madvise(MADV_HUGEPAGE) 请求透明大页；匿名内存改用大页对齐的 MAP_PRIVATE 映射
+//   Explicit    匿名内存用 MAP_HUGETLB（需预留 vm.nr_hugepages），失败时退回 Transparent
+// 文件映射：data_dir 在 hugetlbfs 上时与模式无关，文件长度按大页对齐；在 tmpfs 上时按模式 madvise；
+// 普通磁盘文件系统的共享映射不支持透明大页，仍为 4 KB 页
+enum class HugePages
+{
+    Off,
+    Transparent,
+    Explicit,
+};
+void      setHugePages(HugePages mode);
+HugePages hugePages();
+
+struct MappingInfo
+{
+    HugePages backing = HugePages::Off; // 实际使用的方式
+    long      size    = 0;              // 映射长度（按大页对齐后）
+};
+bool mappingInfo(const char *name, MappingInfo *info); // 对象未打开时返回 false
+
+// ============================================================
+//  看板
+// ============================================================
+
+// 一次读写时标签的状态，data 指向映射区，只在回调期间有效
+struct ItemEvent
+{
+    const char        *board    = nullptr;
+    const char        *itemname = nullptr;
+    const char        *data     = nullptr;
+    int                size     = 0;      // 标签长度（字符串标签为字符串长度）
+    timespec           timestamp{};
+    unsigned long long seq      = 0;
+    // 本次写入改变的字节 [dirtyoffset, dirtyoffset + dirtysize)：部分写入为写入的一段，
+    // 整体写入为与原值不同的最小区间（与原值相同时 dirtysize 为 0），补发快照时为整个值
+    int                dirtyoffset = 0;
+    int                dirtysize   = 0;
+};
+
+// 写入观察者：在标签锁内被调用，用于保证推送顺序与写入顺序一致
+class ItemObserver
+{
+public:
+    virtual ~ItemObserver() = default;
+    virtual void onWrite(const ItemEvent &ev) = 0;
+};
+
+struct ItemMeta
+{
+    int                itemsize = 0;
+    int                strlenth = 0;
+    timespec           timestamp{};
+    unsigned long long seq      = 0;
+    unsigned int       typestamp = 0; // 类型戳，标签长度或类型变化（删除后重建为另一定义）时改变
+};
+
+bool createBoard(const char *board, int datasize, int typesize, unsigned int *error);
+bool loadBoard(const char *board, unsigned int *error);    // 打开已有看板文件
+bool openBoard(const char *board, int datasize, int typesize, unsigned int *error); // 有则打开，无则创建
+bool clearBoard(const char *board, unsigned int *error);
+bool boardInfo(const char *board, BOARD_INFO *info, unsigned int *error);
+
+// 标签长度上限：整个值须能装进一个报文（msg.h 的 MAXMSGLEN），READB 应答和 POST 才不会超长
+constexpr int kMaxItemSize = 16384;
+
+// itemsize 超过 kMaxItemSize 时返回 ERROR_PARAMETER_SIZE
+bool createItem(const char *board, const char *itemname, int itemsize, const void *type, int typesize,
+                unsigned int *error);
+bool deleteItem(const char *board, const char *itemname, unsigned int *error);
+
+// 读标签：拷贝 min(bufsize, itemsize) 字节，meta 给出标签实际长度、时间戳和序号
+bool readItem(const char *board, const char *itemname, void *buf, int bufsize, ItemMeta *meta,
+              unsigned int *error);
+bool readItemString(const char *board, const char *itemname, char *buf, int bufsize, ItemMeta *meta,
+                    unsigned int *error);
+
+// 写标签：size 不能超过标签长度；observer 非空时在标签锁内回调
+bool writeItem(const char *board, const char *itemname, const void *data, int size, ItemObserver *observer,
+               unsigned int *error);
+bool writeItemString(const char *board, const char *itemname, const char *str, int length,
+                     ItemObserver *observer, unsigned int *error);
+
+// 部分读写：[offset, offset + len) 须在标签长度之内，否则 ERROR_ITEM_OVERFLOW；写入只改这一段
+bool readItemRange(const char *board, const char *itemname, int offset, void *buf, int len, ItemMeta *meta,
+                   unsigned int *error);
+bool writeItemRange(const char *board, const char *itemname, int offset, const void *data, int len,
+                    ItemObserver *observer, unsigned int *error);
+
+// 在标签锁内访问当前值（订阅时补发快照用），标签不存在返回 false
+bool visitItem(const char *board, const char *itemname, const std::function<void(const ItemEvent &)> &fn,
+               unsigned int *error);
+
+// typestamp 可为空
+bool readType(const char *board, const char *itemname, void *buf, int bufsize, int *typesize,
+              unsigned int *typestamp, unsigned int *error);
+
+// 列出看板上所有标签名（通配订阅用）
+void listItems(const char *board, std::vector<std::string> &names);
+
+// ============================================================
+//  检查点
+// ============================================================
+// 检查点映像：[CHECKPOINT_HEAD][索引 INDEXSIZE × BOARD_INDEX_STRUCT][已用数据区][已用类型区][序号区]
+// 只保存已用部分，比看板文件小得多；恢复时按目标看板的容量展开，目标看板可以比原看板大。
+struct CheckpointInfo
+{
+    int  items     = 0; // 有效标签数
+    long imagesize = 0; // 映像字节数
+};
+
+// 把看板同一时刻的映像写入 path（先写 path.tmp，fsync 后改名，中途失败不破坏已有映像）。
+// 拷贝期间持 mutex_rw，建删标签等待；数据区和序号在全部标签锁内一次拷贝，写标签等待这几毫秒
+bool checkpointBoard(const char *board, const char *path, CheckpointInfo *info, unsigned int *error);
+
+// 由映像恢复到已打开的看板，原有标签全部被替换；映像不存在时 error 为 ERROR_DQFILE_NOT_FOUND。
+// 映像以 MAP_POPULATE 一次映射预读，校验和不符或看板容量不足时不做任何修改
+bool restoreBoard(const char *board, const char *path, CheckpointInfo *info, unsigned int *error);
+
+// ============================================================
+//  数据库表
+// ============================================================
+// 插入追加在 currcount 处，表满返回 ERROR_TABLE_OVERFLOW；删除表只打标记，记录区在 clearDatabase 时整体回收。
+//
+// 二级索引：在记录的一个字段上声明（偏移 + 长度 + 键类型，或表的类型描述中的字段名，格式见 gplat_typecache.h），
+//   哈希索引做等值查找，O(1)，适合卷号等（近乎）唯一的键；有序索引做等值和范围查找，O(log n)。
+//   插入、更新、清空记录时在表锁内同步维护。索引只在进程内存中，声明时按已有记录建立，
+//   不写入数据库文件 —— 重新打开数据库（进程重启）后需再次声明。
+enum class KeyType
+{
+    Int,   // 有符号整数，1 / 2 / 4 / 8 字节
+    UInt,  // 无符号整数（含 bool），1 / 2 / 4 / 8 字节
+    Float, // float / double
+    Char,  // 定长字符串 char[N]，比较到第一个 '\0'
+    Bytes, // 定长字节串，按字节比较
+};
+
+enum class IndexKind
+{
+    Hash,
+    Ordered,
+};
+
+// 记录中的一个字段：name 非空时按表的类型描述解析，忽略其余成员
+struct FieldSpec
+{
+    std::string name;
+    KeyType     type   = KeyType::Int;
+    int         offset = 0;
+    int         size   = 0;
+};
+
+// 数值字段的 C 类型名 bool / char / uchar / short / ushort / int / uint / long / ulong / float / double，
+// 设置 field 的 type 和 size，其它名称返回 false（history_tags 和派生标签的表达式使用）
+bool numericType(const char *name, FieldSpec *field);
+
+struct IndexSpec
+{
+    std::string name; // 索引名，表内唯一
+    IndexKind   kind = IndexKind::Hash;
+    FieldSpec   field;
+};
+
+// 按键选择记录：index 非空时查索引，否则按 field 顺序扫描全表。
+// 键为字段的原始表示（与记录中的字节相同），Char 键可以短于字段长度
+struct KeyQuery
+{
+    std::string index;
+    FieldSpec   field;
+    const void *lo      = nullptr;
+    const void *hi      = nullptr; // 非空时为 [lo, hi] 范围查找（哈希索引不支持），否则等值查找
+    int         keysize = 0;
+    int         skip    = 0;       // 跳过前 skip 条匹配（分页）
+    int         limit   = 0;       // 最多返回条数
+};
+
+struct TableInfo
+{
+    int      recordsize = 0;
+    int      maxcount   = 0;
+    int      currcount  = 0;
+    int      indexes    = 0;
+    timespec timestamp{};          // 最后一次写入
+};
+
+bool createDatabase(const char *db, int datasize, int typesize, unsigned int *error);
+bool loadDatabase(const char *db, unsigned int *error);
+bool openDatabase(const char *db, int datasize, int typesize, unsigned int *error); // 有则打开，无则创建
+bool clearDatabase(const char *db, unsigned int *error);
+
+bool createTable(const char *db, const char *table, int recordsize, int maxcount, const void *type, int typesize,
+                 unsigned int *error);
+bool deleteTable(const char *db, const char *table, unsigned int *error);
+bool clearTable(const char *db, const char *table, unsigned int *error);
+bool tableInfo(const char *db, const char *table, TableInfo *info, unsigned int *error);
+bool readTableType(const char *db, const char *table, void *buf, int bufsize, int *typesize, unsigned int *error);
+
+// 追加记录：size 为字节数，须是记录长度的整数倍；firstrow / count 返回第一条的行号和条数（可为空）
+bool insertRecords(const char *db, const char *table, const void *records, int size, int *firstrow, int *count,
+                   unsigned int *error);
+// 覆盖从 row 起的记录（size 同上），这些行须已存在
+bool refreshRecords(const char *db, const char *table, int row, const void *records, int size, unsigned int *error);
+// 读 [row, row + count) 中已存在且放得进 buf 的记录，actcount 返回实际条数；info 可为空，与记录在同一次表锁内取得
+bool selectRecords(const char *db, const char *table, int row, int count, void *buf, int bufsize, int *actcount,
+                   TableInfo *info, unsigned int *error);
+
+// 建索引并按已有记录填充，indexed 返回已索引的记录数（可为空）；每张表最多 8 个索引
+bool createIndex(const char *db, const char *table, const IndexSpec &spec, int *indexed, unsigned int *error);
+bool dropIndex(const char *db, const char *table, const char *index, unsigned int *error);
+
+// 按键选择：匹配的行号写入 rows[]，records 非空时同时拷贝记录（bufsize 字节以内），在同一次表锁内完成。
+// 返回条数不超过 query.limit 和 bufsize / recordsize；more 为 true 表示其后还有匹配。
+// 顺序：有序索引按键再按行号，扫描按行号，哈希索引无序（表未修改时分页顺序不变）
+bool selectByKey(const char *db, const char *table, const KeyQuery &query, int *rows, void *records, int bufsize,
+                 int *actcount, bool *more, TableInfo *info, unsigned int *error);
+
+// ============================================================
+//  谓词扫描
+// ============================================================
+// 对数值字段（Int / UInt / Float）的比较和区间谓词，各谓词同时成立（AND）的记录匹配。
+// 记录按 64 条一块求值，选择性强的谓词放在前面，块内已无匹配时跳过其余谓词。
+enum class PredOp
+{
+    Eq,
+    Ne,
+    Lt,
+    Le,
+    Gt,
+    Ge,
+    Between, // value <= x <= value2
+};
+
+struct Predicate
+{
+    FieldSpec field;
+    PredOp    op = PredOp::Eq;
+    char      value[8]{};  // 字段的原始表示（field.size 字节）
+    char      value2[8]{}; // Between 的上界
+};
+
+struct ScanQuery
+{
+    std::vector<Predicate> preds;
+    int start = 0; // 从该行起扫描
+    int limit = 0; // 最多返回条数
+};
+
+// 匹配的行号写入 rows[]，records 非空时同时拷贝记录（bufsize 字节以内），扫描的是调用时刻的快照（见下方"快照读"）；
+// next 返回续扫的起始行（其前的行都已检查），等于 info->currcount 时已扫到表尾
+bool scanTable(const char *db, const char *table, const ScanQuery &query, int *rows, void *records, int bufsize,
+               int *actcount, int *next, TableInfo *info, unsigned int *error);
+
+// ============================================================
+//  快照读
+// ============================================================
+// 快照是打开时刻的表内容（打开时的记录数之内的各行），之后的插入、更新、清空对它不可见。
+// 打开时短暂持表锁，读快照不持表锁：写者在改写前为存活快照保存所在页的原像（页级写时复制），
+// 原像在最后一个引用它的快照释放时回收。表被删除后读快照失败（ERROR_TABLE_NOT_EXIST）。
+// 不带快照的 scanTable、无索引的 selectByKey 也在内部打开一个快照扫描，扫描期间不阻塞写者
+class TableSnapshot;
+using Snapshot = std::shared_ptr<TableSnapshot>;
+
+bool openSnapshot(const char *db, const char *table, Snapshot *snap, TableInfo *info, unsigned int *error);
+const TableInfo &snapshotInfo(const Snapshot &snap); // 打开时的记录长度、记录数等
+bool selectSnapshot(const Snapshot &snap, int row, int count, void *buf, int bufsize, int *actcount,
+                    unsigned int *error);
+bool scanSnapshot(const Snapshot &snap, const ScanQuery &query, int *rows, void *records, int bufsize, int *actcount,
+                  int *next, unsigned int *error);
+
+// ============================================================
+//  历史库
+// ============================================================
+// 序列是一个数值随时间的变化记录：时间戳（CLOCK_REALTIME 微秒）+ 值（按 double 保存），时间戳不减
+// （比前一点早时按前一点的时刻记录）。
+//
+// 段文件：<data_dir>/<序列名>.hNNNNN，每段 segmentsize 字节，MAP_SHARED 映射，只追加：
+//   [段头][块][块]...
+// 每块至多 1024 点（跨度达到 5 分钟且不少于 128 点时提前封存），块头带时间范围和 first / last / min / max / sum，其后是时间戳列（delta-of-delta 编码）
+// 和值列（与前一值 XOR 编码），匀速采样的时间戳每点 1 位，不变的值每点 1 位。
+// 范围查询按块头二分定位；降采样时整块落在一个桶内的直接合并块头，不解码。
+// 正在写的块在内存中（同样可查），写满、flushHistory、closeAll 时封存进段文件，进程崩溃最多丢失这一块。
+// data_dir 为空时段在匿名内存中。已封存的块不再改变，查询只在取块索引时短暂加锁，不阻塞追加
+struct HistoryPoint
+{
+    long long t     = 0; // 微秒
+    double    value = 0;
+};
+
+struct HistoryBucket
+{
+    long long start = 0; // 桶的起始时刻
+    int       count = 0; // 桶内点数，只返回非空的桶
+    double    min   = 0;
+    double    max   = 0;
+    double    avg   = 0;
+    double    first = 0;
+    double    last  = 0;
+};
+
+struct HistoryInfo
+{
+    long long points   = 0;
+    long long first    = 0; // 最早 / 最晚一点的时刻，无点时为 0
+    long long last     = 0;
+    long long bytes    = 0; // 已封存块的编码字节（含块头）
+    int       blocks   = 0;
+    int       segments = 0;
+    long long dropped  = 0; // 段文件写不下而丢弃的点
+};
+
+// 有则打开（沿用已有段文件，续写最后一段），无则创建；segmentsize 为 0 时每段 4 MB
+bool openHistory(const char *series, long segmentsize, unsigned int *error);
+bool appendHistory(const char *series, long long t, double value, unsigned int *error);
+// 封存正在写的块；series 为空时封存所有序列
+bool flushHistory(const char *series, unsigned int *error);
+bool historyInfo(const char *series, HistoryInfo *info, unsigned int *error);
+
+// [from, to) 内的点，跳过前 skip 点，至多 limit 点（0 为全部）；more 为 true 表示其后还有
+bool readHistory(const char *series, long long from, long long to, int skip, int limit,
+                 std::vector<HistoryPoint> &points, bool *more, unsigned int *error);
+// 从 from 起每 bucket 微秒一个桶，至多 limit 个非空桶（0 为全部）；more 同上
+bool downsampleHistory(const char *series, long long from, long long to, long long bucket, int limit,
+                       std::vector<HistoryBucket> &buckets, bool *more, unsigned int *error);
+
+namespace detail {
+class HistorySeries;
+}
+
+// 把看板上选定标签的每次变化记入历史库：作为 writeItem 的 observer，在标签锁内追加一点后交给 next。
+// 字段按 FieldSpec 的偏移 / 长度 / 类型给出（只限 Int / UInt / Float，不解析字段名），
+// 值未变化的写入（字段不在 ItemEvent 的改变区间内）不记录，趋势按阶梯保持。
+// 须在开始写入之前登记完毕，onWrite 不加锁查表
+class HistoryRecorder : public ItemObserver
+{
+public:
+    explicit HistoryRecorder(ItemObserver *next = nullptr) : next_(next) {}
+
+    // 序列须已 openHistory；标签可以尚不存在（自动创建），写入时长度不足的不记录
+    bool add(const char *board, const char *tag, const FieldSpec &field, const char *series, unsigned int *error);
+    bool empty() const { return captures_.empty(); }
+
+    void onWrite(const ItemEvent &ev) override;
+
+private:
+    struct Capture
+    {
+        std::string            board;
+        FieldSpec              field;
+        detail::HistorySeries *series = nullptr;
+    };
+
+    ItemObserver                                         *next_;
+    std::unordered_map<std::string, std::vector<Capture>> captures_; // 按标签名
+};
+
+// ============================================================
+//  派生标签
+// ============================================================
+// 由同一看板上其它标签按表达式算出的标签，定义为 "输出标签:类型 = 表达式"，如
+//   "TOTAL_SPEED:float = F1_SPEED:float + F2_SPEED:float + F3_SPEED:float"
+//   "MILL_READY:bool = DOOR_CLOSED:bool && PUMP_ON:bool && !ESTOP:bool && abs(TENSION@8:double) < 50"
+// 输入写作 标签[@偏移]:类型（类型见 numericType），数值一律按 double 计算；
+// 运算符按优先级从低到高为 || 、&&、比较（< <= > >= == !=，结果为 0 / 1）、+ -、* / %、一元 - !，
+// 函数 abs / sqrt / round / min / max / if(条件, 真值, 假值)。标签名由字母、数字、'_'、'.' 组成。
+//
+// 定义时编译成栈式字节码；作为 writeItem 的 observer，在标签锁内只把改变了所依赖字段的定义标记为待算，
+// 写入方释放标签锁后调用 evaluate()：按定义顺序逐个读入输入、求值，结果与上次写出的不同才写入输出标签
+// （经 observer 推送订阅者，依赖它的后续定义在同一次 evaluate 中接着算）。求值和写输出都不在输入的
+// 标签锁内，分段的标签锁不会嵌套。
+//
+// 输出写成整数时四舍五入并截到类型的范围，结果不是有限数或有输入标签不存在时不写。
+// 定义只能引用在它之前定义的派生标签，因而没有环；输出标签不存在时按类型长度创建。
+// 派生标签只应由 evaluate 写入，客户端写入的值会留到输入下一次变化。
+// 须在开始写入之前定义完毕，onWrite 不加锁查表
+class DerivedTags : public ItemObserver
+{
+public:
+    explicit DerivedTags(ItemObserver *next = nullptr);
+    ~DerivedTags() override;
+
+    DerivedTags(const DerivedTags &)            = delete;
+    DerivedTags &operator=(const DerivedTags &) = delete;
+
+    // 看板须已打开；定义不合法时 error 给出原因
+    bool add(const char *board, const char *definition, std::string *error);
+    bool empty() const { return defs_.empty(); }
+    int  size() const { return static_cast<int>(defs_.size()); }
+
+    void onWrite(const ItemEvent &ev) override;
+
+    // 有待算的定义（开销为一次原子读）
+    bool pending() const { return pending_.load(); }
+    // 计算待算的定义并写出，observer 用于写输出标签（通常为本对象所在观察者链的头）；返回写出的个数
+    int evaluate(ItemObserver *observer);
+
+private:
+    struct Definition;
+    bool evaluate(Definition &d, std::vector<double> &values, ItemObserver *observer);
+
+    struct Watch
+    {
+        std::string board;
+        FieldSpec   field;
+        Definition *def = nullptr;
+    };
+
+    ItemObserver                                        *next_;
+    std::vector<std::unique_ptr<Definition>>             defs_;    // 按定义顺序，即依赖顺序
+    std::unordered_map<std::string, std::vector<Watch>> watches_; // 按输入标签名
+    std::atomic<bool>                                    pending_{false};
+};
+
+// ============================================================
+//  队列
+// ============================================================
+bool createQueue(const char *qname, int recordsize, int recordnum, int datatype, int mode, const void *type,
+                 int typesize, unsigned int *error);
+bool loadQueue(const char *qname, unsigned int *error);
+bool readQueue(const char *qname, void *record, int bufsize, int *actsize, bool peek, RECORD_HEAD *rechead,
+               unsigned int *error);
+bool writeQueue(const char *qname, const void *record, int size, const char *remoteip, unsigned int *error);
+bool clearQueue(const char *qname, unsigned int *error);
+bool queueState(const char *qname, QUEUE_HEAD *head, unsigned int *error);
+
+// 关闭所有已打开的看板、队列、数据库和历史序列（刷回文件）
+void closeAll();
+
+} // namespace qbd
@@ -0,0 +1,169 @@
+#pragma once
+
+/*
+ * server.h — gplat 服务端（msg.h 协议）
+ *
+ * 线程模型：io_threads 个 IO 线程，每个线程一个 epoll 和一个 SO_REUSEPORT 监听套接字，
+ * 由内核在线程间分配新连接；连接建立后只在所属线程中收包和处理请求。
+ *
+ *   一次可读事件读出的所有报文逐个处理，应答以 cork 方式追加到发送缓冲，整批处理完再统一发出，
+ *   客户端流水线发来的多个请求因此只需一次 sendmsg；应答头复制请求头，head.eventid（请求序号）原样带回。
+ *
+ *   写标签在标签锁内回调 SubscriptionTable，直接向订阅者的连接推送 POST（可能跨线程，见 connection.h）。
+ *
+ * 请求中 qname 为空时操作默认看板（ServerOptions::board），否则操作同名的看板 / 队列。
+ * 订阅只作用于默认看板。数据库表的请求（msg.h 中的 *TB / *TABLE / *INDEX）qname 为空时操作默认数据库
+ * （ServerOptions::database），二级索引在服务端内存中，见 qbdstore.h。
+ *
+ * 检查点：设置 checkpoint_dir 后，CHECKPOINTB 请求、定时器（checkpoint_interval）和正常退出时
+ * 由检查点线程把看板映像写到 <checkpoint_dir>/<看板名>.ckpt（见 qbdstore.h），不占用 IO 线程；
+ * 启动时默认看板为空（新建或匿名内存）且有映像则由映像恢复。
+ *
+ * 历史库：history_tags 列出的默认看板标签（或其中一个数值字段）的每次变化由 HistoryRecorder 在标签锁内
+ * 记入同名的历史序列（见 qbdstore.h），先推送订阅者再记录；READHIST 请求按时间范围读原始点或降采样。
+ *
+ * 派生标签：derived_tags 中的定义（"输出标签:类型 = 表达式"，见 qbdstore.h 的 DerivedTags）启动时编译，
+ * 写默认看板的请求改变了某个定义的输入时，处理完该请求即在同一 IO 线程重算并写出输出标签，
+ * 像普通标签一样推送订阅者、记入历史库，客户端不必订阅输入、算好再 WRITEB 回来。
+ *
+ * 多路等待：WAITMULTI 请求登记一组队列和默认看板标签（见 msg.h、waittable.h），不占用 IO 线程，
+ * 写队列 / 写标签的请求处理完后在同一 IO 线程检查被唤醒的等待者并应答，超时由 DelayEngine 应答。
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "subscription.h"
+#include "waittable.h"
+
+namespace gplat {
+namespace server {
+
+struct ServerOptions
+{
+    std::string bind_address       = "0.0.0.0";
+    int         port               = 8777;
+    int         io_threads         = 4;
+    std::string board              = "BOARD";       // 默认看板
+    int         board_size         = 64 << 20;      // 默认看板数据区大小（字节）
+    int         board_typesize     = 4 << 20;       // 默认看板类型区大小（字节）
+    std::string database           = "DB";          // 默认数据库
+    int         database_size      = 64 << 20;      // 默认数据库记录区大小（字节）
+    int         database_typesize  = 1 << 20;       // 默认数据库类型区大小（字节）
+    std::string data_dir;                           // 为空时看板、队列和数据库都在匿名内存中
+    std::string huge_pages         = "off";         // 看板 / 队列映射：off / thp / hugetlb，不可用时自动退回（见 qbdstore.h）
+    bool        auto_create_tags   = true;          // WRITEB 写不存在的标签时按写入长度创建
+    bool        auto_create_queues = true;          // WRITEQ 写不存在的队列时按记录长度创建
+    int         queue_records      = 1024;          // 自动创建队列的记录数
+    std::size_t max_out_bytes      = 16u << 20;     // 单个连接发送缓冲上限，超过即断开
+    std::string checkpoint_dir;                     // 检查点目录，为空时不写检查点、启动时不恢复
+    int         checkpoint_interval = 0;            // 默认看板的定时检查点间隔（秒），0 为只在请求和退出时写
+    std::string history_tags;                       // 记入历史库的标签，"标签[@偏移]:类型" 以逗号或空白分隔
+    int         history_segment_kb = 4096;          // 历史库每个段文件的大小（KB）
+    std::string derived_tags;                       // 派生标签定义，以分号或换行分隔
+};
+
+struct ServerStats
+{
+    std::uint64_t     connections = 0;   // 当前连接数
+    std::uint64_t     accepted    = 0;   // 累计接受的连接
+    std::uint64_t     requests    = 0;   // 累计处理的请求
+    SubscriptionStats subscriptions;
+    std::size_t       delay_pending = 0;
+    std::size_t       waits         = 0;   // 登记中的 WAITMULTI
+    std::uint64_t     checkpoints   = 0;   // 累计写出的检查点
+};
+
+class Server
+{
+public:
+    explicit Server(ServerOptions options);
+    ~Server();
+
+    Server(const Server &)            = delete;
+    Server &operator=(const Server &) = delete;
+
+    // 打开默认看板、监听端口并启动 IO 线程；失败时 error 给出原因
+    bool start(std::string *error);
+    void stop();
+
+    ServerStats stats() const;
+
+    const ServerOptions &options() const { return options_; }
+
+private:
+    struct Reactor;
+
+    void runReactor(Reactor &r);
+    void acceptAll(Reactor &r);
+    void readConnection(Reactor &r, const ConnectionPtr &conn);
+    void closeConnection(Reactor &r, const ConnectionPtr &conn);
+
+    void handle(const ConnectionPtr &conn, const wire::Frame &frame);
+    void handleSubscribe(const ConnectionPtr &conn, const wire::Frame &frame);
+    void handleCancel(const ConnectionPtr &conn, const wire::Frame &frame);
+    void handleQueue(const ConnectionPtr &conn, const wire::Frame &frame);
+    void handleTable(const ConnectionPtr &conn, const wire::Frame &frame);
+    void selectByKey(const ConnectionPtr &conn, const wire::Frame &frame, const char *db, const char *table);
+    void scanTable(const ConnectionPtr &conn, const wire::Frame &frame, const char *db, const char *table);
+
+    // 写标签，不存在时按配置自动创建
+    bool writeTag(const char *board, const char *tag, const char *data, int size, qbd::ItemObserver *observer,
+                  unsigned int *error);
+    bool writeTagString(const char *board, const char *tag, const char *str, int len, qbd::ItemObserver *observer,
+                        unsigned int *error);
+    void writePlcBatch(const ConnectionPtr &conn, const wire::Frame &frame, qbd::ItemObserver *observer);
+    void readRange(const ConnectionPtr &conn, const wire::Frame &frame);
+    void readHistory(const ConnectionPtr &conn, const wire::Frame &frame);
+    void waitMulti(const ConnectionPtr &conn, const wire::Frame &frame);
+    bool openHistoryTags(std::string *error);
+    bool openDerivedTags(std::string *error);
+
+    bool ensureQueue(const char *qname, int recordsize, bool create, unsigned int *error);
+    const char *boardOf(const MSGHEAD &head) const;
+
+    // 检查点
+    struct CheckpointRequest
+    {
+        std::weak_ptr<Connection> conn;
+        MSGHEAD                   head;
+        std::string               board;
+    };
+    void        restoreDefaultBoard();
+    void        runCheckpoints();
+    bool        checkpoint(const std::string &board, qbd::CheckpointInfo *info, unsigned int *error);
+    std::string checkpointPath(const std::string &board) const;
+
+    ServerOptions                         options_;
+    DelayEngine                           delays_;
+    SubscriptionTable                     subs_;
+    WaitTable                             waits_;              // 先交给 subs_ 再唤醒 WAITMULTI
+    qbd::HistoryRecorder                  history_;            // 先交给 waits_ 再记入历史库
+    qbd::DerivedTags                      derived_;            // 先交给 history_ 再标记待算的派生标签
+    qbd::ItemObserver                    *observer_ = nullptr; // 默认看板的写入观察者，链头见 start()
+    std::vector<std::unique_ptr<Reactor>> reactors_;
+    std::mutex                            create_mutex_; // 自动创建 / 加载队列
+    std::atomic<bool>                     running_{false};
+    std::atomic<std::uint64_t>            next_id_{1};
+    std::atomic<std::uint64_t>            connections_{0};
+    std::atomic<std::uint64_t>            accepted_{0};
+    std::atomic<std::uint64_t>            requests_{0};
+
+    std::thread                           ckpt_thread_;
+    std::mutex                            ckpt_mutex_; // 保护 ckpt_queue_ / ckpt_stop_
+    std::condition_variable               ckpt_cv_;
+    std::deque<CheckpointRequest>         ckpt_queue_;
+    bool                                  ckpt_stop_ = false;
+    std::atomic<std::uint64_t>            checkpoints_{0};
+};
+
+} // namespace server
+} // namespace gplat
@@ -0,0 +1,184 @@
+#pragma once
+
+/*
+ * subscription.h — 订阅表与延时推送引擎
+ *
+ * SubscriptionTable 作为看板的写入观察者（qbd::ItemObserver），在标签锁内把新值推送给订阅者，
+ * 因此同一标签的推送顺序与写入顺序一致，订阅时补发的快照也不会与后续推送乱序。
+ * 锁顺序固定为：标签锁 → 订阅表锁。
+ *
+ *   精确订阅   tag → [(连接, 选项)]
+ *   通配订阅   [(连接, 模式, 选项)]，写入时逐个匹配（'*' 任意串，'?' 单个字符）
+ *   延时订阅   tag → [(连接, 事件名, 延时)]，每次写入挂起一个定时器（gplat_timerwheel.h），
+ *              到期推送 itemname = 事件名的 POST；CANCELSUBSCRIBE 带事件名时撤销未到期的定时器
+ *
+ * DelayEngine 的时间轮也用于 WAITMULTI 的超时（scheduleCall，见 waittable.h）。
+ *
+ * 同一连接对同一标签既有精确订阅又匹配通配订阅时只推送一次，选项取并集。
+ */
+
+#include <time.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "connection.h"
+#include "gplat_timerwheel.h"
+#include "qbdstore.h"
+
+namespace gplat {
+namespace server {
+
+bool globMatch(const char *pattern, const char *name);
+
+inline bool isPattern(const char *name)
+{
+    for (; *name != '\0'; ++name)
+    {
+        if (*name == '*' || *name == '?')
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 组装一条 POST 并发给 conn：数值 + 可选 POSTSEQ / POSTSTAMP（见 msg.h）；
+// 带 SUBOPT_RANGE 时 value 为标签中从 offset 起的 size 字节
+bool sendPost(Connection &conn, const char *itemname, const char *value, int size, const timespec &timestamp,
+              int options, unsigned long long seq, bool snapshot, const timespec &dispatchtime, int offset = 0);
+
+// ============================================================
+//  DelayEngine：延时推送，独立线程以 1ms 为 tick 驱动时间轮
+// ============================================================
+class DelayEngine
+{
+public:
+    DelayEngine();
+    ~DelayEngine();
+
+    void start();
+    void stop();
+
+    // 挂起一个延时推送；key 标识 (连接, 标签, 事件)，用于撤销
+    void schedule(const std::string &key, const ConnectionPtr &conn, const std::string &eventname,
+                  const char *value, int size, const timespec &timestamp, int delay_ms);
+
+    // 挂起一个回调，到期时在引擎线程中（不持锁）调用 fn，用于 WAITMULTI 的超时；key 同上
+    void scheduleCall(const std::string &key, int delay_ms, std::function<void()> fn);
+
+    // 撤销 key 下所有未到期的推送，返回撤销个数
+    std::size_t cancel(const std::string &key);
+
+    // 撤销某连接的全部推送（key 以 "连接id\0" 开头）
+    void cancelConnection(uint64_t conn_id);
+
+    std::size_t pending() const;
+
+private:
+    struct Fire
+    {
+        std::weak_ptr<Connection> conn;
+        std::string               key;
+        uint64_t                  id = 0; // 自身在时间轮中的 TimerId，到期时从 ids_[key] 中删去
+        std::string               eventname;
+        std::vector<char>         value;
+        timespec                  timestamp{};
+        std::function<void()>     call; // 非空时到期调用它，不推送
+    };
+    using Wheel = TimerWheel<Fire>;
+
+    void     run();
+    uint64_t nowTick() const;
+    void     forget(const std::string &key, Wheel::TimerId id);
+
+    mutable std::mutex                                          mutex_;
+    std::condition_variable                                     cv_;
+    Wheel                                                       wheel_;
+    std::unordered_map<std::string, std::vector<Wheel::TimerId>> ids_;
+    std::thread                                                 thread_;
+    bool                                                        running_ = false;
+    uint64_t                                                    epoch_ns_;
+};
+
+// ============================================================
+//  SubscriptionTable
+// ============================================================
+struct SubscriptionStats
+{
+    std::size_t   exact    = 0;
+    std::size_t   patterns = 0;
+    std::size_t   delays   = 0;
+    std::uint64_t posts    = 0;
+};
+
+class SubscriptionTable : public qbd::ItemObserver
+{
+public:
+    SubscriptionTable(std::string board, DelayEngine &delays);
+
+    // 精确订阅。SUBOPT_SNAPSHOT 时在标签锁内登记并补发当前值（lastseq 与当前序号相同则不补发）
+    bool subscribe(const ConnectionPtr &conn, const char *tag, int options, unsigned long long lastseq,
+                   unsigned int *error);
+
+    // 通配订阅；SUBOPT_SNAPSHOT 时为匹配到的每个标签补发当前值，lastseqs 给出已知标签的最后序号，
+    // handled 中的标签已由同一批次的精确订阅补发过，不再重复；补发过的标签加入 handled
+    void subscribePattern(const ConnectionPtr &conn, const char *pattern, int options,
+                          const std::unordered_map<std::string, unsigned long long> &lastseqs,
+                          std::unordered_set<std::string> &handled);
+
+    bool unsubscribe(const Connection &conn, const char *tag);
+
+    void subscribeDelay(const ConnectionPtr &conn, const char *tag, const char *eventname, int delay_ms);
+    void cancelDelay(const Connection &conn, const char *tag, const char *eventname);
+
+    void removeConnection(const Connection &conn);
+
+    void onWrite(const qbd::ItemEvent &ev) override;
+
+    SubscriptionStats stats() const;
+
+private:
+    struct Sub
+    {
+        ConnectionPtr conn;
+        int           options;
+    };
+    struct PatternSub
+    {
+        ConnectionPtr conn;
+        std::string   pattern;
+        int           options;
+    };
+    struct DelaySub
+    {
+        ConnectionPtr conn;
+        std::string   eventname;
+        int           delay_ms;
+    };
+
+    static std::string delayKey(uint64_t conn_id, const char *tag, const char *eventname);
+
+    // 登记精确订阅（调用方持有订阅表写锁）
+    void addExactLocked(const ConnectionPtr &conn, const char *tag, int options);
+
+    std::string                                            board_;
+    DelayEngine                                           &delays_;
+    mutable std::shared_mutex                              mutex_;
+    std::unordered_map<std::string, std::vector<Sub>>      exact_;
+    std::vector<PatternSub>                                patterns_;
+    std::unordered_map<std::string, std::vector<DelaySub>> delay_subs_;
+    std::atomic<std::uint64_t>                             posts_{0};
+};
+
+} // namespace server
+} // namespace gplat
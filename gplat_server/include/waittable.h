@@ -0,0 +1,91 @@
+#pragma once
+
+/*
+ * waittable.h — 多路等待（WAITMULTI，见 msg.h）的登记表
+ *
+ * 一个 WAITMULTI 请求是一个等待者，按条目登记在 队列名 → [等待者] 和 标签名 → [等待者] 两张表中：
+ *   队列   WRITEQ 成功后由服务端调用 queueWritten，唤醒该队列上的等待者；
+ *   标签   WaitTable 是默认看板写入观察者链的一环，onWrite 在标签锁内只把等待者放进待检查列表，
+ *          不读其它标签、不发送。
+ * 写入请求处理完后 IO 线程调用 dispatch，在锁外检查被唤醒者的全部条目，有就绪的即应答并撤销登记；
+ * 队列是水平触发的，可能已被别的连接读空，此时等待者继续等待。超时由 DelayEngine 的时间轮到期应答。
+ * 应答可能来自其它 IO 线程或延时线程，因此以非 cork 方式发送（见 connection.h）。
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "subscription.h"
+
+namespace gplat {
+namespace server {
+
+class WaitTable : public qbd::ItemObserver
+{
+public:
+    // board 为默认看板；标签写入先交给 next 再唤醒等待者
+    WaitTable(std::string board, DelayEngine &delays, qbd::ItemObserver *next);
+
+    // 登记一个 WAITMULTI 请求（条目由调用方校验过）。已有就绪条目或 head.timeout 为 0 时立即应答，
+    // 只能在 conn 所属的 IO 线程中调用
+    void wait(const ConnectionPtr &conn, const MSGHEAD &head, const WAITENTRY *entries, int count);
+
+    // 队列 qname 写入了记录
+    void queueWritten(const char *qname);
+
+    void onWrite(const qbd::ItemEvent &ev) override;
+
+    // 有被唤醒、待检查的等待者时由写入方调用 dispatch
+    bool pending() const { return pending_.load(std::memory_order_acquire); }
+    void dispatch();
+
+    void removeConnection(const Connection &conn);
+
+    std::size_t size() const; // 登记中的等待者数
+
+private:
+    struct Entry
+    {
+        std::string        name;
+        int                kind;
+        unsigned long long lastseq;
+    };
+    struct Waiter
+    {
+        ConnectionPtr      conn;
+        MSGHEAD            head;
+        std::vector<Entry> entries;
+        std::string        timer;         // 超时定时器在 DelayEngine 中的 key，不超时为空
+        bool               woken = false; // 已在 woken_ 中（持 mutex_ 访问）
+        std::atomic<bool>  done{false};   // 已应答
+    };
+    using WaiterPtr = std::shared_ptr<Waiter>;
+
+    // 就绪条目，按条目顺序
+    void collect(const Waiter &w, std::vector<WAITREADY> &ready) const;
+    // 撤销登记并应答；同一等待者只应答一次
+    void finish(const WaiterPtr &w, const std::vector<WAITREADY> &ready, bool cork);
+    void unregisterLocked(const WaiterPtr &w);
+    void wakeLocked(const std::vector<WaiterPtr> &waiters);
+
+    std::string                                             board_;
+    DelayEngine                                            &delays_;
+    qbd::ItemObserver                                      *next_;
+    mutable std::mutex                                      mutex_;
+    std::unordered_map<std::string, std::vector<WaiterPtr>> queues_;
+    std::unordered_map<std::string, std::vector<WaiterPtr>> tags_;
+    std::vector<WaiterPtr>                                  woken_;
+    std::size_t                                             waiters_ = 0;
+    std::atomic<std::size_t>                                tag_entries_{0}; // 为 0 时 onWrite 不进锁
+    std::atomic<bool>                                       pending_{false};
+    std::atomic<std::uint64_t>                              next_id_{1};
+};
+
+} // namespace server
+} // namespace gplat
@@ -0,0 +1,986 @@
+// 看板：BOARD_HEAD + 数据区 + 类型区 + 序号区，标签按名称双重散列定位
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "qbdhash.h"
+#include "qbdmap.h"
+
+namespace qbd {
+
+namespace {
+
+constexpr int kAlign = 8;
+
+// 类型区中每个标签的类型前面有一个 8 字节前缀，前 4 字节为类型戳
+constexpr int kTypePrefix = 8;
+
+inline int alignUp(int n)
+{
+    return (n + kAlign - 1) & ~(kAlign - 1);
+}
+
+// 类型戳：标签长度 + 类型内容的 FNV-1a 散列，0 留给"服务端未提供"
+unsigned int typeStamp(int itemsize, const void *type, int typesize)
+{
+    unsigned int h = 2166136261u;
+    auto mix = [&h](const unsigned char *p, int n) {
+        for (int i = 0; i < n; ++i)
+        {
+            h = (h ^ p[i]) * 16777619u;
+        }
+    };
+    mix(reinterpret_cast<const unsigned char *>(&itemsize), sizeof(itemsize));
+    mix(static_cast<const unsigned char *>(type), typesize);
+    return h != 0 ? h : 1;
+}
+
+struct Board
+{
+    BOARD_HEAD         *head = nullptr;
+    char               *base = nullptr;
+    unsigned long long *seqs = nullptr; // 序号区，与 index 一一对应
+};
+
+long boardFileSize(int datasize, int typesize)
+{
+    return static_cast<long>(sizeof(BOARD_HEAD)) + datasize + typesize +
+           static_cast<long>(sizeof(unsigned long long)) * INDEXSIZE;
+}
+
+Board viewOf(void *addr)
+{
+    Board b;
+    b.head = static_cast<BOARD_HEAD *>(addr);
+    b.base = static_cast<char *>(addr);
+    b.seqs = reinterpret_cast<unsigned long long *>(b.base + b.head->totalsize + b.head->typesize);
+    return b;
+}
+
+inline unsigned int storedStamp(const Board &b, const BOARD_INDEX_STRUCT &idx)
+{
+    unsigned int stamp;
+    std::memcpy(&stamp, b.base + idx.typeaddr - kTypePrefix, sizeof(stamp));
+    return stamp;
+}
+
+bool getBoard(const char *board, Board &b, unsigned int *error)
+{
+    TABLE_MSG tab;
+    if (!detail::lookup(board, BOARD_T, tab, error))
+    {
+        return false;
+    }
+    b = viewOf(tab.lpMapAddress);
+    return true;
+}
+
+// 文件中的互斥量状态属于上一个进程，映射后重新构造
+void initMutexes(BOARD_HEAD *head)
+{
+    new (&head->mutex_rw) std::mutex;
+    for (auto &m : head->mutex_rw_tag)
+    {
+        new (&m) std::mutex;
+    }
+}
+
+// 查找标签所在的索引槽，找不到返回 -1；free_slot 返回探测路径上第一个可用槽
+int findItem(const BOARD_HEAD *head, const char *itemname, int *free_slot)
+{
+    int pos  = hash1(itemname) % INDEXSIZE;
+    int step = 1 + hash2(itemname) % (INDEXSIZE - 1);
+    if (free_slot)
+    {
+        *free_slot = -1;
+    }
+    for (int i = 0; i < INDEXSIZE; ++i)
+    {
+        const BOARD_INDEX_STRUCT &idx = head->index[pos];
+        if (idx.itemname[0] == '\0')
+        {
+            if (free_slot && *free_slot < 0)
+            {
+                *free_slot = pos;
+            }
+            return -1;
+        }
+        if (idx.erased)
+        {
+            if (free_slot && *free_slot < 0)
+            {
+                *free_slot = pos;
+            }
+        }
+        else if (std::strncmp(idx.itemname, itemname, MAXDQNAMELENTH) == 0)
+        {
+            return pos;
+        }
+        pos = (pos + step) % INDEXSIZE;
+    }
+    return -1;
+}
+
+inline std::mutex &tagMutex(BOARD_HEAD *head, int slot)
+{
+    return head->mutex_rw_tag[slot % MUTEXSIZE];
+}
+
+// 无锁查找后在标签锁内复核：索引槽可能刚被删除
+inline bool stillValid(const BOARD_HEAD *head, int slot, const char *itemname)
+{
+    const BOARD_INDEX_STRUCT &idx = head->index[slot];
+    return !idx.erased && std::strncmp(idx.itemname, itemname, MAXDQNAMELENTH) == 0;
+}
+
+// dirtysize < 0 表示整个值都算改变
+ItemEvent makeEvent(const char *board, const Board &b, int slot, int size, int dirtyoffset = 0, int dirtysize = -1)
+{
+    const BOARD_INDEX_STRUCT &idx = b.head->index[slot];
+    ItemEvent ev;
+    ev.board       = board;
+    ev.itemname    = idx.itemname;
+    ev.data        = b.base + idx.startpos;
+    ev.size        = size;
+    ev.timestamp   = idx.timestamp;
+    ev.seq         = b.seqs[slot];
+    ev.dirtyoffset = dirtysize < 0 ? 0 : dirtyoffset;
+    ev.dirtysize   = dirtysize < 0 ? size : dirtysize;
+    return ev;
+}
+
+// 新值与原值不同的最小区间：返回长度，*first 为起点；完全相同时返回 0
+int diffSpan(const char *old, const char *data, int size, int *first)
+{
+    constexpr int kStep = 64; // 先按块跳过相同的头尾，再逐字节收窄
+    int lo = 0;
+    while (lo + kStep <= size && std::memcmp(old + lo, data + lo, kStep) == 0)
+    {
+        lo += kStep;
+    }
+    while (lo < size && old[lo] == data[lo])
+    {
+        ++lo;
+    }
+    *first = 0;
+    if (lo == size)
+    {
+        return 0;
+    }
+    int hi = size;
+    while (hi - kStep >= lo && std::memcmp(old + hi - kStep, data + hi - kStep, kStep) == 0)
+    {
+        hi -= kStep;
+    }
+    while (old[hi - 1] == data[hi - 1])
+    {
+        --hi;
+    }
+    *first = lo;
+    return hi - lo;
+}
+
+// 检查点映像头，其后依次为索引、已用数据区、已用类型区、序号区
+struct CHECKPOINT_HEAD
+{
+    char               magic[8];  // "GPLATCK1"
+    unsigned int       headsize;  // sizeof(BOARD_HEAD)，startpos 相对文件头，两边必须一致
+    unsigned int       indexsize; // INDEXSIZE
+    int                totalsize; // 原看板的 totalsize，恢复时据此换算 typeaddr
+    int                datasize;  // 已用数据区（不含 BOARD_HEAD）
+    int                typesize;  // 已用类型区
+    int                counter;
+    int                indexcount;
+    int                reserved;
+    timespec           created;
+    unsigned long long checksum;  // 映像头之后全部内容
+};
+
+constexpr char kCheckpointMagic[8] = {'G', 'P', 'L', 'A', 'T', 'C', 'K', '1'};
+
+long checkpointSize(int datasize, int typesize)
+{
+    return static_cast<long>(sizeof(CHECKPOINT_HEAD)) + static_cast<long>(sizeof(BOARD_INDEX_STRUCT)) * INDEXSIZE +
+           datasize + typesize + static_cast<long>(sizeof(unsigned long long)) * INDEXSIZE;
+}
+
+// 按 8 字节一组做 FNV-1a，映像可达数十 MB，逐字节散列会拖慢恢复
+unsigned long long checksum64(const char *p, long n)
+{
+    unsigned long long h = 14695981039346656037ull;
+    long i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        unsigned long long w;
+        std::memcpy(&w, p + i, sizeof(w));
+        h = (h ^ w) * 1099511628211ull;
+    }
+    for (; i < n; ++i)
+    {
+        h = (h ^ static_cast<unsigned char>(p[i])) * 1099511628211ull;
+    }
+    return h;
+}
+
+bool writeFully(int fd, const char *p, long n)
+{
+    while (n > 0)
+    {
+        ssize_t w = ::write(fd, p, static_cast<std::size_t>(n));
+        if (w < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        p += w;
+        n -= w;
+    }
+    return true;
+}
+
+// 映像写入 path.tmp，fsync 后改名并同步目录，任何时刻 path 都是完整的映像
+bool writeImage(const char *path, const std::vector<char> &image, unsigned int *error)
+{
+    std::string tmp = std::string(path) + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        detail::setError(error, ERROR_FILE_CREATE_FAILSURE);
+        return false;
+    }
+    bool ok = writeFully(fd, image.data(), static_cast<long>(image.size())) && ::fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || ::rename(tmp.c_str(), path) != 0)
+    {
+        ::unlink(tmp.c_str());
+        detail::setError(error, ERROR_FILE_CREATE_FAILSURE);
+        return false;
+    }
+    std::string dir = path;
+    std::size_t slash = dir.rfind('/');
+    dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : dir.substr(0, slash));
+    int dfd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dfd >= 0)
+    {
+        ::fsync(dfd);
+        ::close(dfd);
+    }
+    return true;
+}
+
+} // namespace
+
+bool createBoard(const char *board, int datasize, int typesize, unsigned int *error)
+{
+    if (datasize <= 0 || typesize < 0)
+    {
+        detail::setError(error, ERROR_PARAMETER_SIZE);
+        return false;
+    }
+    datasize = alignUp(datasize);
+    typesize = alignUp(typesize);
+
+    int  fd       = -1;
+    long filesize = 0;
+    void *addr    = detail::mapObject(board, boardFileSize(datasize, typesize), true, &fd, &filesize, error);
+    if (addr == nullptr)
+    {
+        return false;
+    }
+
+    // 新文件内容全为 0，只需填写头部
+    auto *head        = static_cast<BOARD_HEAD *>(addr);
+    head->qbdtype     = BOARD_T;
+    head->counter     = 0;
+    head->totalsize   = static_cast<int>(sizeof(BOARD_HEAD)) + datasize;
+    head->typesize    = typesize;
+    head->nextpos     = static_cast<int>(sizeof(BOARD_HEAD));
+    head->nexttypepos = head->totalsize;
+    head->remain      = datasize;
+    head->typeremain  = typesize;
+    head->indexcount  = 0;
+    initMutexes(head);
+
+    return detail::registerObject(board, addr, fd, filesize, error);
+}
+
+bool loadBoard(const char *board, unsigned int *error)
+{
+    int  fd       = -1;
+    long filesize = 0;
+    void *addr    = detail::mapObject(board, 0, false, &fd, &filesize, error);
+    if (addr == nullptr)
+    {
+        return false;
+    }
+    auto *head = static_cast<BOARD_HEAD *>(addr);
+    if (head->qbdtype != BOARD_T || filesize < boardFileSize(head->totalsize - static_cast<int>(sizeof(BOARD_HEAD)),
+                                                             head->typesize))
+    {
+        ::munmap(addr, filesize);
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        detail::setError(error, ERROR_FILE_OPEN_FAILSURE);
+        return false;
+    }
+    initMutexes(head);
+    return detail::registerObject(board, addr, fd, filesize, error);
+}
+
+bool openBoard(const char *board, int datasize, int typesize, unsigned int *error)
+{
+    TABLE_MSG tab;
+    if (fetchtab(board, tab))
+    {
+        return true;
+    }
+    unsigned int err = 0;
+    if (loadBoard(board, &err))
+    {
+        return true;
+    }
+    if (err != ERROR_DQFILE_NOT_FOUND)
+    {
+        detail::setError(error, err);
+        return false;
+    }
+    return createBoard(board, datasize, typesize, error);
+}
+
+bool clearBoard(const char *board, unsigned int *error)
+{
+    Board b;
+    if (!getBoard(board, b, error))
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(b.head->mutex_rw);
+    for (auto &m : b.head->mutex_rw_tag)
+    {
+        m.lock();
+    }
+    std::memset(b.head->index, 0, sizeof(b.head->index));
+    std::memset(b.seqs, 0, sizeof(unsigned long long) * INDEXSIZE);
+    b.head->counter     = 0;
+    b.head->indexcount  = 0;
+    b.head->nextpos     = static_cast<int>(sizeof(BOARD_HEAD));
+    b.head->nexttypepos = b.head->totalsize;
+    b.head->remain      = b.head->totalsize - static_cast<int>(sizeof(BOARD_HEAD));
+    b.head->typeremain  = b.head->typesize;
+    for (auto &m : b.head->mutex_rw_tag)
+    {
+        m.unlock();
+    }
+    detail::setError(error, 0);
+    return true;
+}
+
+bool boardInfo(const char *board, BOARD_INFO *info, unsigned int *error)
+{
+    Board b;
+    if (!getBoard(board, b, error))
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(b.head->mutex_rw);
+    info->totalsize     = b.head->totalsize;
+    info->remainsize    = b.head->remain;
+    info->tagcount_head = b.head->indexcount;
+    info->tagcount_act  = b.head->counter;
+    detail::setError(error, 0);
+    return true;
+}
+
+bool createItem(const char *board, const char *itemname, int itemsize, const void *type, int typesize,
+                unsigned int *error)
+{
+    if (itemname == nullptr || itemname[0] == '\0' || std::strlen(itemname) >= MAXDQNAMELENTH)
+    {
+        detail::setError(error, ERROR_INVALID_PARAMETER);
+        return false;
+    }
+    if (itemsize <= 0 || itemsize > kMaxItemSize || typesize < 0 || (typesize > 0 && type == nullptr))
+    {
+        detail::setError(error, ERROR_PARAMETER_SIZE);
+        return false;
+    }
+
+    Board b;
+    if (!getBoard(board, b, error))
+    {
+        return false;
+    }
+    BOARD_HEAD *head = b.head;
+    std::lock_guard<std::mutex> lock(head->mutex_rw);
+
+    int free_slot = -1;
+    if (findItem(head, itemname, &free_slot) >= 0)
+    {
+        detail::setError(error, ERROR_ITEM_ALREADY_EXIST);
+        return false;
+    }
+    if (free_slot < 0)
+    {
+        detail::setError(error, ERROR_TABLE_OVERFLOW);
+        return false;
+    }
+    int datalen = alignUp(itemsize);
+    int typelen = kTypePrefix + alignUp(typesize);
+    if (datalen > head->remain || typelen > head->typeremain)
+    {
+        detail::setError(error, ERROR_NO_SPACE);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> tag_lock(tagMutex(head, free_slot));
+    BOARD_INDEX_STRUCT &idx = head->index[free_slot];
+    bool reuse              = idx.itemname[0] != '\0';
+
+    idx.startpos  = head->nextpos;
+    idx.itemsize  = itemsize;
+    idx.strlenth  = 0;
+    idx.typeaddr  = head->nexttypepos + kTypePrefix;
+    idx.typesize  = typesize;
+    idx.timestamp = timespec{};
+    std::memset(b.base + idx.startpos, 0, itemsize);
+    unsigned int stamp = typeStamp(itemsize, type, typesize);
+    std::memcpy(b.base + head->nexttypepos, &stamp, sizeof(stamp));
+    if (typesize > 0)
+    {
+        std::memcpy(b.base + idx.typeaddr, type, typesize);
+    }
+    b.seqs[free_slot] = 0;
+    std::strncpy(idx.itemname, itemname, MAXDQNAMELENTH - 1);
+    idx.itemname[MAXDQNAMELENTH - 1] = '\0';
+    idx.erased                       = false;
+
+    head->nextpos += datalen;
+    head->remain -= datalen;
+    head->nexttypepos += typelen;
+    head->typeremain -= typelen;
+    head->counter++;
+    if (!reuse)
+    {
+        head->indexcount++;
+    }
+    detail::setError(error, 0);
+    return true;
+}
+
+// 删除只打标记，数据区不回收（与原实现一致，clearBoard 时整体回收）
+bool deleteItem(const char *board, const char *itemname, unsigned int *error)
+{
+    Board b;
+    if (!getBoard(board, b, error))
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(b.head->mutex_rw);
+    int slot = findItem(b.head, itemname, nullptr);
+    if (slot < 0)
+    {
+        detail::setError(error, ERROR_ITEM_NOT_EXIST);
+        return false;
+    }
+    std::lock_guard<std::mutex> tag_lock(tagMutex(b.head, slot));
+    b.head->index[slot].erased = true;
+    b.head->counter--;
+    detail::setError(error, 0);
+    return true;
+}
+
+bool readItem(const char *board, const char *itemname, void *buf, int bufsize, ItemMeta *meta,
+              unsigned int *error)
+{
+    Board b;
+    if (!getBoard(board, b, error))
+    {
+        return false;
+    }
+    int slot = findItem(b.head, itemname, nullptr);
+    if (slot < 0)
+    {
+        detail::setError(error, ERROR_ITEM_NOT_EXIST);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(tagMutex(b.head, slot));
+    if (!stillValid(b.head, slot, itemname))
+    {
+        detail::setError(error, ERROR_ITEM_NOT_EXIST);
+        return false;
+    }
+    const BOARD_INDEX_STRUCT &idx = b.head->index[slot];
+    int n = bufsize < idx.itemsize ? bufsize : idx.itemsize;
+    if (n > 0)
+    {
+        std::memcpy(buf, b.base + idx.startpos, n);
+    }
+    if (meta)
+    {
+        meta->itemsize  = idx.itemsize;
+        meta->strlenth  = idx.strlenth;
+        meta->timestamp = idx.timestamp;
+        meta->seq       = b.seqs[slot];
+        meta->typestamp = storedStamp(b, idx);
+    }
+    detail::setError(error, 0);
+    return true;
+}
+
+bool readItemString(const char *board, const char *itemname, char *buf, int bufsize, ItemMeta *meta,
+                    unsigned int *error)
+{
+    Board b;
+    if (!getBoard(board, b, error))
+    {
+        return false;
+    }
+    int slot = findItem(b.head, itemname, nullptr);
+    if (slot < 0)
+    {
+        detail::setError(error, ERROR_ITEM_NOT_EXIST);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(tagMutex(b.head, slot));
+    if (!stillValid(b.head, slot, itemname))
+    {
+        detail::setError(error, ERROR_ITEM_NOT_EXIST);
+        return false;
+    }
+    const BOARD_INDEX_STRUCT &idx = b.head->index[slot];
+    if (meta)
+    {
+        meta->itemsize  = idx.itemsize;
+        meta->strlenth  = idx.strlenth;
+        meta->timestamp = idx.timestamp;
+        meta->seq       = b.seqs[slot];
+        meta->typestamp = storedStamp(b, idx);
+    }
+    if (idx.strlenth + 1 > bufsize)
+    {
+        detail::setError(error, BUFFER_TOO_SMALL);
+        return false;
+    }
+    std::memcpy(buf, b.base + idx.startpos, idx.strlenth);
+    buf[idx.strlenth] = '\0';
+    detail::setError(error, 0);
+    return true;
+}
+
+bool writeItem(const char *board, const char *itemname, const void *data, int size, ItemObserver *observer,
+               unsigned int *error)
+{
+    Board b;
+    if (!getBoard(board, b, error))
+    {
+        return false;
+    }
+    int slot = findItem(b.head, itemname, nullptr);
+    if (slot < 0)
+    {
+        detail::setError(error, ERROR_ITEM_NOT_EXIST);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(tagMutex(b.head, slot));
+    if (!stillValid(b.head, slot, itemname))
+    {
+        detail::setError(error, ERROR_ITEM_NOT_EXIST);
+        return false;
+    }
+    BOARD_INDEX_STRUCT &idx = b.head->index[slot];
+    if (size < 0 || size > idx.itemsize)
+    {
+        detail::setError(error, ERROR_ITEM_OVERFLOW);
+        return false;
+    }
+    int first = 0, dirty = 0;
+    if (observer)
+    {
+        dirty = diffSpan(b.base + idx.startpos, static_cast<const char *>(data), size, &first);
+    }
+    std::memcpy(b.base + idx.startpos, data, size);
+    ::clock_gettime(CLOCK_REALTIME, &idx.timestamp);
+    ++b.seqs[slot];
+    if (observer)
+    {
+        observer->onWrite(makeEvent(board, b, slot, idx.itemsize, first, dirty));
+    }
+    detail::setError(error, 0);
+    return true;
+}
+
+bool readItemRange(const char *board, const char *itemname, int offset, void *buf, int len, ItemMeta *meta,
+                   unsigned int *error)
+{
+    Board b;
+    if (!getBoard(board, b, error))
+    {
+        return false;
+    }
+    int slot = findItem(b.head, itemname, nullptr);
+    if (slot < 0)
+    {
+        detail::setError(error, ERROR_ITEM_NOT_EXIST);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(tagMutex(b.head, slot));
+    if (!stillValid(b.head, slot, itemname))
+    {
+        detail::setError(error, ERROR_ITEM_NOT_EXIST);
+        return false;
+    }
+    const BOARD_INDEX_STRUCT &idx = b.head->index[slot];
+    if (meta)
+    {
+        meta->itemsize  = idx.itemsize;
+        meta->strlenth  = idx.strlenth;
+        meta->timestamp = idx.timestamp;
+        meta->seq       = b.seqs[slot];
+        meta->typestamp = storedStamp(b, idx);
+    }
+    if (offset < 0 || len < 0 || len > idx.itemsize - offset)
+    {
+        detail::setError(error, ERROR_ITEM_OVERFLOW);
+        return false;
+    }
+    std::memcpy(buf, b.base + idx.startpos + offset, len);
+    detail::setError(error, 0);
+    return true;
+}
+
+bool writeItemRange(const char *board, const char *itemname, int offset, const void *data, int len,
+                    ItemObserver *observer, unsigned int *error)
+{
+    Board b;
+    if (!getBoard(board, b, error))
+    {
+        return false;
+    }
+    int slot = findItem(b.head, itemname, nullptr);
+    if (slot < 0)
+    {
+        detail::setError(error, ERROR_ITEM_NOT_EXIST);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(tagMutex(b.head, slot));
+    if (!stillValid(b.head, slot, itemname))
+    {
+        detail::setError(error, ERROR_ITEM_NOT_EXIST);
+        return false;
+    }
+    BOARD_INDEX_STRUCT &idx = b.head->index[slot];
+    if (offset < 0 || len < 0 || len > idx.itemsize - offset)
+    {
+        detail::setError(error, ERROR_ITEM_OVERFLOW);
+        return false;
+    }
+    std::memcpy(b.base + idx.startpos + offset, data, len);
+    ::clock_gettime(CLOCK_REALTIME, &idx.timestamp);
+    ++b.seqs[slot];
+    if (observer)
+    {
+        observer->onWrite(makeEvent(board, b, slot, idx.itemsize, offset, len));
+    }
+    detail::setError(error, 0);
+    return true;
+}
+
+bool writeItemString(const char *board, const char *itemname, const char *str, int length,
+                     ItemObserver *observer, unsigned int *error)
+{
+    Board b;
+    if (!getBoard(board, b, error))
+    {
+        return false;
+    }
+    int slot = findItem(b.head, itemname, nullptr);
+    if (slot < 0)
+    {
+        detail::setError(error, ERROR_ITEM_NOT_EXIST);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(tagMutex(b.head, slot));
+    if (!stillValid(b.head, slot, itemname))
+    {
+        detail::setError(error, ERROR_ITEM_NOT_EXIST);
+        return false;
+    }
+    BOARD_INDEX_STRUCT &idx = b.head->index[slot];
+    if (length < 0 || length + 1 > idx.itemsize)
+    {
+        detail::setError(error, STRING_TOO_LONG);
+        return false;
+    }
+    char *dst = b.base + idx.startpos;
+    std::memcpy(dst, str, length);
+    dst[length]  = '\0';
+    idx.strlenth = length;
+    ::clock_gettime(CLOCK_REALTIME, &idx.timestamp);
+    ++b.seqs[slot];
+    if (observer)
+    {
+        observer->onWrite(makeEvent(board, b, slot, length + 1));
+    }
+    detail::setError(error, 0);
+    return true;
+}
+
+bool visitItem(const char *board, const char *itemname, const std::function<void(const ItemEvent &)> &fn,
+               unsigned int *error)
+{
+    Board b;
+    if (!getBoard(board, b, error))
+    {
+        return false;
+    }
+    int slot = findItem(b.head, itemname, nullptr);
+    if (slot < 0)
+    {
+        detail::setError(error, ERROR_ITEM_NOT_EXIST);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(tagMutex(b.head, slot));
+    if (!stillValid(b.head, slot, itemname))
+    {
+        detail::setError(error, ERROR_ITEM_NOT_EXIST);
+        return false;
+    }
+    const BOARD_INDEX_STRUCT &idx = b.head->index[slot];
+    fn(makeEvent(board, b, slot, idx.strlenth > 0 ? idx.strlenth + 1 : idx.itemsize));
+    detail::setError(error, 0);
+    return true;
+}
+
+bool readType(const char *board, const char *itemname, void *buf, int bufsize, int *typesize,
+              unsigned int *typestamp, unsigned int *error)
+{
+    Board b;
+    if (!getBoard(board, b, error))
+    {
+        return false;
+    }
+    int slot = findItem(b.head, itemname, nullptr);
+    if (slot < 0)
+    {
+        detail::setError(error, ERROR_ITEM_NOT_EXIST);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(tagMutex(b.head, slot));
+    if (!stillValid(b.head, slot, itemname))
+    {
+        detail::setError(error, ERROR_ITEM_NOT_EXIST);
+        return false;
+    }
+    const BOARD_INDEX_STRUCT &idx = b.head->index[slot];
+    *typesize = idx.typesize;
+    if (typestamp)
+    {
+        *typestamp = storedStamp(b, idx);
+    }
+    if (idx.typesize > bufsize)
+    {
+        detail::setError(error, ERROR_BUFFER_SIZE);
+        return false;
+    }
+    std::memcpy(buf, b.base + idx.typeaddr, idx.typesize);
+    detail::setError(error, 0);
+    return true;
+}
+
+void listItems(const char *board, std::vector<std::string> &names)
+{
+    Board b;
+    if (!getBoard(board, b, nullptr))
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(b.head->mutex_rw);
+    for (const auto &idx : b.head->index)
+    {
+        if (idx.itemname[0] != '\0' && !idx.erased)
+        {
+            names.emplace_back(idx.itemname);
+        }
+    }
+}
+
+// ============================================================
+//  检查点
+// ============================================================
+bool checkpointBoard(const char *board, const char *path, CheckpointInfo *info, unsigned int *error)
+{
+    Board b;
+    if (!getBoard(board, b, error))
+    {
+        return false;
+    }
+    BOARD_HEAD *head = b.head;
+    std::vector<char> image;
+    {
+        // 持 mutex_rw：索引和类型区只在建删标签时改变，拷贝期间保持不变
+        std::lock_guard<std::mutex> lock(head->mutex_rw);
+        CHECKPOINT_HEAD ck;
+        std::memset(&ck, 0, sizeof(ck));
+        std::memcpy(ck.magic, kCheckpointMagic, sizeof(ck.magic));
+        ck.headsize   = sizeof(BOARD_HEAD);
+        ck.indexsize  = INDEXSIZE;
+        ck.totalsize  = head->totalsize;
+        ck.datasize   = head->nextpos - static_cast<int>(sizeof(BOARD_HEAD));
+        ck.typesize   = head->nexttypepos - head->totalsize;
+        ck.counter    = head->counter;
+        ck.indexcount = head->indexcount;
+        ::clock_gettime(CLOCK_REALTIME, &ck.created);
+
+        image.resize(checkpointSize(ck.datasize, ck.typesize));
+        char *p     = image.data() + sizeof(CHECKPOINT_HEAD);
+        auto *index = reinterpret_cast<BOARD_INDEX_STRUCT *>(p);
+        char *data  = p + sizeof(BOARD_INDEX_STRUCT) * INDEXSIZE;
+        char *type  = data + ck.datasize;
+        auto *seqs  = reinterpret_cast<unsigned long long *>(type + ck.typesize);
+
+        std::memcpy(type, b.base + head->totalsize, ck.typesize);
+
+        // 持全部标签锁拷贝索引、数据区和序号，得到同一时刻的映像：放在不同标签里的相关值
+        // （如卷号和它的设定）不会一半是旧值。数据区是连续的一段，几千个标签也只锁几毫秒
+        for (auto &m : head->mutex_rw_tag)
+        {
+            m.lock();
+        }
+        std::memcpy(index, head->index, sizeof(head->index));
+        std::memcpy(data, b.base + sizeof(BOARD_HEAD), ck.datasize);
+        std::memcpy(seqs, b.seqs, sizeof(unsigned long long) * INDEXSIZE);
+        for (auto &m : head->mutex_rw_tag)
+        {
+            m.unlock();
+        }
+        ck.checksum = checksum64(p, static_cast<long>(image.size() - sizeof(CHECKPOINT_HEAD)));
+        std::memcpy(image.data(), &ck, sizeof(ck));
+        if (info)
+        {
+            info->items     = ck.counter;
+            info->imagesize = static_cast<long>(image.size());
+        }
+    }
+    if (!writeImage(path, image, error))
+    {
+        return false;
+    }
+    detail::setError(error, 0);
+    return true;
+}
+
+bool restoreBoard(const char *board, const char *path, CheckpointInfo *info, unsigned int *error)
+{
+    Board b;
+    if (!getBoard(board, b, error))
+    {
+        return false;
+    }
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        detail::setError(error, errno == ENOENT ? ERROR_DQFILE_NOT_FOUND : ERROR_FILE_OPEN_FAILSURE);
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(CHECKPOINT_HEAD)))
+    {
+        ::close(fd);
+        detail::setError(error, ERROR_FILE_OPEN_FAILSURE);
+        return false;
+    }
+    // 一次映射并预读全部页面，之后的校验和拷贝不再有缺页读盘
+    long  size = static_cast<long>(st.st_size);
+    void *addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+    {
+        detail::setError(error, ERROR_MAPVIEWOFFILE);
+        return false;
+    }
+    ::madvise(addr, size, MADV_SEQUENTIAL);
+
+    const char *image = static_cast<const char *>(addr);
+    CHECKPOINT_HEAD ck;
+    std::memcpy(&ck, image, sizeof(ck));
+    const char *p = image + sizeof(CHECKPOINT_HEAD);
+    bool valid = std::memcmp(ck.magic, kCheckpointMagic, sizeof(ck.magic)) == 0 &&
+                 ck.headsize == sizeof(BOARD_HEAD) && ck.indexsize == INDEXSIZE && ck.datasize >= 0 &&
+                 ck.typesize >= 0 && size == checkpointSize(ck.datasize, ck.typesize) &&
+                 checksum64(p, size - static_cast<long>(sizeof(CHECKPOINT_HEAD))) == ck.checksum;
+    if (!valid)
+    {
+        ::munmap(addr, size);
+        detail::setError(error, ERROR_FILE_OPEN_FAILSURE);
+        return false;
+    }
+
+    BOARD_HEAD *head = b.head;
+    if (ck.datasize > head->totalsize - static_cast<int>(sizeof(BOARD_HEAD)) || ck.typesize > head->typesize)
+    {
+        ::munmap(addr, size);
+        detail::setError(error, ERROR_NO_SPACE);
+        return false;
+    }
+
+    const auto *index = reinterpret_cast<const BOARD_INDEX_STRUCT *>(p);
+    const char *data  = p + sizeof(BOARD_INDEX_STRUCT) * INDEXSIZE;
+    const char *type  = data + ck.datasize;
+    const char *seqs  = type + ck.typesize;
+
+    std::lock_guard<std::mutex> lock(head->mutex_rw);
+    for (auto &m : head->mutex_rw_tag)
+    {
+        m.lock();
+    }
+    std::memcpy(head->index, index, sizeof(head->index));
+    std::memcpy(b.base + sizeof(BOARD_HEAD), data, ck.datasize);
+    std::memcpy(b.base + head->totalsize, type, ck.typesize);
+    std::memcpy(b.seqs, seqs, sizeof(unsigned long long) * INDEXSIZE);
+    // 类型区紧随数据区，目标看板数据区大小不同时 typeaddr 整体平移
+    int shift = head->totalsize - ck.totalsize;
+    if (shift != 0)
+    {
+        for (auto &idx : head->index)
+        {
+            if (idx.itemname[0] != '\0')
+            {
+                idx.typeaddr += shift;
+            }
+        }
+    }
+    head->counter     = ck.counter;
+    head->indexcount  = ck.indexcount;
+    head->nextpos     = static_cast<int>(sizeof(BOARD_HEAD)) + ck.datasize;
+    head->nexttypepos = head->totalsize + ck.typesize;
+    head->remain      = head->totalsize - head->nextpos;
+    head->typeremain  = head->typesize - ck.typesize;
+    for (auto &m : head->mutex_rw_tag)
+    {
+        m.unlock();
+    }
+    ::munmap(addr, size);
+
+    if (info)
+    {
+        info->items     = ck.counter;
+        info->imagesize = size;
+    }
+    detail::setError(error, 0);
+    return true;
+}
+
+} // namespace qbd
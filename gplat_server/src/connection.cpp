@@ -0,0 +1,186 @@
+#include "connection.h"
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace gplat {
+namespace server {
+
+Connection::Connection(int fd, int epfd, uint64_t id, std::string peer, std::size_t max_out)
+    : fd_(fd), epfd_(epfd), id_(id), peer_(std::move(peer)), max_out_(max_out), rx_(4 * wire::kFrameMax)
+{
+}
+
+Connection::~Connection()
+{
+    close();
+}
+
+bool Connection::write(const MSGHEAD &head, const iovec *parts, int nparts, bool cork)
+{
+    MSGHEAD h = head;
+    std::size_t bodysize = 0;
+    for (int i = 0; i < nparts; ++i)
+    {
+        bodysize += parts[i].iov_len;
+    }
+    h.bodysize = static_cast<int>(bodysize);
+
+    std::lock_guard<std::mutex> lock(out_mutex_);
+    if (closed_.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+
+    std::size_t pending = out_.size() - out_off_;
+    std::size_t total   = wire::kHeadSize + bodysize;
+    if (pending + total > max_out_)
+    {
+        // 对端读得太慢：断开连接，由 IO 线程回收
+        ::shutdown(fd_, SHUT_RDWR);
+        return false;
+    }
+
+    std::size_t sent = 0;
+    if (!cork && pending == 0)
+    {
+        iovec iov[8];
+        int   n       = 0;
+        iov[n].iov_base = &h;
+        iov[n].iov_len  = wire::kHeadSize;
+        ++n;
+        for (int i = 0; i < nparts && n < 8; ++i)
+        {
+            if (parts[i].iov_len > 0)
+            {
+                iov[n++] = parts[i];
+            }
+        }
+        msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov    = iov;
+        msg.msg_iovlen = n;
+        ssize_t r;
+        do
+        {
+            r = ::sendmsg(fd_, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        } while (r < 0 && errno == EINTR);
+        if (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            ::shutdown(fd_, SHUT_RDWR);
+            return false;
+        }
+        sent = r > 0 ? static_cast<std::size_t>(r) : 0;
+        if (sent == total)
+        {
+            return true;
+        }
+    }
+
+    // 追加未发出的部分
+    if (out_off_ > 0 && out_off_ == out_.size())
+    {
+        out_.clear();
+        out_off_ = 0;
+    }
+    const char *hp = reinterpret_cast<const char *>(&h);
+    std::size_t skip = sent;
+    if (skip < static_cast<std::size_t>(wire::kHeadSize))
+    {
+        out_.insert(out_.end(), hp + skip, hp + wire::kHeadSize);
+        skip = 0;
+    }
+    else
+    {
+        skip -= wire::kHeadSize;
+    }
+    for (int i = 0; i < nparts; ++i)
+    {
+        const char *p   = static_cast<const char *>(parts[i].iov_base);
+        std::size_t len = parts[i].iov_len;
+        if (skip >= len)
+        {
+            skip -= len;
+            continue;
+        }
+        out_.insert(out_.end(), p + skip, p + len);
+        skip = 0;
+    }
+    if (!cork)
+    {
+        armOutput(true);
+    }
+    return true;
+}
+
+bool Connection::flush()
+{
+    std::lock_guard<std::mutex> lock(out_mutex_);
+    return flushLocked();
+}
+
+bool Connection::flushLocked()
+{
+    if (closed_.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+    while (out_off_ < out_.size())
+    {
+        ssize_t r = ::send(fd_, out_.data() + out_off_, out_.size() - out_off_, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (r < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                armOutput(true);
+                return true;
+            }
+            return false;
+        }
+        out_off_ += static_cast<std::size_t>(r);
+    }
+    out_.clear();
+    out_off_ = 0;
+    armOutput(false);
+    return true;
+}
+
+void Connection::armOutput(bool on)
+{
+    if (on == out_armed_)
+    {
+        return;
+    }
+    epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events   = EPOLLIN | EPOLLRDHUP | (on ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    ev.data.ptr = this;
+    if (::epoll_ctl(epfd_, EPOLL_CTL_MOD, fd_, &ev) == 0)
+    {
+        out_armed_ = on;
+    }
+}
+
+void Connection::close()
+{
+    std::lock_guard<std::mutex> lock(out_mutex_);
+    if (closed_.exchange(true))
+    {
+        return;
+    }
+    ::epoll_ctl(epfd_, EPOLL_CTL_DEL, fd_, nullptr);
+    ::close(fd_);
+    out_.clear();
+    out_off_ = 0;
+}
+
+} // namespace server
+} // namespace gplat
@@ -0,0 +1,813 @@
+// 派生标签：表达式编译成栈式字节码，输入字段变化时在标签锁外重算并写出
+
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#include "qbdmap.h"
+
+namespace qbd {
+
+namespace {
+
+constexpr int kMaxStack = 32; // 求值栈深度上限
+
+enum class Op : unsigned char
+{
+    Const,
+    Load,
+    Neg,
+    Not,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Mod,
+    Lt,
+    Le,
+    Gt,
+    Ge,
+    Eq,
+    Ne,
+    And,
+    Or,
+    Abs,
+    Sqrt,
+    Round,
+    Min,
+    Max,
+    If,
+};
+
+struct Instr
+{
+    Op     op  = Op::Const;
+    int    arg = 0; // Load：输入序号
+    double k   = 0; // Const：常数
+};
+
+// 表达式引用的一个字段，同一字段只读一次
+struct Input
+{
+    std::string tag;
+    FieldSpec   field;
+};
+
+// 递归下降，按优先级从低到高：|| → && → 比较 → + - → * / % → 一元 → 基本项
+class Compiler
+{
+public:
+    // base 为 text 在整个定义中的位置，用于出错提示
+    Compiler(const std::string &text, std::size_t base, std::vector<Instr> &code, std::vector<Input> &inputs)
+        : text_(text), base_(base), code_(code), inputs_(inputs)
+    {
+    }
+
+    bool expression(std::string *error)
+    {
+        if (!orExpr() || !atEnd())
+        {
+            *error = error_.empty() ? where() + "多余的内容" : error_;
+            return false;
+        }
+        return true;
+    }
+
+    // 输出标签 "标签:类型"
+    bool target(std::string &tag, FieldSpec &field, std::string *error)
+    {
+        if (!name(tag) || !reference(field) || !atEnd())
+        {
+            *error = error_.empty() ? where() + "输出应为 标签:类型" : error_;
+            return false;
+        }
+        return true;
+    }
+
+    int maxDepth() const { return maxDepth_; }
+
+private:
+    void skipSpace()
+    {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_])))
+        {
+            ++pos_;
+        }
+    }
+
+    bool atEnd()
+    {
+        skipSpace();
+        return pos_ == text_.size();
+    }
+
+    char peek()
+    {
+        skipSpace();
+        return pos_ < text_.size() ? text_[pos_] : '\0';
+    }
+
+    bool accept(const char *tok)
+    {
+        skipSpace();
+        std::size_t n = std::strlen(tok);
+        if (text_.compare(pos_, n, tok) != 0)
+        {
+            return false;
+        }
+        pos_ += n;
+        return true;
+    }
+
+    std::string where() const { return "位置 " + std::to_string(base_ + pos_ + 1) + "："; }
+
+    bool fail(const char *msg)
+    {
+        if (error_.empty())
+        {
+            error_ = where() + msg;
+        }
+        return false;
+    }
+
+    void emit(Op op, int arg = 0, double k = 0)
+    {
+        switch (op)
+        {
+        case Op::Const:
+        case Op::Load:
+            ++depth_;
+            break;
+        case Op::Neg:
+        case Op::Not:
+        case Op::Abs:
+        case Op::Sqrt:
+        case Op::Round:
+            break;
+        case Op::If:
+            depth_ -= 2;
+            break;
+        default:
+            --depth_; // 二元运算
+            break;
+        }
+        if (depth_ > maxDepth_)
+        {
+            maxDepth_ = depth_;
+        }
+        code_.push_back(Instr{op, arg, k});
+    }
+
+    bool name(std::string &out)
+    {
+        skipSpace();
+        std::size_t start = pos_;
+        if (pos_ < text_.size() && (std::isalpha(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '_'))
+        {
+            while (pos_ < text_.size() &&
+                   (std::isalnum(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '_' || text_[pos_] == '.'))
+            {
+                ++pos_;
+            }
+        }
+        out.assign(text_, start, pos_ - start);
+        return !out.empty() || fail("应为标签名");
+    }
+
+    // 标签名之后的 [@偏移]:类型
+    bool reference(FieldSpec &field)
+    {
+        field.offset = 0;
+        if (accept("@"))
+        {
+            const char *begin = text_.c_str() + pos_;
+            char       *end   = nullptr;
+            long        off   = std::isdigit(static_cast<unsigned char>(*begin)) ? std::strtol(begin, &end, 10) : -1;
+            if (off < 0 || off > INT_MAX - 8)
+            {
+                return fail("偏移应为非负整数");
+            }
+            pos_ += end - begin;
+            field.offset = static_cast<int>(off);
+        }
+        std::string type;
+        if (!accept(":"))
+        {
+            return fail("标签后应为 :类型");
+        }
+        if (!name(type) || !numericType(type.c_str(), &field))
+        {
+            error_.clear();
+            return fail("类型应为 bool / char / uchar / short / ushort / int / uint / long / ulong / float / double");
+        }
+        return true;
+    }
+
+    bool orExpr()
+    {
+        if (!andExpr())
+        {
+            return false;
+        }
+        while (accept("||"))
+        {
+            if (!andExpr())
+            {
+                return false;
+            }
+            emit(Op::Or);
+        }
+        return true;
+    }
+
+    bool andExpr()
+    {
+        if (!cmpExpr())
+        {
+            return false;
+        }
+        while (accept("&&"))
+        {
+            if (!cmpExpr())
+            {
+                return false;
+            }
+            emit(Op::And);
+        }
+        return true;
+    }
+
+    bool cmpExpr()
+    {
+        static const struct
+        {
+            const char *tok;
+            Op          op;
+        } kOps[] = {{"<=", Op::Le}, {">=", Op::Ge}, {"==", Op::Eq}, {"!=", Op::Ne}, {"<", Op::Lt}, {">", Op::Gt}};
+        if (!addExpr())
+        {
+            return false;
+        }
+        for (;;)
+        {
+            const Op *op = nullptr;
+            for (const auto &o : kOps)
+            {
+                if (accept(o.tok))
+                {
+                    op = &o.op;
+                    break;
+                }
+            }
+            if (!op)
+            {
+                return true;
+            }
+            if (!addExpr())
+            {
+                return false;
+            }
+            emit(*op);
+        }
+    }
+
+    bool addExpr()
+    {
+        if (!mulExpr())
+        {
+            return false;
+        }
+        for (;;)
+        {
+            Op op;
+            if (accept("+"))
+            {
+                op = Op::Add;
+            }
+            else if (accept("-"))
+            {
+                op = Op::Sub;
+            }
+            else
+            {
+                return true;
+            }
+            if (!mulExpr())
+            {
+                return false;
+            }
+            emit(op);
+        }
+    }
+
+    bool mulExpr()
+    {
+        if (!unary())
+        {
+            return false;
+        }
+        for (;;)
+        {
+            Op op;
+            if (accept("*"))
+            {
+                op = Op::Mul;
+            }
+            else if (accept("/"))
+            {
+                op = Op::Div;
+            }
+            else if (accept("%"))
+            {
+                op = Op::Mod;
+            }
+            else
+            {
+                return true;
+            }
+            if (!unary())
+            {
+                return false;
+            }
+            emit(op);
+        }
+    }
+
+    bool unary()
+    {
+        if (accept("-"))
+        {
+            if (!unary())
+            {
+                return false;
+            }
+            emit(Op::Neg);
+            return true;
+        }
+        if (accept("+"))
+        {
+            return unary();
+        }
+        if (peek() == '!' && text_.compare(pos_, 2, "!=") != 0)
+        {
+            ++pos_;
+            if (!unary())
+            {
+                return false;
+            }
+            emit(Op::Not);
+            return true;
+        }
+        return primary();
+    }
+
+    bool primary()
+    {
+        char c = peek();
+        if (c == '(')
+        {
+            ++pos_;
+            if (!orExpr())
+            {
+                return false;
+            }
+            return accept(")") || fail("缺少 ')'");
+        }
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.')
+        {
+            const char *begin = text_.c_str() + pos_;
+            char       *end   = nullptr;
+            double      k     = std::strtod(begin, &end);
+            if (end == begin)
+            {
+                return fail("不合法的数");
+            }
+            pos_ += end - begin;
+            emit(Op::Const, 0, k);
+            return true;
+        }
+        if (!std::isalpha(static_cast<unsigned char>(c)) && c != '_')
+        {
+            return fail("应为标签、数、函数或 '('");
+        }
+        std::string id;
+        name(id);
+        if (peek() == '(')
+        {
+            return call(id);
+        }
+        Input in;
+        in.tag = id;
+        if (!reference(in.field))
+        {
+            return false;
+        }
+        int slot = 0;
+        while (slot < static_cast<int>(inputs_.size()) &&
+               !(inputs_[slot].tag == in.tag && inputs_[slot].field.offset == in.field.offset &&
+                 inputs_[slot].field.type == in.field.type && inputs_[slot].field.size == in.field.size))
+        {
+            ++slot;
+        }
+        if (slot == static_cast<int>(inputs_.size()))
+        {
+            inputs_.push_back(in);
+        }
+        emit(Op::Load, slot);
+        return true;
+    }
+
+    bool call(const std::string &fn)
+    {
+        static const struct
+        {
+            const char *name;
+            Op          op;
+            int         args; // 0 为两个或更多
+        } kFuncs[] = {{"abs", Op::Abs, 1},  {"sqrt", Op::Sqrt, 1}, {"round", Op::Round, 1},
+                      {"min", Op::Min, 0},  {"max", Op::Max, 0},   {"if", Op::If, 3}};
+        const auto *f = std::begin(kFuncs);
+        while (f != std::end(kFuncs) && fn != f->name)
+        {
+            ++f;
+        }
+        if (f == std::end(kFuncs))
+        {
+            return fail("未知的函数（abs / sqrt / round / min / max / if）");
+        }
+        accept("(");
+        int n = 0;
+        do
+        {
+            if (!orExpr())
+            {
+                return false;
+            }
+            // min / max 逐个合并，不必把全部参数留在栈上
+            if (++n >= 2 && f->args == 0)
+            {
+                emit(f->op);
+            }
+        } while (accept(","));
+        if (!accept(")"))
+        {
+            return fail("缺少 ')'");
+        }
+        if (f->args == 0 ? n < 2 : n != f->args)
+        {
+            return fail("函数参数个数不对");
+        }
+        if (f->args != 0)
+        {
+            emit(f->op);
+        }
+        return true;
+    }
+
+    const std::string  &text_;
+    std::size_t         base_;
+    std::vector<Instr> &code_;
+    std::vector<Input> &inputs_;
+    std::size_t         pos_      = 0;
+    int                 depth_    = 0;
+    int                 maxDepth_ = 0;
+    std::string         error_;
+};
+
+double binary(Op op, double a, double b)
+{
+    switch (op)
+    {
+    case Op::Add:
+        return a + b;
+    case Op::Sub:
+        return a - b;
+    case Op::Mul:
+        return a * b;
+    case Op::Div:
+        return a / b;
+    case Op::Mod:
+        return std::fmod(a, b);
+    case Op::Lt:
+        return a < b;
+    case Op::Le:
+        return a <= b;
+    case Op::Gt:
+        return a > b;
+    case Op::Ge:
+        return a >= b;
+    case Op::Eq:
+        return a == b;
+    case Op::Ne:
+        return a != b;
+    case Op::And:
+        return a != 0 && b != 0;
+    case Op::Or:
+        return a != 0 || b != 0;
+    case Op::Min:
+        return std::fmin(a, b);
+    case Op::Max:
+        return std::fmax(a, b);
+    default:
+        return 0;
+    }
+}
+
+double run(const std::vector<Instr> &code, const double *in)
+{
+    double st[kMaxStack];
+    int    sp = 0;
+    for (const Instr &i : code)
+    {
+        switch (i.op)
+        {
+        case Op::Const:
+            st[sp++] = i.k;
+            break;
+        case Op::Load:
+            st[sp++] = in[i.arg];
+            break;
+        case Op::Neg:
+            st[sp - 1] = -st[sp - 1];
+            break;
+        case Op::Not:
+            st[sp - 1] = st[sp - 1] == 0 ? 1 : 0;
+            break;
+        case Op::Abs:
+            st[sp - 1] = std::fabs(st[sp - 1]);
+            break;
+        case Op::Sqrt:
+            st[sp - 1] = std::sqrt(st[sp - 1]);
+            break;
+        case Op::Round:
+            st[sp - 1] = std::round(st[sp - 1]);
+            break;
+        case Op::If:
+            sp -= 2;
+            st[sp - 1] = st[sp - 1] != 0 ? st[sp] : st[sp + 1];
+            break;
+        default:
+            --sp;
+            st[sp - 1] = binary(i.op, st[sp - 1], st[sp]);
+            break;
+        }
+    }
+    return st[0];
+}
+
+// 按字段类型写出 v（整数四舍五入并截到类型的范围），不是有限数返回 false
+bool encodeValue(const FieldSpec &f, double v, char *out)
+{
+    if (!std::isfinite(v))
+    {
+        return false;
+    }
+    if (f.type == KeyType::Float)
+    {
+        if (f.size == 4)
+        {
+            float x = static_cast<float>(v);
+            std::memcpy(out, &x, 4);
+        }
+        else
+        {
+            std::memcpy(out, &v, 8);
+        }
+        return true;
+    }
+    int           bits = f.size * 8;
+    double        r    = std::round(v);
+    std::uint64_t u;
+    if (f.type == KeyType::Int)
+    {
+        double    lo = -std::ldexp(1.0, bits - 1);
+        long long s  = r < lo ? static_cast<long long>(lo)
+                       : r >= -lo ? static_cast<long long>(~std::uint64_t{0} >> (65 - bits))
+                                  : static_cast<long long>(r);
+        u = static_cast<std::uint64_t>(s);
+    }
+    else
+    {
+        double hi = std::ldexp(1.0, bits);
+        u         = r <= 0 ? 0 : r >= hi ? ~std::uint64_t{0} >> (64 - bits) : static_cast<std::uint64_t>(r);
+    }
+    std::memcpy(out, &u, f.size); // 小端：取低位字节
+    return true;
+}
+
+} // namespace
+
+bool numericType(const char *name, FieldSpec *field)
+{
+    static const struct
+    {
+        const char *name;
+        KeyType     type;
+        int         size;
+    } kTypes[] = {
+        {"bool", KeyType::UInt, 1},   {"char", KeyType::Int, 1},    {"uchar", KeyType::UInt, 1},
+        {"short", KeyType::Int, 2},   {"ushort", KeyType::UInt, 2}, {"int", KeyType::Int, 4},
+        {"uint", KeyType::UInt, 4},   {"long", KeyType::Int, 8},    {"ulong", KeyType::UInt, 8},
+        {"float", KeyType::Float, 4}, {"double", KeyType::Float, 8},
+    };
+    for (const auto &t : kTypes)
+    {
+        if (std::strcmp(name, t.name) == 0)
+        {
+            field->type = t.type;
+            field->size = t.size;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================
+//  派生标签
+// ============================================================
+struct DerivedTags::Definition
+{
+    std::string        board;
+    std::string        tag;
+    FieldSpec          field; // 输出，偏移为 0
+    std::vector<Input> inputs;
+    std::vector<Instr> code;
+    std::atomic<bool>  dirty{true}; // 新定义先算一次
+    std::mutex         mutex;       // 同一定义的求值和写出串行，后写出的一定读到了更新的输入
+    char               last[8]{};   // 上次写出的值
+    bool               written = false;
+};
+
+DerivedTags::DerivedTags(ItemObserver *next) : next_(next) {}
+
+DerivedTags::~DerivedTags() = default;
+
+bool DerivedTags::add(const char *board, const char *definition, std::string *error)
+{
+    const char *eq = std::strchr(definition, '=');
+    if (!eq || eq[1] == '=')
+    {
+        *error = "应为 输出标签:类型 = 表达式";
+        return false;
+    }
+    auto def   = std::make_unique<Definition>();
+    def->board = board;
+    std::string out(definition, eq), expr(eq + 1);
+    if (!Compiler(out, 0, def->code, def->inputs).target(def->tag, def->field, error))
+    {
+        return false;
+    }
+    def->code.clear();
+    Compiler compiler(expr, out.size() + 1, def->code, def->inputs);
+    if (!compiler.expression(error))
+    {
+        return false;
+    }
+    if (compiler.maxDepth() > kMaxStack)
+    {
+        *error = "表达式嵌套过深";
+        return false;
+    }
+    if (def->field.offset != 0)
+    {
+        *error = "输出标签不能带偏移";
+        return false;
+    }
+    for (const auto &d : defs_)
+    {
+        if (d->board == board && d->tag == def->tag)
+        {
+            *error = "输出标签 " + def->tag + " 已定义";
+            return false;
+        }
+    }
+    auto watched = watches_.find(def->tag);
+    if (watched != watches_.end())
+    {
+        for (const Watch &w : watched->second)
+        {
+            if (w.board == board)
+            {
+                *error = "输出标签 " + def->tag + " 已被之前的定义引用，派生标签须先定义后引用";
+                return false;
+            }
+        }
+    }
+    for (const Input &in : def->inputs)
+    {
+        if (in.tag == def->tag)
+        {
+            *error = "表达式不能引用输出标签自身";
+            return false;
+        }
+    }
+
+    // 输出标签不存在时按类型长度创建，已存在的须放得下
+    unsigned int err = 0;
+    if (!createItem(board, def->tag.c_str(), def->field.size, nullptr, 0, &err) && err != ERROR_ITEM_ALREADY_EXIST)
+    {
+        *error = "建输出标签 " + def->tag + " 失败，错误码 " + std::to_string(err);
+        return false;
+    }
+    char     buf[8];
+    ItemMeta meta;
+    if (!readItemRange(board, def->tag.c_str(), 0, buf, def->field.size, &meta, &err))
+    {
+        *error = "输出标签 " + def->tag + " 不足 " + std::to_string(def->field.size) + " 字节";
+        return false;
+    }
+
+    for (const Input &in : def->inputs)
+    {
+        watches_[in.tag].push_back(Watch{board, in.field, def.get()});
+    }
+    defs_.push_back(std::move(def));
+    pending_.store(true);
+    return true;
+}
+
+void DerivedTags::onWrite(const ItemEvent &ev)
+{
+    if (next_)
+    {
+        next_->onWrite(ev);
+    }
+    auto it = watches_.find(ev.itemname);
+    if (it == watches_.end())
+    {
+        return;
+    }
+    for (const Watch &w : it->second)
+    {
+        const FieldSpec &f = w.field;
+        if (w.board != ev.board || f.offset + f.size > ev.size || f.offset + f.size <= ev.dirtyoffset ||
+            f.offset >= ev.dirtyoffset + ev.dirtysize)
+        {
+            continue;
+        }
+        // 先标记定义再置 pending_：看到 pending_ 的 evaluate 一定看到标记
+        w.def->dirty.store(true);
+        pending_.store(true);
+    }
+}
+
+int DerivedTags::evaluate(ItemObserver *observer)
+{
+    int                 written = 0;
+    std::vector<double> values;
+    // 写输出时经 observer 回到本对象的 onWrite，依赖它的后续定义被标记，在本轮中接着算；
+    // 本轮写出所置的 pending_ 由第二轮清掉。其它线程的写入由写入方自己的 evaluate 负责，至多两轮
+    for (int round = 0; round < 2 && pending_.exchange(false); ++round)
+    {
+        for (const auto &p : defs_)
+        {
+            written += evaluate(*p, values, observer) ? 1 : 0;
+        }
+    }
+    return written;
+}
+
+bool DerivedTags::evaluate(Definition &d, std::vector<double> &values, ItemObserver *observer)
+{
+    if (!d.dirty.load())
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(d.mutex);
+    // 先清标记再读输入：读之后到达的写入会重新标记，由写入方的 evaluate 再算一次
+    if (!d.dirty.exchange(false))
+    {
+        return false;
+    }
+    values.resize(d.inputs.size());
+    unsigned int err = 0;
+    for (std::size_t i = 0; i < d.inputs.size(); ++i)
+    {
+        const Input &in = d.inputs[i];
+        char         raw[8];
+        ItemMeta     meta;
+        if (!readItemRange(d.board.c_str(), in.tag.c_str(), in.field.offset, raw, in.field.size, &meta, &err))
+        {
+            return false;
+        }
+        values[i] = detail::fieldValue(in.field, raw);
+    }
+    char out[8];
+    if (!encodeValue(d.field, run(d.code, values.data()), out) ||
+        (d.written && std::memcmp(out, d.last, d.field.size) == 0))
+    {
+        return false;
+    }
+    if (!writeItem(d.board.c_str(), d.tag.c_str(), out, d.field.size, observer, &err))
+    {
+        return false;
+    }
+    std::memcpy(d.last, out, d.field.size);
+    d.written = true;
+    return true;
+}
+
+} // namespace qbd
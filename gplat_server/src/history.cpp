@@ -0,0 +1,967 @@
+// 历史库：标签变化的时间序列，delta-of-delta 时间戳 + XOR 浮点压缩，段文件只追加
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+
+#include "qbdmap.h"
+
+namespace qbd {
+
+namespace {
+
+constexpr int       kBlockPoints    = 1024;            // 每块至多点数
+constexpr int       kSpanPoints     = 128;             // 块跨度达到 kBlockSpan 且不少于这么多点时也封存，
+constexpr long long kBlockSpan      = 300LL * 1000000; // 使降采样时小时级的桶能容纳整块（5 分钟）
+constexpr int       kChunkBlocks    = 1024;            // 块索引每片的项数
+constexpr long      kDefaultSegment = 4L << 20;
+constexpr long      kMinSegment     = 64L << 10;       // 不小于一个最坏情况的块（约 19 KB）
+constexpr char      kSegMagic[8]    = "GPHIST1";
+
+// 段头，64 字节
+struct SegHead
+{
+    char      magic[8];
+    char      series[40];
+    int       segno;
+    int       blocks;
+    long long used; // 已用字节（含段头），块完整写入后才增加
+};
+
+// 块头，其后为时间戳列 tsbytes 字节、值列 valbytes 字节（均为 8 的倍数）
+struct BlockHead
+{
+    long long tfirst;
+    long long tlast;
+    double    vfirst;
+    double    vlast;
+    double    vmin;
+    double    vmax;
+    double    vsum;
+    int       count;
+    int       tsbytes;
+    int       valbytes;
+    int       reserved;
+};
+
+static_assert(sizeof(SegHead) == 64, "SegHead 布局");
+static_assert(sizeof(BlockHead) == 72, "BlockHead 布局");
+
+inline std::uint64_t bitsOf(double v)
+{
+    std::uint64_t u;
+    std::memcpy(&u, &v, sizeof(u));
+    return u;
+}
+
+inline double doubleOf(std::uint64_t u)
+{
+    double v;
+    std::memcpy(&v, &u, sizeof(v));
+    return v;
+}
+
+// ============================================================
+//  位流：按 64 位字从高位起依次写入（本机字节序保存）
+// ============================================================
+class BitWriter
+{
+public:
+    // 写入 v 的低 n 位，1 <= n <= 64
+    void put(std::uint64_t v, int n)
+    {
+        if (n < 64)
+        {
+            v &= (std::uint64_t{1} << n) - 1;
+        }
+        int free = 64 - used_;
+        if (free == 0)
+        {
+            words_.push_back(0);
+            used_ = 0;
+            free  = 64;
+        }
+        if (n <= free)
+        {
+            words_.back() |= v << (free - n);
+            used_ += n;
+        }
+        else
+        {
+            int rest = n - free;
+            words_.back() |= v >> rest;
+            words_.push_back(v << (64 - rest));
+            used_ = rest;
+        }
+    }
+
+    int                  bytes() const { return static_cast<int>(words_.size() * sizeof(std::uint64_t)); }
+    const std::uint64_t *data() const { return words_.data(); }
+
+private:
+    std::vector<std::uint64_t> words_;
+    int                        used_ = 64;
+};
+
+class BitReader
+{
+public:
+    explicit BitReader(const std::uint64_t *words) : words_(words) {}
+
+    std::uint64_t get(int n)
+    {
+        std::size_t   i   = pos_ >> 6;
+        int           off = static_cast<int>(pos_ & 63);
+        std::uint64_t v   = words_[i] << off;
+        if (off + n > 64)
+        {
+            v |= words_[i + 1] >> (64 - off);
+        }
+        pos_ += n;
+        return n == 64 ? v : v >> (64 - n);
+    }
+
+    bool bit() { return get(1) != 0; }
+
+private:
+    const std::uint64_t *words_;
+    std::size_t          pos_ = 0;
+};
+
+// ============================================================
+//  编码
+// ============================================================
+// 时间戳：首点在块头，其后每点为差分的差分 dod：
+//   0 → '0'；[-63, 64] → '10' + 7 位；[-2047, 2048] → '110' + 12 位；
+//   [-524287, 524288] → '1110' + 20 位；其余 → '1111' + 64 位
+void encodeTimes(const HistoryPoint *p, int n, BitWriter &w)
+{
+    long long prev = p[0].t, delta = 0;
+    for (int i = 1; i < n; ++i)
+    {
+        long long d   = p[i].t - prev;
+        long long dod = d - delta;
+        prev          = p[i].t;
+        delta         = d;
+        if (dod == 0)
+        {
+            w.put(0, 1);
+        }
+        else if (dod >= -63 && dod <= 64)
+        {
+            w.put(0b10, 2);
+            w.put(static_cast<std::uint64_t>(dod + 63), 7);
+        }
+        else if (dod >= -2047 && dod <= 2048)
+        {
+            w.put(0b110, 3);
+            w.put(static_cast<std::uint64_t>(dod + 2047), 12);
+        }
+        else if (dod >= -524287 && dod <= 524288)
+        {
+            w.put(0b1110, 4);
+            w.put(static_cast<std::uint64_t>(dod + 524287), 20);
+        }
+        else
+        {
+            w.put(0b1111, 4);
+            w.put(static_cast<std::uint64_t>(dod), 64);
+        }
+    }
+    w.put(0, 1); // 保证列非空，且解码时越过末尾的读取仍在列内
+}
+
+void decodeTimes(const BlockHead &h, const std::uint64_t *words, HistoryPoint *out)
+{
+    BitReader r(words);
+    long long prev = h.tfirst, delta = 0;
+    out[0].t       = prev;
+    for (int i = 1; i < h.count; ++i)
+    {
+        long long dod;
+        if (!r.bit())
+        {
+            dod = 0;
+        }
+        else if (!r.bit())
+        {
+            dod = static_cast<long long>(r.get(7)) - 63;
+        }
+        else if (!r.bit())
+        {
+            dod = static_cast<long long>(r.get(12)) - 2047;
+        }
+        else if (!r.bit())
+        {
+            dod = static_cast<long long>(r.get(20)) - 524287;
+        }
+        else
+        {
+            dod = static_cast<long long>(r.get(64));
+        }
+        delta += dod;
+        prev += delta;
+        out[i].t = prev;
+    }
+}
+
+// 值：首值 64 位原样，其后与前一值 XOR：
+//   相同 → '0'；否则 '1' + 控制位：有效位落在上一个窗口内 → '0' + 窗口内的位，
+//   否则 → '1' + 前导零个数（5 位，至多 31）+ 有效位数 - 1（6 位）+ 有效位
+void encodeValues(const HistoryPoint *p, int n, BitWriter &w)
+{
+    std::uint64_t prev = bitsOf(p[0].value);
+    w.put(prev, 64);
+    int lead = -1, trail = 0;
+    for (int i = 1; i < n; ++i)
+    {
+        std::uint64_t cur = bitsOf(p[i].value);
+        std::uint64_t x   = cur ^ prev;
+        prev              = cur;
+        if (x == 0)
+        {
+            w.put(0, 1);
+            continue;
+        }
+        int l = std::min(__builtin_clzll(x), 31);
+        int t = __builtin_ctzll(x);
+        if (lead >= 0 && l >= lead && t >= trail)
+        {
+            w.put(0b10, 2);
+            w.put(x >> trail, 64 - lead - trail);
+        }
+        else
+        {
+            lead    = l;
+            trail   = t;
+            int len = 64 - l - t;
+            w.put(0b11, 2);
+            w.put(static_cast<std::uint64_t>(l), 5);
+            w.put(static_cast<std::uint64_t>(len - 1), 6);
+            w.put(x >> t, len);
+        }
+    }
+}
+
+void decodeValues(const BlockHead &h, const std::uint64_t *words, HistoryPoint *out)
+{
+    BitReader     r(words);
+    std::uint64_t prev = r.get(64);
+    out[0].value       = doubleOf(prev);
+    int lead = 0, trail = 0;
+    for (int i = 1; i < h.count; ++i)
+    {
+        if (r.bit())
+        {
+            if (r.bit())
+            {
+                lead  = static_cast<int>(r.get(5));
+                trail = 64 - lead - (static_cast<int>(r.get(6)) + 1);
+            }
+            prev ^= r.get(64 - lead - trail) << trail;
+        }
+        out[i].value = doubleOf(prev);
+    }
+}
+
+// 解码整块到 out[0, count)
+void decodeBlock(const BlockHead *h, HistoryPoint *out)
+{
+    const char *p = reinterpret_cast<const char *>(h + 1);
+    decodeTimes(*h, reinterpret_cast<const std::uint64_t *>(p), out);
+    decodeValues(*h, reinterpret_cast<const std::uint64_t *>(p + h->tsbytes), out);
+}
+
+inline long blockBytes(const BlockHead *h)
+{
+    return static_cast<long>(sizeof(BlockHead)) + h->tsbytes + h->valbytes;
+}
+
+std::string segmentPath(const std::string &series, int segno)
+{
+    std::string path = dataDir();
+    if (!path.empty() && path.back() != '/')
+    {
+        path += '/';
+    }
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), ".h%05d", segno);
+    return path + series + suffix;
+}
+
+struct Segment
+{
+    char    *base     = nullptr;
+    long     capacity = 0;
+    int      fd       = -1;
+    SegHead *head() const { return reinterpret_cast<SegHead *>(base); }
+};
+
+// 块索引的一片：已发布的项不再改变，读者取得片列表后在锁外访问
+struct IndexChunk
+{
+    const BlockHead *blocks[kChunkBlocks];
+};
+
+} // namespace
+
+namespace detail {
+
+// ============================================================
+//  序列
+// ============================================================
+class HistorySeries
+{
+public:
+    HistorySeries(std::string name, long segmentsize) : name_(std::move(name)), segmentsize_(segmentsize) {}
+    ~HistorySeries() { close(); }
+
+    // 打开已有的段文件并重建块索引
+    bool load(unsigned int *error);
+    void append(long long t, double value);
+    bool flush(unsigned int *error);
+    void close();
+    void info(HistoryInfo *info);
+
+    // 查询时刻的视图：已封存的块 + 正在写的点
+    struct View
+    {
+        std::vector<std::shared_ptr<IndexChunk>> chunks;
+        int                                      nblocks = 0;
+        std::vector<HistoryPoint>                open;
+
+        const BlockHead *block(int i) const { return chunks[i / kChunkBlocks]->blocks[i % kChunkBlocks]; }
+        // 第一个 tlast >= t 的块
+        int lowerBound(long long t) const
+        {
+            int lo = 0, hi = nblocks;
+            while (lo < hi)
+            {
+                int mid = (lo + hi) / 2;
+                if (block(mid)->tlast < t)
+                {
+                    lo = mid + 1;
+                }
+                else
+                {
+                    hi = mid;
+                }
+            }
+            return lo;
+        }
+    };
+    void view(View &v);
+
+private:
+    bool seal(unsigned int *error);
+    bool addSegment(long minsize, unsigned int *error);
+    void publish(const BlockHead *h);
+
+    std::string                              name_;
+    long                                     segmentsize_;
+    std::mutex                               mutex_; // 以下全部
+    std::vector<Segment>                     segments_;
+    std::vector<std::shared_ptr<IndexChunk>> chunks_;
+    int                                      nblocks_ = 0;
+    std::vector<HistoryPoint>                pending_; // 正在写的块
+    long long                                sealedpoints_ = 0;
+    long long                                bytes_        = 0;
+    long long                                lastt_        = 0;
+    bool                                     haslast_      = false;
+    long long                                dropped_      = 0;
+};
+
+void HistorySeries::publish(const BlockHead *h)
+{
+    if (nblocks_ % kChunkBlocks == 0)
+    {
+        chunks_.push_back(std::make_shared<IndexChunk>());
+    }
+    chunks_.back()->blocks[nblocks_ % kChunkBlocks] = h;
+    ++nblocks_;
+    sealedpoints_ += h->count;
+    bytes_ += blockBytes(h);
+    lastt_   = h->tlast;
+    haslast_ = true;
+}
+
+bool HistorySeries::load(unsigned int *error)
+{
+    if (dataDir().empty())
+    {
+        return true;
+    }
+    for (int segno = 0;; ++segno)
+    {
+        std::string path = segmentPath(name_, segno);
+        int         f    = ::open(path.c_str(), O_RDWR);
+        if (f < 0)
+        {
+            if (errno == ENOENT)
+            {
+                return true;
+            }
+            setError(error, ERROR_FILE_OPEN_FAILSURE);
+            return false;
+        }
+        struct stat st;
+        void       *addr = MAP_FAILED;
+        if (::fstat(f, &st) == 0 && st.st_size >= static_cast<long>(sizeof(SegHead)))
+        {
+            addr = ::mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, f, 0);
+        }
+        if (addr == MAP_FAILED)
+        {
+            ::close(f);
+            setError(error, ERROR_FILE_OPEN_FAILSURE);
+            return false;
+        }
+        Segment seg{static_cast<char *>(addr), static_cast<long>(st.st_size), f};
+        segments_.push_back(seg);
+        const SegHead *sh = seg.head();
+        if (std::memcmp(sh->magic, kSegMagic, sizeof(kSegMagic)) != 0 || sh->segno != segno ||
+            std::strncmp(sh->series, name_.c_str(), sizeof(sh->series)) != 0 || sh->used < static_cast<long>(sizeof(SegHead)) ||
+            sh->used > seg.capacity)
+        {
+            setError(error, ERROR_FILE_OPEN_FAILSURE);
+            return false;
+        }
+        long pos = sizeof(SegHead);
+        for (int b = 0; b < sh->blocks; ++b)
+        {
+            const BlockHead *h = reinterpret_cast<const BlockHead *>(seg.base + pos);
+            if (pos + static_cast<long>(sizeof(BlockHead)) > sh->used || h->count <= 0 || h->count > kBlockPoints ||
+                h->tsbytes <= 0 || h->valbytes <= 0 || pos + blockBytes(h) > sh->used)
+            {
+                setError(error, ERROR_FILE_OPEN_FAILSURE);
+                return false;
+            }
+            publish(h);
+            pos += blockBytes(h);
+        }
+    }
+}
+
+bool HistorySeries::addSegment(long minsize, unsigned int *error)
+{
+    long size  = std::max(segmentsize_, minsize);
+    int  segno = static_cast<int>(segments_.size());
+    int  f     = -1;
+    void *addr;
+    if (dataDir().empty())
+    {
+        addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    else
+    {
+        std::string path = segmentPath(name_, segno);
+        f                = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (f < 0)
+        {
+            setError(error, errno == EEXIST ? ERROR_FILE_IN_USE : ERROR_FILE_CREATE_FAILSURE);
+            return false;
+        }
+        if (::ftruncate(f, size) != 0)
+        {
+            ::close(f);
+            ::unlink(path.c_str());
+            setError(error, ERROR_FILE_CREATE_FAILSURE);
+            return false;
+        }
+        addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, f, 0);
+        if (addr == MAP_FAILED)
+        {
+            ::close(f);
+            ::unlink(path.c_str());
+        }
+    }
+    if (addr == MAP_FAILED)
+    {
+        setError(error, ERROR_MAPVIEWOFFILE);
+        return false;
+    }
+    Segment seg{static_cast<char *>(addr), size, f};
+    SegHead *sh = seg.head();
+    std::memcpy(sh->magic, kSegMagic, sizeof(kSegMagic));
+    std::strncpy(sh->series, name_.c_str(), sizeof(sh->series) - 1);
+    sh->segno  = segno;
+    sh->blocks = 0;
+    sh->used   = sizeof(SegHead);
+    segments_.push_back(seg);
+    return true;
+}
+
+// 把正在写的块编码后追加到最后一段，放不下时开新段（须持 mutex_）
+bool HistorySeries::seal(unsigned int *error)
+{
+    if (pending_.empty())
+    {
+        return true;
+    }
+    const HistoryPoint *p = pending_.data();
+    int                 n = static_cast<int>(pending_.size());
+    BitWriter           tw, vw;
+    encodeTimes(p, n, tw);
+    encodeValues(p, n, vw);
+
+    BlockHead h;
+    std::memset(&h, 0, sizeof(h));
+    h.tfirst   = p[0].t;
+    h.tlast    = p[n - 1].t;
+    h.vfirst   = p[0].value;
+    h.vlast    = p[n - 1].value;
+    h.vmin     = p[0].value;
+    h.vmax     = p[0].value;
+    h.count    = n;
+    h.tsbytes  = tw.bytes();
+    h.valbytes = vw.bytes();
+    for (int i = 0; i < n; ++i)
+    {
+        h.vmin = std::min(h.vmin, p[i].value);
+        h.vmax = std::max(h.vmax, p[i].value);
+        h.vsum += p[i].value;
+    }
+
+    long bytes = static_cast<long>(sizeof(BlockHead)) + h.tsbytes + h.valbytes;
+    if (segments_.empty() || segments_.back().head()->used + bytes > segments_.back().capacity)
+    {
+        if (!addSegment(std::max(kMinSegment, bytes + static_cast<long>(sizeof(SegHead))), error))
+        {
+            dropped_ += n;
+            pending_.clear();
+            return false;
+        }
+    }
+    Segment &seg = segments_.back();
+    char    *dst = seg.base + seg.head()->used;
+    std::memcpy(dst, &h, sizeof(h));
+    std::memcpy(dst + sizeof(h), tw.data(), h.tsbytes);
+    std::memcpy(dst + sizeof(h) + h.tsbytes, vw.data(), h.valbytes);
+    seg.head()->used += bytes;
+    ++seg.head()->blocks;
+    publish(reinterpret_cast<const BlockHead *>(dst));
+    pending_.clear();
+    return true;
+}
+
+void HistorySeries::append(long long t, double value)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (haslast_ && t < lastt_)
+    {
+        t = lastt_;
+    }
+    lastt_   = t;
+    haslast_ = true;
+    if (pending_.capacity() == 0)
+    {
+        pending_.reserve(kBlockPoints);
+    }
+    pending_.push_back(HistoryPoint{t, value});
+    int n = static_cast<int>(pending_.size());
+    if (n == kBlockPoints || (n >= kSpanPoints && t - pending_.front().t >= kBlockSpan))
+    {
+        seal(nullptr);
+    }
+}
+
+bool HistorySeries::flush(unsigned int *error)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return seal(error);
+}
+
+void HistorySeries::close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    seal(nullptr);
+    for (Segment &seg : segments_)
+    {
+        if (seg.fd >= 0)
+        {
+            ::msync(seg.base, seg.capacity, MS_SYNC);
+            ::close(seg.fd);
+        }
+        ::munmap(seg.base, seg.capacity);
+    }
+    segments_.clear();
+    chunks_.clear();
+    nblocks_ = 0;
+}
+
+void HistorySeries::info(HistoryInfo *info)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    *info          = HistoryInfo{};
+    info->points   = sealedpoints_ + static_cast<long long>(pending_.size());
+    info->bytes    = bytes_;
+    info->blocks   = nblocks_;
+    info->segments = static_cast<int>(segments_.size());
+    info->dropped  = dropped_;
+    if (nblocks_ > 0)
+    {
+        info->first = chunks_[0]->blocks[0]->tfirst;
+    }
+    else if (!pending_.empty())
+    {
+        info->first = pending_.front().t;
+    }
+    if (info->points > 0)
+    {
+        info->last = lastt_;
+    }
+}
+
+void HistorySeries::view(View &v)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    v.chunks  = chunks_;
+    v.nblocks = nblocks_;
+    v.open    = pending_;
+}
+
+} // namespace detail
+
+namespace {
+
+std::shared_mutex                                                              g_series_mutex;
+std::unordered_map<std::string, std::unique_ptr<detail::HistorySeries>>       g_series;
+
+detail::HistorySeries *findSeries(const char *series, unsigned int *error)
+{
+    std::shared_lock<std::shared_mutex> lock(g_series_mutex);
+    auto it = g_series.find(series);
+    if (it == g_series.end())
+    {
+        detail::setError(error, ERROR_DQ_NOT_OPEN);
+        return nullptr;
+    }
+    return it->second.get();
+}
+
+// 按时间顺序遍历 [from, to) 内的块和点：onBlock 返回 true 表示已用块头处理整块，不再解码；
+// onPoint 返回 false 时停止
+template <typename OnBlock, typename OnPoint>
+void scanRange(const detail::HistorySeries::View &v, long long from, long long to, OnBlock onBlock, OnPoint onPoint)
+{
+    std::vector<HistoryPoint> buf(kBlockPoints);
+    for (int b = v.lowerBound(from); b < v.nblocks; ++b)
+    {
+        const BlockHead *h = v.block(b);
+        if (h->tfirst >= to)
+        {
+            return;
+        }
+        if (onBlock(*h))
+        {
+            continue;
+        }
+        decodeBlock(h, buf.data());
+        for (int i = 0; i < h->count; ++i)
+        {
+            const HistoryPoint &p = buf[i];
+            if (p.t >= from && p.t < to && !onPoint(p))
+            {
+                return;
+            }
+        }
+    }
+    for (const HistoryPoint &p : v.open)
+    {
+        if (p.t >= to)
+        {
+            return;
+        }
+        if (p.t >= from && !onPoint(p))
+        {
+            return;
+        }
+    }
+}
+
+} // namespace
+
+// ============================================================
+//  接口
+// ============================================================
+bool openHistory(const char *series, long segmentsize, unsigned int *error)
+{
+    std::size_t len = std::strlen(series);
+    if (len == 0 || std::strchr(series, '/') != nullptr)
+    {
+        detail::setError(error, ERROR_INVALID_PARAMETER);
+        return false;
+    }
+    if (len >= sizeof(SegHead::series))
+    {
+        detail::setError(error, ERROR_FILENAME_TOO_LONG);
+        return false;
+    }
+    std::unique_lock<std::shared_mutex> lock(g_series_mutex);
+    if (g_series.count(series) != 0)
+    {
+        detail::setError(error, 0);
+        return true;
+    }
+    auto s = std::make_unique<detail::HistorySeries>(series,
+                                                     segmentsize > 0 ? std::max(segmentsize, kMinSegment) : kDefaultSegment);
+    if (!s->load(error))
+    {
+        return false;
+    }
+    g_series.emplace(series, std::move(s));
+    detail::setError(error, 0);
+    return true;
+}
+
+bool appendHistory(const char *series, long long t, double value, unsigned int *error)
+{
+    detail::HistorySeries *s = findSeries(series, error);
+    if (!s)
+    {
+        return false;
+    }
+    s->append(t, value);
+    detail::setError(error, 0);
+    return true;
+}
+
+bool flushHistory(const char *series, unsigned int *error)
+{
+    if (series == nullptr || series[0] == '\0')
+    {
+        std::shared_lock<std::shared_mutex> lock(g_series_mutex);
+        bool                                ok = true;
+        for (auto &kv : g_series)
+        {
+            ok = kv.second->flush(error) && ok;
+        }
+        if (ok)
+        {
+            detail::setError(error, 0);
+        }
+        return ok;
+    }
+    detail::HistorySeries *s = findSeries(series, error);
+    if (!s || !s->flush(error))
+    {
+        return false;
+    }
+    detail::setError(error, 0);
+    return true;
+}
+
+bool historyInfo(const char *series, HistoryInfo *info, unsigned int *error)
+{
+    detail::HistorySeries *s = findSeries(series, error);
+    if (!s)
+    {
+        return false;
+    }
+    s->info(info);
+    detail::setError(error, 0);
+    return true;
+}
+
+bool readHistory(const char *series, long long from, long long to, int skip, int limit,
+                 std::vector<HistoryPoint> &points, bool *more, unsigned int *error)
+{
+    points.clear();
+    if (more)
+    {
+        *more = false;
+    }
+    detail::HistorySeries *s = findSeries(series, error);
+    if (!s)
+    {
+        return false;
+    }
+    detail::HistorySeries::View v;
+    s->view(v);
+    scanRange(
+        v, from, to,
+        [&](const BlockHead &h) {
+            // 整块都要跳过时不必解码
+            if (skip >= h.count && h.tfirst >= from && h.tlast < to)
+            {
+                skip -= h.count;
+                return true;
+            }
+            return false;
+        },
+        [&](const HistoryPoint &p) {
+            if (skip > 0)
+            {
+                --skip;
+                return true;
+            }
+            if (limit > 0 && static_cast<int>(points.size()) == limit)
+            {
+                if (more)
+                {
+                    *more = true;
+                }
+                return false;
+            }
+            points.push_back(p);
+            return true;
+        });
+    detail::setError(error, 0);
+    return true;
+}
+
+bool downsampleHistory(const char *series, long long from, long long to, long long bucket, int limit,
+                       std::vector<HistoryBucket> &buckets, bool *more, unsigned int *error)
+{
+    buckets.clear();
+    if (more)
+    {
+        *more = false;
+    }
+    if (bucket <= 0 || to <= from)
+    {
+        detail::setError(error, ERROR_INVALID_PARAMETER);
+        return false;
+    }
+    detail::HistorySeries *s = findSeries(series, error);
+    if (!s)
+    {
+        return false;
+    }
+    detail::HistorySeries::View v;
+    s->view(v);
+
+    bool full = false;
+    // 取 t 所在的桶，新桶超出 limit 时返回空
+    auto bucketOf = [&](long long t) -> HistoryBucket * {
+        long long start = from + (t - from) / bucket * bucket;
+        if (!buckets.empty() && buckets.back().start == start)
+        {
+            return &buckets.back();
+        }
+        if (limit > 0 && static_cast<int>(buckets.size()) == limit)
+        {
+            full = true;
+            return nullptr;
+        }
+        HistoryBucket b;
+        b.start = start;
+        buckets.push_back(b);
+        return &buckets.back();
+    };
+    // avg 在合并期间暂存和
+    auto merge = [](HistoryBucket &b, int count, double vmin, double vmax, double sum, double first, double last) {
+        if (b.count == 0)
+        {
+            b.min   = vmin;
+            b.max   = vmax;
+            b.first = first;
+        }
+        else
+        {
+            b.min = std::min(b.min, vmin);
+            b.max = std::max(b.max, vmax);
+        }
+        b.count += count;
+        b.avg += sum;
+        b.last = last;
+    };
+    scanRange(
+        v, from, to,
+        [&](const BlockHead &h) {
+            if (h.tfirst < from || h.tlast >= to || (h.tfirst - from) / bucket != (h.tlast - from) / bucket)
+            {
+                return false;
+            }
+            HistoryBucket *b = bucketOf(h.tfirst);
+            if (!b)
+            {
+                return false; // 交给 onPoint 结束遍历
+            }
+            merge(*b, h.count, h.vmin, h.vmax, h.vsum, h.vfirst, h.vlast);
+            return true;
+        },
+        [&](const HistoryPoint &p) {
+            HistoryBucket *b = bucketOf(p.t);
+            if (!b)
+            {
+                return false;
+            }
+            merge(*b, 1, p.value, p.value, p.value, p.value, p.value);
+            return true;
+        });
+    for (HistoryBucket &b : buckets)
+    {
+        b.avg /= b.count;
+    }
+    if (more)
+    {
+        *more = full;
+    }
+    detail::setError(error, 0);
+    return true;
+}
+
+// ============================================================
+//  记录器
+// ============================================================
+bool HistoryRecorder::add(const char *board, const char *tag, const FieldSpec &field, const char *series,
+                          unsigned int *error)
+{
+    if (!detail::isNumeric(field) || field.offset < 0 || !field.name.empty())
+    {
+        detail::setError(error, ERROR_INVALID_PARAMETER);
+        return false;
+    }
+    detail::HistorySeries *s = findSeries(series, error);
+    if (!s)
+    {
+        return false;
+    }
+    captures_[tag].push_back(Capture{board, field, s});
+    detail::setError(error, 0);
+    return true;
+}
+
+void HistoryRecorder::onWrite(const ItemEvent &ev)
+{
+    if (next_)
+    {
+        next_->onWrite(ev);
+    }
+    auto it = captures_.find(ev.itemname);
+    if (it == captures_.end())
+    {
+        return;
+    }
+    long long t = static_cast<long long>(ev.timestamp.tv_sec) * 1000000 + ev.timestamp.tv_nsec / 1000;
+    for (const Capture &c : it->second)
+    {
+        const FieldSpec &f = c.field;
+        if (c.board != ev.board || f.offset + f.size > ev.size || f.offset + f.size <= ev.dirtyoffset ||
+            f.offset >= ev.dirtyoffset + ev.dirtysize)
+        {
+            continue;
+        }
+        c.series->append(t, detail::fieldValue(f, ev.data + f.offset));
+    }
+}
+
+namespace detail {
+
+void closeHistories()
+{
+    std::unique_lock<std::shared_mutex> lock(g_series_mutex);
+    g_series.clear();
+}
+
+} // namespace detail
+} // namespace qbd
@@ -0,0 +1,110 @@
+// gplat_server —— higplat 协议（msg.h）的服务端
+// 提供看板、队列、数据库表（含二级索引）、订阅（含快照续订、通配、延时推送）、历史库、派生标签和请求流水线，
+// 配置见 config/gplat_server.yaml
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "CConfig.h"
+#include "logging.h"
+#include "server.h"
+
+static volatile sig_atomic_t bExit = 0;
+
+static void signalHandler(int)
+{
+    bExit = 1;
+}
+
+int main(int argc, char *argv[])
+{
+    auto &config = CConfig::GetInstance();
+
+    std::string configPath = argc > 1 ? argv[1] : "../config/gplat_server.yaml";
+    if (!config.Load(configPath))
+    {
+        std::cerr << "警告: " << config.GetLastError() << std::endl;
+        std::cerr << "将使用默认配置运行" << std::endl;
+    }
+
+    // 初始化日志系统
+    LogConfig logCfg;
+    logCfg.log_console     = config.GetBoolDefault("log_console", logCfg.log_console);
+    logCfg.level           = config.GetStringDefault("level", logCfg.level);
+    logCfg.pattern         = config.GetStringDefault("pattern", logCfg.pattern);
+    logCfg.filename        = config.GetStringDefault("filename", "logs/gplat_server.log");
+    logCfg.immediate_flush = config.GetBoolDefault("immediate_flush", logCfg.immediate_flush);
+    logCfg.max_size_mb     = config.GetIntDefault("max_size", logCfg.max_size_mb);
+    logCfg.max_files       = config.GetIntDefault("max_files", logCfg.max_files);
+    logCfg.logger_name     = "gplat_server";
+
+    if (!initLogging(logCfg))
+    {
+        std::cerr << "日志系统初始化失败，程序退出" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    gplat::server::ServerOptions opts;
+    opts.bind_address       = config.GetStringDefault("bind_address", opts.bind_address);
+    opts.port               = config.GetIntDefault("port", opts.port);
+    opts.io_threads         = config.GetIntDefault("io_threads", opts.io_threads);
+    opts.board              = config.GetStringDefault("board", opts.board);
+    opts.board_size         = config.GetIntDefault("board_size", opts.board_size);
+    opts.board_typesize     = config.GetIntDefault("board_typesize", opts.board_typesize);
+    opts.database           = config.GetStringDefault("database", opts.database);
+    opts.database_size      = config.GetIntDefault("database_size", opts.database_size);
+    opts.database_typesize  = config.GetIntDefault("database_typesize", opts.database_typesize);
+    opts.data_dir           = config.GetStringDefault("data_dir", opts.data_dir);
+    opts.huge_pages         = config.GetStringDefault("huge_pages", opts.huge_pages);
+    opts.auto_create_tags   = config.GetBoolDefault("auto_create_tags", opts.auto_create_tags);
+    opts.auto_create_queues = config.GetBoolDefault("auto_create_queues", opts.auto_create_queues);
+    opts.queue_records      = config.GetIntDefault("queue_records", opts.queue_records);
+    opts.max_out_bytes      = static_cast<std::size_t>(config.GetIntDefault("max_out_kb", 16384)) * 1024;
+    opts.checkpoint_dir      = config.GetStringDefault("checkpoint_dir", opts.checkpoint_dir);
+    opts.checkpoint_interval = config.GetIntDefault("checkpoint_interval", opts.checkpoint_interval);
+    opts.history_tags        = config.GetStringDefault("history_tags", opts.history_tags);
+    opts.history_segment_kb  = config.GetIntDefault("history_segment_kb", opts.history_segment_kb);
+    opts.derived_tags        = config.GetStringDefault("derived_tags", opts.derived_tags);
+
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
+    signal(SIGPIPE, SIG_IGN);
+
+    gplat::server::Server server(opts);
+    std::string error;
+    if (!server.start(&error))
+    {
+        getLogger()->error("启动失败: {}", error);
+        std::cerr << "启动失败: " << error << std::endl;
+        shutdownLogging();
+        return EXIT_FAILURE;
+    }
+    std::cout << "gplat_server 已启动，端口 " << opts.port << "（PID: " << getpid() << "）" << std::endl;
+
+    // 主线程每分钟记录一次运行统计
+    auto last = std::chrono::steady_clock::now();
+    while (!bExit)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        auto now = std::chrono::steady_clock::now();
+        if (now - last >= std::chrono::minutes(1))
+        {
+            last   = now;
+            auto s = server.stats();
+            getLogger()->info("连接 {}，累计请求 {}，订阅 {} / 通配 {} / 延时 {}，推送 {}，待发延时推送 {}，多路等待 {}，检查点 {}",
+                              s.connections, s.requests, s.subscriptions.exact, s.subscriptions.patterns,
+                              s.subscriptions.delays, s.subscriptions.posts, s.delay_pending, s.waits, s.checkpoints);
+        }
+    }
+
+    getLogger()->warn("收到退出信号，停止服务...");
+    server.stop();
+    qbd::closeAll();
+    getLogger()->info("gplat_server 已退出");
+    shutdownLogging();
+    return EXIT_SUCCESS;
+}
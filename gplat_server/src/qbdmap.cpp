@@ -0,0 +1,346 @@
+// 对象文件的映射、登记与关闭
+
+#include "qbdmap.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#include "qbdhash.h"
+
+namespace qbd {
+
+namespace {
+
+std::string g_data_dir;
+HugePages   g_huge_pages = HugePages::Off;
+
+constexpr long kHugetlbfsMagic = 0x958458f6; // <linux/magic.h> HUGETLBFS_MAGIC
+constexpr long kTmpfsMagic     = 0x01021994; // <linux/magic.h> TMPFS_MAGIC
+
+// 映射方式：mapObject 按地址记下，registerObject 改按名称登记
+std::mutex                                   g_mapping_mutex;
+std::unordered_map<const void *, MappingInfo> g_mapped;
+std::unordered_map<std::string, MappingInfo>  g_mappings;
+
+std::string pathFor(const char *name)
+{
+    std::string path = g_data_dir;
+    if (!path.empty() && path.back() != '/')
+    {
+        path += '/';
+    }
+    return path + name;
+}
+
+// 系统默认大页大小（/proc/meminfo 的 Hugepagesize），读不到按 2 MB
+long hugePageSize()
+{
+    static const long size = []() {
+        long  kb = 0;
+        FILE *f  = std::fopen("/proc/meminfo", "r");
+        if (f != nullptr)
+        {
+            char line[128];
+            while (std::fgets(line, sizeof(line), f) != nullptr)
+            {
+                if (std::sscanf(line, "Hugepagesize: %ld kB", &kb) == 1)
+                {
+                    break;
+                }
+            }
+            std::fclose(f);
+        }
+        return kb > 0 ? kb * 1024 : 2L << 20;
+    }();
+    return size;
+}
+
+inline long roundUp(long n, long align)
+{
+    return (n + align - 1) / align * align;
+}
+
+void rememberMapping(const void *addr, HugePages backing, long size)
+{
+    std::lock_guard<std::mutex> lock(g_mapping_mutex);
+    g_mapped[addr] = MappingInfo{backing, size};
+}
+
+// 匿名内存：Explicit 先试 MAP_HUGETLB；Transparent（或退回）时多映射一个大页，截成大页对齐的一段再 madvise，
+// 用 MAP_PRIVATE，因为共享匿名内存属于 shmem，透明大页受 shmem_enabled 控制（多数发行版为 never）
+void *mapAnonymous(long size, long *mapped)
+{
+    const long huge = hugePageSize();
+    if (g_huge_pages == HugePages::Explicit)
+    {
+        long  len  = roundUp(size, huge);
+        void *addr = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (addr != MAP_FAILED)
+        {
+            *mapped = len;
+            rememberMapping(addr, HugePages::Explicit, len);
+            return addr;
+        }
+    }
+    if (g_huge_pages != HugePages::Off)
+    {
+        long  len = roundUp(size, huge);
+        void *raw = ::mmap(nullptr, len + huge, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw != MAP_FAILED)
+        {
+            char *begin   = static_cast<char *>(raw);
+            char *aligned = reinterpret_cast<char *>(roundUp(reinterpret_cast<long>(begin), huge));
+            if (aligned > begin)
+            {
+                ::munmap(begin, aligned - begin);
+            }
+            char *end = begin + len + huge;
+            if (end > aligned + len)
+            {
+                ::munmap(aligned + len, end - (aligned + len));
+            }
+            bool advised = ::madvise(aligned, len, MADV_HUGEPAGE) == 0;
+            *mapped      = len;
+            rememberMapping(aligned, advised ? HugePages::Transparent : HugePages::Off, len);
+            return aligned;
+        }
+    }
+    void *addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (addr != MAP_FAILED)
+    {
+        *mapped = size;
+        rememberMapping(addr, HugePages::Off, size);
+    }
+    return addr;
+}
+
+} // namespace
+
+void setDataDir(const std::string &dir)
+{
+    g_data_dir = dir;
+}
+
+const std::string &dataDir()
+{
+    return g_data_dir;
+}
+
+void setHugePages(HugePages mode)
+{
+    g_huge_pages = mode;
+}
+
+HugePages hugePages()
+{
+    return g_huge_pages;
+}
+
+bool mappingInfo(const char *name, MappingInfo *info)
+{
+    std::lock_guard<std::mutex> lock(g_mapping_mutex);
+    auto it = g_mappings.find(name);
+    if (it == g_mappings.end())
+    {
+        return false;
+    }
+    *info = it->second;
+    return true;
+}
+
+void closeAll()
+{
+    std::vector<std::string> names;
+    detail::eachObject([&](const TABLE_MSG &t) { names.emplace_back(t.dqname); });
+    for (const auto &name : names)
+    {
+        detail::closeObject(name.c_str());
+    }
+    detail::closeHistories();
+}
+
+namespace detail {
+
+void *mapObject(const char *name, long size, bool create, int *fd, long *filesize, unsigned int *error)
+{
+    *fd       = -1;
+    *filesize = 0;
+    if (std::strlen(name) >= MAXDQNAMELENTH)
+    {
+        setError(error, ERROR_FILENAME_TOO_LONG);
+        return nullptr;
+    }
+
+    if (g_data_dir.empty())
+    {
+        if (!create)
+        {
+            setError(error, ERROR_DQFILE_NOT_FOUND);
+            return nullptr;
+        }
+        void *addr = mapAnonymous(size, filesize);
+        if (addr == MAP_FAILED)
+        {
+            setError(error, ERROR_MAPVIEWOFFILE);
+            return nullptr;
+        }
+        return addr;
+    }
+
+    std::string path = pathFor(name);
+    int f = create ? ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644) : ::open(path.c_str(), O_RDWR);
+    if (f < 0)
+    {
+        if (create)
+        {
+            setError(error, errno == EEXIST ? ERROR_FILE_IN_USE : ERROR_FILE_CREATE_FAILSURE);
+        }
+        else
+        {
+            setError(error, errno == ENOENT ? ERROR_DQFILE_NOT_FOUND : ERROR_FILE_OPEN_FAILSURE);
+        }
+        return nullptr;
+    }
+
+    // data_dir 在 hugetlbfs 上时文件和映射长度都须是大页的整数倍
+    struct statfs fs;
+    if (::fstatfs(f, &fs) != 0)
+    {
+        std::memset(&fs, 0, sizeof(fs));
+    }
+    bool hugetlbfs = static_cast<long>(fs.f_type) == kHugetlbfsMagic;
+    if (create)
+    {
+        if (hugetlbfs)
+        {
+            size = roundUp(size, static_cast<long>(fs.f_bsize));
+        }
+        if (::ftruncate(f, size) != 0)
+        {
+            ::close(f);
+            ::unlink(path.c_str());
+            setError(error, ERROR_FILE_CREATE_FAILSURE);
+            return nullptr;
+        }
+    }
+    else
+    {
+        struct stat st;
+        if (::fstat(f, &st) != 0 || st.st_size <= 0)
+        {
+            ::close(f);
+            setError(error, ERROR_FILE_OPEN_FAILSURE);
+            return nullptr;
+        }
+        size = st.st_size;
+    }
+
+    void *addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, f, 0);
+    if (addr == MAP_FAILED)
+    {
+        ::close(f);
+        if (create)
+        {
+            ::unlink(path.c_str());
+        }
+        setError(error, ERROR_MAPVIEWOFFILE);
+        return nullptr;
+    }
+    // 文件的共享映射只有 tmpfs（huge=advise 等）支持透明大页，普通磁盘文件系统仍是 4 KB 页
+    HugePages backing = hugetlbfs ? HugePages::Explicit : HugePages::Off;
+    bool      tmpfs   = static_cast<long>(fs.f_type) == kTmpfsMagic;
+    if (tmpfs && g_huge_pages != HugePages::Off && ::madvise(addr, size, MADV_HUGEPAGE) == 0)
+    {
+        backing = HugePages::Transparent;
+    }
+    rememberMapping(addr, backing, size);
+    *fd       = f;
+    *filesize = size;
+    return addr;
+}
+
+bool registerObject(const char *name, void *addr, int fd, long filesize, unsigned int *error)
+{
+    TABLE_MSG tab;
+    std::memset(&tab, 0, sizeof(tab));
+    std::strncpy(tab.dqname, name, MAXDQNAMELENTH - 1);
+    tab.hFile        = fd;
+    tab.lpMapAddress = addr;
+    tab.hMapFile     = fd;
+    tab.pmutex_rw    = new std::mutex;
+    tab.erased       = false;
+    tab.count        = 0;
+    tab.filesize     = filesize;
+    MappingInfo mapping;
+    {
+        std::lock_guard<std::mutex> lock(g_mapping_mutex);
+        auto it = g_mapped.find(addr);
+        if (it != g_mapped.end())
+        {
+            mapping = it->second;
+            g_mapped.erase(it);
+        }
+    }
+    if (!inserttab(tab))
+    {
+        delete tab.pmutex_rw;
+        ::munmap(addr, filesize);
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        setError(error, ERROR_ALREADY_OPEN);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(g_mapping_mutex);
+    g_mappings[name] = mapping;
+    return true;
+}
+
+bool lookup(const char *name, int qbdtype, TABLE_MSG &tabmsg, unsigned int *error)
+{
+    if (!fetchtab(name, tabmsg))
+    {
+        setError(error, ERROR_DQ_NOT_OPEN);
+        return false;
+    }
+    if (*static_cast<const int *>(tabmsg.lpMapAddress) != qbdtype)
+    {
+        setError(error, ERROR_OPERATE_PROHIBIT);
+        return false;
+    }
+    return true;
+}
+
+// 只在进程退出前调用：其它线程不应再访问该对象
+void closeObject(const char *name)
+{
+    TABLE_MSG tab;
+    if (!deletetab(name, tab))
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_mapping_mutex);
+        g_mappings.erase(name);
+    }
+    ::msync(tab.lpMapAddress, tab.filesize, MS_SYNC);
+    ::munmap(tab.lpMapAddress, tab.filesize);
+    if (tab.hFile >= 0)
+    {
+        ::close(tab.hFile);
+    }
+    delete tab.pmutex_rw;
+}
+
+} // namespace detail
+} // namespace qbd
@@ -0,0 +1,77 @@
+#pragma once
+
+// gplat_store 内部使用：对象文件的映射与登记
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#include "qbdstore.h"
+
+namespace qbd {
+namespace detail {
+
+// 映射一个对象：create 为 true 时新建指定大小的文件（已存在则失败），否则打开已有文件
+// 数据目录为空时使用匿名内存，此时不能 load
+void *mapObject(const char *name, long size, bool create, int *fd, long *filesize, unsigned int *error);
+
+// 映射并登记到 TABLE_MSG 表；失败时解除映射
+bool registerObject(const char *name, void *addr, int fd, long filesize, unsigned int *error);
+
+// 查找已登记的对象并检查类型（QUEUE_T / BOARD_T / DATABASE_T）
+bool lookup(const char *name, int qbdtype, TABLE_MSG &tabmsg, unsigned int *error);
+
+// 遍历所有已登记的对象
+void eachObject(const std::function<void(const TABLE_MSG &)> &fn);
+
+// 注销并解除映射
+void closeObject(const char *name);
+
+// 封存并关闭所有历史序列（history.cpp）
+void closeHistories();
+
+inline void setError(unsigned int *error, unsigned int value)
+{
+    if (error)
+    {
+        *error = value;
+    }
+}
+
+// Int / UInt 为 1 / 2 / 4 / 8 字节，Float 为 4 / 8 字节
+inline bool isNumeric(const FieldSpec &f)
+{
+    if (f.type == KeyType::Int || f.type == KeyType::UInt)
+    {
+        return f.size == 1 || f.size == 2 || f.size == 4 || f.size == 8;
+    }
+    return f.type == KeyType::Float && (f.size == 4 || f.size == 8);
+}
+
+// 数值字段的值（p 指向字段），调用方保证 isNumeric(f)
+inline double fieldValue(const FieldSpec &f, const char *p)
+{
+    if (f.type == KeyType::Float)
+    {
+        if (f.size == 4)
+        {
+            float x;
+            std::memcpy(&x, p, 4);
+            return x;
+        }
+        double v;
+        std::memcpy(&v, p, 8);
+        return v;
+    }
+    std::uint64_t u = 0;
+    std::memcpy(&u, p, f.size); // 小端：低位字节在前
+    if (f.type == KeyType::Int && f.size < 8 && (u >> (f.size * 8 - 1)) != 0)
+    {
+        u |= ~std::uint64_t{0} << (f.size * 8); // 符号扩展
+    }
+    return f.type == KeyType::Int ? static_cast<double>(static_cast<std::int64_t>(u)) : static_cast<double>(u);
+}
+
+} // namespace detail
+} // namespace qbd
@@ -0,0 +1,296 @@
+// 已打开对象登记表：qbd.h 中 inserttab / fetchtab / fetchtab1 / deletetab 的实现
+//
+// 每个请求都要按名称查一次登记表，登记、注销只在建立 / 打开 / 关闭对象时发生，按读多写少组织：
+//   - 按名称散列分成 kShards 个分片，每个分片发布一个只读版本：线性探测的开放定址表，
+//     容量取不小于登记数 2 倍的 2 的幂，随登记数伸缩，不再有固定的 TABLESIZE 上限；
+//   - 读者不加锁：取分片的当前版本，登记到本线程的危险指针（hazard pointer）后复核，
+//     再在版本中查找并拷出 TABLE_MSG。读者只写自己的危险指针，不写任何共享的缓存行；
+//   - 写者持分片锁复制当前版本、修改后原子替换；被替换的版本在没有危险指针指向它之后释放。
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "qbdhash.h"
+#include "qbdmap.h"
+
+namespace {
+
+constexpr unsigned kShards      = 16; // 2 的幂
+constexpr unsigned kMinCapacity = 8;  // 2 的幂
+
+// 一个分片的只读版本，dqname[0] == '\0' 为空槽
+struct Version
+{
+    std::vector<TABLE_MSG> slots;
+    unsigned               mask = 0;
+};
+
+struct alignas(64) Shard
+{
+    std::mutex             mutex; // 写者
+    std::atomic<Version *> current{nullptr};
+    std::vector<Version *> retired; // 已被替换、可能仍有读者的版本（mutex 保护）
+};
+
+// 每个线程一个，读者在访问版本期间指向它
+struct alignas(64) Hazard
+{
+    std::atomic<const Version *> ptr{nullptr};
+    std::atomic<bool>            used{false};
+    Hazard                      *next = nullptr;
+};
+
+Shard                g_shards[kShards];
+std::atomic<Hazard *> g_hazards{nullptr}; // 只增不减的链表，线程退出后槽位留给之后的线程
+
+Hazard *acquireHazard()
+{
+    for (Hazard *h = g_hazards.load(std::memory_order_acquire); h != nullptr; h = h->next)
+    {
+        bool expected = false;
+        if (!h->used.load(std::memory_order_relaxed) &&
+            h->used.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+        {
+            return h;
+        }
+    }
+    Hazard *h = new Hazard;
+    h->used.store(true, std::memory_order_relaxed);
+    Hazard *head = g_hazards.load(std::memory_order_relaxed);
+    do
+    {
+        h->next = head;
+    } while (!g_hazards.compare_exchange_weak(head, h, std::memory_order_release, std::memory_order_relaxed));
+    return h;
+}
+
+struct HazardHolder
+{
+    Hazard *hazard = acquireHazard();
+    ~HazardHolder()
+    {
+        hazard->ptr.store(nullptr, std::memory_order_release);
+        hazard->used.store(false, std::memory_order_release);
+    }
+};
+
+Hazard &localHazard()
+{
+    thread_local HazardHolder holder;
+    return *holder.hazard;
+}
+
+Shard &shardOf(const char *dqname)
+{
+    return g_shards[static_cast<unsigned>(hash1(dqname)) & (kShards - 1)];
+}
+
+const TABLE_MSG *findIn(const Version &v, const char *dqname)
+{
+    for (unsigned pos = static_cast<unsigned>(hash2(dqname)) & v.mask;; pos = (pos + 1) & v.mask)
+    {
+        const TABLE_MSG &slot = v.slots[pos];
+        if (slot.dqname[0] == '\0')
+        {
+            return nullptr; // 装载率不超过 1/2，必有空槽
+        }
+        if (std::strncmp(slot.dqname, dqname, MAXDQNAMELENTH) == 0)
+        {
+            return &slot;
+        }
+    }
+}
+
+// 在分片的当前版本上执行 fn（不加锁），执行期间该版本不会被释放
+template <typename Fn>
+void readShard(Shard &s, Fn &&fn)
+{
+    Hazard        &h = localHazard();
+    const Version *v = s.current.load(std::memory_order_acquire);
+    for (;;)
+    {
+        // 先登记再复核：复核时仍是当前版本，则写者替换它之后一定能看到这次登记
+        h.ptr.store(v, std::memory_order_seq_cst);
+        const Version *again = s.current.load(std::memory_order_seq_cst);
+        if (again == v)
+        {
+            break;
+        }
+        v = again;
+    }
+    if (v != nullptr)
+    {
+        fn(*v);
+    }
+    h.ptr.store(nullptr, std::memory_order_release);
+}
+
+// 以下持分片锁调用
+std::vector<TABLE_MSG> entriesOf(const Shard &s)
+{
+    std::vector<TABLE_MSG> entries;
+    const Version         *v = s.current.load(std::memory_order_relaxed);
+    if (v != nullptr)
+    {
+        for (const TABLE_MSG &slot : v->slots)
+        {
+            if (slot.dqname[0] != '\0')
+            {
+                entries.push_back(slot);
+            }
+        }
+    }
+    return entries;
+}
+
+void publish(Shard &s, const std::vector<TABLE_MSG> &entries)
+{
+    unsigned capacity = kMinCapacity;
+    while (capacity < entries.size() * 2)
+    {
+        capacity *= 2;
+    }
+    Version *next = new Version;
+    next->slots.resize(capacity); // 值初始化：全部为空槽
+    next->mask = capacity - 1;
+    for (const TABLE_MSG &e : entries)
+    {
+        unsigned pos = static_cast<unsigned>(hash2(e.dqname)) & next->mask;
+        while (next->slots[pos].dqname[0] != '\0')
+        {
+            pos = (pos + 1) & next->mask;
+        }
+        next->slots[pos]        = e;
+        next->slots[pos].erased = false;
+    }
+
+    Version *old = s.current.exchange(next, std::memory_order_seq_cst);
+    if (old != nullptr)
+    {
+        s.retired.push_back(old);
+    }
+
+    // 释放已没有读者的旧版本，其余留到该分片下一次写入
+    std::vector<const Version *> inuse;
+    for (Hazard *h = g_hazards.load(std::memory_order_acquire); h != nullptr; h = h->next)
+    {
+        if (const Version *p = h->ptr.load(std::memory_order_seq_cst))
+        {
+            inuse.push_back(p);
+        }
+    }
+    auto keep = std::partition(s.retired.begin(), s.retired.end(), [&](Version *v) {
+        return std::find(inuse.begin(), inuse.end(), v) != inuse.end();
+    });
+    for (auto it = keep; it != s.retired.end(); ++it)
+    {
+        delete *it;
+    }
+    s.retired.erase(keep, s.retired.end());
+}
+
+// 找到名称返回其在 entries 中的下标，否则返回 -1
+int indexOf(const std::vector<TABLE_MSG> &entries, const char *dqname)
+{
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        if (std::strncmp(entries[i].dqname, dqname, MAXDQNAMELENTH) == 0)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+bool inserttab(const struct TABLE_MSG &tabmsg)
+{
+    Shard                      &s = shardOf(tabmsg.dqname);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::vector<TABLE_MSG>      entries = entriesOf(s);
+    if (indexOf(entries, tabmsg.dqname) >= 0)
+    {
+        return false; // 已存在
+    }
+    entries.push_back(tabmsg);
+    publish(s, entries);
+    return true;
+}
+
+bool fetchtab(const char *dqname, struct TABLE_MSG &tabmsg)
+{
+    bool found = false;
+    readShard(shardOf(dqname), [&](const Version &v) {
+        if (const TABLE_MSG *slot = findIn(v, dqname))
+        {
+            tabmsg = *slot;
+            found  = true;
+        }
+    });
+    return found;
+}
+
+// 与 fetchtab 相同，同时把引用计数加 1（写操作，走分片锁）
+bool fetchtab1(const char *dqname, struct TABLE_MSG &tabmsg)
+{
+    Shard                      &s = shardOf(dqname);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::vector<TABLE_MSG>      entries = entriesOf(s);
+    int                         i       = indexOf(entries, dqname);
+    if (i < 0)
+    {
+        return false;
+    }
+    ++entries[i].count;
+    tabmsg = entries[i];
+    publish(s, entries);
+    return true;
+}
+
+bool deletetab(const char *dqname, struct TABLE_MSG &tabmsg)
+{
+    Shard                      &s = shardOf(dqname);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::vector<TABLE_MSG>      entries = entriesOf(s);
+    int                         i       = indexOf(entries, dqname);
+    if (i < 0)
+    {
+        return false;
+    }
+    tabmsg = entries[i];
+    entries.erase(entries.begin() + i);
+    publish(s, entries);
+    return true;
+}
+
+namespace qbd {
+namespace detail {
+
+// 先拷出各分片的登记项再回调，fn 中可以再调用登记表的函数
+void eachObject(const std::function<void(const TABLE_MSG &)> &fn)
+{
+    std::vector<TABLE_MSG> all;
+    for (Shard &s : g_shards)
+    {
+        readShard(s, [&](const Version &v) {
+            for (const TABLE_MSG &slot : v.slots)
+            {
+                if (slot.dqname[0] != '\0')
+                {
+                    all.push_back(slot);
+                }
+            }
+        });
+    }
+    for (const TABLE_MSG &t : all)
+    {
+        fn(t);
+    }
+}
+
+} // namespace detail
+} // namespace qbd
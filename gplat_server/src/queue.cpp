@@ -0,0 +1,251 @@
+// 队列：QUEUE_HEAD + 类型区 + (RECORD_HEAD + 记录) × (num + 1) 的环形缓冲
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <mutex>
+
+#include "qbdhash.h"
+#include "qbdmap.h"
+
+namespace qbd {
+
+namespace {
+
+struct Queue
+{
+    QUEUE_HEAD *head  = nullptr;
+    char       *slots = nullptr; // 第一个槽
+    std::mutex *mutex = nullptr;
+};
+
+inline int slotCount(const QUEUE_HEAD *head)
+{
+    return head->num + 1; // 多留一个槽区分空和满
+}
+
+inline int slotSize(const QUEUE_HEAD *head)
+{
+    return static_cast<int>(RECORDHEADSIZE) + head->size;
+}
+
+long queueFileSize(int recordsize, int recordnum, int typesize)
+{
+    return static_cast<long>(QUEUEHEADSIZE) + typesize +
+           static_cast<long>(RECORDHEADSIZE + recordsize) * (recordnum + 1);
+}
+
+bool getQueue(const char *qname, Queue &q, unsigned int *error)
+{
+    TABLE_MSG tab;
+    if (!detail::lookup(qname, QUEUE_T, tab, error))
+    {
+        return false;
+    }
+    q.head  = static_cast<QUEUE_HEAD *>(tab.lpMapAddress);
+    q.slots = static_cast<char *>(tab.lpMapAddress) + QUEUEHEADSIZE + q.head->typesize;
+    q.mutex = tab.pmutex_rw;
+    return true;
+}
+
+inline bool isEmpty(const QUEUE_HEAD *head)
+{
+    return head->readPoint == head->writePoint;
+}
+
+inline bool isFull(const QUEUE_HEAD *head)
+{
+    return (head->writePoint + 1) % slotCount(head) == head->readPoint;
+}
+
+} // namespace
+
+bool createQueue(const char *qname, int recordsize, int recordnum, int datatype, int mode, const void *type,
+                 int typesize, unsigned int *error)
+{
+    if (recordsize <= 0 || recordnum <= 0 || typesize < 0 || (typesize > 0 && type == nullptr))
+    {
+        detail::setError(error, ERROR_RECORDSIZE);
+        return false;
+    }
+    int  fd       = -1;
+    long filesize = 0;
+    void *addr    = detail::mapObject(qname, queueFileSize(recordsize, recordnum, typesize), true, &fd, &filesize,
+                                      error);
+    if (addr == nullptr)
+    {
+        return false;
+    }
+
+    auto *head        = static_cast<QUEUE_HEAD *>(addr);
+    head->qbdtype     = QUEUE_T;
+    head->dataType    = datatype;
+    head->operateMode = mode;
+    head->num         = recordnum;
+    head->size        = recordsize;
+    head->readPoint   = 0;
+    head->writePoint  = 0;
+    head->typesize    = typesize;
+    gettime(head->createDate);
+    if (typesize > 0)
+    {
+        std::memcpy(static_cast<char *>(addr) + QUEUEHEADSIZE, type, typesize);
+    }
+    return detail::registerObject(qname, addr, fd, filesize, error);
+}
+
+bool loadQueue(const char *qname, unsigned int *error)
+{
+    TABLE_MSG tab;
+    if (fetchtab(qname, tab))
+    {
+        detail::setError(error, 0);
+        return true;
+    }
+    int  fd       = -1;
+    long filesize = 0;
+    void *addr    = detail::mapObject(qname, 0, false, &fd, &filesize, error);
+    if (addr == nullptr)
+    {
+        return false;
+    }
+    auto *head = static_cast<QUEUE_HEAD *>(addr);
+    if (head->qbdtype != QUEUE_T || filesize < queueFileSize(head->size, head->num, head->typesize))
+    {
+        ::munmap(addr, filesize);
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        detail::setError(error, ERROR_FILE_OPEN_FAILSURE);
+        return false;
+    }
+    return detail::registerObject(qname, addr, fd, filesize, error);
+}
+
+bool readQueue(const char *qname, void *record, int bufsize, int *actsize, bool peek, RECORD_HEAD *rechead,
+               unsigned int *error)
+{
+    Queue q;
+    if (!getQueue(qname, q, error))
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(*q.mutex);
+    QUEUE_HEAD *head = q.head;
+    if (isEmpty(head))
+    {
+        detail::setError(error, ERROR_DQ_EMPTY);
+        return false;
+    }
+    if (bufsize < head->size && head->dataType != ASCII_TYPE)
+    {
+        detail::setError(error, ERROR_BUFFER_SIZE);
+        return false;
+    }
+
+    const char *slot = q.slots + static_cast<long>(head->readPoint) * slotSize(head);
+    const char *data = slot + RECORDHEADSIZE;
+    int n = head->size;
+    if (head->dataType == ASCII_TYPE)
+    {
+        n = static_cast<int>(::strnlen(data, head->size));
+        if (n + 1 > bufsize)
+        {
+            detail::setError(error, BUFFER_TOO_SMALL);
+            return false;
+        }
+        static_cast<char *>(record)[n] = '\0';
+    }
+    std::memcpy(record, data, n);
+    if (actsize)
+    {
+        *actsize = n;
+    }
+    if (rechead)
+    {
+        std::memcpy(rechead, slot, RECORDHEADSIZE);
+    }
+    if (!peek)
+    {
+        head->readPoint = (head->readPoint + 1) % slotCount(head);
+    }
+    detail::setError(error, 0);
+    return true;
+}
+
+bool writeQueue(const char *qname, const void *record, int size, const char *remoteip, unsigned int *error)
+{
+    Queue q;
+    if (!getQueue(qname, q, error))
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(*q.mutex);
+    QUEUE_HEAD *head = q.head;
+    if (size < 0 || size > head->size)
+    {
+        detail::setError(error, ERROR_RECORDSIZE);
+        return false;
+    }
+    if (isFull(head))
+    {
+        if (head->operateMode != SHIFT_MODE)
+        {
+            detail::setError(error, ERROR_DQ_FULL);
+            return false;
+        }
+        head->readPoint = (head->readPoint + 1) % slotCount(head); // 移位队列：丢弃最旧的记录
+    }
+
+    char *slot = q.slots + static_cast<long>(head->writePoint) * slotSize(head);
+    auto *rh   = reinterpret_cast<RECORD_HEAD *>(slot);
+    gettime(rh->createDate);
+    std::memset(rh->remoteIp, 0, sizeof(rh->remoteIp));
+    if (remoteip)
+    {
+        std::strncpy(rh->remoteIp, remoteip, sizeof(rh->remoteIp) - 1);
+    }
+    rh->ack   = 0;
+    rh->index = head->writePoint;
+
+    char *data = slot + RECORDHEADSIZE;
+    std::memcpy(data, record, size);
+    if (size < head->size)
+    {
+        std::memset(data + size, 0, head->size - size);
+    }
+    head->writePoint = (head->writePoint + 1) % slotCount(head);
+    detail::setError(error, 0);
+    return true;
+}
+
+bool clearQueue(const char *qname, unsigned int *error)
+{
+    Queue q;
+    if (!getQueue(qname, q, error))
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(*q.mutex);
+    q.head->readPoint  = 0;
+    q.head->writePoint = 0;
+    detail::setError(error, 0);
+    return true;
+}
+
+bool queueState(const char *qname, QUEUE_HEAD *head, unsigned int *error)
+{
+    Queue q;
+    if (!getQueue(qname, q, error))
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(*q.mutex);
+    *head = *q.head;
+    detail::setError(error, 0);
+    return true;
+}
+
+} // namespace qbd
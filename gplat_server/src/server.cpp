@@ -0,0 +1,1627 @@
+#include "server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "logging.h"
+
+namespace gplat {
+namespace server {
+
+namespace {
+
+constexpr int         kMaxEvents    = 256;
+constexpr std::size_t kMaxSnapshots = 16; // 每个连接同时打开的表快照数
+
+static_assert(qbd::kMaxItemSize == MAXMSGLEN, "标签长度上限须与报文长度上限一致");
+
+// 连接打开的快照，快照号不存在时返回空
+qbd::Snapshot snapshotOf(Connection &conn, int id)
+{
+    auto it = conn.snapshots().find(id);
+    return it != conn.snapshots().end() ? it->second : nullptr;
+}
+
+// 应答：复制请求头（带回 eventid 请求序号），只改 id / error
+void reply(Connection &conn, const MSGHEAD &request, bool ok, unsigned int error, const void *body = nullptr,
+           int size = 0)
+{
+    MSGHEAD head = request;
+    head.id      = ok ? SUCCEED : FAIL;
+    head.error   = ok ? 0 : error;
+    conn.write(head, body, size, true);
+}
+
+int listenSocket(const std::string &address, int port, std::string *error)
+{
+    sockaddr_in addr;
+    if (!wire::resolveAddress(address.c_str(), port, addr))
+    {
+        *error = "无法解析监听地址 " + address;
+        return -1;
+    }
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        *error = std::string("socket: ") + std::strerror(errno);
+        return -1;
+    }
+    int on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || ::listen(fd, SOMAXCONN) != 0)
+    {
+        *error = "监听 " + address + ":" + std::to_string(port) + " 失败: " + std::strerror(errno);
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+std::string peerName(const sockaddr_in &addr)
+{
+    char ip[INET_ADDRSTRLEN] = {0};
+    ::inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+    return ip;
+}
+
+std::string nameOf(const char *field, std::size_t n)
+{
+    return std::string(field, ::strnlen(field, n));
+}
+
+// 报文头中的定长名称字段转为以 '\0' 结尾的串，放在栈上：请求路径上不为标签名分配内存
+// （跟踪类标签名常超过 std::string 的短串长度）
+template <std::size_t N>
+struct FieldName
+{
+    explicit FieldName(const char (&field)[N])
+    {
+        std::size_t n = ::strnlen(field, N);
+        std::memcpy(str, field, n);
+        str[n] = '\0';
+    }
+    bool empty() const { return str[0] == '\0'; }
+
+    char str[N + 1];
+};
+
+// PLC 批量写中各值类型的长度，PLCVAL_STRING 为 -1（变长），未知类型为 0
+int plcValueSize(int valtype)
+{
+    switch (valtype)
+    {
+    case PLCVAL_BOOL:
+        return sizeof(bool);
+    case PLCVAL_SHORT:
+    case PLCVAL_USHORT:
+        return sizeof(short);
+    case PLCVAL_INT:
+    case PLCVAL_UINT:
+    case PLCVAL_FLOAT:
+        return sizeof(int);
+    case PLCVAL_STRING:
+        return -1;
+    default:
+        return 0;
+    }
+}
+
+// history_tags 中的一项 "标签[@偏移]:类型"，类型为 C 的数值类型名
+bool parseHistoryTag(const std::string &spec, std::string &tag, qbd::FieldSpec &field)
+{
+    std::size_t colon = spec.rfind(':');
+    if (colon == std::string::npos)
+    {
+        return false;
+    }
+    std::string type = spec.substr(colon + 1);
+    tag              = spec.substr(0, colon);
+    field.offset     = 0;
+    std::size_t at   = tag.find('@');
+    if (at != std::string::npos)
+    {
+        char *end    = nullptr;
+        long  offset = std::strtol(tag.c_str() + at + 1, &end, 10);
+        if (end == tag.c_str() + at + 1 || *end != '\0' || offset < 0 || offset > MAXMSGLEN)
+        {
+            return false;
+        }
+        field.offset = static_cast<int>(offset);
+        tag.resize(at);
+    }
+    return !tag.empty() && qbd::numericType(type.c_str(), &field);
+}
+
+} // namespace
+
+// ============================================================
+//  Reactor：一个 IO 线程
+// ============================================================
+struct Server::Reactor
+{
+    int         epfd     = -1;
+    int         listenfd = -1;
+    int         wakefd   = -1;
+    std::thread thread;
+
+    // 只由本线程访问
+    std::unordered_map<Connection *, ConnectionPtr> conns;
+
+    ~Reactor()
+    {
+        for (int fd : {listenfd, wakefd, epfd})
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+    }
+};
+
+Server::Server(ServerOptions options)
+    : options_(std::move(options)), subs_(options_.board, delays_), waits_(options_.board, delays_, &subs_),
+      history_(&waits_), derived_(&history_)
+{
+}
+
+Server::~Server()
+{
+    stop();
+}
+
+bool Server::start(std::string *error)
+{
+    if (running_.load())
+    {
+        return true;
+    }
+    qbd::setDataDir(options_.data_dir);
+    if (options_.huge_pages == "thp")
+    {
+        qbd::setHugePages(qbd::HugePages::Transparent);
+    }
+    else if (options_.huge_pages == "hugetlb")
+    {
+        qbd::setHugePages(qbd::HugePages::Explicit);
+    }
+    else
+    {
+        qbd::setHugePages(qbd::HugePages::Off);
+    }
+
+    unsigned int err = 0;
+    if (!qbd::openBoard(options_.board.c_str(), options_.board_size, options_.board_typesize, &err))
+    {
+        *error = "打开看板 " + options_.board + " 失败，错误码 " + std::to_string(err);
+        return false;
+    }
+    qbd::MappingInfo mapping;
+    if (qbd::mappingInfo(options_.board.c_str(), &mapping))
+    {
+        static const char *kBacking[] = {"4 KB 页", "透明大页", "hugetlb 大页"};
+        getLogger()->info("看板 {} 映射 {} 字节，{}（配置 {}）", options_.board, mapping.size,
+                          kBacking[static_cast<int>(mapping.backing)], options_.huge_pages);
+    }
+    if (!options_.checkpoint_dir.empty())
+    {
+        restoreDefaultBoard();
+    }
+    if (!qbd::openDatabase(options_.database.c_str(), options_.database_size, options_.database_typesize, &err))
+    {
+        *error = "打开数据库 " + options_.database + " 失败，错误码 " + std::to_string(err);
+        return false;
+    }
+    if (!openHistoryTags(error) || !openDerivedTags(error))
+    {
+        return false;
+    }
+    // 观察者链：派生标签 → 历史库 → 多路等待 → 订阅表，没有派生标签 / 历史标签时跳过
+    observer_ = !derived_.empty() ? static_cast<qbd::ItemObserver *>(&derived_)
+                : !history_.empty() ? static_cast<qbd::ItemObserver *>(&history_)
+                                    : &waits_;
+    derived_.evaluate(observer_); // 按看板中已有的输入先算一次
+
+    int threads = options_.io_threads > 0 ? options_.io_threads : 1;
+    for (int i = 0; i < threads; ++i)
+    {
+        auto r      = std::make_unique<Reactor>();
+        r->listenfd = listenSocket(options_.bind_address, options_.port, error);
+        r->epfd     = ::epoll_create1(EPOLL_CLOEXEC);
+        r->wakefd   = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (r->listenfd < 0 || r->epfd < 0 || r->wakefd < 0)
+        {
+            if (error->empty())
+            {
+                *error = std::string("epoll: ") + std::strerror(errno);
+            }
+            reactors_.clear();
+            return false;
+        }
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events   = EPOLLIN;
+        ev.data.ptr = nullptr; // 监听套接字
+        ::epoll_ctl(r->epfd, EPOLL_CTL_ADD, r->listenfd, &ev);
+        ev.data.ptr = r.get(); // 唤醒
+        ::epoll_ctl(r->epfd, EPOLL_CTL_ADD, r->wakefd, &ev);
+        reactors_.push_back(std::move(r));
+    }
+
+    running_.store(true);
+    delays_.start();
+    for (auto &r : reactors_)
+    {
+        r->thread = std::thread(&Server::runReactor, this, std::ref(*r));
+    }
+    if (!options_.checkpoint_dir.empty())
+    {
+        ckpt_stop_   = false;
+        ckpt_thread_ = std::thread(&Server::runCheckpoints, this);
+    }
+    getLogger()->info("gplat_server 监听 {}:{}，IO 线程 {}，看板 {}（{} 字节），数据库 {}（{} 字节），数据目录 {}",
+                      options_.bind_address, options_.port, threads, options_.board, options_.board_size,
+                      options_.database, options_.database_size,
+                      options_.data_dir.empty() ? "<内存>" : options_.data_dir);
+    return true;
+}
+
+void Server::stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+    for (auto &r : reactors_)
+    {
+        uint64_t one = 1;
+        (void)::write(r->wakefd, &one, sizeof(one));
+    }
+    for (auto &r : reactors_)
+    {
+        if (r->thread.joinable())
+        {
+            r->thread.join();
+        }
+    }
+    delays_.stop();
+    reactors_.clear();
+
+    if (ckpt_thread_.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(ckpt_mutex_);
+            ckpt_stop_ = true;
+            ckpt_queue_.clear(); // 请求方的连接已全部关闭
+        }
+        ckpt_cv_.notify_all();
+        ckpt_thread_.join();
+        // 已没有写入，退出前的检查点即下次启动的恢复点
+        unsigned int err = 0;
+        checkpoint(options_.board, nullptr, &err);
+    }
+}
+
+ServerStats Server::stats() const
+{
+    ServerStats s;
+    s.connections   = connections_.load(std::memory_order_relaxed);
+    s.accepted      = accepted_.load(std::memory_order_relaxed);
+    s.requests      = requests_.load(std::memory_order_relaxed);
+    s.subscriptions = subs_.stats();
+    s.delay_pending = delays_.pending();
+    s.waits         = waits_.size();
+    s.checkpoints   = checkpoints_.load(std::memory_order_relaxed);
+    return s;
+}
+
+void Server::runReactor(Reactor &r)
+{
+    epoll_event events[kMaxEvents];
+    while (running_.load(std::memory_order_relaxed))
+    {
+        int n = ::epoll_wait(r.epfd, events, kMaxEvents, -1);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            getLogger()->error("epoll_wait: {}", std::strerror(errno));
+            break;
+        }
+        for (int i = 0; i < n; ++i)
+        {
+            void *ptr = events[i].data.ptr;
+            if (ptr == nullptr)
+            {
+                acceptAll(r);
+                continue;
+            }
+            if (ptr == &r)
+            {
+                continue; // 唤醒：回到循环检查 running_
+            }
+            auto it = r.conns.find(static_cast<Connection *>(ptr));
+            if (it == r.conns.end())
+            {
+                continue;
+            }
+            ConnectionPtr conn = it->second;
+            uint32_t      ev   = events[i].events;
+            if ((ev & EPOLLOUT) != 0 && !conn->flush())
+            {
+                closeConnection(r, conn);
+                continue;
+            }
+            if ((ev & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0)
+            {
+                readConnection(r, conn);
+            }
+        }
+    }
+
+    // 退出：关闭本线程的所有连接
+    while (!r.conns.empty())
+    {
+        ConnectionPtr conn = r.conns.begin()->second;
+        closeConnection(r, conn);
+    }
+}
+
+void Server::acceptAll(Reactor &r)
+{
+    for (;;)
+    {
+        sockaddr_in addr;
+        socklen_t   len = sizeof(addr);
+        int fd = ::accept4(r.listenfd, reinterpret_cast<sockaddr *>(&addr), &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                getLogger()->warn("accept: {}", std::strerror(errno));
+            }
+            return;
+        }
+        int on = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+        auto conn = std::make_shared<Connection>(fd, r.epfd, next_id_.fetch_add(1), peerName(addr),
+                                                 options_.max_out_bytes);
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events   = EPOLLIN | EPOLLRDHUP;
+        ev.data.ptr = conn.get();
+        if (::epoll_ctl(r.epfd, EPOLL_CTL_ADD, fd, &ev) != 0)
+        {
+            getLogger()->warn("epoll_ctl: {}", std::strerror(errno));
+            continue; // conn 析构时关闭 fd
+        }
+        r.conns.emplace(conn.get(), conn);
+        connections_.fetch_add(1, std::memory_order_relaxed);
+        accepted_.fetch_add(1, std::memory_order_relaxed);
+        getLogger()->debug("连接 {} 来自 {}", conn->id(), conn->peer());
+    }
+}
+
+void Server::readConnection(Reactor &r, const ConnectionPtr &conn)
+{
+    // 水平触发：每次只读一次，读出的完整报文全部处理后统一发出应答
+    ssize_t n = conn->rx().readFrom(conn->fd());
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+    {
+        closeConnection(r, conn);
+        return;
+    }
+
+    wire::Frame  frame;
+    unsigned int err   = 0;
+    std::uint64_t count = 0;
+    while (conn->rx().next(frame, &err))
+    {
+        handle(conn, frame);
+        ++count;
+    }
+    requests_.fetch_add(count, std::memory_order_relaxed);
+    if (err != 0)
+    {
+        getLogger()->warn("连接 {} 报文长度非法，断开", conn->id());
+        closeConnection(r, conn);
+        return;
+    }
+    if (!conn->flush())
+    {
+        closeConnection(r, conn);
+    }
+}
+
+void Server::closeConnection(Reactor &r, const ConnectionPtr &conn)
+{
+    subs_.removeConnection(*conn);
+    waits_.removeConnection(*conn);
+    conn->snapshots().clear();
+    conn->close();
+    if (r.conns.erase(conn.get()) > 0)
+    {
+        connections_.fetch_sub(1, std::memory_order_relaxed);
+        getLogger()->debug("连接 {} 关闭", conn->id());
+    }
+}
+
+const char *Server::boardOf(const MSGHEAD &head) const
+{
+    return head.qname[0] != '\0' ? head.qname : options_.board.c_str();
+}
+
+// ============================================================
+//  请求分发
+// ============================================================
+void Server::handle(const ConnectionPtr &conn, const wire::Frame &frame)
+{
+    const MSGHEAD &head  = frame.head;
+    const char    *board = boardOf(head);
+    FieldName      name(head.itemname);
+    const char    *tag   = name.str;
+    unsigned int   err   = 0;
+
+    // 只有默认看板的写入通知订阅表（及历史库、派生标签）
+    qbd::ItemObserver *observer = nullptr;
+    if (head.qname[0] == '\0' || options_.board == head.qname)
+    {
+        observer = observer_;
+    }
+
+    switch (head.id)
+    {
+    case READB:
+    {
+        if (head.subsize > 0)
+        {
+            readRange(conn, frame);
+            break;
+        }
+        char          buf[MAXMSGLEN];
+        qbd::ItemMeta meta;
+        bool ok = qbd::readItem(board, tag, buf, sizeof(buf), &meta, &err);
+        if (ok && meta.itemsize > static_cast<int>(sizeof(buf)))
+        {
+            // 不经 createItem 建成的超长标签（如旧的看板文件），只能部分读
+            ok  = false;
+            err = ERROR_BUFFER_SIZE;
+        }
+        if (ok && head.datasize > 0 && head.datasize != meta.itemsize)
+        {
+            ok  = false;
+            err = ERROR_RECORDSIZE;
+        }
+        MSGHEAD h   = head;
+        h.datasize  = ok ? meta.itemsize : 0;
+        h.timestamp = meta.timestamp;
+        h.datatype  = static_cast<int>(meta.typestamp);
+        reply(*conn, h, ok, err, buf, ok ? meta.itemsize : 0);
+        break;
+    }
+    case READBSTRING:
+    {
+        char          buf[MAXMSGLEN];
+        qbd::ItemMeta meta;
+        bool ok = qbd::readItemString(board, tag, buf, sizeof(buf), &meta, &err);
+        MSGHEAD h   = head;
+        h.datasize  = ok ? meta.strlenth : 0;
+        h.timestamp = meta.timestamp;
+        h.datatype  = static_cast<int>(meta.typestamp);
+        reply(*conn, h, ok, err, buf, ok ? meta.strlenth + 1 : 0);
+        break;
+    }
+    case WRITEB:
+    case WRITEBPLC:
+    {
+        if (head.id == WRITEBPLC && head.arraysize > 0 && name.empty())
+        {
+            writePlcBatch(conn, frame, observer);
+            break;
+        }
+        if (head.subsize > 0)
+        {
+            bool ok = head.bodysize == head.subsize;
+            if (ok)
+            {
+                ok = qbd::writeItemRange(board, tag, head.offset, frame.body, head.subsize, observer, &err);
+            }
+            reply(*conn, head, ok, ok ? 0 : (err != 0 ? err : ERROR_INVALID_PARAMETER));
+            break;
+        }
+        bool ok = writeTag(board, tag, frame.body, head.bodysize, observer, &err);
+        reply(*conn, head, ok, err);
+        break;
+    }
+    case WRITEBSTRING:
+    case WRITEBSTRINGPLC:
+    {
+        int  len = static_cast<int>(::strnlen(frame.body, head.bodysize));
+        bool ok  = writeTagString(board, tag, frame.body, len, observer, &err);
+        reply(*conn, head, ok, err);
+        break;
+    }
+    case CREATEITEM:
+    {
+        bool ok = qbd::createItem(board, tag, head.datasize, head.bodysize > 0 ? frame.body : nullptr,
+                                  head.bodysize, &err);
+        reply(*conn, head, ok, err);
+        break;
+    }
+    case DELETEITEM:
+    {
+        bool ok = qbd::deleteItem(board, tag, &err);
+        reply(*conn, head, ok, err);
+        break;
+    }
+    case READTYPE:
+    {
+        char         buf[MAXMSGLEN];
+        int          typesize = 0;
+        unsigned int stamp    = 0;
+        bool ok = qbd::readType(board, tag, buf, sizeof(buf), &typesize, &stamp, &err);
+        MSGHEAD h  = head;
+        h.datasize = ok ? typesize : 0;
+        h.datatype = static_cast<int>(stamp);
+        reply(*conn, h, ok, err, buf, ok ? typesize : 0);
+        break;
+    }
+    case CLEARB:
+    {
+        bool ok = qbd::clearBoard(board, &err);
+        reply(*conn, head, ok, err);
+        break;
+    }
+    case READBOARDINFO:
+    {
+        BOARD_INFO info;
+        std::memset(&info, 0, sizeof(info));
+        bool ok = qbd::boardInfo(board, &info, &err);
+        reply(*conn, head, ok, err, &info, ok ? static_cast<int>(sizeof(info)) : 0);
+        break;
+    }
+    case CHECKPOINTB:
+    {
+        if (options_.checkpoint_dir.empty())
+        {
+            reply(*conn, head, false, ERROR_OPERATE_PROHIBIT);
+            break;
+        }
+        // 交给检查点线程，写完后由其应答
+        {
+            std::lock_guard<std::mutex> lock(ckpt_mutex_);
+            ckpt_queue_.push_back(CheckpointRequest{conn, head, board});
+        }
+        ckpt_cv_.notify_one();
+        break;
+    }
+    case READHIST:
+        readHistory(conn, frame);
+        break;
+    case WAITMULTI:
+        waitMulti(conn, frame);
+        break;
+    case OPENQ:
+    case CLOSEQ:
+    case READQ:
+    case PEEKQ:
+    case POPARECORDQ:
+    case WRITEQ:
+    case CLEARQ:
+    case ISEMPTYQ:
+    case ISFULLQ:
+        handleQueue(conn, frame);
+        break;
+    case SELECTTB:
+    case CLEARTB:
+    case INSERTTB:
+    case REFRESHTB:
+    case CREATETABLE:
+    case DELETETABLE:
+    case CLEARDB:
+    case CREATEINDEX:
+    case DELETEINDEX:
+    case SCANTB:
+    case OPENSNAPSHOT:
+    case CLOSESNAPSHOT:
+        handleTable(conn, frame);
+        break;
+    case SUBSCRIBE:
+        handleSubscribe(conn, frame);
+        break;
+    case CANCELSUBSCRIBE:
+        handleCancel(conn, frame);
+        break;
+    case CONNECT:
+    case RECONNECT:
+    case DISCONNECT:
+    case OPEN:
+    case WATCHDOG:
+    case ACK:
+    case REGISTERPLCSERVER:
+        reply(*conn, head, true, 0);
+        break;
+    default:
+        reply(*conn, head, false, ERROR_INVALID_PARAMETER);
+        break;
+    }
+
+    // 本请求改变了派生标签的输入：释放标签锁后在本线程重算，应答随同一批发出
+    if (observer && derived_.pending())
+    {
+        derived_.evaluate(observer);
+    }
+    // 本请求写了等待中的队列 / 标签：检查被唤醒的 WAITMULTI 并应答
+    if (waits_.pending())
+    {
+        waits_.dispatch();
+    }
+}
+
+// ============================================================
+//  标签写入
+// ============================================================
+bool Server::writeTag(const char *board, const char *tag, const char *data, int size, qbd::ItemObserver *observer,
+                      unsigned int *error)
+{
+    bool ok = qbd::writeItem(board, tag, data, size, observer, error);
+    if (!ok && *error == ERROR_ITEM_NOT_EXIST && options_.auto_create_tags && size > 0)
+    {
+        if (size > qbd::kMaxItemSize)
+        {
+            *error = ERROR_PARAMETER_SIZE;
+            return false;
+        }
+        // 并发自动创建时另一方先建成也算成功
+        if (qbd::createItem(board, tag, size, nullptr, 0, error) || *error == ERROR_ITEM_ALREADY_EXIST)
+        {
+            ok = qbd::writeItem(board, tag, data, size, observer, error);
+        }
+    }
+    return ok;
+}
+
+bool Server::writeTagString(const char *board, const char *tag, const char *str, int len,
+                            qbd::ItemObserver *observer, unsigned int *error)
+{
+    bool ok = qbd::writeItemString(board, tag, str, len, observer, error);
+    if (!ok && *error == ERROR_ITEM_NOT_EXIST && options_.auto_create_tags)
+    {
+        int size = std::max(len + 1, 256);
+        if (size > qbd::kMaxItemSize)
+        {
+            *error = ERROR_PARAMETER_SIZE;
+            return false;
+        }
+        if (qbd::createItem(board, tag, size, nullptr, 0, error) || *error == ERROR_ITEM_ALREADY_EXIST)
+        {
+            ok = qbd::writeItemString(board, tag, str, len, observer, error);
+        }
+    }
+    return ok;
+}
+
+// 部分读（见 msg.h"部分读写"）：应答 body 为 [offset, offset + subsize)，datasize 为标签长度
+void Server::readRange(const ConnectionPtr &conn, const wire::Frame &frame)
+{
+    const MSGHEAD &head = frame.head;
+    FieldName      name(head.itemname);
+    char           buf[MAXMSGLEN];
+    qbd::ItemMeta  meta;
+    unsigned int   err = 0;
+    bool           ok  = head.subsize <= MAXMSGLEN;
+    if (ok)
+    {
+        ok = qbd::readItemRange(boardOf(head), name.str, head.offset, buf, head.subsize, &meta, &err);
+    }
+    else
+    {
+        err = ERROR_ITEM_OVERFLOW;
+    }
+    if (ok && head.datasize > 0 && head.datasize != meta.itemsize)
+    {
+        ok  = false;
+        err = ERROR_RECORDSIZE;
+    }
+    MSGHEAD h   = head;
+    h.datasize  = meta.itemsize;
+    h.timestamp = meta.timestamp;
+    h.datatype  = static_cast<int>(meta.typestamp);
+    reply(*conn, h, ok, err, buf, ok ? head.subsize : 0);
+}
+
+// ============================================================
+//  历史库
+// ============================================================
+bool Server::openHistoryTags(std::string *error)
+{
+    std::string list = options_.history_tags;
+    std::replace(list.begin(), list.end(), ',', ' ');
+    std::size_t pos = 0;
+    int         n   = 0;
+    while ((pos = list.find_first_not_of(" \t", pos)) != std::string::npos)
+    {
+        std::size_t    end  = list.find_first_of(" \t", pos);
+        std::string    spec = list.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        std::string    tag;
+        qbd::FieldSpec field;
+        pos = end;
+        if (!parseHistoryTag(spec, tag, field))
+        {
+            *error = "history_tags 中的 " + spec + " 格式应为 标签[@偏移]:类型";
+            return false;
+        }
+        std::string  series = field.offset > 0 ? tag + "@" + std::to_string(field.offset) : tag;
+        unsigned int err    = 0;
+        if (!qbd::openHistory(series.c_str(), static_cast<long>(options_.history_segment_kb) * 1024, &err) ||
+            !history_.add(options_.board.c_str(), tag.c_str(), field, series.c_str(), &err))
+        {
+            *error = "打开历史序列 " + series + " 失败，错误码 " + std::to_string(err);
+            return false;
+        }
+        ++n;
+    }
+    if (n > 0)
+    {
+        getLogger()->info("历史库记录 {} 个序列，段文件 {} KB", n, options_.history_segment_kb);
+    }
+    return true;
+}
+
+void Server::readHistory(const ConnectionPtr &conn, const wire::Frame &frame)
+{
+    const MSGHEAD &head = frame.head;
+    HISTQUERY      q;
+    if (head.bodysize < static_cast<int>(sizeof(q)))
+    {
+        reply(*conn, head, false, ERROR_MSGSIZE);
+        return;
+    }
+    std::memcpy(&q, frame.body, sizeof(q));
+    FieldName    name(head.itemname);
+    unsigned int err  = 0;
+    bool         more = false;
+    MSGHEAD      h    = head;
+    if (q.bucket > 0)
+    {
+        int                             limit = MAXMSGLEN / static_cast<int>(sizeof(HISTBUCKET));
+        std::vector<qbd::HistoryBucket> buckets;
+        bool ok = qbd::downsampleHistory(name.str, q.from, q.to, q.bucket, q.limit > 0 && q.limit < limit ? q.limit : limit,
+                                         buckets, &more, &err);
+        std::vector<HISTBUCKET> out(buckets.size());
+        for (std::size_t i = 0; i < buckets.size(); ++i)
+        {
+            const qbd::HistoryBucket &b = buckets[i];
+            out[i] = HISTBUCKET{b.start, b.count, 0, b.min, b.max, b.avg, b.first, b.last};
+        }
+        h.count   = static_cast<int>(out.size());
+        h.readptr = more ? 1 : 0;
+        reply(*conn, h, ok, err, out.data(), ok ? static_cast<int>(out.size() * sizeof(HISTBUCKET)) : 0);
+        return;
+    }
+    int                            limit = MAXMSGLEN / static_cast<int>(sizeof(HISTPOINT));
+    std::vector<qbd::HistoryPoint> points;
+    bool ok = qbd::readHistory(name.str, q.from, q.to, q.skip > 0 ? q.skip : 0,
+                               q.limit > 0 && q.limit < limit ? q.limit : limit, points, &more, &err);
+    std::vector<HISTPOINT> out(points.size());
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+        out[i] = HISTPOINT{points[i].t, points[i].value};
+    }
+    h.count   = static_cast<int>(out.size());
+    h.readptr = more ? 1 : 0;
+    reply(*conn, h, ok, err, out.data(), ok ? static_cast<int>(out.size() * sizeof(HISTPOINT)) : 0);
+}
+
+// ============================================================
+//  派生标签
+// ============================================================
+bool Server::openDerivedTags(std::string *error)
+{
+    std::string list = options_.derived_tags;
+    std::replace(list.begin(), list.end(), '\n', ';');
+    std::size_t pos = 0;
+    while (pos < list.size())
+    {
+        std::size_t end   = std::min(list.find(';', pos), list.size());
+        std::string def   = list.substr(pos, end - pos);
+        std::size_t first = def.find_first_not_of(" \t\r");
+        pos               = end + 1;
+        if (first == std::string::npos)
+        {
+            continue;
+        }
+        def = def.substr(first, def.find_last_not_of(" \t\r") + 1 - first);
+        std::string err;
+        if (!derived_.add(options_.board.c_str(), def.c_str(), &err))
+        {
+            *error = "derived_tags 中的 " + def + "：" + err;
+            return false;
+        }
+    }
+    if (!derived_.empty())
+    {
+        getLogger()->info("派生标签 {} 个", derived_.size());
+    }
+    return true;
+}
+
+// PLC 批量写（见 msg.h 的 PLCWRITE）：先校验整个 body，再在一次处理中逐项写入
+void Server::writePlcBatch(const ConnectionPtr &conn, const wire::Frame &frame, qbd::ItemObserver *observer)
+{
+    const MSGHEAD &head  = frame.head;
+    const char    *board = boardOf(head);
+    int            count = head.arraysize;
+
+    // 项数来自客户端，分配前先按 body 长度核对：每项至少一个 PLCWRITE 头
+    if (count <= 0 || count > head.bodysize / static_cast<int>(sizeof(PLCWRITE)))
+    {
+        reply(*conn, head, false, ERROR_INVALID_PARAMETER);
+        return;
+    }
+
+    std::vector<int> offsets; // 各项 PLCWRITE 在 body 中的偏移
+    offsets.reserve(count);
+    int pos = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        PLCWRITE w;
+        if (head.bodysize - pos < static_cast<int>(sizeof(w)))
+        {
+            break;
+        }
+        std::memcpy(&w, frame.body + pos, sizeof(w));
+        int fixed = plcValueSize(w.valtype);
+        if (fixed == 0 || w.valuesize <= 0 || w.valuesize > head.bodysize - pos - static_cast<int>(sizeof(w)) ||
+            (fixed > 0 && w.valuesize != fixed) || ::strnlen(w.tagname, sizeof(w.tagname)) == 0)
+        {
+            break;
+        }
+        offsets.push_back(pos);
+        pos += static_cast<int>(sizeof(w)) + w.valuesize;
+    }
+    if (static_cast<int>(offsets.size()) != count || pos != head.bodysize)
+    {
+        reply(*conn, head, false, ERROR_INVALID_PARAMETER);
+        return;
+    }
+
+    std::vector<unsigned int> errors(offsets.size(), 0);
+    unsigned int              first = 0;
+    int                       done  = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        PLCWRITE w;
+        std::memcpy(&w, frame.body + offsets[i], sizeof(w));
+        FieldName   name(w.tagname);
+        const char *value = frame.body + offsets[i] + sizeof(w);
+        bool        ok    = w.valtype == PLCVAL_STRING
+                                ? writeTagString(board, name.str, value,
+                                                 static_cast<int>(::strnlen(value, w.valuesize)), observer, &errors[i])
+                                : writeTag(board, name.str, value, w.valuesize, observer, &errors[i]);
+        if (ok)
+        {
+            errors[i] = 0;
+            ++done;
+        }
+        else if (first == 0)
+        {
+            first = errors[i];
+        }
+    }
+    MSGHEAD h = head;
+    h.count   = done;
+    reply(*conn, h, done == count, first, errors.data(), static_cast<int>(errors.size() * sizeof(unsigned int)));
+}
+
+// ============================================================
+//  检查点
+// ============================================================
+std::string Server::checkpointPath(const std::string &board) const
+{
+    std::string path = options_.checkpoint_dir;
+    if (path.back() != '/')
+    {
+        path += '/';
+    }
+    return path + board + ".ckpt";
+}
+
+void Server::restoreDefaultBoard()
+{
+    const char  *board = options_.board.c_str();
+    BOARD_INFO   info;
+    unsigned int err = 0;
+    std::memset(&info, 0, sizeof(info));
+    if (qbd::boardInfo(board, &info, &err) && info.tagcount_head > 0)
+    {
+        getLogger()->info("看板 {} 已有 {} 个标签（数据文件），不从检查点恢复", board, info.tagcount_act);
+        return;
+    }
+    std::string         path = checkpointPath(options_.board);
+    qbd::CheckpointInfo ci;
+    auto                t0 = std::chrono::steady_clock::now();
+    if (qbd::restoreBoard(board, path.c_str(), &ci, &err))
+    {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        getLogger()->info("由检查点 {} 恢复看板 {}：{} 个标签，映像 {} 字节，耗时 {:.1f} ms", path, board, ci.items,
+                          ci.imagesize, ms);
+    }
+    else if (err != ERROR_DQFILE_NOT_FOUND)
+    {
+        // 改名保留，免得之后的检查点用空看板覆盖它
+        std::string bad = path + ".bad";
+        ::rename(path.c_str(), bad.c_str());
+        getLogger()->warn("检查点 {} 无法恢复（错误码 {}），已改名为 {}，看板 {} 以空看板启动", path, err, bad,
+                          board);
+    }
+}
+
+bool Server::checkpoint(const std::string &board, qbd::CheckpointInfo *info, unsigned int *error)
+{
+    qbd::CheckpointInfo ci;
+    std::string         path = checkpointPath(board);
+    auto                t0   = std::chrono::steady_clock::now();
+    if (!qbd::checkpointBoard(board.c_str(), path.c_str(), &ci, error))
+    {
+        getLogger()->warn("看板 {} 写检查点 {} 失败，错误码 {}", board, path, *error);
+        return false;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    getLogger()->info("看板 {} 检查点：{} 个标签，映像 {} 字节，耗时 {:.1f} ms", board, ci.items, ci.imagesize, ms);
+    checkpoints_.fetch_add(1, std::memory_order_relaxed);
+    if (info)
+    {
+        *info = ci;
+    }
+    return true;
+}
+
+void Server::runCheckpoints()
+{
+    using Clock        = std::chrono::steady_clock;
+    const auto  period = std::chrono::seconds(options_.checkpoint_interval);
+    auto        next   = Clock::now() + period;
+    std::unique_lock<std::mutex> lock(ckpt_mutex_);
+    while (!ckpt_stop_)
+    {
+        auto ready = [this]() { return ckpt_stop_ || !ckpt_queue_.empty(); };
+        if (options_.checkpoint_interval > 0)
+        {
+            ckpt_cv_.wait_until(lock, next, ready);
+        }
+        else
+        {
+            ckpt_cv_.wait(lock, ready);
+        }
+        if (ckpt_stop_)
+        {
+            break;
+        }
+
+        if (!ckpt_queue_.empty())
+        {
+            CheckpointRequest req = std::move(ckpt_queue_.front());
+            ckpt_queue_.pop_front();
+            lock.unlock();
+            qbd::CheckpointInfo info;
+            unsigned int        err = 0;
+            bool                ok  = checkpoint(req.board, &info, &err);
+            if (ConnectionPtr conn = req.conn.lock())
+            {
+                // 跨线程应答，不走 IO 线程的 cork 批处理
+                MSGHEAD h  = req.head;
+                h.id       = ok ? SUCCEED : FAIL;
+                h.error    = ok ? 0 : err;
+                h.count    = ok ? info.items : 0;
+                h.datasize = ok ? static_cast<int>(info.imagesize) : 0;
+                conn->write(h, static_cast<const iovec *>(nullptr), 0, false);
+            }
+            lock.lock();
+        }
+        else if (options_.checkpoint_interval > 0 && Clock::now() >= next)
+        {
+            next = Clock::now() + period;
+            lock.unlock();
+            unsigned int err = 0;
+            checkpoint(options_.board, nullptr, &err);
+            lock.lock();
+        }
+    }
+}
+
+// ============================================================
+//  队列
+// ============================================================
+bool Server::ensureQueue(const char *qname, int recordsize, bool create, unsigned int *error)
+{
+    QUEUE_HEAD state;
+    if (qbd::queueState(qname, &state, error))
+    {
+        return true;
+    }
+    if (*error != ERROR_DQ_NOT_OPEN)
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(create_mutex_);
+    if (qbd::queueState(qname, &state, error) || (!options_.data_dir.empty() && qbd::loadQueue(qname, error)))
+    {
+        return true;
+    }
+    if (!create || recordsize <= 0)
+    {
+        *error = ERROR_DQ_NOT_OPEN;
+        return false;
+    }
+    return qbd::createQueue(qname, recordsize, options_.queue_records, BINARY_TYPE, NORMAL_MODE, nullptr, 0, error);
+}
+
+void Server::handleQueue(const ConnectionPtr &conn, const wire::Frame &frame)
+{
+    const MSGHEAD &head  = frame.head;
+    FieldName      name(head.qname);
+    const char    *qname = name.str;
+    unsigned int   err   = 0;
+
+    bool create = head.id == WRITEQ && options_.auto_create_queues;
+    int  recsize = std::max(head.recsize, head.bodysize);
+    if (name.empty() || !ensureQueue(qname, recsize, create, &err))
+    {
+        reply(*conn, head, false, name.empty() ? ERROR_INVALID_PARAMETER : err);
+        return;
+    }
+
+    switch (head.id)
+    {
+    case OPENQ:
+    case CLOSEQ:
+        reply(*conn, head, true, 0);
+        break;
+    case READQ:
+    case PEEKQ:
+    case POPARECORDQ:
+    {
+        char        buf[MAXMSGLEN];
+        int         actsize = 0;
+        RECORD_HEAD rechead;
+        bool ok = qbd::readQueue(qname, buf, sizeof(buf), &actsize, head.id == PEEKQ, &rechead, &err);
+        MSGHEAD h  = head;
+        h.datasize = ok ? actsize : 0;
+        if (ok)
+        {
+            std::memcpy(h.ip, rechead.remoteIp, std::min(sizeof(h.ip), sizeof(rechead.remoteIp)));
+        }
+        reply(*conn, h, ok, err, buf, ok ? actsize : 0);
+        break;
+    }
+    case WRITEQ:
+    {
+        bool ok = qbd::writeQueue(qname, frame.body, head.bodysize, conn->peer().c_str(), &err);
+        reply(*conn, head, ok, err);
+        if (ok)
+        {
+            waits_.queueWritten(qname);
+        }
+        break;
+    }
+    case CLEARQ:
+    {
+        bool ok = qbd::clearQueue(qname, &err);
+        reply(*conn, head, ok, err);
+        break;
+    }
+    case ISEMPTYQ:
+    case ISFULLQ:
+    {
+        // 结果放在 head.count（1 是 / 0 否），readptr / writeptr 带回队列当前读写位置
+        QUEUE_HEAD state;
+        bool ok = qbd::queueState(qname, &state, &err);
+        MSGHEAD h = head;
+        if (ok)
+        {
+            bool empty = state.readPoint == state.writePoint;
+            bool full  = (state.writePoint + 1) % (state.num + 1) == state.readPoint;
+            h.count    = (head.id == ISEMPTYQ ? empty : full) ? 1 : 0;
+            h.readptr  = state.readPoint;
+            h.writeptr = state.writePoint;
+        }
+        reply(*conn, h, ok, err);
+        break;
+    }
+    default:
+        reply(*conn, head, false, ERROR_INVALID_PARAMETER);
+        break;
+    }
+}
+
+// WAITMULTI：校验条目后交给 WaitTable；已存在于数据目录的队列先加载，尚不存在的视为空
+void Server::waitMulti(const ConnectionPtr &conn, const wire::Frame &frame)
+{
+    const MSGHEAD &head  = frame.head;
+    int            count = head.arraysize;
+    if (count <= 0 || count > WAITMAX)
+    {
+        reply(*conn, head, false, ERROR_INVALID_PARAMETER);
+        return;
+    }
+    if (head.bodysize != count * static_cast<int>(sizeof(WAITENTRY)))
+    {
+        reply(*conn, head, false, ERROR_MSGSIZE);
+        return;
+    }
+    const WAITENTRY *entries = reinterpret_cast<const WAITENTRY *>(frame.body);
+    for (int i = 0; i < count; ++i)
+    {
+        FieldName name(entries[i].name);
+        if (name.empty() || (entries[i].kind != WAIT_QUEUE && entries[i].kind != WAIT_TAG))
+        {
+            reply(*conn, head, false, ERROR_INVALID_PARAMETER);
+            return;
+        }
+        if (entries[i].kind == WAIT_QUEUE)
+        {
+            unsigned int err = 0;
+            ensureQueue(name.str, 0, false, &err);
+        }
+    }
+    waits_.wait(conn, head, entries, count);
+}
+
+// ============================================================
+//  数据库表
+// ============================================================
+void Server::handleTable(const ConnectionPtr &conn, const wire::Frame &frame)
+{
+    const MSGHEAD &head = frame.head;
+    FieldName      dbname(head.qname);
+    FieldName      name(head.itemname);
+    const char    *db    = dbname.empty() ? options_.database.c_str() : dbname.str;
+    const char    *table = name.str;
+    unsigned int   err   = 0;
+
+    switch (head.id)
+    {
+    case CREATETABLE:
+    {
+        bool ok = qbd::createTable(db, table, head.recsize, head.count, head.bodysize > 0 ? frame.body : nullptr,
+                                   head.bodysize, &err);
+        reply(*conn, head, ok, err);
+        break;
+    }
+    case DELETETABLE:
+    {
+        bool ok = qbd::deleteTable(db, table, &err);
+        reply(*conn, head, ok, err);
+        break;
+    }
+    case CLEARTB:
+    {
+        bool ok = qbd::clearTable(db, table, &err);
+        reply(*conn, head, ok, err);
+        break;
+    }
+    case CLEARDB:
+    {
+        bool ok = qbd::clearDatabase(db, &err);
+        reply(*conn, head, ok, err);
+        break;
+    }
+    case INSERTTB:
+    {
+        int     first = 0;
+        int     count = 0;
+        bool    ok    = qbd::insertRecords(db, table, frame.body, head.bodysize, &first, &count, &err);
+        MSGHEAD h     = head;
+        h.start       = ok ? first : 0;
+        h.count       = ok ? count : 0;
+        reply(*conn, h, ok, err);
+        break;
+    }
+    case REFRESHTB:
+    {
+        bool ok = qbd::refreshRecords(db, table, head.start, frame.body, head.bodysize, &err);
+        reply(*conn, head, ok, err);
+        break;
+    }
+    case SELECTTB:
+    {
+        if (head.bodysize > 0)
+        {
+            selectByKey(conn, frame, db, table);
+            break;
+        }
+        char           buf[MAXMSGLEN];
+        int            n     = 0;
+        int            count = head.count > 0 ? head.count : MAXMSGLEN;
+        qbd::TableInfo info;
+        bool           ok;
+        if (head.writeptr != 0)
+        {
+            qbd::Snapshot snap = snapshotOf(*conn, head.writeptr);
+            if (!snap)
+            {
+                reply(*conn, head, false, ERROR_ITEM_NOT_EXIST);
+                break;
+            }
+            info = qbd::snapshotInfo(snap);
+            ok   = qbd::selectSnapshot(snap, head.start, count, buf, sizeof(buf), &n, &err);
+        }
+        else
+        {
+            ok = qbd::selectRecords(db, table, head.start, count, buf, sizeof(buf), &n, &info, &err);
+        }
+        MSGHEAD h  = head;
+        h.count    = n;
+        h.recsize  = info.recordsize;
+        h.datasize = info.currcount;
+        reply(*conn, h, ok, err, buf, ok ? n * info.recordsize : 0);
+        break;
+    }
+    case CREATEINDEX:
+    {
+        TBINDEX spec;
+        if (head.bodysize < static_cast<int>(sizeof(spec)))
+        {
+            reply(*conn, head, false, ERROR_MSGSIZE);
+            break;
+        }
+        std::memcpy(&spec, frame.body, sizeof(spec));
+        if ((spec.kind != TBIDX_HASH && spec.kind != TBIDX_ORDERED) || spec.keytype < TBKEY_INT ||
+            spec.keytype > TBKEY_BYTES)
+        {
+            reply(*conn, head, false, ERROR_INVALID_PARAMETER);
+            break;
+        }
+        qbd::IndexSpec ix;
+        ix.name         = nameOf(spec.name, sizeof(spec.name));
+        ix.kind         = spec.kind == TBIDX_HASH ? qbd::IndexKind::Hash : qbd::IndexKind::Ordered;
+        ix.field.name   = nameOf(spec.field, sizeof(spec.field));
+        ix.field.type   = static_cast<qbd::KeyType>(spec.keytype);
+        ix.field.offset = spec.offset;
+        ix.field.size   = spec.size;
+        int     indexed = 0;
+        bool    ok      = qbd::createIndex(db, table, ix, &indexed, &err);
+        MSGHEAD h       = head;
+        h.count         = indexed;
+        reply(*conn, h, ok, err);
+        if (ok)
+        {
+            getLogger()->info("表 {}.{} 建{}索引 {}，{} 条记录", db, table,
+                              ix.kind == qbd::IndexKind::Hash ? "哈希" : "有序", ix.name, indexed);
+        }
+        break;
+    }
+    case DELETEINDEX:
+    {
+        TBINDEX spec;
+        if (head.bodysize < static_cast<int>(sizeof(spec)))
+        {
+            reply(*conn, head, false, ERROR_MSGSIZE);
+            break;
+        }
+        std::memcpy(&spec, frame.body, sizeof(spec));
+        FieldName index(spec.name);
+        bool ok = qbd::dropIndex(db, table, index.str, &err);
+        reply(*conn, head, ok, err);
+        break;
+    }
+    case SCANTB:
+        scanTable(conn, frame, db, table);
+        break;
+    case OPENSNAPSHOT:
+    {
+        if (conn->snapshots().size() >= kMaxSnapshots)
+        {
+            reply(*conn, head, false, ERROR_OPERATE_PROHIBIT);
+            break;
+        }
+        qbd::Snapshot  snap;
+        qbd::TableInfo info;
+        bool           ok = qbd::openSnapshot(db, table, &snap, &info, &err);
+        MSGHEAD        h  = head;
+        if (ok)
+        {
+            h.writeptr = conn->nextSnapshotId();
+            h.recsize  = info.recordsize;
+            h.datasize = info.currcount;
+            conn->snapshots().emplace(h.writeptr, std::move(snap));
+        }
+        reply(*conn, h, ok, err);
+        break;
+    }
+    case CLOSESNAPSHOT:
+    {
+        bool ok = conn->snapshots().erase(head.writeptr) > 0;
+        reply(*conn, head, ok, ok ? 0 : ERROR_ITEM_NOT_EXIST);
+        break;
+    }
+    default:
+        reply(*conn, head, false, ERROR_INVALID_PARAMETER);
+        break;
+    }
+}
+
+// 按键 SELECTTB：应答 body 为行号[n] + 记录[n]（TBSEL_ROWIDS 时只有行号）
+void Server::selectByKey(const ConnectionPtr &conn, const wire::Frame &frame, const char *db, const char *table)
+{
+    const MSGHEAD &head = frame.head;
+    TBKEY          key;
+    if (head.bodysize < static_cast<int>(sizeof(key)))
+    {
+        reply(*conn, head, false, ERROR_MSGSIZE);
+        return;
+    }
+    std::memcpy(&key, frame.body, sizeof(key));
+    if (head.writeptr != 0)
+    {
+        // 按键选择走索引，不读快照
+        reply(*conn, head, false, ERROR_OPERATE_PROHIBIT);
+        return;
+    }
+    bool range = (key.flags & TBSEL_RANGE) != 0;
+    if (key.keysize <= 0 || key.keytype < TBKEY_INT || key.keytype > TBKEY_BYTES ||
+        head.bodysize < static_cast<int>(sizeof(key)) + key.keysize * (range ? 2 : 1))
+    {
+        reply(*conn, head, false, ERROR_INVALID_PARAMETER);
+        return;
+    }
+
+    qbd::KeyQuery q;
+    q.index        = nameOf(key.index, sizeof(key.index));
+    q.field.name   = nameOf(key.field, sizeof(key.field));
+    q.field.type   = static_cast<qbd::KeyType>(key.keytype);
+    q.field.offset = key.offset;
+    q.field.size   = key.size;
+    q.lo           = frame.body + sizeof(key);
+    q.hi           = range ? frame.body + sizeof(key) + key.keysize : nullptr;
+    q.keysize      = key.keysize;
+    q.skip         = head.start;
+
+    // 每条占 行号 + 记录，按当前记录长度算出一个应答放得下的条数；
+    // 记录缓冲只留余下的空间，即使表在两次调用之间被重建为更长的记录，应答也不会超过 MAXMSGLEN
+    bool           rowids = (key.flags & TBSEL_ROWIDS) != 0;
+    qbd::TableInfo info;
+    unsigned int   err = 0;
+    if (!qbd::tableInfo(db, table, &info, &err))
+    {
+        reply(*conn, head, false, err);
+        return;
+    }
+    int per   = static_cast<int>(sizeof(int)) + (rowids ? 0 : info.recordsize);
+    int limit = MAXMSGLEN / per;
+    q.limit   = head.count > 0 && head.count < limit ? head.count : limit;
+
+    char  out[MAXMSGLEN];
+    char *records = rowids ? nullptr : out + sizeof(int) * q.limit;
+    int   rows[MAXMSGLEN / sizeof(int)];
+    int   n    = 0;
+    bool  more = false;
+    bool  ok   = qbd::selectByKey(db, table, q, rows, records, MAXMSGLEN - static_cast<int>(sizeof(int)) * q.limit,
+                                  &n, &more, &info, &err);
+    int size = 0;
+    if (ok)
+    {
+        std::memcpy(out, rows, sizeof(int) * n);
+        size = static_cast<int>(sizeof(int)) * n;
+        if (!rowids)
+        {
+            std::memmove(out + size, records, static_cast<std::size_t>(n) * info.recordsize);
+            size += n * info.recordsize;
+        }
+    }
+    MSGHEAD h  = head;
+    h.count    = n;
+    h.recsize  = info.recordsize;
+    h.datasize = info.currcount;
+    h.readptr  = more ? 1 : 0;
+    reply(*conn, h, ok, err, out, size);
+}
+
+// SCANTB：应答 body 同按键 SELECTTB，head.start 为续扫的起始行
+void Server::scanTable(const ConnectionPtr &conn, const wire::Frame &frame, const char *db, const char *table)
+{
+    const MSGHEAD &head = frame.head;
+    TBSCAN         scan;
+    if (head.bodysize < static_cast<int>(sizeof(scan)))
+    {
+        reply(*conn, head, false, ERROR_MSGSIZE);
+        return;
+    }
+    std::memcpy(&scan, frame.body, sizeof(scan));
+    if (scan.npred < 0 ||
+        head.bodysize < static_cast<int>(sizeof(scan)) + scan.npred * static_cast<int>(sizeof(TBPRED)))
+    {
+        reply(*conn, head, false, ERROR_INVALID_PARAMETER);
+        return;
+    }
+
+    qbd::ScanQuery q;
+    q.start = head.start;
+    for (int i = 0; i < scan.npred; ++i)
+    {
+        TBPRED pred;
+        std::memcpy(&pred, frame.body + sizeof(scan) + i * sizeof(pred), sizeof(pred));
+        if (pred.keytype < TBKEY_INT || pred.keytype > TBKEY_FLOAT || pred.op < TBOP_EQ || pred.op > TBOP_BETWEEN)
+        {
+            reply(*conn, head, false, ERROR_INVALID_PARAMETER);
+            return;
+        }
+        qbd::Predicate p;
+        p.field.name   = nameOf(pred.field, sizeof(pred.field));
+        p.field.type   = static_cast<qbd::KeyType>(pred.keytype);
+        p.field.offset = pred.offset;
+        p.field.size   = pred.size;
+        p.op           = static_cast<qbd::PredOp>(pred.op);
+        std::memcpy(p.value, pred.value, sizeof(p.value));
+        std::memcpy(p.value2, pred.value2, sizeof(p.value2));
+        q.preds.push_back(p);
+    }
+
+    // 应答大小的限制同 selectByKey
+    bool           rowids = (scan.flags & TBSEL_ROWIDS) != 0;
+    qbd::TableInfo info;
+    unsigned int   err = 0;
+    qbd::Snapshot  snap;
+    if (head.writeptr != 0)
+    {
+        snap = snapshotOf(*conn, head.writeptr);
+        if (!snap)
+        {
+            reply(*conn, head, false, ERROR_ITEM_NOT_EXIST);
+            return;
+        }
+        info = qbd::snapshotInfo(snap);
+    }
+    else if (!qbd::tableInfo(db, table, &info, &err))
+    {
+        reply(*conn, head, false, err);
+        return;
+    }
+    int per   = static_cast<int>(sizeof(int)) + (rowids ? 0 : info.recordsize);
+    int limit = MAXMSGLEN / per;
+    q.limit   = head.count > 0 && head.count < limit ? head.count : limit;
+
+    char  out[MAXMSGLEN];
+    char *records = rowids ? nullptr : out + sizeof(int) * q.limit;
+    int   rows[MAXMSGLEN / sizeof(int)];
+    int   n    = 0;
+    int   next = 0;
+    int   bufsize = MAXMSGLEN - static_cast<int>(sizeof(int)) * q.limit;
+    bool  ok      = snap ? qbd::scanSnapshot(snap, q, rows, records, bufsize, &n, &next, &err)
+                         : qbd::scanTable(db, table, q, rows, records, bufsize, &n, &next, &info, &err);
+    int size = 0;
+    if (ok)
+    {
+        std::memcpy(out, rows, sizeof(int) * n);
+        size = static_cast<int>(sizeof(int)) * n;
+        if (!rowids)
+        {
+            std::memmove(out + size, records, static_cast<std::size_t>(n) * info.recordsize);
+            size += n * info.recordsize;
+        }
+    }
+    MSGHEAD h  = head;
+    h.start    = ok ? next : head.start;
+    h.count    = n;
+    h.recsize  = info.recordsize;
+    h.datasize = info.currcount;
+    h.readptr  = ok && next < info.currcount ? 1 : 0;
+    reply(*conn, h, ok, err, out, size);
+}
+
+// ============================================================
+//  订阅
+// ============================================================
+void Server::handleSubscribe(const ConnectionPtr &conn, const wire::Frame &frame)
+{
+    const MSGHEAD &head    = frame.head;
+    int            options = head.eventarg & (SUBOPT_STAMP | SUBOPT_SNAPSHOT | SUBOPT_SEQ | SUBOPT_RANGE);
+    unsigned int   err     = 0;
+
+    if (head.count > 0)
+    {
+        // 批量 / 通配 / 续订：先处理精确条目，再处理通配条目，已补发过的标签不再重复
+        if (static_cast<std::size_t>(head.bodysize) < head.count * sizeof(SUBENTRY))
+        {
+            reply(*conn, head, false, ERROR_MSGSIZE);
+            return;
+        }
+        std::vector<SUBENTRY> entries(head.count);
+        std::memcpy(entries.data(), frame.body, entries.size() * sizeof(SUBENTRY));
+
+        std::unordered_map<std::string, unsigned long long> lastseqs;
+        std::unordered_set<std::string>                     handled;
+        for (const auto &e : entries)
+        {
+            std::string name = nameOf(e.tagname, sizeof(e.tagname));
+            if (!name.empty() && !isPattern(name.c_str()))
+            {
+                lastseqs[name] = e.lastseq;
+                if (handled.insert(name).second)
+                {
+                    subs_.subscribe(conn, name.c_str(), options, e.lastseq, &err);
+                }
+            }
+        }
+        for (const auto &e : entries)
+        {
+            std::string name = nameOf(e.tagname, sizeof(e.tagname));
+            if (isPattern(name.c_str()))
+            {
+                subs_.subscribePattern(conn, name.c_str(), options, lastseqs, handled);
+            }
+        }
+        reply(*conn, head, true, 0);
+        return;
+    }
+
+    std::string tag = nameOf(head.itemname, sizeof(head.itemname));
+    if (tag.empty())
+    {
+        reply(*conn, head, false, ERROR_INVALID_PARAMETER);
+        return;
+    }
+    if (head.bodysize > 0)
+    {
+        // 延时订阅：body 为事件名，timeout 为延时
+        std::string eventname = nameOf(frame.body, static_cast<std::size_t>(head.bodysize));
+        if (eventname.empty() || head.timeout < 0)
+        {
+            reply(*conn, head, false, ERROR_INVALID_PARAMETER);
+            return;
+        }
+        subs_.subscribeDelay(conn, tag.c_str(), eventname.c_str(), head.timeout);
+        reply(*conn, head, true, 0);
+        return;
+    }
+    if (isPattern(tag.c_str()))
+    {
+        std::unordered_set<std::string> handled;
+        subs_.subscribePattern(conn, tag.c_str(), options, {}, handled);
+        reply(*conn, head, true, 0);
+        return;
+    }
+    bool ok = subs_.subscribe(conn, tag.c_str(), options, 0, &err);
+    reply(*conn, head, ok, err);
+}
+
+void Server::handleCancel(const ConnectionPtr &conn, const wire::Frame &frame)
+{
+    const MSGHEAD &head = frame.head;
+    std::string    tag  = nameOf(head.itemname, sizeof(head.itemname));
+    if (head.bodysize > 0)
+    {
+        // 撤销延时推送：不回应答（见 gplat_delaypost.h）
+        std::string eventname = nameOf(frame.body, static_cast<std::size_t>(head.bodysize));
+        subs_.cancelDelay(*conn, tag.c_str(), eventname.c_str());
+        return;
+    }
+    bool ok = subs_.unsubscribe(*conn, tag.c_str());
+    reply(*conn, head, ok, ERROR_ITEM_NOT_EXIST);
+}
+
+} // namespace server
+} // namespace gplat
@@ -0,0 +1,593 @@
+#include "subscription.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace gplat {
+namespace server {
+
+bool globMatch(const char *pattern, const char *name)
+{
+    const char *star = nullptr; // 最近一个 '*' 之后的位置
+    const char *mark = nullptr; // '*' 当前吞到的位置
+    while (*name != '\0')
+    {
+        if (*pattern == '?' || (*pattern != '*' && *pattern == *name))
+        {
+            ++pattern;
+            ++name;
+        }
+        else if (*pattern == '*')
+        {
+            star = ++pattern;
+            mark = name;
+        }
+        else if (star)
+        {
+            pattern = star;
+            name    = ++mark;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    while (*pattern == '*')
+    {
+        ++pattern;
+    }
+    return *pattern == '\0';
+}
+
+bool sendPost(Connection &conn, const char *itemname, const char *value, int size, const timespec &timestamp,
+              int options, unsigned long long seq, bool snapshot, const timespec &dispatchtime, int offset)
+{
+    int effective = options & (SUBOPT_STAMP | SUBOPT_RANGE);
+    if ((options & (SUBOPT_SEQ | SUBOPT_SNAPSHOT)) != 0)
+    {
+        effective |= SUBOPT_SEQ;
+    }
+
+    MSGHEAD head   = wire::makeHead(POST, "", itemname);
+    head.datasize  = size;
+    head.timestamp = timestamp;
+    head.eventarg  = effective;
+    if ((effective & SUBOPT_RANGE) != 0)
+    {
+        head.offset  = offset;
+        head.subsize = size;
+    }
+
+    POSTSEQ   pseq;
+    POSTSTAMP stamp;
+    iovec     parts[3];
+    int       n = 0;
+    parts[n++]  = iovec{const_cast<char *>(value), static_cast<std::size_t>(size)};
+    if ((effective & SUBOPT_SEQ) != 0)
+    {
+        pseq.seq      = seq;
+        pseq.flags    = snapshot ? POSTFLAG_SNAPSHOT : 0;
+        pseq.reserved = 0;
+        parts[n++]    = iovec{&pseq, sizeof(pseq)};
+    }
+    if ((effective & SUBOPT_STAMP) != 0)
+    {
+        stamp.writetime    = timestamp;
+        stamp.dispatchtime = dispatchtime;
+        parts[n++]         = iovec{&stamp, sizeof(stamp)};
+    }
+    return conn.write(head, parts, n, false);
+}
+
+// ============================================================
+//  DelayEngine
+// ============================================================
+DelayEngine::DelayEngine()
+    : epoch_ns_(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now().time_since_epoch())
+                                          .count()))
+{
+}
+
+DelayEngine::~DelayEngine()
+{
+    stop();
+}
+
+uint64_t DelayEngine::nowTick() const
+{
+    uint64_t ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+    return (ns - epoch_ns_) / 1000000;
+}
+
+void DelayEngine::start()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_)
+    {
+        return;
+    }
+    running_ = true;
+    thread_  = std::thread(&DelayEngine::run, this);
+}
+
+void DelayEngine::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+        {
+            return;
+        }
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+void DelayEngine::schedule(const std::string &key, const ConnectionPtr &conn, const std::string &eventname,
+                           const char *value, int size, const timespec &timestamp, int delay_ms)
+{
+    Fire fire;
+    fire.conn      = conn;
+    fire.key       = key;
+    fire.eventname = eventname;
+    fire.value.assign(value, value + size);
+    fire.timestamp = timestamp;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t expire = nowTick() + static_cast<uint64_t>(delay_ms > 0 ? delay_ms : 0);
+        Wheel::TimerId id = wheel_.schedule(expire, std::move(fire));
+        wheel_.get(id)->id = id;
+        ids_[key].push_back(id);
+    }
+    cv_.notify_one();
+}
+
+void DelayEngine::scheduleCall(const std::string &key, int delay_ms, std::function<void()> fn)
+{
+    Fire fire;
+    fire.key  = key;
+    fire.call = std::move(fn);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t expire = nowTick() + static_cast<uint64_t>(delay_ms > 0 ? delay_ms : 0);
+        Wheel::TimerId id = wheel_.schedule(expire, std::move(fire));
+        wheel_.get(id)->id = id;
+        ids_[key].push_back(id);
+    }
+    cv_.notify_one();
+}
+
+std::size_t DelayEngine::cancel(const std::string &key)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = ids_.find(key);
+    if (it == ids_.end())
+    {
+        return 0;
+    }
+    std::size_t n = 0;
+    for (auto id : it->second)
+    {
+        n += wheel_.cancel(id) ? 1 : 0;
+    }
+    ids_.erase(it);
+    return n;
+}
+
+void DelayEngine::cancelConnection(uint64_t conn_id)
+{
+    std::string prefix = std::to_string(conn_id);
+    prefix.push_back('\0');
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = ids_.begin(); it != ids_.end();)
+    {
+        if (it->first.compare(0, prefix.size(), prefix) == 0)
+        {
+            for (auto id : it->second)
+            {
+                wheel_.cancel(id);
+            }
+            it = ids_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+std::size_t DelayEngine::pending() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return wheel_.size();
+}
+
+// 重新订阅可能改变同一 key 的延时，后挂起的定时器可以先到期，按 id 删去到期的那个
+void DelayEngine::forget(const std::string &key, Wheel::TimerId id)
+{
+    auto it = ids_.find(key);
+    if (it == ids_.end())
+    {
+        return;
+    }
+    auto &ids = it->second;
+    for (std::size_t i = 0; i < ids.size(); ++i)
+    {
+        if (ids[i] == id)
+        {
+            ids[i] = ids.back();
+            ids.pop_back();
+            break;
+        }
+    }
+    if (ids.empty())
+    {
+        ids_.erase(it);
+    }
+}
+
+void DelayEngine::run()
+{
+    std::vector<Fire> fired;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_)
+    {
+        fired.clear();
+        wheel_.advance(nowTick(), fired);
+        for (const auto &f : fired)
+        {
+            forget(f.key, f.id);
+        }
+
+        if (!fired.empty())
+        {
+            lock.unlock();
+            timespec now;
+            ::clock_gettime(CLOCK_REALTIME, &now);
+            for (const auto &f : fired)
+            {
+                if (f.call)
+                {
+                    f.call();
+                }
+                else if (auto conn = f.conn.lock())
+                {
+                    sendPost(*conn, f.eventname.c_str(), f.value.data(), static_cast<int>(f.value.size()),
+                             f.timestamp, 0, 0, false, now);
+                }
+            }
+            lock.lock();
+            continue;
+        }
+
+        uint64_t ticks = wheel_.ticksToNext();
+        if (ticks > 1000)
+        {
+            ticks = 1000;
+        }
+        cv_.wait_for(lock, std::chrono::milliseconds(ticks));
+    }
+}
+
+// ============================================================
+//  SubscriptionTable
+// ============================================================
+SubscriptionTable::SubscriptionTable(std::string board, DelayEngine &delays)
+    : board_(std::move(board)), delays_(delays)
+{
+}
+
+std::string SubscriptionTable::delayKey(uint64_t conn_id, const char *tag, const char *eventname)
+{
+    std::string key = std::to_string(conn_id);
+    key.push_back('\0');
+    key += tag;
+    key.push_back('\0');
+    key += eventname;
+    return key;
+}
+
+void SubscriptionTable::addExactLocked(const ConnectionPtr &conn, const char *tag, int options)
+{
+    auto &subs = exact_[tag];
+    for (auto &s : subs)
+    {
+        if (s.conn == conn)
+        {
+            s.options = options;
+            return;
+        }
+    }
+    subs.push_back(Sub{conn, options});
+}
+
+bool SubscriptionTable::subscribe(const ConnectionPtr &conn, const char *tag, int options,
+                                  unsigned long long lastseq, unsigned int *error)
+{
+    if ((options & SUBOPT_SNAPSHOT) != 0)
+    {
+        // 在标签锁内登记并补发：此后的写入一定排在快照之后
+        bool found = qbd::visitItem(board_.c_str(), tag, [&](const qbd::ItemEvent &ev) {
+            {
+                std::unique_lock<std::shared_mutex> lock(mutex_);
+                addExactLocked(conn, tag, options);
+            }
+            if (lastseq == 0 || ev.seq != lastseq)
+            {
+                timespec now;
+                ::clock_gettime(CLOCK_REALTIME, &now);
+                sendPost(*conn, tag, ev.data, ev.size, ev.timestamp, options, ev.seq, true, now);
+            }
+        }, nullptr);
+        if (found)
+        {
+            *error = 0;
+            return true;
+        }
+    }
+    // 标签还不存在时也登记，创建并写入后即开始推送
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    addExactLocked(conn, tag, options);
+    *error = 0;
+    return true;
+}
+
+void SubscriptionTable::subscribePattern(const ConnectionPtr &conn, const char *pattern, int options,
+                                         const std::unordered_map<std::string, unsigned long long> &lastseqs,
+                                         std::unordered_set<std::string> &handled)
+{
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        bool updated = false;
+        for (auto &p : patterns_)
+        {
+            if (p.conn == conn && p.pattern == pattern)
+            {
+                p.options = options;
+                updated   = true;
+                break;
+            }
+        }
+        if (!updated)
+        {
+            patterns_.push_back(PatternSub{conn, pattern, options});
+        }
+    }
+    if ((options & SUBOPT_SNAPSHOT) == 0)
+    {
+        return;
+    }
+
+    // 先登记再补发：登记与补发之间的写入可能先于快照到达，客户端按序号丢弃重复的快照
+    std::vector<std::string> names;
+    qbd::listItems(board_.c_str(), names);
+    for (const auto &name : names)
+    {
+        if (!globMatch(pattern, name.c_str()) || !handled.insert(name).second)
+        {
+            continue;
+        }
+        auto known = lastseqs.find(name);
+        unsigned long long lastseq = known == lastseqs.end() ? 0 : known->second;
+        qbd::visitItem(board_.c_str(), name.c_str(), [&](const qbd::ItemEvent &ev) {
+            if (lastseq == 0 || ev.seq != lastseq)
+            {
+                timespec now;
+                ::clock_gettime(CLOCK_REALTIME, &now);
+                sendPost(*conn, ev.itemname, ev.data, ev.size, ev.timestamp, options, ev.seq, true, now);
+            }
+        }, nullptr);
+    }
+}
+
+bool SubscriptionTable::unsubscribe(const Connection &conn, const char *tag)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (isPattern(tag))
+    {
+        auto it = std::find_if(patterns_.begin(), patterns_.end(), [&](const PatternSub &p) {
+            return p.conn.get() == &conn && p.pattern == tag;
+        });
+        if (it == patterns_.end())
+        {
+            return false;
+        }
+        patterns_.erase(it);
+        return true;
+    }
+
+    auto it = exact_.find(tag);
+    if (it == exact_.end())
+    {
+        return false;
+    }
+    auto &subs = it->second;
+    auto pos   = std::find_if(subs.begin(), subs.end(), [&](const Sub &s) { return s.conn.get() == &conn; });
+    if (pos == subs.end())
+    {
+        return false;
+    }
+    subs.erase(pos);
+    if (subs.empty())
+    {
+        exact_.erase(it);
+    }
+    return true;
+}
+
+void SubscriptionTable::subscribeDelay(const ConnectionPtr &conn, const char *tag, const char *eventname,
+                                       int delay_ms)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto &subs = delay_subs_[tag];
+    for (auto &s : subs)
+    {
+        if (s.conn == conn && s.eventname == eventname)
+        {
+            s.delay_ms = delay_ms;
+            return;
+        }
+    }
+    subs.push_back(DelaySub{conn, eventname, delay_ms});
+}
+
+void SubscriptionTable::cancelDelay(const Connection &conn, const char *tag, const char *eventname)
+{
+    delays_.cancel(delayKey(conn.id(), tag, eventname));
+}
+
+void SubscriptionTable::removeConnection(const Connection &conn)
+{
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        for (auto it = exact_.begin(); it != exact_.end();)
+        {
+            auto &subs = it->second;
+            subs.erase(std::remove_if(subs.begin(), subs.end(),
+                                      [&](const Sub &s) { return s.conn.get() == &conn; }),
+                       subs.end());
+            it = subs.empty() ? exact_.erase(it) : std::next(it);
+        }
+        patterns_.erase(std::remove_if(patterns_.begin(), patterns_.end(),
+                                       [&](const PatternSub &p) { return p.conn.get() == &conn; }),
+                        patterns_.end());
+        for (auto it = delay_subs_.begin(); it != delay_subs_.end();)
+        {
+            auto &subs = it->second;
+            subs.erase(std::remove_if(subs.begin(), subs.end(),
+                                      [&](const DelaySub &s) { return s.conn.get() == &conn; }),
+                       subs.end());
+            it = subs.empty() ? delay_subs_.erase(it) : std::next(it);
+        }
+    }
+    delays_.cancelConnection(conn.id());
+}
+
+void SubscriptionTable::onWrite(const qbd::ItemEvent &ev)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (exact_.empty() && patterns_.empty() && delay_subs_.empty())
+    {
+        return;
+    }
+
+    // 收集目标连接，同一连接只推送一次，选项取并集
+    struct Target
+    {
+        Connection *conn;
+        int         options;
+    };
+    Target targets[64];
+    std::vector<Target> more;
+    int count = 0;
+    auto add = [&](Connection *conn, int options) {
+        for (int i = 0; i < count; ++i)
+        {
+            if (targets[i].conn == conn)
+            {
+                targets[i].options |= options;
+                return;
+            }
+        }
+        for (auto &t : more)
+        {
+            if (t.conn == conn)
+            {
+                t.options |= options;
+                return;
+            }
+        }
+        if (count < 64)
+        {
+            targets[count++] = Target{conn, options};
+        }
+        else
+        {
+            more.push_back(Target{conn, options});
+        }
+    };
+
+    std::string tag(ev.itemname);
+    auto it = exact_.find(tag);
+    if (it != exact_.end())
+    {
+        for (const auto &s : it->second)
+        {
+            add(s.conn.get(), s.options);
+        }
+    }
+    for (const auto &p : patterns_)
+    {
+        if (globMatch(p.pattern.c_str(), ev.itemname))
+        {
+            add(p.conn.get(), p.options);
+        }
+    }
+
+    if (count > 0)
+    {
+        timespec now;
+        ::clock_gettime(CLOCK_REALTIME, &now);
+        // SUBOPT_RANGE 的订阅者只收改变的字节
+        auto post = [&](Connection &conn, int options) {
+            if ((options & SUBOPT_RANGE) != 0)
+            {
+                sendPost(conn, ev.itemname, ev.data + ev.dirtyoffset, ev.dirtysize, ev.timestamp, options, ev.seq,
+                         false, now, ev.dirtyoffset);
+            }
+            else
+            {
+                sendPost(conn, ev.itemname, ev.data, ev.size, ev.timestamp, options, ev.seq, false, now);
+            }
+        };
+        for (int i = 0; i < count; ++i)
+        {
+            post(*targets[i].conn, targets[i].options);
+        }
+        for (const auto &t : more)
+        {
+            post(*t.conn, t.options);
+        }
+        posts_.fetch_add(static_cast<std::uint64_t>(count) + more.size(), std::memory_order_relaxed);
+    }
+
+    auto dit = delay_subs_.find(tag);
+    if (dit != delay_subs_.end())
+    {
+        for (const auto &d : dit->second)
+        {
+            delays_.schedule(delayKey(d.conn->id(), ev.itemname, d.eventname.c_str()), d.conn, d.eventname,
+                             ev.data, ev.size, ev.timestamp, d.delay_ms);
+        }
+    }
+}
+
+SubscriptionStats SubscriptionTable::stats() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    SubscriptionStats s;
+    for (const auto &kv : exact_)
+    {
+        s.exact += kv.second.size();
+    }
+    s.patterns = patterns_.size();
+    for (const auto &kv : delay_subs_)
+    {
+        s.delays += kv.second.size();
+    }
+    s.posts = posts_.load(std::memory_order_relaxed);
+    return s;
+}
+
+} // namespace server
+} // namespace gplat
@@ -0,0 +1,1305 @@
+// 数据库表：DB_HEAD + 记录区 + 类型区，表按名称双重散列定位；二级索引和快照的页原像在进程内存中
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "gplat_typecache.h"
+#include "qbdhash.h"
+#include "qbdmap.h"
+#include "tablescan.h"
+#include "tableversion.h"
+
+namespace qbd {
+
+namespace {
+
+constexpr int kAlign      = 8;
+constexpr int kMaxIndexes = 8; // 每张表最多的二级索引数
+
+inline int alignUp(int n)
+{
+    return (n + kAlign - 1) & ~(kAlign - 1);
+}
+
+long dbFileSize(int datasize, int typesize)
+{
+    return static_cast<long>(sizeof(DB_HEAD)) + datasize + typesize;
+}
+
+template <typename T>
+inline T load(const char *p)
+{
+    T v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// ============================================================
+//  索引键
+// ============================================================
+// 字段值编码为可按字节比较的键：整数、浮点转为 8 字节大端（有符号数翻转符号位，负浮点数按位取反），
+// 字符串取到第一个 '\0'。哈希索引、有序索引和扫描都只比较编码后的字节串，不必按类型分别实现
+void encodeKey(KeyType type, int size, const char *value, std::string &key)
+{
+    std::uint64_t u = 0;
+    switch (type)
+    {
+    case KeyType::Int:
+    {
+        std::int64_t v = 0;
+        switch (size)
+        {
+        case 1: v = load<std::int8_t>(value); break;
+        case 2: v = load<std::int16_t>(value); break;
+        case 4: v = load<std::int32_t>(value); break;
+        default: v = load<std::int64_t>(value); break;
+        }
+        u = static_cast<std::uint64_t>(v) ^ (1ull << 63);
+        break;
+    }
+    case KeyType::UInt:
+        switch (size)
+        {
+        case 1: u = load<std::uint8_t>(value); break;
+        case 2: u = load<std::uint16_t>(value); break;
+        case 4: u = load<std::uint32_t>(value); break;
+        default: u = load<std::uint64_t>(value); break;
+        }
+        break;
+    case KeyType::Float:
+    {
+        double d = size == 4 ? load<float>(value) : load<double>(value);
+        if (d == 0)
+        {
+            d = 0; // -0.0 与 0.0 相等
+        }
+        std::uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        u = (bits >> 63) != 0 ? ~bits : bits | (1ull << 63);
+        break;
+    }
+    case KeyType::Char:
+        key.assign(value, ::strnlen(value, size));
+        return;
+    case KeyType::Bytes:
+        key.assign(value, size);
+        return;
+    }
+    char be[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        be[i] = static_cast<char>(u >> (56 - 8 * i));
+    }
+    key.assign(be, sizeof(be));
+}
+
+bool validField(const FieldSpec &f, int recordsize)
+{
+    if (f.offset < 0 || f.size <= 0 || f.offset + f.size > recordsize)
+    {
+        return false;
+    }
+    switch (f.type)
+    {
+    case KeyType::Int:
+    case KeyType::UInt:
+        return f.size == 1 || f.size == 2 || f.size == 4 || f.size == 8;
+    case KeyType::Float:
+        return f.size == 4 || f.size == 8;
+    case KeyType::Char:
+    case KeyType::Bytes:
+        return true;
+    }
+    return false;
+}
+
+// 查询给出的键转为编码：数值键须与字段等长，Char 键可以更短
+bool encodeQueryKey(const FieldSpec &f, const void *key, int keysize, std::string &out)
+{
+    if (key == nullptr || keysize <= 0 || keysize > f.size || (f.type != KeyType::Char && keysize != f.size))
+    {
+        return false;
+    }
+    encodeKey(f.type, keysize, static_cast<const char *>(key), out);
+    return true;
+}
+
+class SecondaryIndex
+{
+public:
+    explicit SecondaryIndex(IndexSpec spec) : spec_(std::move(spec)) {}
+
+    const IndexSpec &spec() const { return spec_; }
+
+    void insert(const char *record, int row)
+    {
+        keyOf(record);
+        if (spec_.kind == IndexKind::Hash)
+        {
+            hash_.emplace(scratch_, row);
+        }
+        else
+        {
+            ordered_.emplace(scratch_, row);
+        }
+    }
+
+    void erase(const char *record, int row)
+    {
+        keyOf(record);
+        if (spec_.kind == IndexKind::Hash)
+        {
+            auto range = hash_.equal_range(scratch_);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (it->second == row)
+                {
+                    hash_.erase(it);
+                    break;
+                }
+            }
+        }
+        else
+        {
+            ordered_.erase(std::make_pair(scratch_, row));
+        }
+    }
+
+    // 更新一行时键字段未变就不必动索引
+    bool sameKey(const char *a, const char *b) const
+    {
+        return std::memcmp(a + spec_.field.offset, b + spec_.field.offset, spec_.field.size) == 0;
+    }
+
+    void clear()
+    {
+        hash_.clear();
+        ordered_.clear();
+    }
+
+    // 依次回调匹配的行号，fn 返回 false 时停止
+    template <typename Fn>
+    void lookup(const std::string &lo, const std::string *hi, Fn &&fn) const
+    {
+        if (spec_.kind == IndexKind::Hash)
+        {
+            auto range = hash_.equal_range(lo);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (!fn(it->second))
+                {
+                    return;
+                }
+            }
+            return;
+        }
+        const std::string &end = hi ? *hi : lo;
+        for (auto it = ordered_.lower_bound(std::make_pair(lo, INT_MIN)); it != ordered_.end() && it->first <= end;
+             ++it)
+        {
+            if (!fn(it->second))
+            {
+                return;
+            }
+        }
+    }
+
+private:
+    void keyOf(const char *record)
+    {
+        encodeKey(spec_.field.type, spec_.field.size, record + spec_.field.offset, scratch_);
+    }
+
+    IndexSpec                                spec_;
+    std::unordered_multimap<std::string, int> hash_;
+    std::set<std::pair<std::string, int>>    ordered_;
+    std::string                              scratch_; // 只在表锁内使用
+};
+
+using TableIndexes = std::vector<std::unique_ptr<SecondaryIndex>>;
+
+// 一个数据库在进程内的附加状态（二级索引、快照的页版本），按表所在的索引槽存放，只在该表的表锁内访问
+struct DbIndexes
+{
+    std::vector<TableIndexes>                                tables{static_cast<std::size_t>(INDEXSIZE)};
+    std::vector<std::shared_ptr<detail::VersionStore>> versions{static_cast<std::size_t>(INDEXSIZE)};
+};
+
+std::mutex                                                  g_indexes_mutex;
+std::unordered_map<std::string, std::shared_ptr<DbIndexes>> g_indexes;
+
+// 新建或重新打开数据库时索引从空开始（登记成功之后，已打开的同名数据库不受影响）
+void resetIndexes(const char *db)
+{
+    std::lock_guard<std::mutex> lock(g_indexes_mutex);
+    g_indexes[db] = std::make_shared<DbIndexes>();
+}
+
+std::shared_ptr<DbIndexes> indexesOf(const char *db)
+{
+    std::lock_guard<std::mutex> lock(g_indexes_mutex);
+    auto it = g_indexes.find(db);
+    return it != g_indexes.end() ? it->second : nullptr;
+}
+
+// ============================================================
+//  数据库
+// ============================================================
+struct Database
+{
+    DB_HEAD                   *head = nullptr;
+    char                      *base = nullptr;
+    std::shared_ptr<DbIndexes> indexes;
+};
+
+bool getDatabase(const char *db, Database &d, unsigned int *error)
+{
+    TABLE_MSG tab;
+    if (!detail::lookup(db, DATABASE_T, tab, error))
+    {
+        return false;
+    }
+    d.head    = static_cast<DB_HEAD *>(tab.lpMapAddress);
+    d.base    = static_cast<char *>(tab.lpMapAddress);
+    d.indexes = indexesOf(db);
+    if (!d.indexes)
+    {
+        detail::setError(error, ERROR_DQ_NOT_OPEN);
+        return false;
+    }
+    return true;
+}
+
+// 文件中的互斥量状态属于上一个进程，映射后重新构造
+void initMutexes(DB_HEAD *head)
+{
+    new (&head->mutex_rw) std::mutex;
+    for (auto &m : head->mutex_rw_tag)
+    {
+        new (&m) std::mutex;
+    }
+}
+
+// 查找表所在的索引槽，找不到返回 -1；free_slot 返回探测路径上第一个可用槽
+int findTable(const DB_HEAD *head, const char *table, int *free_slot)
+{
+    int pos  = hash1(table) % INDEXSIZE;
+    int step = 1 + hash2(table) % (INDEXSIZE - 1);
+    if (free_slot)
+    {
+        *free_slot = -1;
+    }
+    for (int i = 0; i < INDEXSIZE; ++i)
+    {
+        const DB_INDEX_STRUCT &idx = head->index[pos];
+        if (idx.tablename[0] == '\0')
+        {
+            if (free_slot && *free_slot < 0)
+            {
+                *free_slot = pos;
+            }
+            return -1;
+        }
+        if (idx.erased)
+        {
+            if (free_slot && *free_slot < 0)
+            {
+                *free_slot = pos;
+            }
+        }
+        else if (std::strncmp(idx.tablename, table, MAXDQNAMELENTH) == 0)
+        {
+            return pos;
+        }
+        pos = (pos + step) % INDEXSIZE;
+    }
+    return -1;
+}
+
+inline std::mutex &tableMutex(DB_HEAD *head, int slot)
+{
+    return head->mutex_rw_tag[slot % MUTEXSIZE];
+}
+
+inline bool stillValid(const DB_HEAD *head, int slot, const char *table)
+{
+    const DB_INDEX_STRUCT &idx = head->index[slot];
+    return !idx.erased && std::strncmp(idx.tablename, table, MAXDQNAMELENTH) == 0;
+}
+
+// 查找表并加表锁：无锁查找后在表锁内复核（索引槽可能刚被删除）
+class TableLock
+{
+public:
+    TableLock(const Database &d, const char *table, unsigned int *error)
+    {
+        slot_ = findTable(d.head, table, nullptr);
+        if (slot_ < 0)
+        {
+            detail::setError(error, ERROR_TABLE_NOT_EXIST);
+            return;
+        }
+        lock_ = std::unique_lock<std::mutex>(tableMutex(d.head, slot_));
+        if (!stillValid(d.head, slot_, table))
+        {
+            lock_.unlock();
+            slot_ = -1;
+            detail::setError(error, ERROR_TABLE_NOT_EXIST);
+        }
+    }
+
+    bool ok() const { return slot_ >= 0; }
+    int  slot() const { return slot_; }
+    void unlock() { lock_.unlock(); }
+
+private:
+    int                          slot_ = -1;
+    std::unique_lock<std::mutex> lock_;
+};
+
+inline char *recordAt(const Database &d, const DB_INDEX_STRUCT &idx, int row)
+{
+    return d.base + idx.startpos + static_cast<long>(row) * idx.recordsize;
+}
+
+SecondaryIndex *findIndex(TableIndexes &list, const std::string &name)
+{
+    for (auto &ix : list)
+    {
+        if (ix->spec().name == name)
+        {
+            return ix.get();
+        }
+    }
+    return nullptr;
+}
+
+// 字段名按表的类型描述解析为偏移 / 长度 / 键类型
+bool resolveField(const char *type, int typesize, int recordsize, FieldSpec &f, unsigned int *error)
+{
+    if (!f.name.empty())
+    {
+        gplat::TypeLayout layout;
+        if (typesize <= 0 || !gplat::compileFieldList(type, typesize, recordsize, layout, nullptr))
+        {
+            detail::setError(error, ERROR_INVALID_PARAMETER);
+            return false;
+        }
+        int i = layout.indexOf(f.name);
+        if (i < 0)
+        {
+            detail::setError(error, ERROR_ITEM_NOT_EXIST);
+            return false;
+        }
+        const gplat::FieldDesc &fd = layout.fields()[i];
+        f.offset = fd.offset;
+        f.size   = fd.count * fd.elemsize;
+        switch (fd.kind)
+        {
+        case gplat::FieldKind::Int8:
+        case gplat::FieldKind::Int16:
+        case gplat::FieldKind::Int32:
+        case gplat::FieldKind::Int64:
+            f.type = KeyType::Int;
+            break;
+        case gplat::FieldKind::Bool:
+        case gplat::FieldKind::UInt8:
+        case gplat::FieldKind::UInt16:
+        case gplat::FieldKind::UInt32:
+        case gplat::FieldKind::UInt64:
+            f.type = KeyType::UInt;
+            break;
+        case gplat::FieldKind::Float:
+        case gplat::FieldKind::Double:
+            f.type = KeyType::Float;
+            break;
+        case gplat::FieldKind::Char:
+            f.type = KeyType::Char;
+            break;
+        }
+        // 数值数组不能作为键
+        if (fd.count > 1 && f.type != KeyType::Char)
+        {
+            detail::setError(error, ERROR_INVALID_PARAMETER);
+            return false;
+        }
+    }
+    if (!validField(f, recordsize))
+    {
+        detail::setError(error, ERROR_INVALID_PARAMETER);
+        return false;
+    }
+    return true;
+}
+
+// 按表的类型描述解析（须在表锁内调用）
+bool resolveField(const Database &d, const DB_INDEX_STRUCT &idx, FieldSpec &f, unsigned int *error)
+{
+    return resolveField(d.base + idx.typeaddr, idx.typesize, idx.recordsize, f, error);
+}
+
+void fillInfo(const Database &d, int slot, TableInfo *info)
+{
+    if (info == nullptr)
+    {
+        return;
+    }
+    const DB_INDEX_STRUCT &idx = d.head->index[slot];
+    info->recordsize = idx.recordsize;
+    info->maxcount   = idx.maxcount;
+    info->currcount  = idx.currcount;
+    info->indexes    = static_cast<int>(d.indexes->tables[slot].size());
+    info->timestamp  = idx.timestamp;
+}
+
+// 表的页版本，首次打开快照时建立（须在表锁内调用）
+const std::shared_ptr<detail::VersionStore> &versionsOf(const Database &d, int slot)
+{
+    std::shared_ptr<detail::VersionStore> &vs = d.indexes->versions[slot];
+    if (!vs)
+    {
+        const DB_INDEX_STRUCT &idx = d.head->index[slot];
+        vs = std::make_shared<detail::VersionStore>(d.base + idx.startpos, idx.recordsize, idx.maxcount);
+    }
+    return vs;
+}
+
+// 改写 [row, row + count) 之前为存活快照保存原像（须在表锁内调用）
+void beforeWrite(const Database &d, int slot, int row, int count)
+{
+    if (const auto &vs = d.indexes->versions[slot])
+    {
+        vs->beforeWrite(row, count);
+    }
+}
+
+// 表被删除：已打开的快照随之失效
+void dropVersions(const Database &d, int slot)
+{
+    if (auto &vs = d.indexes->versions[slot])
+    {
+        vs->drop();
+        vs.reset();
+    }
+}
+
+// 在表锁内打开快照
+Snapshot snapshotOf(const Database &d, int slot)
+{
+    const DB_INDEX_STRUCT &idx = d.head->index[slot];
+    TableInfo              info;
+    fillInfo(d, slot, &info);
+    return std::make_shared<TableSnapshot>(versionsOf(d, slot), info, d.base + idx.typeaddr, idx.typesize);
+}
+
+} // namespace
+
+bool createDatabase(const char *db, int datasize, int typesize, unsigned int *error)
+{
+    if (datasize <= 0 || typesize < 0)
+    {
+        detail::setError(error, ERROR_PARAMETER_SIZE);
+        return false;
+    }
+    datasize = alignUp(datasize);
+    typesize = alignUp(typesize);
+
+    int  fd       = -1;
+    long filesize = 0;
+    void *addr    = detail::mapObject(db, dbFileSize(datasize, typesize), true, &fd, &filesize, error);
+    if (addr == nullptr)
+    {
+        return false;
+    }
+
+    auto *head        = static_cast<DB_HEAD *>(addr);
+    head->qbdtype     = DATABASE_T;
+    head->counter     = 0;
+    head->totalsize   = static_cast<int>(sizeof(DB_HEAD)) + datasize;
+    head->typesize    = typesize;
+    head->nextpos     = static_cast<int>(sizeof(DB_HEAD));
+    head->nexttypepos = head->totalsize;
+    head->remain      = datasize;
+    head->typeremain  = typesize;
+    head->indexcount  = 0;
+    initMutexes(head);
+    if (!detail::registerObject(db, addr, fd, filesize, error))
+    {
+        return false;
+    }
+    resetIndexes(db);
+    return true;
+}
+
+bool loadDatabase(const char *db, unsigned int *error)
+{
+    int  fd       = -1;
+    long filesize = 0;
+    void *addr    = detail::mapObject(db, 0, false, &fd, &filesize, error);
+    if (addr == nullptr)
+    {
+        return false;
+    }
+    auto *head = static_cast<DB_HEAD *>(addr);
+    if (head->qbdtype != DATABASE_T ||
+        filesize < dbFileSize(head->totalsize - static_cast<int>(sizeof(DB_HEAD)), head->typesize))
+    {
+        ::munmap(addr, filesize);
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        detail::setError(error, ERROR_FILE_OPEN_FAILSURE);
+        return false;
+    }
+    initMutexes(head);
+    if (!detail::registerObject(db, addr, fd, filesize, error))
+    {
+        return false;
+    }
+    resetIndexes(db);
+    return true;
+}
+
+bool openDatabase(const char *db, int datasize, int typesize, unsigned int *error)
+{
+    TABLE_MSG tab;
+    if (fetchtab(db, tab))
+    {
+        return true;
+    }
+    unsigned int err = 0;
+    if (loadDatabase(db, &err))
+    {
+        return true;
+    }
+    if (err != ERROR_DQFILE_NOT_FOUND)
+    {
+        detail::setError(error, err);
+        return false;
+    }
+    return createDatabase(db, datasize, typesize, error);
+}
+
+bool clearDatabase(const char *db, unsigned int *error)
+{
+    Database d;
+    if (!getDatabase(db, d, error))
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(d.head->mutex_rw);
+    for (auto &m : d.head->mutex_rw_tag)
+    {
+        m.lock();
+    }
+    std::memset(d.head->index, 0, sizeof(d.head->index));
+    d.head->counter     = 0;
+    d.head->indexcount  = 0;
+    d.head->nextpos     = static_cast<int>(sizeof(DB_HEAD));
+    d.head->nexttypepos = d.head->totalsize;
+    d.head->remain      = d.head->totalsize - static_cast<int>(sizeof(DB_HEAD));
+    d.head->typeremain  = d.head->typesize;
+    for (auto &list : d.indexes->tables)
+    {
+        list.clear();
+    }
+    for (int slot = 0; slot < INDEXSIZE; ++slot)
+    {
+        dropVersions(d, slot);
+    }
+    for (auto &m : d.head->mutex_rw_tag)
+    {
+        m.unlock();
+    }
+    detail::setError(error, 0);
+    return true;
+}
+
+bool createTable(const char *db, const char *table, int recordsize, int maxcount, const void *type, int typesize,
+                 unsigned int *error)
+{
+    if (table == nullptr || table[0] == '\0' || std::strlen(table) >= MAXDQNAMELENTH)
+    {
+        detail::setError(error, ERROR_INVALID_PARAMETER);
+        return false;
+    }
+    if (recordsize <= 0 || maxcount <= 0 || typesize < 0 || (typesize > 0 && type == nullptr))
+    {
+        detail::setError(error, ERROR_PARAMETER_SIZE);
+        return false;
+    }
+
+    Database d;
+    if (!getDatabase(db, d, error))
+    {
+        return false;
+    }
+    DB_HEAD *head = d.head;
+    std::lock_guard<std::mutex> lock(head->mutex_rw);
+
+    int free_slot = -1;
+    if (findTable(head, table, &free_slot) >= 0)
+    {
+        detail::setError(error, ERROR_TABLE_ALREADY_EXIST);
+        return false;
+    }
+    if (free_slot < 0)
+    {
+        detail::setError(error, ERROR_TABLE_OVERFLOW);
+        return false;
+    }
+    long datalen = (static_cast<long>(recordsize) * maxcount + kAlign - 1) & ~static_cast<long>(kAlign - 1);
+    int  typelen = alignUp(typesize);
+    if (datalen > head->remain || typelen > head->typeremain)
+    {
+        detail::setError(error, ERROR_NO_SPACE);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> table_lock(tableMutex(head, free_slot));
+    DB_INDEX_STRUCT &idx = head->index[free_slot];
+    bool reuse           = idx.tablename[0] != '\0';
+
+    idx.startpos    = head->nextpos;
+    idx.recordsize  = recordsize;
+    idx.maxcount    = maxcount;
+    idx.currcount   = 0;
+    idx.mutexaccess = 0;
+    idx.typeaddr    = head->nexttypepos;
+    idx.typesize    = typesize;
+    ::clock_gettime(CLOCK_REALTIME, &idx.timestamp);
+    if (typesize > 0)
+    {
+        std::memcpy(d.base + idx.typeaddr, type, typesize);
+    }
+    std::strncpy(idx.tablename, table, MAXDQNAMELENTH - 1);
+    idx.tablename[MAXDQNAMELENTH - 1] = '\0';
+    idx.erased                        = false;
+    d.indexes->tables[free_slot].clear();
+    dropVersions(d, free_slot);
+
+    head->nextpos += static_cast<int>(datalen);
+    head->remain -= static_cast<int>(datalen);
+    head->nexttypepos += typelen;
+    head->typeremain -= typelen;
+    head->counter++;
+    if (!reuse)
+    {
+        head->indexcount++;
+    }
+    detail::setError(error, 0);
+    return true;
+}
+
+bool deleteTable(const char *db, const char *table, unsigned int *error)
+{
+    Database d;
+    if (!getDatabase(db, d, error))
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(d.head->mutex_rw);
+    int slot = findTable(d.head, table, nullptr);
+    if (slot < 0)
+    {
+        detail::setError(error, ERROR_TABLE_NOT_EXIST);
+        return false;
+    }
+    std::lock_guard<std::mutex> table_lock(tableMutex(d.head, slot));
+    d.head->index[slot].erased = true;
+    d.head->counter--;
+    d.indexes->tables[slot].clear();
+    dropVersions(d, slot);
+    detail::setError(error, 0);
+    return true;
+}
+
+bool clearTable(const char *db, const char *table, unsigned int *error)
+{
+    Database d;
+    if (!getDatabase(db, d, error))
+    {
+        return false;
+    }
+    TableLock lock(d, table, error);
+    if (!lock.ok())
+    {
+        return false;
+    }
+    DB_INDEX_STRUCT &idx = d.head->index[lock.slot()];
+    idx.currcount        = 0;
+    ::clock_gettime(CLOCK_REALTIME, &idx.timestamp);
+    for (auto &ix : d.indexes->tables[lock.slot()])
+    {
+        ix->clear();
+    }
+    detail::setError(error, 0);
+    return true;
+}
+
+bool tableInfo(const char *db, const char *table, TableInfo *info, unsigned int *error)
+{
+    Database d;
+    if (!getDatabase(db, d, error))
+    {
+        return false;
+    }
+    TableLock lock(d, table, error);
+    if (!lock.ok())
+    {
+        return false;
+    }
+    fillInfo(d, lock.slot(), info);
+    detail::setError(error, 0);
+    return true;
+}
+
+bool readTableType(const char *db, const char *table, void *buf, int bufsize, int *typesize, unsigned int *error)
+{
+    Database d;
+    if (!getDatabase(db, d, error))
+    {
+        return false;
+    }
+    TableLock lock(d, table, error);
+    if (!lock.ok())
+    {
+        return false;
+    }
+    const DB_INDEX_STRUCT &idx = d.head->index[lock.slot()];
+    *typesize = idx.typesize;
+    if (idx.typesize > bufsize)
+    {
+        detail::setError(error, ERROR_BUFFER_SIZE);
+        return false;
+    }
+    std::memcpy(buf, d.base + idx.typeaddr, idx.typesize);
+    detail::setError(error, 0);
+    return true;
+}
+
+bool insertRecords(const char *db, const char *table, const void *records, int size, int *firstrow, int *count,
+                   unsigned int *error)
+{
+    Database d;
+    if (!getDatabase(db, d, error))
+    {
+        return false;
+    }
+    TableLock lock(d, table, error);
+    if (!lock.ok())
+    {
+        return false;
+    }
+    DB_INDEX_STRUCT &idx = d.head->index[lock.slot()];
+    if (size <= 0 || size % idx.recordsize != 0 || records == nullptr)
+    {
+        detail::setError(error, ERROR_RECORDSIZE);
+        return false;
+    }
+    int n = size / idx.recordsize;
+    if (n > idx.maxcount - idx.currcount)
+    {
+        detail::setError(error, ERROR_TABLE_OVERFLOW);
+        return false;
+    }
+    int   row = idx.currcount;
+    char *dst = recordAt(d, idx, row);
+    beforeWrite(d, lock.slot(), row, n); // 清空后再插入时会覆盖快照仍能看到的行
+    std::memcpy(dst, records, size);
+    for (auto &ix : d.indexes->tables[lock.slot()])
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            ix->insert(dst + static_cast<long>(i) * idx.recordsize, row + i);
+        }
+    }
+    idx.currcount += n;
+    ::clock_gettime(CLOCK_REALTIME, &idx.timestamp);
+    if (firstrow)
+    {
+        *firstrow = row;
+    }
+    if (count)
+    {
+        *count = n;
+    }
+    detail::setError(error, 0);
+    return true;
+}
+
+bool refreshRecords(const char *db, const char *table, int row, const void *records, int size, unsigned int *error)
+{
+    Database d;
+    if (!getDatabase(db, d, error))
+    {
+        return false;
+    }
+    TableLock lock(d, table, error);
+    if (!lock.ok())
+    {
+        return false;
+    }
+    DB_INDEX_STRUCT &idx = d.head->index[lock.slot()];
+    if (size <= 0 || size % idx.recordsize != 0 || records == nullptr)
+    {
+        detail::setError(error, ERROR_RECORDSIZE);
+        return false;
+    }
+    int n = size / idx.recordsize;
+    if (row < 0 || n > idx.currcount - row)
+    {
+        detail::setError(error, ERROR_TABLE_ROWID);
+        return false;
+    }
+    beforeWrite(d, lock.slot(), row, n);
+    TableIndexes &list = d.indexes->tables[lock.slot()];
+    const char   *src  = static_cast<const char *>(records);
+    for (int i = 0; i < n; ++i, src += idx.recordsize)
+    {
+        char *dst = recordAt(d, idx, row + i);
+        for (auto &ix : list)
+        {
+            if (!ix->sameKey(dst, src))
+            {
+                ix->erase(dst, row + i);
+                ix->insert(src, row + i);
+            }
+        }
+        std::memcpy(dst, src, idx.recordsize);
+    }
+    ::clock_gettime(CLOCK_REALTIME, &idx.timestamp);
+    detail::setError(error, 0);
+    return true;
+}
+
+bool selectRecords(const char *db, const char *table, int row, int count, void *buf, int bufsize, int *actcount,
+                   TableInfo *info, unsigned int *error)
+{
+    Database d;
+    if (!getDatabase(db, d, error))
+    {
+        return false;
+    }
+    TableLock lock(d, table, error);
+    if (!lock.ok())
+    {
+        return false;
+    }
+    const DB_INDEX_STRUCT &idx = d.head->index[lock.slot()];
+    if (row < 0 || row > idx.currcount)
+    {
+        detail::setError(error, ERROR_TABLE_ROWID);
+        return false;
+    }
+    int n = idx.currcount - row;
+    n     = count < n ? count : n;
+    n     = bufsize / idx.recordsize < n ? bufsize / idx.recordsize : n;
+    n     = n > 0 ? n : 0;
+    if (n > 0)
+    {
+        std::memcpy(buf, recordAt(d, idx, row), static_cast<std::size_t>(n) * idx.recordsize);
+    }
+    *actcount = n;
+    fillInfo(d, lock.slot(), info);
+    detail::setError(error, 0);
+    return true;
+}
+
+// ============================================================
+//  二级索引
+// ============================================================
+bool createIndex(const char *db, const char *table, const IndexSpec &spec, int *indexed, unsigned int *error)
+{
+    if (spec.name.empty() || spec.name.size() >= MAXDQNAMELENTH)
+    {
+        detail::setError(error, ERROR_INVALID_PARAMETER);
+        return false;
+    }
+    Database d;
+    if (!getDatabase(db, d, error))
+    {
+        return false;
+    }
+    TableLock lock(d, table, error);
+    if (!lock.ok())
+    {
+        return false;
+    }
+    const DB_INDEX_STRUCT &idx  = d.head->index[lock.slot()];
+    TableIndexes          &list = d.indexes->tables[lock.slot()];
+    if (findIndex(list, spec.name) != nullptr)
+    {
+        detail::setError(error, ERROR_ITEM_ALREADY_EXIST);
+        return false;
+    }
+    if (static_cast<int>(list.size()) >= kMaxIndexes)
+    {
+        detail::setError(error, ERROR_TABLE_OVERFLOW);
+        return false;
+    }
+    IndexSpec resolved = spec;
+    if (!resolveField(d, idx, resolved.field, error))
+    {
+        return false;
+    }
+
+    // 建索引期间持表锁，该表的读写等待；百万条记录约需数百毫秒
+    auto ix = std::make_unique<SecondaryIndex>(std::move(resolved));
+    for (int row = 0; row < idx.currcount; ++row)
+    {
+        ix->insert(recordAt(d, idx, row), row);
+    }
+    list.push_back(std::move(ix));
+    if (indexed)
+    {
+        *indexed = idx.currcount;
+    }
+    detail::setError(error, 0);
+    return true;
+}
+
+bool dropIndex(const char *db, const char *table, const char *index, unsigned int *error)
+{
+    Database d;
+    if (!getDatabase(db, d, error))
+    {
+        return false;
+    }
+    TableLock lock(d, table, error);
+    if (!lock.ok())
+    {
+        return false;
+    }
+    TableIndexes &list = d.indexes->tables[lock.slot()];
+    for (auto it = list.begin(); it != list.end(); ++it)
+    {
+        if ((*it)->spec().name == index)
+        {
+            list.erase(it);
+            detail::setError(error, 0);
+            return true;
+        }
+    }
+    detail::setError(error, ERROR_ITEM_NOT_EXIST);
+    return false;
+}
+
+bool selectByKey(const char *db, const char *table, const KeyQuery &query, int *rows, void *records, int bufsize,
+                 int *actcount, bool *more, TableInfo *info, unsigned int *error)
+{
+    *actcount = 0;
+    *more     = false;
+    Database d;
+    if (!getDatabase(db, d, error))
+    {
+        return false;
+    }
+    TableLock lock(d, table, error);
+    if (!lock.ok())
+    {
+        return false;
+    }
+    const DB_INDEX_STRUCT &idx = d.head->index[lock.slot()];
+
+    const SecondaryIndex *ix = nullptr;
+    FieldSpec             field;
+    if (!query.index.empty())
+    {
+        ix = findIndex(d.indexes->tables[lock.slot()], query.index);
+        if (ix == nullptr)
+        {
+            detail::setError(error, ERROR_ITEM_NOT_EXIST);
+            return false;
+        }
+        if (query.hi != nullptr && ix->spec().kind == IndexKind::Hash)
+        {
+            detail::setError(error, ERROR_OPERATE_PROHIBIT);
+            return false;
+        }
+        field = ix->spec().field;
+    }
+    else
+    {
+        field = query.field;
+        if (!resolveField(d, idx, field, error))
+        {
+            return false;
+        }
+    }
+    std::string lo, hi;
+    if (!encodeQueryKey(field, query.lo, query.keysize, lo) ||
+        (query.hi != nullptr && !encodeQueryKey(field, query.hi, query.keysize, hi)))
+    {
+        detail::setError(error, ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    const int recordsize = idx.recordsize; // 无索引时在表锁外使用
+    int       limit      = query.limit;
+    if (records != nullptr && bufsize / recordsize < limit)
+    {
+        limit = bufsize / recordsize;
+    }
+    int  skip = query.skip > 0 ? query.skip : 0;
+    int  n    = 0;
+    auto emit = [&](int row, const char *record) {
+        if (skip > 0)
+        {
+            --skip;
+            return true;
+        }
+        if (n >= limit)
+        {
+            *more = true;
+            return false;
+        }
+        rows[n] = row;
+        if (records != nullptr)
+        {
+            std::memcpy(static_cast<char *>(records) + static_cast<long>(n) * recordsize, record, recordsize);
+        }
+        ++n;
+        return true;
+    };
+
+    if (ix != nullptr)
+    {
+        ix->lookup(lo, query.hi != nullptr ? &hi : nullptr, [&](int row) { return emit(row, recordAt(d, idx, row)); });
+        fillInfo(d, lock.slot(), info);
+    }
+    else
+    {
+        // 无索引：在快照上逐条编码比较，扫描期间不持表锁
+        Snapshot snap = snapshotOf(d, lock.slot());
+        lock.unlock();
+        const TableInfo   &si  = snap->info();
+        const std::string &end = query.hi != nullptr ? hi : lo;
+        std::string        key;
+        bool               stop = false;
+        for (int row = 0; row < si.currcount && !stop;)
+        {
+            detail::BlockView view;
+            int               count = snap->block(row, detail::kScanBlock, view);
+            int               n0 = n, skip0 = skip;
+            for (int i = 0; i < count && !stop; ++i)
+            {
+                const char *record = view.data + static_cast<long>(i) * si.recordsize;
+                encodeKey(field.type, field.size, record + field.offset, key);
+                stop = key >= lo && key <= end && !emit(row + i, record);
+            }
+            if (!snap->stable(view))
+            {
+                if (snap->dropped())
+                {
+                    detail::setError(error, ERROR_TABLE_NOT_EXIST);
+                    return false;
+                }
+                n     = n0;
+                skip  = skip0;
+                stop  = false;
+                *more = false;
+                continue;
+            }
+            row += count;
+        }
+        if (info != nullptr)
+        {
+            *info = si;
+        }
+    }
+    *actcount = n;
+    detail::setError(error, 0);
+    return true;
+}
+
+// ============================================================
+//  谓词扫描
+// ============================================================
+namespace {
+
+// 在快照上扫描：逐块求匹配位图并取出匹配行，块直接读记录区时用完复核，期间有写入则重做该块
+bool scanRows(const TableSnapshot &snap, const ScanQuery &query, int *rows, void *records, int bufsize,
+              int *actcount, int *next, unsigned int *error)
+{
+    const TableInfo &info = snap.info();
+    if (snap.dropped())
+    {
+        detail::setError(error, ERROR_TABLE_NOT_EXIST);
+        return false;
+    }
+    if (query.start < 0 || query.start > info.currcount)
+    {
+        detail::setError(error, ERROR_TABLE_ROWID);
+        return false;
+    }
+    std::vector<detail::ScanPred> preds(query.preds.size());
+    for (std::size_t i = 0; i < preds.size(); ++i)
+    {
+        Predicate p = query.preds[i];
+        if (!resolveField(snap.type().data(), static_cast<int>(snap.type().size()), info.recordsize, p.field,
+                          error))
+        {
+            return false;
+        }
+        if (!detail::compilePredicate(p, preds[i]))
+        {
+            detail::setError(error, ERROR_INVALID_PARAMETER);
+            return false;
+        }
+    }
+
+    int limit = query.limit;
+    if (records != nullptr && bufsize / info.recordsize < limit)
+    {
+        limit = bufsize / info.recordsize;
+    }
+    int n   = 0;
+    int row = query.start;
+    while (row < info.currcount && n < limit)
+    {
+        detail::BlockView view;
+        int               count = snap.block(row, detail::kScanBlock, view);
+        std::uint64_t     mask  = count == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << count) - 1;
+        for (const detail::ScanPred &p : preds)
+        {
+            if (mask == 0)
+            {
+                break;
+            }
+            mask &= detail::matchBlock(view.data, info.recordsize, count, p);
+        }
+        int first = n;
+        for (; mask != 0 && n < limit; mask &= mask - 1)
+        {
+            int i   = __builtin_ctzll(mask);
+            rows[n] = row + i;
+            if (records != nullptr)
+            {
+                std::memcpy(static_cast<char *>(records) + static_cast<long>(n) * info.recordsize,
+                            view.data + static_cast<long>(i) * info.recordsize, info.recordsize);
+            }
+            ++n;
+        }
+        if (!snap.stable(view))
+        {
+            if (snap.dropped())
+            {
+                detail::setError(error, ERROR_TABLE_NOT_EXIST);
+                return false;
+            }
+            n = first;
+            continue;
+        }
+        if (mask != 0)
+        {
+            // 本块还有未返回的匹配：从下一条匹配续扫
+            row += __builtin_ctzll(mask);
+            break;
+        }
+        row += count;
+    }
+    *actcount = n;
+    *next     = row;
+    detail::setError(error, 0);
+    return true;
+}
+
+} // namespace
+
+bool scanTable(const char *db, const char *table, const ScanQuery &query, int *rows, void *records, int bufsize,
+               int *actcount, int *next, TableInfo *info, unsigned int *error)
+{
+    *actcount = 0;
+    *next     = query.start;
+    Database d;
+    if (!getDatabase(db, d, error))
+    {
+        return false;
+    }
+    TableLock lock(d, table, error);
+    if (!lock.ok())
+    {
+        return false;
+    }
+    Snapshot snap = snapshotOf(d, lock.slot());
+    lock.unlock();
+    if (info != nullptr)
+    {
+        *info = snap->info();
+    }
+    return scanRows(*snap, query, rows, records, bufsize, actcount, next, error);
+}
+
+// ============================================================
+//  快照读
+// ============================================================
+bool openSnapshot(const char *db, const char *table, Snapshot *snap, TableInfo *info, unsigned int *error)
+{
+    Database d;
+    if (!getDatabase(db, d, error))
+    {
+        return false;
+    }
+    TableLock lock(d, table, error);
+    if (!lock.ok())
+    {
+        return false;
+    }
+    *snap = snapshotOf(d, lock.slot());
+    fillInfo(d, lock.slot(), info);
+    detail::setError(error, 0);
+    return true;
+}
+
+const TableInfo &snapshotInfo(const Snapshot &snap)
+{
+    return snap->info();
+}
+
+bool selectSnapshot(const Snapshot &snap, int row, int count, void *buf, int bufsize, int *actcount,
+                    unsigned int *error)
+{
+    *actcount             = 0;
+    const TableInfo &info = snap->info();
+    if (row < 0 || row > info.currcount)
+    {
+        detail::setError(error, ERROR_TABLE_ROWID);
+        return false;
+    }
+    int n = info.currcount - row;
+    n     = count < n ? count : n;
+    n     = bufsize / info.recordsize < n ? bufsize / info.recordsize : n;
+    n     = n > 0 ? n : 0;
+    if (!snap->read(row, n, static_cast<char *>(buf)))
+    {
+        detail::setError(error, ERROR_TABLE_NOT_EXIST);
+        return false;
+    }
+    *actcount = n;
+    detail::setError(error, 0);
+    return true;
+}
+
+bool scanSnapshot(const Snapshot &snap, const ScanQuery &query, int *rows, void *records, int bufsize, int *actcount,
+                  int *next, unsigned int *error)
+{
+    *actcount = 0;
+    *next     = query.start;
+    return scanRows(*snap, query, rows, records, bufsize, actcount, next, error);
+}
+
+} // namespace qbd
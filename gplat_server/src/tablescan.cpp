@@ -0,0 +1,239 @@
+// 数据库表谓词扫描的求值核心：谓词编译为闭区间，按块求匹配位图
+
+#include "tablescan.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace qbd {
+namespace detail {
+
+namespace {
+
+template <typename T>
+inline T load(const char *p)
+{
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return v;
+}
+
+inline std::uint64_t blockMask(int n)
+{
+    return n >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << n) - 1;
+}
+
+// 字段原始值读为比较类型（1 / 2 字节整数扩展到 32 位）
+inline std::int32_t loadI32(const char *p, int size, KeyType type)
+{
+    switch (size)
+    {
+    case 1:
+        return type == KeyType::UInt ? load<std::uint8_t>(p) : load<std::int8_t>(p);
+    case 2:
+        return type == KeyType::UInt ? load<std::uint16_t>(p) : load<std::int16_t>(p);
+    default:
+        return load<std::int32_t>(p);
+    }
+}
+
+// ---- 区间化：比较运算都化成 [lo, hi]，Ne 为 Eq 取反 ----
+
+template <typename T>
+bool integerRange(PredOp op, T v, T v2, T &lo, T &hi, bool &never)
+{
+    const T lowest  = std::numeric_limits<T>::min();
+    const T highest = std::numeric_limits<T>::max();
+    switch (op)
+    {
+    case PredOp::Eq:
+    case PredOp::Ne:
+        lo = hi = v;
+        return true;
+    case PredOp::Lt:
+        never = v == lowest;
+        lo    = lowest;
+        hi    = never ? lowest : static_cast<T>(v - 1);
+        return true;
+    case PredOp::Le:
+        lo = lowest;
+        hi = v;
+        return true;
+    case PredOp::Gt:
+        never = v == highest;
+        lo    = never ? highest : static_cast<T>(v + 1);
+        hi    = highest;
+        return true;
+    case PredOp::Ge:
+        lo = v;
+        hi = highest;
+        return true;
+    case PredOp::Between:
+        lo    = v;
+        hi    = v2;
+        never = v > v2;
+        return true;
+    }
+    return false;
+}
+
+// NaN 与任何值比较都不成立，因此 NaN 作比较值时区间为空（Ne 取反后全部匹配）
+template <typename T>
+bool floatRange(PredOp op, T v, T v2, T &lo, T &hi, bool &never)
+{
+    const T inf = std::numeric_limits<T>::infinity();
+    switch (op)
+    {
+    case PredOp::Eq:
+    case PredOp::Ne:
+        lo = hi = v;
+        break;
+    case PredOp::Lt:
+        never = v == -inf;
+        lo    = -inf;
+        hi    = std::nextafter(v, -inf);
+        break;
+    case PredOp::Le:
+        lo = -inf;
+        hi = v;
+        break;
+    case PredOp::Gt:
+        never = v == inf;
+        lo    = std::nextafter(v, inf);
+        hi    = inf;
+        break;
+    case PredOp::Ge:
+        lo = v;
+        hi = inf;
+        break;
+    case PredOp::Between:
+        lo    = v;
+        hi    = v2;
+        never = !(v <= v2);
+        break;
+    default:
+        return false;
+    }
+    if (std::isnan(v) || (op == PredOp::Between && std::isnan(v2)))
+    {
+        never = true;
+    }
+    return true;
+}
+
+// ---- 区间比较核心 ----
+
+template <typename T, typename Load>
+std::uint64_t scalarRange(const char *p, int stride, int n, T lo, T hi, Load get)
+{
+    std::uint64_t bits = 0;
+    for (int i = 0; i < n; ++i, p += stride)
+    {
+        T x = get(p);
+        bits |= static_cast<std::uint64_t>(x >= lo && x <= hi) << i;
+    }
+    return bits;
+}
+
+std::uint64_t scalarBlock(const char *records, int stride, int n, const ScanPred &s)
+{
+    const char *p = records + s.offset;
+    switch (s.lane)
+    {
+    case Lane::I32:
+        return scalarRange(p, stride, n, s.lo.i32, s.hi.i32,
+                           [&s](const char *q) { return loadI32(q, s.size, s.type); });
+    case Lane::U32:
+        return scalarRange(p, stride, n, s.lo.u32, s.hi.u32, load<std::uint32_t>);
+    case Lane::I64:
+        return scalarRange(p, stride, n, s.lo.i64, s.hi.i64, load<std::int64_t>);
+    case Lane::U64:
+        return scalarRange(p, stride, n, s.lo.u64, s.hi.u64, load<std::uint64_t>);
+    case Lane::F32:
+        return scalarRange(p, stride, n, s.lo.f32, s.hi.f32, load<float>);
+    case Lane::F64:
+        return scalarRange(p, stride, n, s.lo.f64, s.hi.f64, load<double>);
+    }
+    return 0;
+}
+
+} // namespace
+
+bool compilePredicate(const Predicate &p, ScanPred &out)
+{
+    const FieldSpec &f = p.field;
+    out        = ScanPred{};
+    out.type   = f.type;
+    out.offset = f.offset;
+    out.size   = f.size;
+    out.negate = p.op == PredOp::Ne;
+    switch (f.type)
+    {
+    case KeyType::Int:
+    case KeyType::UInt:
+        if (f.size == 8)
+        {
+            if (f.type == KeyType::Int)
+            {
+                out.lane = Lane::I64;
+                return integerRange(p.op, load<std::int64_t>(p.value), load<std::int64_t>(p.value2), out.lo.i64,
+                                    out.hi.i64, out.never);
+            }
+            out.lane = Lane::U64;
+            return integerRange(p.op, load<std::uint64_t>(p.value), load<std::uint64_t>(p.value2), out.lo.u64,
+                                out.hi.u64, out.never);
+        }
+        if (f.size == 4 && f.type == KeyType::UInt)
+        {
+            out.lane = Lane::U32;
+            return integerRange(p.op, load<std::uint32_t>(p.value), load<std::uint32_t>(p.value2), out.lo.u32,
+                                out.hi.u32, out.never);
+        }
+        if (f.size == 1 || f.size == 2 || f.size == 4)
+        {
+            // 比较值同样按字段宽度读取，1 / 2 字节的值域在 32 位内比较
+            out.lane = Lane::I32;
+            if (!integerRange(p.op, loadI32(p.value, f.size, f.type), loadI32(p.value2, f.size, f.type), out.lo.i32,
+                              out.hi.i32, out.never))
+            {
+                return false;
+            }
+            if (f.size < 4 && !out.never)
+            {
+                // 区间端点收窄到字段值域，便于判断 Lt 最小值 / Gt 最大值
+                std::int32_t vmin = f.type == KeyType::UInt ? 0 : (f.size == 1 ? INT8_MIN : INT16_MIN);
+                std::int32_t vmax = f.type == KeyType::UInt ? (f.size == 1 ? UINT8_MAX : UINT16_MAX)
+                                                            : (f.size == 1 ? INT8_MAX : INT16_MAX);
+                out.lo.i32 = out.lo.i32 < vmin ? vmin : out.lo.i32;
+                out.hi.i32 = out.hi.i32 > vmax ? vmax : out.hi.i32;
+                out.never  = out.lo.i32 > out.hi.i32;
+            }
+            return true;
+        }
+        return false;
+    case KeyType::Float:
+        if (f.size == 4)
+        {
+            out.lane = Lane::F32;
+            return floatRange(p.op, load<float>(p.value), load<float>(p.value2), out.lo.f32, out.hi.f32, out.never);
+        }
+        if (f.size == 8)
+        {
+            out.lane = Lane::F64;
+            return floatRange(p.op, load<double>(p.value), load<double>(p.value2), out.lo.f64, out.hi.f64, out.never);
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+std::uint64_t matchBlock(const char *records, int stride, int n, const ScanPred &p)
+{
+    std::uint64_t bits = p.never ? 0 : scalarBlock(records, stride, n, p);
+    return p.negate ? ~bits & blockMask(n) : bits;
+}
+
+} // namespace detail
+} // namespace qbd
@@ -0,0 +1,55 @@
+#pragma once
+
+// gplat_store 内部使用：数据库表谓词扫描的求值核心
+//
+// 每个谓词先编译成"字段值落在 [lo, hi] 内（negate 时取反）"的统一形式，比较运算、BETWEEN 都化成闭区间，
+// 于是每种字段类型只需一个区间比较核心。记录按 64 条一块求值，每块得到一个 64 位的匹配位图，
+// 各谓词的位图相与。
+
+#include <cstdint>
+
+#include "qbdstore.h"
+
+namespace qbd {
+namespace detail {
+
+// 比较所用的值类型
+enum class Lane : std::uint8_t
+{
+    I32, // 1 / 2 / 4 字节有符号整数，1 / 2 字节无符号整数
+    U32, // 4 字节无符号整数
+    I64, // 8 字节有符号整数
+    U64, // 8 字节无符号整数
+    F32,
+    F64,
+};
+
+struct ScanPred
+{
+    Lane    lane   = Lane::I32;
+    KeyType type   = KeyType::Int; // 1 / 2 字节字段按它区分有无符号
+    int     offset = 0;
+    int     size   = 0;
+    bool    negate = false;
+    bool    never  = false; // 区间为空：不取反时没有记录匹配
+    union
+    {
+        std::int32_t  i32;
+        std::uint32_t u32;
+        std::int64_t  i64;
+        std::uint64_t u64;
+        float         f32;
+        double        f64;
+    } lo{}, hi{};
+};
+
+// 把 Predicate 编译为 ScanPred；字段须已解析（非数值字段、非法运算返回 false）
+bool compilePredicate(const Predicate &p, ScanPred &out);
+
+constexpr int kScanBlock = 64;
+
+// 对从 records 起的 n（≤ kScanBlock）条记录求一个谓词，返回匹配位图（第 i 位对应第 i 条）
+std::uint64_t matchBlock(const char *records, int stride, int n, const ScanPred &p);
+
+} // namespace detail
+} // namespace qbd
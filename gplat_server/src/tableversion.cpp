@@ -0,0 +1,178 @@
+// 数据库表的快照读：页原像的保存、共享和按页一致读取
+
+#include "tableversion.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace qbd {
+
+namespace {
+
+constexpr int kPageBytes = 4096;
+
+} // namespace
+
+// ============================================================
+//  快照
+// ============================================================
+TableSnapshot::TableSnapshot(std::shared_ptr<detail::VersionStore> store, const TableInfo &info, const char *type,
+                             int typesize)
+    : store_(std::move(store)), info_(info), type_(type, typesize > 0 ? typesize : 0)
+{
+    store_->attach(this);
+}
+
+TableSnapshot::~TableSnapshot()
+{
+    store_->detach(this);
+}
+
+bool TableSnapshot::dropped() const
+{
+    return store_->dropped();
+}
+
+int TableSnapshot::block(int row, int max, detail::BlockView &view) const
+{
+    int rpp   = store_->rowsPerPage();
+    int page  = row / rpp;
+    int first = page * rpp;
+    int n     = std::min({max, first + rpp - row, info_.currcount - row});
+
+    view.page = page;
+    view.seq  = store_->seq(page);
+    if (images_.load(std::memory_order_acquire) > 0)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = pages_.find(page);
+        if (it != pages_.end())
+        {
+            view.data = it->second->data() + static_cast<long>(row - first) * info_.recordsize;
+            view.live = false;
+            return n;
+        }
+    }
+    view.data = store_->recordAt(row);
+    view.live = true;
+    return n;
+}
+
+bool TableSnapshot::stable(const detail::BlockView &view) const
+{
+    if (!view.live)
+    {
+        return true;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return store_->seq(view.page) == view.seq && !store_->dropped();
+}
+
+bool TableSnapshot::read(int row, int count, char *dst) const
+{
+    if (dropped())
+    {
+        return false;
+    }
+    detail::BlockView view;
+    while (count > 0)
+    {
+        int n = block(row, count, view);
+        std::memcpy(dst, view.data, static_cast<std::size_t>(n) * info_.recordsize);
+        if (!stable(view))
+        {
+            if (dropped())
+            {
+                return false;
+            }
+            continue;
+        }
+        row += n;
+        count -= n;
+        dst += static_cast<long>(n) * info_.recordsize;
+    }
+    return true;
+}
+
+namespace detail {
+
+// ============================================================
+//  页修改计数和原像
+// ============================================================
+VersionStore::VersionStore(const char *records, int recordsize, int maxcount)
+    : records_(records), recordsize_(recordsize), rows_per_page_(recordsize < kPageBytes ? kPageBytes / recordsize : 1)
+{
+    int pages = (maxcount + rows_per_page_ - 1) / rows_per_page_;
+    seq_.reset(new std::atomic<std::uint32_t>[pages > 0 ? pages : 1]);
+    for (int i = 0; i < pages; ++i)
+    {
+        seq_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void VersionStore::attach(TableSnapshot *snap)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    live_.push_back(snap);
+}
+
+void VersionStore::detach(TableSnapshot *snap)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    live_.erase(std::remove(live_.begin(), live_.end(), snap), live_.end());
+}
+
+void VersionStore::drop()
+{
+    dropped_.store(true, std::memory_order_release);
+}
+
+void VersionStore::beforeWrite(int row, int count)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (live_.empty() || count <= 0)
+    {
+        return;
+    }
+    int visible = 0;
+    for (const TableSnapshot *s : live_)
+    {
+        visible = std::max(visible, s->info_.currcount);
+    }
+    int end = std::min(row + count, visible);
+    for (int page = row / rows_per_page_; page * rows_per_page_ < end; ++page)
+    {
+        int       first = page * rows_per_page_;
+        PageImage image;
+        for (TableSnapshot *s : live_)
+        {
+            if (s->info_.currcount <= first)
+            {
+                continue; // 该快照看不到这一页
+            }
+            std::lock_guard<std::mutex> slock(s->mutex_);
+            if (s->pages_.count(page) != 0)
+            {
+                continue; // 已有更早的原像
+            }
+            if (!image)
+            {
+                // 只保存快照可能看到的行
+                int rows = std::min(first + rows_per_page_, visible) - first;
+                image    = std::make_shared<const std::vector<char>>(
+                    recordAt(first), recordAt(first) + static_cast<long>(rows) * recordsize_);
+            }
+            s->pages_.emplace(page, image);
+            s->images_.fetch_add(1, std::memory_order_release);
+        }
+        if (image)
+        {
+            seq_[page].fetch_add(1, std::memory_order_release);
+        }
+    }
+    // 原像和计数先于随后对记录区的改写
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+} // namespace detail
+} // namespace qbd
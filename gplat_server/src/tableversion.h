@@ -0,0 +1,111 @@
+#pragma once
+
+// gplat_store 内部使用：数据库表的快照读（页级写时复制）
+//
+// 记录区按页（约 4 KB，整数条记录）划分。打开快照时在表锁内记下当时的记录数，之后不再持表锁读：
+//   - 写者（插入、更新）在表锁内、改写之前，为"能看到被改行"的每个存活快照保存所在页的原像
+//     （同一时刻的原像在多个快照间共享），然后递增该页的修改计数，再改写记录区；
+//   - 读者按页读取：快照有该页原像时读原像，否则直接读记录区，读完复核该页的修改计数，
+//     期间有写入（原像必已装入）时重读。
+// 原像由引用它的快照持有，最后一个引用它的快照关闭时释放；没有快照时写入不复制任何页。
+// 删除表、清空数据库后记录区可能被新表复用，这之后的快照读失败（ERROR_TABLE_NOT_EXIST）。
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "qbdstore.h"
+
+namespace qbd {
+
+namespace detail {
+
+using PageImage = std::shared_ptr<const std::vector<char>>;
+
+class VersionStore;
+
+// 快照内一个不跨页的块
+struct BlockView
+{
+    const char   *data = nullptr; // 块的第一条记录
+    int           page = 0;
+    std::uint32_t seq  = 0;
+    bool          live = false; // 直接指向记录区，读完须 TableSnapshot::stable() 复核
+};
+
+} // namespace detail
+
+class TableSnapshot
+{
+public:
+    TableSnapshot(std::shared_ptr<detail::VersionStore> store, const TableInfo &info, const char *type,
+                  int typesize);
+    ~TableSnapshot();
+
+    TableSnapshot(const TableSnapshot &)            = delete;
+    TableSnapshot &operator=(const TableSnapshot &) = delete;
+
+    const TableInfo   &info() const { return info_; }
+    const std::string &type() const { return type_; }
+
+    // 取 row 起、不跨页的至多 max 条记录，返回条数
+    int block(int row, int max, detail::BlockView &view) const;
+    // 直接读记录区的块在用完后复核：false 表示期间有写入或表已删除，须重取
+    bool stable(const detail::BlockView &view) const;
+    bool dropped() const;
+
+    // 拷贝 [row, row + count) 到 dst（行号须在快照的记录数之内），表已删除时返回 false
+    bool read(int row, int count, char *dst) const;
+
+private:
+    friend class detail::VersionStore;
+
+    std::shared_ptr<detail::VersionStore> store_;
+    TableInfo                             info_;
+    std::string                           type_; // 类型描述，解析字段名用
+
+    mutable std::mutex                         mutex_; // 保护 pages_（写者装入原像 / 读者查找）
+    std::unordered_map<int, detail::PageImage> pages_;
+    std::atomic<int>                           images_{0};
+};
+
+namespace detail {
+
+// 一张表的页修改计数和存活快照，与表同生命周期（表删除后由仍打开的快照持有）
+class VersionStore
+{
+public:
+    VersionStore(const char *records, int recordsize, int maxcount);
+
+    int         rowsPerPage() const { return rows_per_page_; }
+    const char *recordAt(int row) const { return records_ + static_cast<long>(row) * recordsize_; }
+
+    // 写入 [row, row + count) 之前调用（表锁内）
+    void beforeWrite(int row, int count);
+    // 表被删除（表锁内）
+    void drop();
+    bool dropped() const { return dropped_.load(std::memory_order_acquire); }
+
+    std::uint32_t seq(int page) const { return seq_[page].load(std::memory_order_acquire); }
+
+    // 快照登记 / 注销（打开快照时在表锁内登记）
+    void attach(TableSnapshot *snap);
+    void detach(TableSnapshot *snap);
+
+private:
+    const char *records_;
+    int         recordsize_;
+    int         rows_per_page_;
+
+    std::mutex                                     mutex_; // 保护 live_
+    std::vector<TableSnapshot *>                   live_;
+    std::unique_ptr<std::atomic<std::uint32_t>[]> seq_;
+    std::atomic<bool>                              dropped_{false};
+};
+
+} // namespace detail
+} // namespace qbd
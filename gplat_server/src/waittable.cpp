@@ -0,0 +1,286 @@
+#include "waittable.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace gplat {
+namespace server {
+
+WaitTable::WaitTable(std::string board, DelayEngine &delays, qbd::ItemObserver *next)
+    : board_(std::move(board)), delays_(delays), next_(next)
+{
+}
+
+void WaitTable::wait(const ConnectionPtr &conn, const MSGHEAD &head, const WAITENTRY *entries, int count)
+{
+    auto w  = std::make_shared<Waiter>();
+    w->conn = conn;
+    w->head = head;
+    for (int i = 0; i < count; ++i)
+    {
+        WAITENTRY e;
+        std::memcpy(&e, entries + i, sizeof(e));
+        Entry entry{std::string(e.name, ::strnlen(e.name, sizeof(e.name))), e.kind, e.lastseq};
+        // lastseq 为 0：登记之后的下一次写入，取登记前的序号（标签不存在时为 0，写入即就绪）
+        if (entry.kind == WAIT_TAG && entry.lastseq == 0)
+        {
+            qbd::ItemMeta meta;
+            if (qbd::readItem(board_.c_str(), entry.name.c_str(), nullptr, 0, &meta, nullptr))
+            {
+                entry.lastseq = meta.seq;
+            }
+        }
+        w->entries.push_back(std::move(entry));
+    }
+
+    std::vector<WAITREADY> ready;
+    if (head.timeout == 0)
+    {
+        collect(*w, ready);
+        finish(w, ready, true);
+        return;
+    }
+
+    // 定时器的 key 在登记前定好：登记之后别的线程随时可能应答并读它
+    if (head.timeout > 0)
+    {
+        w->timer = std::to_string(conn->id());
+        w->timer.push_back('\0'); // 与延时订阅的 "连接号\0标签\0事件名" 区分，cancelConnection 时一并撤销
+        w->timer.push_back('\0');
+        w->timer += std::to_string(next_id_.fetch_add(1, std::memory_order_relaxed));
+    }
+
+    // 先登记再检查：检查之后的写入一定会唤醒，不会漏掉
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Entry &e : w->entries)
+        {
+            (e.kind == WAIT_QUEUE ? queues_ : tags_)[e.name].push_back(w);
+            if (e.kind == WAIT_TAG)
+            {
+                tag_entries_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        ++waiters_;
+    }
+    // 挂定时器之前别的线程已应答的，finish 撤销不到定时器，由这里撤销
+    if (head.timeout > 0)
+    {
+        std::weak_ptr<Waiter> weak = w;
+        delays_.scheduleCall(w->timer, head.timeout, [this, weak]() {
+            auto expired = weak.lock();
+            if (expired && !expired->done.load(std::memory_order_acquire))
+            {
+                std::vector<WAITREADY> now;
+                collect(*expired, now);
+                finish(expired, now, false);
+            }
+        });
+        if (w->done.load(std::memory_order_acquire))
+        {
+            delays_.cancel(w->timer);
+        }
+    }
+
+    collect(*w, ready);
+    if (!ready.empty())
+    {
+        finish(w, ready, true);
+    }
+}
+
+void WaitTable::queueWritten(const char *qname)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = queues_.find(qname);
+    if (it != queues_.end())
+    {
+        wakeLocked(it->second);
+    }
+}
+
+void WaitTable::onWrite(const qbd::ItemEvent &ev)
+{
+    if (next_)
+    {
+        next_->onWrite(ev);
+    }
+    if (tag_entries_.load(std::memory_order_relaxed) == 0)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = tags_.find(ev.itemname);
+    if (it != tags_.end())
+    {
+        wakeLocked(it->second);
+    }
+}
+
+void WaitTable::dispatch()
+{
+    std::vector<WaiterPtr> woken;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.store(false, std::memory_order_release);
+        woken.swap(woken_);
+        for (const auto &w : woken)
+        {
+            w->woken = false; // 检查期间的新写入再次唤醒
+        }
+    }
+    std::vector<WAITREADY> ready;
+    for (const auto &w : woken)
+    {
+        if (w->done.load(std::memory_order_acquire))
+        {
+            continue;
+        }
+        collect(*w, ready);
+        if (!ready.empty())
+        {
+            finish(w, ready, false);
+        }
+    }
+}
+
+void WaitTable::removeConnection(const Connection &conn)
+{
+    std::vector<WaiterPtr> removed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto *table : {&queues_, &tags_})
+        {
+            for (const auto &kv : *table)
+            {
+                for (const auto &w : kv.second)
+                {
+                    if (w->conn.get() == &conn && !w->done.exchange(true))
+                    {
+                        removed.push_back(w);
+                    }
+                }
+            }
+        }
+        for (const auto &w : removed)
+        {
+            unregisterLocked(w);
+        }
+    }
+    for (const auto &w : removed)
+    {
+        if (!w->timer.empty())
+        {
+            delays_.cancel(w->timer);
+        }
+    }
+}
+
+std::size_t WaitTable::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return waiters_;
+}
+
+void WaitTable::collect(const Waiter &w, std::vector<WAITREADY> &ready) const
+{
+    ready.clear();
+    for (std::size_t i = 0; i < w.entries.size(); ++i)
+    {
+        const Entry &e = w.entries[i];
+        WAITREADY    r;
+        r.index = static_cast<int>(i);
+        r.kind  = e.kind;
+        r.value = 0;
+        if (e.kind == WAIT_QUEUE)
+        {
+            QUEUE_HEAD state;
+            if (qbd::queueState(e.name.c_str(), &state, nullptr))
+            {
+                r.value = static_cast<unsigned long long>((state.writePoint - state.readPoint + state.num + 1) %
+                                                          (state.num + 1));
+            }
+            if (r.value > 0)
+            {
+                ready.push_back(r);
+            }
+        }
+        else
+        {
+            qbd::ItemMeta meta;
+            if (qbd::readItem(board_.c_str(), e.name.c_str(), nullptr, 0, &meta, nullptr) && meta.seq != e.lastseq)
+            {
+                r.value = meta.seq;
+                ready.push_back(r);
+            }
+        }
+    }
+}
+
+void WaitTable::finish(const WaiterPtr &w, const std::vector<WAITREADY> &ready, bool cork)
+{
+    if (w->done.exchange(true))
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        unregisterLocked(w);
+    }
+    if (!w->timer.empty())
+    {
+        delays_.cancel(w->timer);
+    }
+    MSGHEAD h = w->head;
+    h.id      = SUCCEED;
+    h.error   = 0;
+    h.count   = static_cast<int>(ready.size());
+    w->conn->write(h, ready.data(), static_cast<int>(ready.size() * sizeof(WAITREADY)), cork);
+}
+
+// 未登记（timeout 为 0）或已撤销时什么也不做
+void WaitTable::unregisterLocked(const WaiterPtr &w)
+{
+    bool found = false;
+    for (const Entry &e : w->entries)
+    {
+        auto &table = e.kind == WAIT_QUEUE ? queues_ : tags_;
+        auto  it    = table.find(e.name);
+        if (it == table.end())
+        {
+            continue;
+        }
+        auto &list = it->second;
+        auto  end  = std::remove(list.begin(), list.end(), w);
+        if (e.kind == WAIT_TAG)
+        {
+            tag_entries_.fetch_sub(static_cast<std::size_t>(list.end() - end), std::memory_order_relaxed);
+        }
+        found = found || end != list.end();
+        list.erase(end, list.end());
+        if (list.empty())
+        {
+            table.erase(it);
+        }
+    }
+    if (found)
+    {
+        --waiters_;
+    }
+}
+
+void WaitTable::wakeLocked(const std::vector<WaiterPtr> &waiters)
+{
+    for (const auto &w : waiters)
+    {
+        if (!w->woken)
+        {
+            w->woken = true;
+            woken_.push_back(w);
+        }
+    }
+    pending_.store(true, std::memory_order_release);
+}
+
+} // namespace server
+} // namespace gplat
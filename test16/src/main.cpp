@@ -0,0 +1,127 @@
+// 1、协程方式
+// 用 C++20 协程在一个线程里同时完成 test14（轮询）和 test15（订阅 + 喂狗）的工作，
+// 不再需要多线程和 200ms 超时轮询
+
+#include <atomic>   // 原子操作库
+#include <chrono>   // 时间库
+#include <cstdio>   // C标准输入输出（printf）
+#include <iostream> // C++输入输出流（cin）
+#include <string>   // 字符串类
+#include <thread>   // 仅用于读取键盘输入的线程
+
+#include "gplat_coro.h"
+
+using namespace std::chrono_literals;
+
+// 并发读取的逻辑任务数量，演示单线程承载大量任务
+constexpr int kConcurrentReaders = 2000;
+
+// --- 任务 1：订阅者 & 看门狗监控器 ---
+// 订阅流没有数据时协程挂起，不占用线程，也不需要超时轮询
+gplat::Task<> watchdogMonitor(gplat::AsyncConnection &conn)
+{
+    auto sub = conn.subscribe("WATCHDOG");
+    std::printf("[Monitor] 监控任务已启动，正在监听信号...\n");
+
+    int last_hb_value = 0;       // 保存上一次的值
+    bool has_last_value = false; // 标记是否已经有上一次的值
+    while (auto ev = co_await sub.next())
+    {
+        int hb_value = ev->as<int>();
+        if (!has_last_value || hb_value != last_hb_value)
+        {
+            std::printf("[Monitor] 收到 WATCHDOG 信号，当前值: %d\n", hb_value);
+            last_hb_value = hb_value;
+            has_last_value = true;
+        }
+    }
+    std::printf("[Monitor] 订阅结束，error=%u\n", sub.error());
+}
+
+// --- 任务 2：发布者 & 喂狗执行者 ---
+gplat::Task<> watchdogFeeder(gplat::EventLoop &loop, gplat::AsyncConnection &conn)
+{
+    std::printf("[Feeder] 喂狗任务已启动...\n");
+    int hb_count = 0;
+    while (!loop.stopping())
+    {
+        hb_count++;
+        auto st = co_await gplat::writeb_async(conn, "WATCHDOG", hb_count);
+        if (!st)
+        {
+            std::printf("[Feeder] writeb failed, error=%u\n", st.error);
+            break;
+        }
+        // 定时器挂起，不阻塞线程
+        co_await loop.sleep_for(200ms);
+    }
+    std::printf("[Feeder] 喂狗任务退出\n");
+}
+
+// --- 任务 3：大量并发读取 ---
+// 同一连接上同时挂起 kConcurrentReaders 个 readb 请求，统计全部完成的耗时
+gplat::Task<> concurrentReader(gplat::AsyncConnection &conn, std::atomic<int> &done,
+                               std::chrono::steady_clock::time_point start)
+{
+    // 读取失败（如 WATCHDOG 尚未写入）也计入完成数，这里只关心应答耗时
+    co_await gplat::readb_async<int>(conn, "WATCHDOG");
+    if (++done == kConcurrentReaders)
+    {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - start).count();
+        std::printf("[Readers] %d 个并发 readb 全部完成，耗时 %lld us\n",
+                    kConcurrentReaders, static_cast<long long>(us));
+    }
+}
+
+gplat::Task<> startup(gplat::EventLoop &loop, gplat::AsyncConnection &monitor_conn,
+                      gplat::AsyncConnection &feeder_conn, std::atomic<int> &done)
+{
+    // 连接本地 gplat 服务
+    if (!co_await monitor_conn.connect("127.0.0.1", 8777) ||
+        !co_await feeder_conn.connect("127.0.0.1", 8777))
+    {
+        std::printf("connectgplat failed\n");
+        loop.stop();
+        co_return;
+    }
+
+    loop.spawn(watchdogMonitor(monitor_conn));
+    loop.spawn(watchdogFeeder(loop, feeder_conn));
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kConcurrentReaders; ++i)
+    {
+        loop.spawn(concurrentReader(monitor_conn, done, start));
+    }
+}
+
+int main()
+{
+    gplat::EventLoop loop;
+    gplat::AsyncConnection monitor_conn(loop);
+    gplat::AsyncConnection feeder_conn(loop);
+    std::atomic<int> done{0};
+
+    loop.spawn(startup(loop, monitor_conn, feeder_conn, done));
+
+    // 键盘输入放在独立线程，按 'q' 后通知事件循环停止
+    std::thread input_thread([&loop]() {
+        std::printf("程序启动。按 'q' 键退出。\n");
+        std::string input;
+        while (std::cin >> input)
+        {
+            if (input == "q")
+            {
+                break;
+            }
+        }
+        loop.stop();
+    });
+
+    loop.run(); // 所有协程任务都在主线程中执行
+
+    input_thread.join();
+    std::printf("Main thread exit\n");
+    return 0;
+}
@@ -0,0 +1,167 @@
+// 1、时间轮基准测试
+// 模拟 subscribedelaypost 的延时推送引擎：10 万个定时器同时挂起，
+// 统计插入/取消开销，以及按 1ms tick 驱动时实际触发时刻相对到期时刻的抖动
+
+#include <algorithm> // 排序
+#include <chrono>    // 时间库
+#include <cstdio>    // C标准输入输出（printf）
+#include <map>       // 对照组：有序定时器表
+#include <random>    // 随机延时
+#include <vector>    // 动态数组
+
+#include <time.h>    // clock_nanosleep
+
+#include "gplat_timerwheel.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kTimerCount   = 100000; // 挂起的定时器数量
+constexpr int kMinDelayMs   = 100;    // 最短延时
+constexpr int kMaxDelayMs   = 5000;   // 最长延时
+constexpr int kCancelEvery  = 10;     // 每 10 个取消 1 个，模拟卷按时到达
+
+// 定时器负载：记录到期时刻（纳秒），用于计算抖动
+struct DelayEvent
+{
+    int     id  = 0;
+    int64_t due = 0;
+};
+
+int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// 以 1ms 为一个 tick（当前时刻向下取整）
+uint64_t nsToTick(int64_t ns) { return static_cast<uint64_t>(ns / 1000000); }
+
+// 到期时刻向上取整，保证定时器不会提前触发
+uint64_t dueToTick(int64_t ns) { return static_cast<uint64_t>((ns + 999999) / 1000000); }
+
+// 睡到指定 tick 的起点
+void sleepUntilTick(uint64_t tick)
+{
+    int64_t target = static_cast<int64_t>(tick) * 1000000;
+    timespec ts;
+    ts.tv_sec  = target / 1000000000;
+    ts.tv_nsec = target % 1000000000;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+}
+
+double percentile(std::vector<int64_t> &v, double p)
+{
+    if (v.empty())
+    {
+        return 0;
+    }
+    size_t idx = static_cast<size_t>(p * (v.size() - 1));
+    return static_cast<double>(v[idx]);
+}
+
+// 对照组：std::multimap 作为有序定时器表的插入/取消开销
+void benchMultimap(const std::vector<int> &delays)
+{
+    std::multimap<int64_t, DelayEvent> timers;
+    std::vector<std::multimap<int64_t, DelayEvent>::iterator> handles;
+    handles.reserve(delays.size());
+
+    int64_t base = nowNs();
+    auto t0 = Clock::now();
+    for (size_t i = 0; i < delays.size(); ++i)
+    {
+        int64_t due = base + static_cast<int64_t>(delays[i]) * 1000000;
+        handles.push_back(timers.emplace(due, DelayEvent{static_cast<int>(i), due}));
+    }
+    auto t1 = Clock::now();
+    for (size_t i = 0; i < handles.size(); i += kCancelEvery)
+    {
+        timers.erase(handles[i]);
+    }
+    auto t2 = Clock::now();
+
+    double insert_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / delays.size();
+    double cancel_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / (delays.size() / kCancelEvery);
+    std::printf("[multimap ] 插入 %.1f ns/op，取消 %.1f ns/op\n", insert_ns, cancel_ns);
+}
+
+int main()
+{
+    std::mt19937 rng(20240601);
+    std::uniform_int_distribution<int> dist(kMinDelayMs, kMaxDelayMs);
+    std::vector<int> delays(kTimerCount);
+    for (auto &d : delays)
+    {
+        d = dist(rng);
+    }
+
+    benchMultimap(delays);
+
+    // 1. 插入 10 万个定时器
+    int64_t start_ns = nowNs();
+    gplat::TimerWheel<DelayEvent> wheel(nsToTick(start_ns));
+    std::vector<gplat::TimerWheel<DelayEvent>::TimerId> ids(kTimerCount);
+
+    auto t0 = Clock::now();
+    for (int i = 0; i < kTimerCount; ++i)
+    {
+        int64_t due = start_ns + static_cast<int64_t>(delays[i]) * 1000000;
+        ids[i]      = wheel.schedule(dueToTick(due), DelayEvent{i, due});
+    }
+    auto t1 = Clock::now();
+
+    // 2. 取消其中 10%
+    int cancelled = 0;
+    for (int i = 0; i < kTimerCount; i += kCancelEvery)
+    {
+        cancelled += wheel.cancel(ids[i]) ? 1 : 0;
+    }
+    auto t2 = Clock::now();
+
+    double insert_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / kTimerCount;
+    double cancel_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / cancelled;
+    std::printf("[timerwheel] 插入 %.1f ns/op，取消 %.1f ns/op，挂起 %zu 个\n", insert_ns, cancel_ns, wheel.size());
+
+    // 3. 按 1ms tick 驱动，批量取出到期定时器并记录抖动
+    std::vector<int64_t> jitter_us;
+    jitter_us.reserve(kTimerCount);
+    std::vector<DelayEvent> fired;
+    size_t batches = 0;
+    size_t max_batch = 0;
+    int64_t advance_ns_total = 0;
+
+    while (!wheel.empty())
+    {
+        uint64_t next = wheel.now() + wheel.ticksToNext();
+        sleepUntilTick(next);
+
+        fired.clear();
+        int64_t a0 = nowNs();
+        wheel.advance(nsToTick(a0), fired);
+        int64_t fire_ns = nowNs();
+        advance_ns_total += fire_ns - a0;
+
+        if (!fired.empty())
+        {
+            ++batches;
+            max_batch = std::max(max_batch, fired.size());
+        }
+        for (const auto &ev : fired)
+        {
+            jitter_us.push_back((fire_ns - ev.due) / 1000);
+        }
+    }
+
+    std::sort(jitter_us.begin(), jitter_us.end());
+    if (jitter_us.size() != static_cast<size_t>(kTimerCount - cancelled) ||
+        (!jitter_us.empty() && jitter_us.front() < 0))
+    {
+        std::printf("[timerwheel] 错误：触发数量或触发时刻不正确\n");
+        return 1;
+    }
+    std::printf("[timerwheel] 触发 %zu 个，%zu 个批次（单批最多 %zu 个），推进总耗时 %.2f ms\n",
+                jitter_us.size(), batches, max_batch, advance_ns_total / 1e6);
+    std::printf("[timerwheel] 触发抖动（实际 - 到期，1ms tick）: p50=%.0f us  p99=%.0f us  p999=%.0f us  max=%.0f us\n",
+                percentile(jitter_us, 0.50), percentile(jitter_us, 0.99),
+                percentile(jitter_us, 0.999), percentile(jitter_us, 1.0));
+    return 0;
+}
@@ -0,0 +1,128 @@
+// 1、端到端延迟统计
+// 写线程周期 writeb 心跳，订阅线程以 SUBOPT_STAMP 订阅并批量接收，
+// 按 写入→分发→接收 三段统计延迟直方图，定期打印并写入日志
+
+#include <atomic>   // 原子操作库
+#include <chrono>   // 时间库
+#include <cstdio>   // C标准输入输出（printf）
+#include <iostream> // C++输入输出流（cin）
+#include <string>   // 字符串类
+#include <thread>   // 线程库
+
+#include "higplat.h"
+#include "gplat_latency.h"
+
+std::atomic<bool> g_running{true};
+
+constexpr int kWritePeriodMs  = 1;    // 写入周期
+constexpr int kReportPeriodMs = 5000; // 统计输出周期
+
+// --- 线程 1：订阅者，记录每条推送的延迟 ---
+void subscriberThread(gplat::PostLatencyRecorder &recorder)
+{
+    int conngplat = connectgplat("127.0.0.1", 8777);
+    if (conngplat < 0)
+    {
+        std::printf("[Subscriber] connectgplat failed\n");
+        g_running = false;
+        return;
+    }
+
+    unsigned int error = 0;
+    gplat::PostReceiver rx;
+    if (!gplat::subscribe_ex(conngplat, rx, "WATCHDOG", SUBOPT_STAMP, &error))
+    {
+        std::printf("[Subscriber] subscribe failed, error=%u\n", error);
+        g_running = false;
+        disconnectgplat(conngplat);
+        return;
+    }
+    std::printf("[Subscriber] 已订阅 WATCHDOG（带时间戳）\n");
+
+    gplat::PostView events[256];
+    auto last_report = std::chrono::steady_clock::now();
+    while (g_running)
+    {
+        int n = gplat::waitpostdata_multi(conngplat, rx, events, 256, 200, &error);
+        if (n < 0)
+        {
+            std::printf("[Subscriber] waitpostdata_multi failed, error=%u\n", error);
+            break;
+        }
+        for (int i = 0; i < n; ++i)
+        {
+            recorder.record(events[i]);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_report >= std::chrono::milliseconds(kReportPeriodMs))
+        {
+            last_report = now;
+            for (const auto &s : recorder.stats(false))
+            {
+                std::printf("[Latency] %-8s count=%llu p50=%.1fus p99=%.1fus p999=%.1fus max=%.1fus\n",
+                            s.stage.c_str(), static_cast<unsigned long long>(s.count),
+                            s.p50_us, s.p99_us, s.p999_us, s.max_us);
+            }
+            gplat::logLatencyStats(recorder);
+        }
+    }
+
+    disconnectgplat(conngplat);
+    std::printf("[Subscriber] 订阅线程退出\n");
+}
+
+// --- 线程 2：写入者 ---
+void writerThread()
+{
+    int conngplat = connectgplat("127.0.0.1", 8777);
+    if (conngplat < 0)
+    {
+        std::printf("[Writer] connectgplat failed\n");
+        return;
+    }
+
+    unsigned int error = 0;
+    int hb_count = 0;
+    while (g_running)
+    {
+        hb_count++;
+        writeb(conngplat, "WATCHDOG", &hb_count, sizeof(hb_count), &error);
+        std::this_thread::sleep_for(std::chrono::milliseconds(kWritePeriodMs));
+    }
+    disconnectgplat(conngplat);
+    std::printf("[Writer] 写入线程退出\n");
+}
+
+int main()
+{
+    LogConfig log_cfg;
+    log_cfg.log_console = false;
+    log_cfg.filename    = "logs/test18.log";
+    initLogging(log_cfg);
+
+    gplat::PostLatencyRecorder recorder;
+    std::thread t1(subscriberThread, std::ref(recorder));
+    std::thread t2(writerThread);
+
+    std::printf("程序启动。按 'q' 键退出。\n");
+    std::string input;
+    while (g_running && std::cin >> input)
+    {
+        if (input == "q")
+        {
+            g_running = false;
+        }
+    }
+    g_running = false;
+
+    t1.join();
+    t2.join();
+
+    // 退出前输出一次完整统计（含每个标签）
+    gplat::logLatencyStats(recorder);
+    shutdownLogging();
+
+    std::printf("Main thread exit\n");
+    return 0;
+}
@@ -0,0 +1,106 @@
+// 1、进程内订阅复用
+// 多个工作线程都关心 WATCHDOG，通过 SubscriptionHub 共用一个连接、只向服务端订阅一次，
+// 每条推送在进程内扇出给所有线程
+
+#include <atomic>   // 原子操作库
+#include <chrono>   // 时间库
+#include <cstdio>   // C标准输入输出（printf）
+#include <iostream> // C++输入输出流（cin）
+#include <memory>   // 智能指针
+#include <string>   // 字符串类
+#include <thread>   // 线程库
+#include <vector>   // 动态数组
+
+#include "higplat.h"
+#include "gplat_hub.h"
+
+std::atomic<bool> g_running{true};
+
+constexpr int kWorkerCount = 8; // 关心 WATCHDOG 的工作线程数
+
+// --- 工作线程：各自一个监听者，共享同一个服务端订阅 ---
+void workerThread(int id)
+{
+    auto &hub = gplat::SubscriptionHub::GetInstance();
+    auto listener = std::make_shared<gplat::HubListener>();
+
+    unsigned int error = 0;
+    if (!hub.subscribe(listener, "127.0.0.1", 8777, "WATCHDOG", &error))
+    {
+        std::printf("[Worker %d] subscribe failed, error=%u\n", id, error);
+        return;
+    }
+
+    int received = 0;
+    gplat::HubEventPtr ev;
+    while (g_running)
+    {
+        // 200ms 超时只是为了检查退出标志
+        if (!listener->wait(ev, 200))
+        {
+            continue;
+        }
+        ++received;
+        if (id == 0)
+        {
+            std::printf("[Worker 0] 收到 WATCHDOG 信号，当前值: %d\n", ev->as<int>());
+        }
+    }
+
+    hub.unsubscribeAll(listener);
+    std::printf("[Worker %d] 退出，共收到 %d 条，丢弃 %llu 条\n", id, received,
+                static_cast<unsigned long long>(listener->dropped()));
+}
+
+// --- 喂狗线程：与 test15 相同，周期写入心跳 ---
+void feederThread()
+{
+    int conngplat = connectgplat("127.0.0.1", 8777);
+    unsigned int error = 0;
+    int hb_count = 0;
+    while (g_running)
+    {
+        hb_count++;
+        writeb(conngplat, "WATCHDOG", &hb_count, sizeof(hb_count), &error);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    disconnectgplat(conngplat);
+}
+
+int main()
+{
+    std::vector<std::thread> workers;
+    for (int i = 0; i < kWorkerCount; ++i)
+    {
+        workers.emplace_back(workerThread, i);
+    }
+    std::thread feeder(feederThread);
+
+    std::printf("程序启动。按 's' 查看复用统计，按 'q' 键退出。\n");
+    std::string input;
+    while (g_running && std::cin >> input)
+    {
+        if (input == "q")
+        {
+            g_running = false;
+        }
+        else if (input == "s")
+        {
+            auto st = gplat::SubscriptionHub::GetInstance().stats();
+            std::printf("[Hub] 连接 %zu 个，服务端订阅 %zu 个，监听者 %zu 个，收到推送 %llu 条，扇出 %llu 次\n",
+                        st.servers, st.tags, st.listeners,
+                        static_cast<unsigned long long>(st.posts),
+                        static_cast<unsigned long long>(st.deliveries));
+        }
+    }
+    g_running = false;
+
+    for (auto &t : workers)
+    {
+        t.join();
+    }
+    feeder.join();
+
+    std::printf("Main thread exit\n");
+    return 0;
+}
@@ -0,0 +1,183 @@
+// 1、连接池基准测试
+// 64 个工作线程共享一个 gplat::ConnectionPool，每次操作 = 借出连接 + readb + 归还，
+// 依次测试不同的池大小，对照每线程独占一个连接的写法，输出吞吐量和借出等待时间
+
+#include <algorithm> // 排序
+#include <atomic>    // 原子操作库
+#include <chrono>    // 时间库
+#include <cstdio>    // C标准输入输出（printf）
+#include <thread>    // 线程库
+#include <vector>    // 动态数组
+
+#include "higplat.h"
+#include "gplat_pool.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kWorkerCount = 64;   // 工作线程数
+constexpr int kRunMs       = 3000; // 每轮持续时间
+
+const char *kServer = "127.0.0.1";
+constexpr int kPort = 8777;
+
+struct RoundResult
+{
+    double ops_per_sec = 0;
+    double wait_p50_us = 0; // 借出连接的等待时间
+    double wait_p99_us = 0;
+    long   errors      = 0;
+    gplat::PoolStats stats;
+};
+
+double percentileUs(std::vector<int64_t> &v, double p)
+{
+    if (v.empty())
+    {
+        return 0;
+    }
+    size_t idx = static_cast<size_t>(p * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + idx, v.end());
+    return v[idx] / 1000.0;
+}
+
+// --- 一轮测试：池大小为 pool_size ---
+RoundResult runPooled(size_t pool_size)
+{
+    gplat::PoolOptions opt;
+    opt.server           = kServer;
+    opt.port             = kPort;
+    opt.min_size         = pool_size;
+    opt.max_size         = pool_size;
+    opt.checkout_timeout = std::chrono::milliseconds(5000);
+    gplat::ConnectionPool pool(opt, connectgplat, disconnectgplat);
+
+    std::atomic<bool> running{true};
+    std::atomic<long> ops{0};
+    std::atomic<long> errors{0};
+    std::vector<std::vector<int64_t>> waits(kWorkerCount);
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < kWorkerCount; ++i)
+    {
+        workers.emplace_back([&, i] {
+            auto &my_waits = waits[i];
+            unsigned int error = 0;
+            int hb = 0;
+            long local = 0;
+            while (running.load(std::memory_order_relaxed))
+            {
+                auto t0   = Clock::now();
+                auto conn = pool.checkout(&error);
+                my_waits.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count());
+                if (!conn)
+                {
+                    errors.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                if (!readb(conn.fd(), "WATCHDOG", &hb, sizeof(hb), &error))
+                {
+                    errors.fetch_add(1, std::memory_order_relaxed);
+                    if (error == ERROR_SOCKET_NOT_CONNECTED)
+                    {
+                        conn.invalidate();
+                    }
+                }
+                ++local;
+            }
+            ops.fetch_add(local, std::memory_order_relaxed);
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kRunMs));
+    running = false;
+    for (auto &t : workers)
+    {
+        t.join();
+    }
+
+    std::vector<int64_t> all;
+    for (auto &w : waits)
+    {
+        all.insert(all.end(), w.begin(), w.end());
+    }
+    RoundResult r;
+    r.ops_per_sec = ops.load() * 1000.0 / kRunMs;
+    r.wait_p50_us = percentileUs(all, 0.50);
+    r.wait_p99_us = percentileUs(all, 0.99);
+    r.errors      = errors.load();
+    r.stats       = pool.stats();
+    return r;
+}
+
+// --- 对照组：每个线程独占一个连接 ---
+RoundResult runPerThread()
+{
+    std::atomic<bool> running{true};
+    std::atomic<long> ops{0};
+    std::atomic<long> errors{0};
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < kWorkerCount; ++i)
+    {
+        workers.emplace_back([&] {
+            int conngplat = connectgplat(kServer, kPort);
+            unsigned int error = 0;
+            int hb = 0;
+            long local = 0;
+            while (running.load(std::memory_order_relaxed))
+            {
+                if (!readb(conngplat, "WATCHDOG", &hb, sizeof(hb), &error))
+                {
+                    errors.fetch_add(1, std::memory_order_relaxed);
+                }
+                ++local;
+            }
+            ops.fetch_add(local, std::memory_order_relaxed);
+            disconnectgplat(conngplat);
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kRunMs));
+    running = false;
+    for (auto &t : workers)
+    {
+        t.join();
+    }
+
+    RoundResult r;
+    r.ops_per_sec = ops.load() * 1000.0 / kRunMs;
+    r.errors      = errors.load();
+    return r;
+}
+
+int main()
+{
+    // 确保标签存在
+    int conngplat = connectgplat(kServer, kPort);
+    if (conngplat < 0)
+    {
+        std::printf("connectgplat failed\n");
+        return 1;
+    }
+    unsigned int error = 0;
+    int hb = 1;
+    writeb(conngplat, "WATCHDOG", &hb, sizeof(hb), &error);
+    disconnectgplat(conngplat);
+
+    std::printf("%d 个工作线程，每轮 %d ms，操作 = checkout + readb(WATCHDOG) + 归还\n\n", kWorkerCount, kRunMs);
+    std::printf("%-12s %12s %14s %14s %8s %8s\n", "连接数", "ops/s", "等待 p50(us)", "等待 p99(us)", "等待次数", "错误");
+
+    const size_t sizes[] = {1, 2, 4, 8, 16, 32, 64};
+    for (size_t size : sizes)
+    {
+        RoundResult r = runPooled(size);
+        std::printf("pool=%-7zu %12.0f %14.1f %14.1f %8llu %8ld\n", size, r.ops_per_sec, r.wait_p50_us, r.wait_p99_us,
+                    static_cast<unsigned long long>(r.stats.waits), r.errors);
+    }
+
+    RoundResult r = runPerThread();
+    std::printf("%-12s %12.0f %14s %14s %8s %8ld\n", "每线程独占", r.ops_per_sec, "-", "-", "-", r.errors);
+
+    std::printf("\nMain thread exit\n");
+    return 0;
+}
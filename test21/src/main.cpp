@@ -0,0 +1,106 @@
+// 1、请求流水线基准测试
+// 单个连接上对 WATCHDOG 连续 readb，对照一问一答的 readb 与不同深度的 gplat::Pipeline，
+// 输出每秒请求数；流水线深度越大，单连接吞吐越不受往返时延限制
+
+#include <chrono>  // 时间库
+#include <cstdio>  // C标准输入输出（printf）
+#include <vector>  // 动态数组
+
+#include "higplat.h"
+#include "gplat_pipeline.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kRequests = 20000; // 每轮请求数
+
+const char *kServer = "127.0.0.1";
+constexpr int kPort = 8777;
+
+double elapsedSec(Clock::time_point t0)
+{
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// --- 对照组：一问一答 ---
+double runSync(int conngplat)
+{
+    unsigned int error = 0;
+    int hb = 0;
+    auto t0 = Clock::now();
+    for (int i = 0; i < kRequests; ++i)
+    {
+        readb(conngplat, "WATCHDOG", &hb, sizeof(hb), &error);
+    }
+    return kRequests / elapsedSec(t0);
+}
+
+// --- 流水线：最多 depth 个请求在途，按发出顺序收取 ---
+double runPipelined(int conngplat, int depth, long *errors)
+{
+    gplat::Pipeline pipe(conngplat, depth);
+    std::vector<int> values(depth);
+    std::vector<gplat::PipelineResult> results(depth);
+    unsigned int error = 0;
+    *errors = 0;
+
+    auto t0 = Clock::now();
+    int issued = 0;
+    int done   = 0;
+    while (done < kRequests)
+    {
+        // 补满流水线；每个请求的结果写入各自的槽位
+        while (issued < kRequests && pipe.inflight() < depth)
+        {
+            if (pipe.readb("WATCHDOG", &values[issued % depth], sizeof(int)) == 0)
+            {
+                return 0;
+            }
+            ++issued;
+        }
+        int n = pipe.collectInOrder(results.data(), depth, 1000, &error);
+        if (n <= 0)
+        {
+            std::printf("collect failed, error=%u\n", error);
+            return 0;
+        }
+        for (int i = 0; i < n; ++i)
+        {
+            *errors += results[i].ok ? 0 : 1;
+        }
+        done += n;
+    }
+    return kRequests / elapsedSec(t0);
+}
+
+int main()
+{
+    int conngplat = connectgplat(kServer, kPort);
+    if (conngplat < 0)
+    {
+        std::printf("connectgplat failed\n");
+        return 1;
+    }
+    unsigned int error = 0;
+    int hb = 1;
+    writeb(conngplat, "WATCHDOG", &hb, sizeof(hb), &error); // 确保标签存在
+
+    std::printf("单连接 readb(WATCHDOG) %d 次\n\n", kRequests);
+    std::printf("%-14s %12s %10s %8s\n", "模式", "req/s", "相对同步", "错误");
+
+    double sync = runSync(conngplat);
+    std::printf("%-14s %12.0f %10.2f %8d\n", "同步", sync, 1.0, 0);
+
+    const int depths[] = {1, 2, 4, 8, 16, 32, 64, 128};
+    for (int depth : depths)
+    {
+        long errors = 0;
+        double rate = runPipelined(conngplat, depth, &errors);
+        char label[32];
+        std::snprintf(label, sizeof(label), "depth=%d", depth);
+        std::printf("%-14s %12.0f %10.2f %8ld\n", label, rate, rate / sync, errors);
+    }
+
+    disconnectgplat(conngplat);
+    std::printf("\nMain thread exit\n");
+    return 0;
+}
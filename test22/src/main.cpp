@@ -0,0 +1,156 @@
+// 1、强类型标签的零开销验证
+// 同一段读写循环分别用裸的 readb/writeb(void*, actsize) 与 gplat::Tag<T> 实现，
+// 交替运行多轮，比较每次调用的耗时：本地看板（ReadB/WriteB，没有网络开销，差异最容易暴露）
+// 和远程连接（readb/writeb）两种路径
+
+#include <algorithm> // 排序
+#include <chrono>    // 时间库
+#include <cstdio>    // C标准输入输出（printf）
+#include <vector>    // 动态数组
+
+#include "higplat.h"
+#include "gplat_tag.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kRounds      = 7;       // 交替运行的轮数，取中位数
+constexpr int kLocalOps    = 2000000; // 本地每轮次数
+constexpr int kRemoteOps   = 20000;   // 远程每轮次数
+
+const char *kBoard = "TAGBENCH";
+
+struct Sample
+{
+    double x;
+    double y;
+    double z;
+};
+
+constexpr gplat::Tag<int>    kCounter{"BENCH_COUNTER"};
+constexpr gplat::Tag<Sample> kSample{"BENCH_SAMPLE"};
+constexpr gplat::Tag<int>    kWatchdog{"WATCHDOG"};
+
+// 编译期检查示例，取消注释会编译失败：
+// constexpr gplat::Tag<std::string> kBad1{"BAD"};                                  // 不可平凡拷贝
+// constexpr gplat::Tag<int> kBad2{"A_TAG_NAME_LONGER_THAN_THIRTY_NINE_CHARACTERS"}; // 名称过长
+// kCounter.write(conngplat, 1.0, &error);                                        // double 不是 int
+
+double nsPerOp(Clock::time_point t0, int ops)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / ops;
+}
+
+double median(std::vector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+// --- 本地看板 ---
+double localRaw()
+{
+    int counter = 0;
+    Sample s{};
+    auto t0 = Clock::now();
+    for (int i = 0; i < kLocalOps; ++i)
+    {
+        ReadB(kBoard, "BENCH_COUNTER", &counter, sizeof(counter));
+        ++counter;
+        WriteB(kBoard, "BENCH_COUNTER", &counter, sizeof(counter));
+        ReadB(kBoard, "BENCH_SAMPLE", &s, sizeof(s));
+    }
+    return nsPerOp(t0, kLocalOps);
+}
+
+double localTag()
+{
+    int counter = 0;
+    Sample s{};
+    auto t0 = Clock::now();
+    for (int i = 0; i < kLocalOps; ++i)
+    {
+        kCounter.readLocal(kBoard, counter);
+        ++counter;
+        kCounter.writeLocal(kBoard, counter);
+        kSample.readLocal(kBoard, s);
+    }
+    return nsPerOp(t0, kLocalOps);
+}
+
+// --- 远程连接 ---
+double remoteRaw(int conngplat)
+{
+    unsigned int error = 0;
+    int hb = 0;
+    auto t0 = Clock::now();
+    for (int i = 0; i < kRemoteOps; ++i)
+    {
+        readb(conngplat, "WATCHDOG", &hb, sizeof(hb), &error);
+    }
+    return nsPerOp(t0, kRemoteOps);
+}
+
+double remoteTag(int conngplat)
+{
+    unsigned int error = 0;
+    int hb = 0;
+    auto t0 = Clock::now();
+    for (int i = 0; i < kRemoteOps; ++i)
+    {
+        kWatchdog.read(conngplat, hb, &error);
+    }
+    return nsPerOp(t0, kRemoteOps);
+}
+
+void report(const char *name, const std::vector<double> &raw, const std::vector<double> &tag)
+{
+    double r = median(raw);
+    double t = median(tag);
+    std::printf("%-8s 裸调用 %10.1f ns/op   Tag<T> %10.1f ns/op   差异 %+6.2f%%\n", name, r, t, (t - r) * 100.0 / r);
+}
+
+int main()
+{
+    std::printf("交替运行 %d 轮，取中位数\n\n", kRounds);
+
+    // 本地看板：建一个小看板和两个标签（已存在时创建失败，直接沿用）
+    CreateB(kBoard, 64 * 1024);
+    kCounter.createLocal(kBoard);
+    kSample.createLocal(kBoard);
+    int probe = 0;
+    if (kCounter.readLocal(kBoard, probe))
+    {
+        std::vector<double> raw, tag;
+        for (int i = 0; i < kRounds; ++i)
+        {
+            raw.push_back(localRaw());
+            tag.push_back(localTag());
+        }
+        report("本地", raw, tag);
+    }
+    else
+    {
+        std::printf("本地看板 %s 不可用，跳过本地测试\n", kBoard);
+    }
+
+    int conngplat = connectgplat("127.0.0.1", 8777);
+    if (conngplat < 0)
+    {
+        std::printf("connectgplat failed，跳过远程测试\n");
+        return 0;
+    }
+    unsigned int error = 0;
+    kWatchdog.write(conngplat, 1, &error); // 确保标签存在
+
+    std::vector<double> raw, tag;
+    for (int i = 0; i < kRounds; ++i)
+    {
+        raw.push_back(remoteRaw(conngplat));
+        tag.push_back(remoteTag(conngplat));
+    }
+    report("远程", raw, tag);
+    disconnectgplat(conngplat);
+
+    std::printf("\nMain thread exit\n");
+    return 0;
+}
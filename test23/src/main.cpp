@@ -0,0 +1,278 @@
+// 1、标签类型描述的客户端缓存
+// 一个带 16 个字段的结构体标签，分别用两种方式读值并解码全部字段：
+//   每次 readtype：READB 取值 + READTYPE 取类型 + 解析类型描述 + 按偏移解码
+//   缓存        ：readTyped()，READB 应答带回的类型戳与缓存一致时直接用编译好的布局解码
+// 交替运行多轮取中位数；另测纯本地的"解析 + 解码"与"缓存布局解码"，排除网络后的差异。
+// 最后删除并以另一类型重建标签，演示类型戳变化后缓存自动失效
+// 需要 gplat_server（或支持类型戳的 higplat 服务端），用法：test23 [服务端地址] [端口]
+
+#include <algorithm> // 排序
+#include <chrono>    // 时间库
+#include <cstddef>   // offsetof
+#include <cstdio>    // C标准输入输出（printf）
+#include <cstdlib>   // atoi
+#include <cstring>   // strlen / strcpy
+#include <vector>    // 动态数组
+
+#include "higplat.h"
+#include "gplat_typecache.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kRounds     = 5;       // 交替运行的轮数，取中位数
+constexpr int kRemoteOps  = 5000;    // 远程每轮次数
+constexpr int kLocalOps   = 200000;  // 本地每轮次数
+
+const char *kTag = "ROLL_DATA";
+
+// 与类型描述字段顺序一致的 C 结构体，写入时用
+struct RollData
+{
+    int       coil_id;
+    int       pass_no;
+    float     width;
+    float     thickness;
+    float     entry_temp;
+    float     exit_temp;
+    double    length;
+    double    weight;
+    short     stand;
+    short     mode;
+    char      grade[16];
+    char      operator_id[8];
+    float     roll_force[6];
+    float     roll_speed[6];
+    long long produced_at;
+    bool      cooling_on;
+};
+
+const char *kType =
+    "coil_id:int32;pass_no:int32;width:float;thickness:float;entry_temp:float;exit_temp:float;"
+    "length:double;weight:double;stand:short;mode:short;grade:char[16];operator_id:char[8];"
+    "roll_force:float[6];roll_speed:float[6];produced_at:int64;cooling_on:bool";
+
+// 重建时用的另一定义：同长度，字段含义不同
+const char *kTypeV2 =
+    "coil_id:int32;pass_no:int32;width:float;thickness:float;entry_temp:float;exit_temp:float;"
+    "length:double;weight:double;stand:short;mode:short;grade:char[16];operator_id:char[8];"
+    "roll_gap:float[6];roll_speed:float[6];produced_at:int64;cooling_on:bool";
+
+double nsPerOp(Clock::time_point t0, int ops)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / ops;
+}
+
+double median(std::vector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+// 解码全部字段（数值字段的全部元素求和，字符串字段取长度），防止被优化掉
+double decodeAll(const gplat::TypeLayout &layout, const char *value)
+{
+    double sum = 0;
+    for (int f = 0; f < static_cast<int>(layout.fields().size()); ++f)
+    {
+        const gplat::FieldDesc &d = layout.fields()[f];
+        if (d.kind == gplat::FieldKind::Char)
+        {
+            sum += static_cast<double>(layout.text(value, f).size());
+            continue;
+        }
+        for (int i = 0; i < d.count; ++i)
+        {
+            sum += layout.number(value, f, i);
+        }
+    }
+    return sum;
+}
+
+bool request(int fd, gplat::wire::FrameBuffer &rx, int id, int datasize, const void *body, int bodysize,
+             unsigned int *error)
+{
+    MSGHEAD head  = gplat::wire::makeHead(id, "", kTag);
+    head.datasize = datasize;
+    MSGHEAD reply;
+    if (!gplat::wire::call(fd, rx, head, body, bodysize, reply, nullptr, error))
+    {
+        return false;
+    }
+    *error = reply.error;
+    return gplat::wire::replyOk(reply);
+}
+
+// 删除后按 type 重建标签并写入一个样本值
+bool defineTag(int fd, gplat::wire::FrameBuffer &rx, const char *type)
+{
+    unsigned int error = 0;
+    request(fd, rx, DELETEITEM, 0, nullptr, 0, &error);
+    if (!request(fd, rx, CREATEITEM, sizeof(RollData), type, static_cast<int>(std::strlen(type)) + 1, &error))
+    {
+        std::printf("建标签 %s 失败，error = %u\n", kTag, error);
+        return false;
+    }
+    RollData v{};
+    v.coil_id = 240117;
+    v.pass_no = 5;
+    v.width   = 1250.5f;
+    v.length  = 812.25;
+    std::strcpy(v.grade, "Q235B");
+    std::strcpy(v.operator_id, "OP07");
+    for (int i = 0; i < 6; ++i)
+    {
+        v.roll_force[i] = 1800.0f + i;
+        v.roll_speed[i] = 3.5f + i * 0.1f;
+    }
+    return request(fd, rx, WRITEB, 0, &v, sizeof(v), &error);
+}
+
+// --- 远程 ---
+double remoteUncached(int fd, gplat::wire::FrameBuffer &rx, double &sink)
+{
+    std::vector<char> value;
+    std::vector<char> type;
+    gplat::TypeLayout layout;
+    unsigned int      error = 0;
+    MSGHEAD           reply;
+    auto t0 = Clock::now();
+    for (int i = 0; i < kRemoteOps; ++i)
+    {
+        MSGHEAD head = gplat::wire::makeHead(READB, "", kTag);
+        gplat::wire::call(fd, rx, head, nullptr, 0, reply, &value, &error);
+        head = gplat::wire::makeHead(READTYPE, "", kTag);
+        gplat::wire::call(fd, rx, head, nullptr, 0, reply, &type, &error);
+        gplat::compileFieldList(type.data(), static_cast<int>(type.size()), static_cast<int>(value.size()), layout,
+                                nullptr);
+        sink += decodeAll(layout, value.data());
+    }
+    return nsPerOp(t0, kRemoteOps);
+}
+
+double remoteCached(int fd, gplat::wire::FrameBuffer &rx, gplat::TypeCache &cache, double &sink)
+{
+    char         value[sizeof(RollData)];
+    unsigned int error = 0;
+    std::shared_ptr<const gplat::TypeLayout> layout;
+    auto t0 = Clock::now();
+    for (int i = 0; i < kRemoteOps; ++i)
+    {
+        gplat::readTyped(fd, rx, cache, kTag, value, sizeof(value), &layout, &error);
+        sink += decodeAll(*layout, value);
+    }
+    return nsPerOp(t0, kRemoteOps);
+}
+
+// --- 本地：只比较解析类型描述的开销 ---
+double localParse(const RollData &v, double &sink)
+{
+    gplat::TypeLayout layout;
+    int               typesize = static_cast<int>(std::strlen(kType)) + 1;
+    auto t0 = Clock::now();
+    for (int i = 0; i < kLocalOps; ++i)
+    {
+        gplat::compileFieldList(kType, typesize, sizeof(RollData), layout, nullptr);
+        sink += decodeAll(layout, reinterpret_cast<const char *>(&v));
+    }
+    return nsPerOp(t0, kLocalOps);
+}
+
+double localCached(const RollData &v, const gplat::TypeLayout &layout, double &sink)
+{
+    auto t0 = Clock::now();
+    for (int i = 0; i < kLocalOps; ++i)
+    {
+        char value[sizeof(RollData)];
+        std::memcpy(value, &v, sizeof(v));
+        sink += decodeAll(layout, value);
+    }
+    return nsPerOp(t0, kLocalOps);
+}
+
+void report(const char *name, const std::vector<double> &raw, const std::vector<double> &cached)
+{
+    double r = median(raw);
+    double c = median(cached);
+    std::printf("%-8s 每次解析 %10.1f ns/op   缓存 %10.1f ns/op   加速 %5.2fx\n", name, r, c, r / c);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *server = argc > 1 ? argv[1] : "127.0.0.1";
+    int         port   = argc > 2 ? std::atoi(argv[2]) : 8777;
+    double      sink   = 0;
+
+    std::printf("结构体 %zu 字节，类型描述 %zu 字节，交替运行 %d 轮，取中位数\n\n", sizeof(RollData),
+                std::strlen(kType) + 1, kRounds);
+
+    // 本地：解析 + 解码 与 缓存布局解码
+    gplat::TypeLayout layout;
+    std::string       msg;
+    if (!gplat::compileFieldList(kType, static_cast<int>(std::strlen(kType)) + 1, sizeof(RollData), layout, &msg))
+    {
+        std::printf("类型描述解析失败: %s\n", msg.c_str());
+        return 1;
+    }
+    if (layout.fields().back().offset != static_cast<int>(offsetof(RollData, cooling_on)))
+    {
+        std::printf("布局与 C 结构体不一致\n");
+        return 1;
+    }
+    RollData sample{};
+    sample.coil_id = 1;
+    {
+        std::vector<double> raw, cached;
+        for (int i = 0; i < kRounds; ++i)
+        {
+            raw.push_back(localParse(sample, sink));
+            cached.push_back(localCached(sample, layout, sink));
+        }
+        report("本地", raw, cached);
+    }
+
+    int fd = gplat::wire::connectTcp(server, port, false);
+    if (fd < 0)
+    {
+        std::printf("连接 %s:%d 失败，跳过远程测试\n", server, port);
+        return 0;
+    }
+    gplat::wire::FrameBuffer rx;
+    if (!defineTag(fd, rx, kType))
+    {
+        ::close(fd);
+        return 1;
+    }
+
+    gplat::TypeCache cache;
+    {
+        std::vector<double> raw, cached;
+        for (int i = 0; i < kRounds; ++i)
+        {
+            raw.push_back(remoteUncached(fd, rx, sink));
+            cached.push_back(remoteCached(fd, rx, cache, sink));
+        }
+        report("远程", raw, cached);
+    }
+
+    // 重定义标签：类型戳变化，下一次读值自动重新取类型
+    std::shared_ptr<const gplat::TypeLayout> current;
+    char         value[sizeof(RollData)];
+    unsigned int error = 0;
+    gplat::readTyped(fd, rx, cache, kTag, value, sizeof(value), &current, &error);
+    unsigned int stamp1 = current ? current->stamp() : 0;
+    defineTag(fd, rx, kTypeV2);
+    if (gplat::readTyped(fd, rx, cache, kTag, value, sizeof(value), &current, &error))
+    {
+        std::printf("\n重定义后：类型戳 %08x -> %08x，字段 12 = %s\n", stamp1, current->stamp(),
+                    current->fields()[12].name.c_str());
+    }
+
+    gplat::TypeCacheStats s = cache.stats();
+    std::printf("缓存命中 %llu，未缓存 %llu，失效 %llu，错误 %llu\n", static_cast<unsigned long long>(s.hits),
+                static_cast<unsigned long long>(s.misses), static_cast<unsigned long long>(s.invalidations),
+                static_cast<unsigned long long>(s.errors));
+    ::close(fd);
+
+    std::printf("\n(校验和 %.0f)\nMain thread exit\n", sink);
+    return 0;
+}
@@ -0,0 +1,126 @@
+// 1、字符串标签读写的堆分配次数
+// 替换全局 operator new 计数，对比同一连接上两组接口每次调用的分配次数和耗时：
+//   higplat：writeb_string2(std::string 按值) / readb_string2(std::string&，每次新建 std::string)
+//   gplat_string.h：writeb_string(std::string_view) / readb_string(调用方缓冲区) / readb_string(复用 std::string)
+// 标签名和字符串都超过 std::string 的短串长度（跟踪类标签的常见情况），按值传参必然分配
+
+#include <atomic>    // 原子计数
+#include <chrono>    // 时间库
+#include <cstdio>    // C标准输入输出（printf）
+#include <cstdlib>   // malloc / free
+#include <new>       // operator new
+#include <string>    // 字符串
+
+#include "higplat.h"
+#include "gplat_string.h"
+
+using Clock = std::chrono::steady_clock;
+
+// ============================================================
+//  分配计数
+// ============================================================
+static std::atomic<unsigned long long> g_allocs{0};
+
+void *operator new(std::size_t size)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+constexpr int kOps = 20000;
+
+const char *kTag = "TRACK_COIL_ID_ENTRY_STAND_01";
+
+struct Result
+{
+    double allocs; // 每次调用的分配次数
+    double ns;     // 每次调用的耗时
+};
+
+template <typename Fn>
+Result measure(Fn &&fn)
+{
+    fn(); // 预热：建标签、撑开复用的缓冲
+    unsigned long long a0 = g_allocs.load();
+    auto               t0 = Clock::now();
+    for (int i = 0; i < kOps; ++i)
+    {
+        fn();
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / kOps;
+    return Result{static_cast<double>(g_allocs.load() - a0) / kOps, ns};
+}
+
+void report(const char *name, const Result &r)
+{
+    std::printf("%-46s %8.2f 次分配/调用 %10.1f ns/op\n", name, r.allocs, r.ns);
+}
+
+int main()
+{
+    int conngplat = connectgplat("127.0.0.1", 8777);
+    if (conngplat < 0)
+    {
+        std::printf("connectgplat failed\n");
+        return 0;
+    }
+
+    unsigned int error = 0;
+    std::string  coil  = "C2024-117-0458-HSM2-PASS05"; // 26 个字符
+    long         sink  = 0;
+
+    std::printf("标签 %s，字符串 %zu 字节，每项 %d 次\n\n", kTag, coil.size(), kOps);
+
+    std::printf("--- 写 ---\n");
+    report("higplat writeb_string2(std::string 按值)", measure([&] {
+               writeb_string2(conngplat, kTag, coil, &error);
+           }));
+    report("gplat::writeb_string(std::string_view)", measure([&] {
+               gplat::writeb_string(conngplat, kTag, coil, &error);
+           }));
+
+    std::printf("\n--- 读 ---\n");
+    report("higplat readb_string2(每次新建 std::string)", measure([&] {
+               std::string value;
+               readb_string2(conngplat, kTag, value, &error);
+               sink += static_cast<long>(value.size());
+           }));
+    std::string reused;
+    report("higplat readb_string2(复用 std::string)", measure([&] {
+               readb_string2(conngplat, kTag, reused, &error);
+               sink += static_cast<long>(reused.size());
+           }));
+    report("gplat::readb_string(复用 std::string)", measure([&] {
+               gplat::readb_string(conngplat, kTag, reused, &error);
+               sink += static_cast<long>(reused.size());
+           }));
+    report("gplat::readb_string(调用方缓冲区)", measure([&] {
+               char buf[64];
+               int  len = 0;
+               gplat::readb_string(conngplat, kTag, buf, sizeof(buf), &len, &error);
+               sink += len;
+           }));
+
+    if (reused != coil)
+    {
+        std::printf("\n读回的值不一致: %s\n", reused.c_str());
+    }
+    disconnectgplat(conngplat);
+
+    std::printf("\n(校验和 %ld)\nMain thread exit\n", sink);
+    return 0;
+}
@@ -0,0 +1,175 @@
+// 1、由订阅保持一致的本地标签缓存
+// 几个工作线程反复读取同一批配置标签，分别用直接 readb（每次一次网络往返）和 gplat::TagCache（进程内存）实现，
+// 比较每次读的耗时；随后另一连接修改配置，测量缓存读到新值所需的时间，最后输出命中 / 未命中 / 过期等待统计
+// 用法：test25 [服务端地址] [端口]
+
+#include <atomic>    // 原子变量
+#include <chrono>    // 时间库
+#include <cstdio>    // C标准输入输出（printf）
+#include <cstdlib>   // atoi
+#include <cstring>   // strlen
+#include <string>    // 字符串
+#include <thread>    // 线程
+#include <vector>    // 动态数组
+
+#include "higplat.h"
+#include "gplat_tagcache.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kThreads    = 4;      // 读线程数
+constexpr int kConfigTags = 8;      // 配置标签数
+constexpr int kDirectOps  = 5000;   // 每线程直接 readb 次数
+constexpr int kCachedOps  = 2000000; // 每线程缓存读次数
+
+struct SpeedConfig
+{
+    double limit;
+    double accel;
+    int    version;
+    int    reserved;
+};
+
+const char *kConfigType = "limit:double;accel:double;version:int32;reserved:int32";
+
+std::string configTag(int i)
+{
+    return "CFG_SPEED_STAND_" + std::to_string(i);
+}
+
+// 每个线程各读 ops 次（轮流读全部配置标签），返回每次读的平均耗时
+template <typename Fn>
+double runThreads(int ops, Fn &&readOne)
+{
+    std::vector<std::thread> threads;
+    std::atomic<int>         ready{0};
+    std::atomic<bool>        go{false};
+    std::vector<double>      ns(kThreads);
+    for (int t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            std::vector<std::string> tags;
+            for (int i = 0; i < kConfigTags; ++i)
+            {
+                tags.push_back(configTag(i));
+            }
+            ready.fetch_add(1);
+            while (!go.load())
+            {
+                std::this_thread::yield();
+            }
+            auto t0 = Clock::now();
+            for (int i = 0; i < ops; ++i)
+            {
+                readOne(t, tags[i % kConfigTags].c_str());
+            }
+            ns[t] = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / ops;
+        });
+    }
+    while (ready.load() < kThreads)
+    {
+        std::this_thread::yield();
+    }
+    go.store(true);
+    for (auto &th : threads)
+    {
+        th.join();
+    }
+    double sum = 0;
+    for (double v : ns)
+    {
+        sum += v;
+    }
+    return sum / kThreads;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *server = argc > 1 ? argv[1] : "127.0.0.1";
+    int         port   = argc > 2 ? std::atoi(argv[2]) : 8777;
+
+    int writer = connectgplat(server, port);
+    if (writer < 0)
+    {
+        std::printf("connectgplat failed\n");
+        return 0;
+    }
+    unsigned int error = 0;
+    SpeedConfig  cfg{12.5, 0.8, 1, 0};
+    for (int i = 0; i < kConfigTags; ++i)
+    {
+        // 标签已存在时 createtag 失败，不影响后续写入
+        createtag(writer, configTag(i).c_str(), sizeof(cfg), const_cast<char *>(kConfigType),
+                  static_cast<int>(std::strlen(kConfigType)) + 1, &error);
+        writeb(writer, configTag(i).c_str(), &cfg, sizeof(cfg), &error);
+    }
+
+    // --- 直接 readb：每个线程一个连接 ---
+    std::vector<int> conns;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        conns.push_back(connectgplat(server, port));
+    }
+    double direct = runThreads(kDirectOps, [&](int t, const char *tag) {
+        SpeedConfig v;
+        unsigned int err = 0;
+        readb(conns[t], tag, &v, sizeof(v), &err);
+    });
+    for (int fd : conns)
+    {
+        disconnectgplat(fd);
+    }
+
+    // --- TagCache：全部线程共用一个缓存（一个订阅连接） ---
+    gplat::TagCacheOptions opt;
+    opt.server     = server;
+    opt.port       = port;
+    opt.max_age_ms = 500;
+    gplat::TagCache cache(opt);
+
+    std::atomic<long> failures{0};
+    double cached = runThreads(kCachedOps, [&](int, const char *tag) {
+        SpeedConfig v;
+        unsigned int err = 0;
+        if (!cache.read(tag, v, &err))
+        {
+            failures.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    std::printf("%d 个线程，%d 个配置标签\n", kThreads, kConfigTags);
+    std::printf("直接 readb      %10.1f ns/次\n", direct);
+    std::printf("TagCache        %10.1f ns/次（失败 %ld）\n", cached, failures.load());
+
+    // --- 修改配置，测缓存读到新值的时间 ---
+    cfg.version = 2;
+    cfg.limit   = 10.0;
+    auto t0     = Clock::now();
+    writeb(writer, configTag(0).c_str(), &cfg, sizeof(cfg), &error);
+    SpeedConfig seen{};
+    while (cache.read(configTag(0).c_str(), seen, &error) && seen.version != 2)
+    {
+        if (Clock::now() - t0 > std::chrono::seconds(2))
+        {
+            break;
+        }
+    }
+    double us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+    std::printf("写入后 %.1f us 缓存读到新值（version %d，limit %.1f）\n", us, seen.version, seen.limit);
+
+    // 不存在的标签：同样缓存"不存在"，之后的读不再访问服务端
+    SpeedConfig missing;
+    cache.read("CFG_NOT_DEFINED", missing, &error);
+    cache.read("CFG_NOT_DEFINED", missing, &error);
+    std::printf("读不存在的标签：error = %u\n", error);
+
+    gplat::TagCacheStats s = cache.stats();
+    std::printf("命中 %llu，未命中 %llu，过期等待 %llu，超时 %llu，推送 %llu，标签 %zu\n",
+                static_cast<unsigned long long>(s.hits), static_cast<unsigned long long>(s.misses),
+                static_cast<unsigned long long>(s.stale), static_cast<unsigned long long>(s.timeouts),
+                static_cast<unsigned long long>(s.posts), s.tags);
+
+    disconnectgplat(writer);
+    std::printf("\nMain thread exit\n");
+    return 0;
+}
@@ -0,0 +1,154 @@
+// 1、看板检查点与热重启
+// build：逐个 CREATEITEM + WRITEB 建 7000 个标签（相当于重启后由程序重建看板），再发 CHECKPOINTB 写检查点，
+//        比较两者耗时；
+// verify：重启服务端（checkpoint_dir 不变）后运行，逐个读回全部标签校验内容，服务端日志给出由映像恢复的耗时
+// 需要 gplat_server 且配置了 checkpoint_dir，用法：test26 [build|verify] [服务端地址] [端口]
+
+#include <chrono>    // 时间库
+#include <cstdio>    // C标准输入输出（printf）
+#include <cstdlib>   // atoi
+#include <cstring>   // strcmp / snprintf
+#include <vector>    // 动态数组
+
+#include "higplat.h"
+#include "gplat_wire.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kTags = 7000; // 默认看板最多 INDEXSIZE（7177）个标签
+
+// 每个标签 64 字节：测量值 + 质量码 + 序号 + 描述
+struct PlantTag
+{
+    double value;
+    int    quality;
+    int    index;
+    char   desc[48];
+};
+
+const char *kType = "value:double;quality:int32;index:int32;desc:char[48]";
+
+void tagName(int i, char *name, std::size_t n)
+{
+    std::snprintf(name, n, "PLANT_TAG_%05d", i);
+}
+
+PlantTag sampleValue(int i)
+{
+    PlantTag v{};
+    v.value   = i * 0.25;
+    v.quality = 192;
+    v.index   = i;
+    std::snprintf(v.desc, sizeof(v.desc), "stand %d sensor %d", i / 100, i % 100);
+    return v;
+}
+
+double msSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+bool request(int fd, gplat::wire::FrameBuffer &rx, int id, const char *tag, int datasize, const void *body,
+             int bodysize, MSGHEAD &reply, std::vector<char> *out, unsigned int *error)
+{
+    MSGHEAD head  = gplat::wire::makeHead(id, "", tag);
+    head.datasize = datasize;
+    if (!gplat::wire::call(fd, rx, head, body, bodysize, reply, out, error))
+    {
+        return false;
+    }
+    *error = reply.error;
+    return gplat::wire::replyOk(reply);
+}
+
+int build(int fd, gplat::wire::FrameBuffer &rx)
+{
+    MSGHEAD      reply;
+    unsigned int error = 0;
+    char         name[40];
+    int          typesize = static_cast<int>(std::strlen(kType)) + 1;
+
+    auto t0 = Clock::now();
+    for (int i = 0; i < kTags; ++i)
+    {
+        tagName(i, name, sizeof(name));
+        if (!request(fd, rx, CREATEITEM, name, sizeof(PlantTag), kType, typesize, reply, nullptr, &error) &&
+            error != ERROR_ITEM_ALREADY_EXIST)
+        {
+            std::printf("建标签 %s 失败，error = %u\n", name, error);
+            return 1;
+        }
+        PlantTag v = sampleValue(i);
+        if (!request(fd, rx, WRITEB, name, 0, &v, sizeof(v), reply, nullptr, &error))
+        {
+            std::printf("写标签 %s 失败，error = %u\n", name, error);
+            return 1;
+        }
+    }
+    double rebuild = msSince(t0);
+
+    t0 = Clock::now();
+    if (!request(fd, rx, CHECKPOINTB, "", 0, nullptr, 0, reply, nullptr, &error))
+    {
+        std::printf("CHECKPOINTB 失败，error = %u（服务端未配置 checkpoint_dir？）\n", error);
+        return 1;
+    }
+    double ckpt = msSince(t0);
+
+    std::printf("逐个建标签并写值：%d 个标签，%.1f ms\n", kTags, rebuild);
+    std::printf("写检查点        ：%d 个标签，映像 %d 字节，%.1f ms\n", reply.count, reply.datasize, ckpt);
+    std::printf("\n重启 gplat_server（checkpoint_dir 不变）后运行 test26 verify 校验，服务端日志给出恢复耗时\n");
+    return 0;
+}
+
+int verify(int fd, gplat::wire::FrameBuffer &rx)
+{
+    MSGHEAD           reply;
+    unsigned int      error = 0;
+    std::vector<char> out;
+    if (request(fd, rx, READBOARDINFO, "", 0, nullptr, 0, reply, &out, &error) && out.size() >= sizeof(BOARD_INFO))
+    {
+        BOARD_INFO info;
+        std::memcpy(&info, out.data(), sizeof(info));
+        std::printf("看板标签数 %d\n", info.tagcount_act);
+    }
+
+    char name[40];
+    int  bad = 0;
+    auto t0  = Clock::now();
+    for (int i = 0; i < kTags; ++i)
+    {
+        tagName(i, name, sizeof(name));
+        PlantTag expect = sampleValue(i);
+        if (!request(fd, rx, READB, name, sizeof(PlantTag), nullptr, 0, reply, &out, &error) ||
+            out.size() != sizeof(PlantTag) || std::memcmp(out.data(), &expect, sizeof(expect)) != 0)
+        {
+            if (bad++ < 5)
+            {
+                std::printf("标签 %s 不一致，error = %u\n", name, error);
+            }
+        }
+    }
+    std::printf("读回 %d 个标签，%.1f ms，不一致 %d 个\n", kTags, msSince(t0), bad);
+    return bad == 0 ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    bool        check  = argc > 1 && std::strcmp(argv[1], "verify") == 0;
+    const char *server = argc > 2 ? argv[2] : "127.0.0.1";
+    int         port   = argc > 3 ? std::atoi(argv[3]) : 8777;
+
+    int fd = gplat::wire::connectTcp(server, port, false);
+    if (fd < 0)
+    {
+        std::printf("连接 %s:%d 失败\n", server, port);
+        return 0;
+    }
+    gplat::wire::FrameBuffer rx;
+    int rc = check ? verify(fd, rx) : build(fd, rx);
+    ::close(fd);
+
+    std::printf("\nMain thread exit\n");
+    return rc;
+}
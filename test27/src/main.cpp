@@ -0,0 +1,179 @@
+// 1、大页映射的看板：随机读标签的延迟
+// 进程内直接用 gplat_store 建一块 7000 个标签、每个 16 KB 的看板（数据区约 110 MB），按随机顺序 readItem，
+// 分别以 4 KB 页、透明大页（THP）、hugetlb 大页映射，交替运行多轮取中位数。
+// 4 KB 页时每次读都落在不同的页上，TLB 放不下；2 MB 页时整个看板只占几十个 TLB 项。
+// hugetlb 需先预留大页（如 sysctl vm.nr_hugepages=128），不可用时自动退回透明大页，输出中给出实际方式
+// 用法：test27 [轮数]
+
+#include <algorithm> // 排序
+#include <chrono>    // 时间库
+#include <cstdio>    // C标准输入输出（printf）
+#include <cstdlib>   // atoi
+#include <random>    // 随机数
+#include <string>    // 字符串
+#include <vector>    // 动态数组
+
+#include "qbdstore.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kTags     = 7000;      // 默认看板最多 INDEXSIZE（7177）个标签
+constexpr int kItemSize = 16 * 1024; // 每个标签 16 KB（标签长度上限），相邻标签的起始地址必在不同的 4 KB 页上
+constexpr int kReads    = 1000000;   // 每轮随机读次数
+
+struct Mode
+{
+    const char     *name;
+    qbd::HugePages  pages;
+    const char     *board;
+};
+
+const char *backingName(qbd::HugePages p)
+{
+    switch (p)
+    {
+    case qbd::HugePages::Transparent:
+        return "透明大页";
+    case qbd::HugePages::Explicit:
+        return "hugetlb 大页";
+    default:
+        return "4 KB 页";
+    }
+}
+
+// 本进程的匿名透明大页总量（/proc/self/smaps_rollup），用来确认 THP 确实生效
+long anonHugeKb()
+{
+    long  kb = 0;
+    FILE *f  = std::fopen("/proc/self/smaps_rollup", "r");
+    if (f == nullptr)
+    {
+        return -1;
+    }
+    char line[128];
+    while (std::fgets(line, sizeof(line), f) != nullptr)
+    {
+        if (std::sscanf(line, "AnonHugePages: %ld kB", &kb) == 1)
+        {
+            break;
+        }
+    }
+    std::fclose(f);
+    return kb;
+}
+
+std::string tagName(int i)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "ROLL_STAND_%04d", i);
+    return name;
+}
+
+// 建看板并写满全部标签（同时把页面全部触碰一遍）
+bool buildBoard(const Mode &m)
+{
+    qbd::setHugePages(m.pages);
+    unsigned int error = 0;
+    if (!qbd::createBoard(m.board, kTags * kItemSize + (1 << 20), 1 << 20, &error))
+    {
+        std::printf("建看板 %s 失败，error = %u\n", m.board, error);
+        return false;
+    }
+    std::vector<char> value(kItemSize, 'x');
+    for (int i = 0; i < kTags; ++i)
+    {
+        std::string name = tagName(i);
+        if (!qbd::createItem(m.board, name.c_str(), kItemSize, nullptr, 0, &error) ||
+            !qbd::writeItem(m.board, name.c_str(), value.data(), kItemSize, nullptr, &error))
+        {
+            std::printf("建标签 %s 失败，error = %u\n", name.c_str(), error);
+            return false;
+        }
+    }
+    return true;
+}
+
+// 按给定的随机顺序读标签开头 16 字节，返回每次读的平均耗时
+double randomReads(const Mode &m, const std::vector<std::string> &names, const std::vector<int> &order, long &sink)
+{
+    char         buf[16];
+    unsigned int error = 0;
+    auto t0 = Clock::now();
+    for (int i : order)
+    {
+        qbd::readItem(m.board, names[i].c_str(), buf, sizeof(buf), nullptr, &error);
+        sink += buf[0];
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / order.size();
+}
+
+int main(int argc, char *argv[])
+{
+    int rounds = argc > 1 ? std::atoi(argv[1]) : 5;
+    if (rounds <= 0)
+    {
+        rounds = 5;
+    }
+
+    std::vector<Mode> modes = {
+        {"4 KB 页", qbd::HugePages::Off, "BOARD_4K"},
+        {"透明大页", qbd::HugePages::Transparent, "BOARD_THP"},
+        {"hugetlb", qbd::HugePages::Explicit, "BOARD_HUGETLB"},
+    };
+
+    std::vector<std::string> names;
+    for (int i = 0; i < kTags; ++i)
+    {
+        names.push_back(tagName(i));
+    }
+    std::mt19937     rng(20240117);
+    std::vector<int> order(kReads);
+    for (int &i : order)
+    {
+        i = static_cast<int>(rng() % kTags);
+    }
+
+    std::printf("%d 个标签 × %d KB，每轮随机读 %d 次，%d 轮取中位数\n\n", kTags, kItemSize / 1024, kReads, rounds);
+    for (const Mode &m : modes)
+    {
+        long before = anonHugeKb();
+        if (!buildBoard(m))
+        {
+            return 1;
+        }
+        qbd::MappingInfo info;
+        qbd::mappingInfo(m.board, &info);
+        long after = anonHugeKb();
+        std::printf("%-10s 实际映射：%s，%ld MB，匿名透明大页 +%ld MB\n", m.name, backingName(info.backing),
+                    info.size >> 20, (after - before) / 1024);
+    }
+    std::printf("\n");
+
+    // 交替运行，每轮轮换起始方式，减少 CPU 频率、缓存残留和其它进程对某一种方式的偏向
+    std::vector<std::vector<double>> ns(modes.size());
+    long sink = 0;
+    for (int r = 0; r < rounds; ++r)
+    {
+        for (std::size_t j = 0; j < modes.size(); ++j)
+        {
+            std::size_t k = (j + r) % modes.size();
+            ns[k].push_back(randomReads(modes[k], names, order, sink));
+        }
+    }
+
+    double base = 0;
+    for (std::size_t k = 0; k < modes.size(); ++k)
+    {
+        std::sort(ns[k].begin(), ns[k].end());
+        double med = ns[k][ns[k].size() / 2];
+        if (k == 0)
+        {
+            base = med;
+        }
+        std::printf("%-10s 随机读 %8.1f ns/次   相对 4 KB 页 %5.2fx\n", modes[k].name, med, base / med);
+    }
+
+    qbd::closeAll();
+    std::printf("\n(校验和 %ld)\nMain thread exit\n", sink);
+    return 0;
+}
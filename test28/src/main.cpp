@@ -0,0 +1,235 @@
+// 1、数据库表的二级索引
+// 建一张 20 万条的卷材跟踪表，分别以"服务端扫描全表"和"二级索引"两种方式 SELECTTB：
+//   按卷号等值查找（哈希索引）、按宽度范围查找（有序索引），比较每次查询的耗时；
+// 随后用 REFRESHTB 修改一条记录的卷号，确认索引随之更新
+// 需要 gplat_server，用法：test28 [服务端地址] [端口]
+
+#include <chrono>    // 时间库
+#include <cstdio>    // C标准输入输出（printf）
+#include <cstdlib>   // atoi
+#include <cstring>   // memcpy / snprintf
+#include <random>    // 随机数
+#include <vector>    // 动态数组
+
+#include "gplat_wire.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kRecords = 200000; // 表的记录数
+constexpr int kLookups = 2000;   // 每种方式的查询次数（扫描方式取其 1/20）
+
+const char *kTable = "COIL_TRACK";
+
+// 与类型描述同样字段顺序的 C 结构体，72 字节
+struct CoilRecord
+{
+    char   coilid[20];
+    int    status;
+    float  width;
+    double weight;
+    int    stand;
+    float  temps[6];
+};
+
+const char *kType = "coilid:char[20];status:int32;width:float;weight:double;stand:int32;temps:float[6]";
+
+CoilRecord sampleRecord(int i)
+{
+    CoilRecord r{};
+    std::snprintf(r.coilid, sizeof(r.coilid), "C2024-%07d", i);
+    r.status = i % 5;
+    r.width  = 900.0f + static_cast<float>(i % 10000) * 0.1f; // 900.0 ~ 1899.9 mm
+    r.weight = 18.0 + (i % 97) * 0.25;
+    r.stand  = i % 7;
+    return r;
+}
+
+double usSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+}
+
+bool request(int fd, gplat::wire::FrameBuffer &rx, MSGHEAD head, const void *body, int bodysize, MSGHEAD &reply,
+             std::vector<char> *out, unsigned int *error)
+{
+    if (!gplat::wire::call(fd, rx, head, body, bodysize, reply, out, error))
+    {
+        return false;
+    }
+    *error = reply.error;
+    return gplat::wire::replyOk(reply);
+}
+
+// 按键 SELECTTB：index 为空时由服务端扫描全表。返回本页条数，rows 为行号
+int selectKey(int fd, gplat::wire::FrameBuffer &rx, const char *index, const char *field, const void *lo,
+              const void *hi, int keysize, std::vector<int> &rows, unsigned int *error)
+{
+    TBKEY key;
+    std::memset(&key, 0, sizeof(key));
+    std::snprintf(key.index, sizeof(key.index), "%s", index);
+    std::snprintf(key.field, sizeof(key.field), "%s", field);
+    key.flags   = TBSEL_ROWIDS | (hi != nullptr ? TBSEL_RANGE : 0);
+    key.keysize = keysize;
+
+    std::vector<char> body(sizeof(key) + keysize * 2);
+    std::memcpy(body.data(), &key, sizeof(key));
+    std::memcpy(body.data() + sizeof(key), lo, keysize);
+    if (hi != nullptr)
+    {
+        std::memcpy(body.data() + sizeof(key) + keysize, hi, keysize);
+    }
+
+    MSGHEAD           head = gplat::wire::makeHead(SELECTTB, "", kTable);
+    MSGHEAD           reply;
+    std::vector<char> out;
+    if (!request(fd, rx, head, body.data(), static_cast<int>(body.size()), reply, &out, error))
+    {
+        return -1;
+    }
+    rows.resize(reply.count);
+    std::memcpy(rows.data(), out.data(), sizeof(int) * reply.count);
+    return reply.count;
+}
+
+bool createIndex(int fd, gplat::wire::FrameBuffer &rx, const char *name, const char *field, int kind,
+                 unsigned int *error)
+{
+    TBINDEX spec;
+    std::memset(&spec, 0, sizeof(spec));
+    std::snprintf(spec.name, sizeof(spec.name), "%s", name);
+    std::snprintf(spec.field, sizeof(spec.field), "%s", field);
+    spec.kind = kind;
+
+    MSGHEAD head = gplat::wire::makeHead(CREATEINDEX, "", kTable);
+    MSGHEAD reply;
+    auto    t0 = Clock::now();
+    if (!request(fd, rx, head, &spec, sizeof(spec), reply, nullptr, error))
+    {
+        std::printf("建索引 %s 失败，error = %u\n", name, *error);
+        return false;
+    }
+    std::printf("建索引 %-10s（%s）：%d 条记录，%.1f ms\n", name, kind == TBIDX_HASH ? "哈希" : "有序", reply.count,
+                usSince(t0) / 1000);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *server = argc > 1 ? argv[1] : "127.0.0.1";
+    int         port   = argc > 2 ? std::atoi(argv[2]) : 8777;
+
+    int fd = gplat::wire::connectTcp(server, port, false);
+    if (fd < 0)
+    {
+        std::printf("连接 %s:%d 失败\n", server, port);
+        return 0;
+    }
+    gplat::wire::FrameBuffer rx;
+    MSGHEAD                  reply;
+    unsigned int             error = 0;
+
+    // --- 建表并插入记录（重复运行时先删除上次的表） ---
+    request(fd, rx, gplat::wire::makeHead(DELETETABLE, "", kTable), nullptr, 0, reply, nullptr, &error);
+    MSGHEAD head = gplat::wire::makeHead(CREATETABLE, "", kTable);
+    head.recsize = sizeof(CoilRecord);
+    head.count   = kRecords;
+    if (!request(fd, rx, head, kType, static_cast<int>(std::strlen(kType)) + 1, reply, nullptr, &error))
+    {
+        std::printf("建表失败，error = %u（数据库空间不足时调大 database_size）\n", error);
+        return 1;
+    }
+    constexpr int           kBatch = MAXMSGLEN / sizeof(CoilRecord);
+    std::vector<CoilRecord> batch;
+    auto                    t0 = Clock::now();
+    for (int i = 0; i < kRecords; i += kBatch)
+    {
+        batch.clear();
+        for (int j = i; j < kRecords && j < i + kBatch; ++j)
+        {
+            batch.push_back(sampleRecord(j));
+        }
+        if (!request(fd, rx, gplat::wire::makeHead(INSERTTB, "", kTable), batch.data(),
+                     static_cast<int>(batch.size() * sizeof(CoilRecord)), reply, nullptr, &error))
+        {
+            std::printf("插入失败，error = %u\n", error);
+            return 1;
+        }
+    }
+    std::printf("插入 %d 条记录（每条 %zu 字节），%.1f ms\n\n", kRecords, sizeof(CoilRecord), usSince(t0) / 1000);
+
+    std::mt19937     rng(20240117);
+    std::vector<int> probes(kLookups);
+    for (int &p : probes)
+    {
+        p = static_cast<int>(rng() % kRecords);
+    }
+    std::vector<int> rows;
+
+    // 卷号等值查找，返回每次查询的平均耗时（us），找错时 bad 加 1
+    auto lookupIds = [&](const char *index, int count, int &bad) {
+        auto t = Clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            CoilRecord r = sampleRecord(probes[i]);
+            if (selectKey(fd, rx, index, "coilid", r.coilid, nullptr, static_cast<int>(std::strlen(r.coilid)), rows,
+                          &error) != 1 ||
+                rows[0] != probes[i])
+            {
+                ++bad;
+            }
+        }
+        return usSince(t) / count;
+    };
+    // 宽度范围查找 [w, w + 0.25]：每个 0.1 mm 档约 20 条，范围内约 60 条
+    auto lookupWidths = [&](const char *index, int count, long &matches) {
+        auto t = Clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            float lo = 900.0f + static_cast<float>(probes[i] % 9990) * 0.1f;
+            float hi = lo + 0.25f;
+            int   n  = selectKey(fd, rx, index, "width", &lo, &hi, sizeof(float), rows, &error);
+            matches += n > 0 ? n : 0;
+        }
+        return usSince(t) / count;
+    };
+
+    int  badScan = 0, badHash = 0;
+    long rangeScan = 0, rangeOrdered = 0;
+    int  scanCount = kLookups / 20;
+
+    double idScan    = lookupIds("", scanCount, badScan);
+    double widthScan = lookupWidths("", scanCount, rangeScan);
+
+    if (!createIndex(fd, rx, "by_coilid", "coilid", TBIDX_HASH, &error) ||
+        !createIndex(fd, rx, "by_width", "width", TBIDX_ORDERED, &error))
+    {
+        return 1;
+    }
+    double idHash       = lookupIds("by_coilid", kLookups, badHash);
+    double widthOrdered = lookupWidths("by_width", scanCount, rangeOrdered);
+
+    std::printf("\n按卷号等值查找：扫描 %9.1f us/次   哈希索引 %7.1f us/次   %.0fx（找错 %d / %d）\n", idScan, idHash,
+                idScan / idHash, badScan, badHash);
+    std::printf("按宽度范围查找：扫描 %9.1f us/次   有序索引 %7.1f us/次   %.0fx（匹配 %ld / %ld 条）\n", widthScan,
+                widthOrdered, widthScan / widthOrdered, rangeScan, rangeOrdered);
+
+    // --- 更新记录的卷号，索引随之更新 ---
+    int        row = probes[0];
+    CoilRecord r   = sampleRecord(row);
+    std::snprintf(r.coilid, sizeof(r.coilid), "C2025-RENAMED");
+    head       = gplat::wire::makeHead(REFRESHTB, "", kTable);
+    head.start = row;
+    request(fd, rx, head, &r, sizeof(r), reply, nullptr, &error);
+    CoilRecord old = sampleRecord(row);
+    int nNew = selectKey(fd, rx, "by_coilid", "", r.coilid, nullptr, static_cast<int>(std::strlen(r.coilid)), rows,
+                         &error);
+    bool newOk = nNew == 1 && rows[0] == row;
+    int  nOld  = selectKey(fd, rx, "by_coilid", "", old.coilid, nullptr, static_cast<int>(std::strlen(old.coilid)),
+                           rows, &error);
+    std::printf("\n第 %d 行改为 %s：新卷号查到 %s，旧卷号查到 %d 条\n", row, r.coilid, newOk ? "该行" : "错误结果",
+                nOld);
+
+    ::close(fd);
+    std::printf("\nMain thread exit\n");
+    return badScan == 0 && badHash == 0 && newOk && nOld == 0 && rangeScan == rangeOrdered ? 0 : 1;
+}
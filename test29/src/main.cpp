@@ -0,0 +1,253 @@
+// 1、数据库表的谓词扫描
+// 建一张 100 万条的卷材跟踪表，按"状态 = 3 且宽度 > 1800"、"重量在 [40, 42] 内且机架 >= 5"两个条件筛选记录：
+//   客户端方式：SELECTTB 分页把整表读回客户端再逐条判断；
+//   服务端方式：SCANTB 把谓词交给服务端，只返回匹配的行号；
+// 两种方式各运行多轮取中位数，并核对匹配的行号一致
+// 需要 gplat_server（database_size 不小于 64 MB），用法：test29 [服务端地址] [端口] [轮数]
+
+#include <algorithm> // 排序
+#include <chrono>    // 时间库
+#include <cstdio>    // C标准输入输出（printf）
+#include <cstdlib>   // atoi
+#include <cstring>   // memcpy / snprintf
+#include <vector>    // 动态数组
+
+#include "gplat_wire.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kRecords = 1000000; // 表的记录数
+
+const char *kTable = "COIL_SCAN";
+
+// 与类型描述同样字段顺序的 C 结构体，48 字节
+struct CoilRecord
+{
+    char   coilid[16];
+    int    status;
+    float  width;
+    float  thickness;
+    int    grade;
+    double weight;
+    int    stand;
+    int    reserved;
+};
+
+const char *kType =
+    "coilid:char[16];status:int32;width:float;thickness:float;grade:int32;weight:double;stand:int32;reserved:int32";
+
+CoilRecord sampleRecord(int i)
+{
+    CoilRecord r{};
+    std::snprintf(r.coilid, sizeof(r.coilid), "C%07d", i);
+    r.status    = i % 5;
+    r.width     = 900.0f + static_cast<float>((i * 7919) % 10000) * 0.1f; // 900.0 ~ 1899.9 mm
+    r.thickness = 1.5f + static_cast<float>(i % 300) * 0.01f;
+    r.grade     = i % 40;
+    r.weight    = 18.0 + (i % 97) * 0.25;
+    r.stand     = i % 7;
+    return r;
+}
+
+// 查询条件：客户端判断用 match，服务端用 preds
+struct Query
+{
+    const char          *name;
+    bool               (*match)(const CoilRecord &);
+    std::vector<TBPRED> preds;
+};
+
+TBPRED makePred(const char *field, int keytype, int op, const void *value, const void *value2, int size)
+{
+    TBPRED p;
+    std::memset(&p, 0, sizeof(p));
+    std::snprintf(p.field, sizeof(p.field), "%s", field);
+    p.keytype = keytype;
+    p.op      = op;
+    std::memcpy(p.value, value, size);
+    if (value2 != nullptr)
+    {
+        std::memcpy(p.value2, value2, size);
+    }
+    return p;
+}
+
+double msSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+bool request(int fd, gplat::wire::FrameBuffer &rx, MSGHEAD head, const void *body, int bodysize, MSGHEAD &reply,
+             std::vector<char> *out, unsigned int *error)
+{
+    if (!gplat::wire::call(fd, rx, head, body, bodysize, reply, out, error))
+    {
+        return false;
+    }
+    *error = reply.error;
+    return gplat::wire::replyOk(reply);
+}
+
+// 客户端方式：分页读回全部记录后逐条判断
+bool clientScan(int fd, gplat::wire::FrameBuffer &rx, const Query &q, std::vector<int> &rows, unsigned int *error)
+{
+    rows.clear();
+    constexpr int     kPage = MAXMSGLEN / sizeof(CoilRecord);
+    MSGHEAD           reply;
+    std::vector<char> out;
+    for (int start = 0; start < kRecords; start += kPage)
+    {
+        MSGHEAD head = gplat::wire::makeHead(SELECTTB, "", kTable);
+        head.start   = start;
+        head.count   = kPage;
+        if (!request(fd, rx, head, nullptr, 0, reply, &out, error))
+        {
+            return false;
+        }
+        for (int i = 0; i < reply.count; ++i)
+        {
+            CoilRecord r;
+            std::memcpy(&r, out.data() + i * sizeof(CoilRecord), sizeof(r));
+            if (q.match(r))
+            {
+                rows.push_back(start + i);
+            }
+        }
+    }
+    return true;
+}
+
+// 服务端方式：SCANTB 只取行号，按应答的 head.start 续扫到表尾
+bool serverScan(int fd, gplat::wire::FrameBuffer &rx, const Query &q, std::vector<int> &rows, unsigned int *error)
+{
+    rows.clear();
+    TBSCAN scan;
+    std::memset(&scan, 0, sizeof(scan));
+    scan.npred = static_cast<int>(q.preds.size());
+    scan.flags = TBSEL_ROWIDS;
+    std::vector<char> body(sizeof(scan) + sizeof(TBPRED) * q.preds.size());
+    std::memcpy(body.data(), &scan, sizeof(scan));
+    std::memcpy(body.data() + sizeof(scan), q.preds.data(), sizeof(TBPRED) * q.preds.size());
+
+    MSGHEAD           reply;
+    std::vector<char> out;
+    int               start = 0;
+    do
+    {
+        MSGHEAD head = gplat::wire::makeHead(SCANTB, "", kTable);
+        head.start   = start;
+        if (!request(fd, rx, head, body.data(), static_cast<int>(body.size()), reply, &out, error))
+        {
+            return false;
+        }
+        std::size_t old = rows.size();
+        rows.resize(old + reply.count);
+        std::memcpy(rows.data() + old, out.data(), sizeof(int) * reply.count);
+        start = reply.start;
+    } while (reply.readptr != 0);
+    return true;
+}
+
+double median(std::vector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+int main(int argc, char *argv[])
+{
+    const char *server = argc > 1 ? argv[1] : "127.0.0.1";
+    int         port   = argc > 2 ? std::atoi(argv[2]) : 8777;
+    int         rounds = argc > 3 ? std::atoi(argv[3]) : 5;
+    if (rounds <= 0)
+    {
+        rounds = 5;
+    }
+
+    int fd = gplat::wire::connectTcp(server, port, false);
+    if (fd < 0)
+    {
+        std::printf("连接 %s:%d 失败\n", server, port);
+        return 0;
+    }
+    gplat::wire::FrameBuffer rx;
+    MSGHEAD                  reply;
+    unsigned int             error = 0;
+
+    // --- 建表并插入记录（重复运行时先删除上次的表） ---
+    request(fd, rx, gplat::wire::makeHead(DELETETABLE, "", kTable), nullptr, 0, reply, nullptr, &error);
+    MSGHEAD head = gplat::wire::makeHead(CREATETABLE, "", kTable);
+    head.recsize = sizeof(CoilRecord);
+    head.count   = kRecords;
+    if (!request(fd, rx, head, kType, static_cast<int>(std::strlen(kType)) + 1, reply, nullptr, &error))
+    {
+        std::printf("建表失败，error = %u（数据库空间不足时调大 database_size）\n", error);
+        return 1;
+    }
+    constexpr int           kBatch = MAXMSGLEN / sizeof(CoilRecord);
+    std::vector<CoilRecord> batch;
+    auto                    t0 = Clock::now();
+    for (int i = 0; i < kRecords; i += kBatch)
+    {
+        batch.clear();
+        for (int j = i; j < kRecords && j < i + kBatch; ++j)
+        {
+            batch.push_back(sampleRecord(j));
+        }
+        if (!request(fd, rx, gplat::wire::makeHead(INSERTTB, "", kTable), batch.data(),
+                     static_cast<int>(batch.size() * sizeof(CoilRecord)), reply, nullptr, &error))
+        {
+            std::printf("插入失败，error = %u\n", error);
+            return 1;
+        }
+    }
+    std::printf("插入 %d 条记录（每条 %zu 字节），%.1f ms\n\n", kRecords, sizeof(CoilRecord), msSince(t0));
+
+    int    status = 3, stand = 5;
+    float  width = 1800.0f;
+    double wlo = 40.0, whi = 42.0;
+
+    std::vector<Query> queries(2);
+    queries[0].name  = "状态 = 3 且宽度 > 1800";
+    queries[0].match = [](const CoilRecord &r) { return r.status == 3 && r.width > 1800.0f; };
+    queries[0].preds = {makePred("status", TBKEY_INT, TBOP_EQ, &status, nullptr, sizeof(status)),
+                        makePred("width", TBKEY_FLOAT, TBOP_GT, &width, nullptr, sizeof(width))};
+    queries[1].name  = "重量在 [40, 42] 内且机架 >= 5";
+    queries[1].match = [](const CoilRecord &r) { return r.weight >= 40.0 && r.weight <= 42.0 && r.stand >= 5; };
+    queries[1].preds = {makePred("weight", TBKEY_FLOAT, TBOP_BETWEEN, &wlo, &whi, sizeof(wlo)),
+                        makePred("stand", TBKEY_INT, TBOP_GE, &stand, nullptr, sizeof(stand))};
+
+    bool allSame = true;
+    for (const Query &q : queries)
+    {
+        std::vector<double> client, scan;
+        std::vector<int>    rowsClient, rowsScan;
+        for (int r = 0; r < rounds; ++r)
+        {
+            auto t = Clock::now();
+            if (!clientScan(fd, rx, q, rowsClient, &error))
+            {
+                std::printf("SELECTTB 失败，error = %u\n", error);
+                return 1;
+            }
+            client.push_back(msSince(t));
+            t = Clock::now();
+            if (!serverScan(fd, rx, q, rowsScan, &error))
+            {
+                std::printf("SCANTB 失败，error = %u\n", error);
+                return 1;
+            }
+            scan.push_back(msSince(t));
+        }
+        bool same = rowsClient == rowsScan;
+        allSame   = allSame && same;
+        std::printf("%s：匹配 %zu 条%s\n", q.name, rowsClient.size(), same ? "" : "（两种方式结果不一致）");
+        std::printf("  客户端分页读回判断 %8.2f ms\n", median(client));
+        std::printf("  SCANTB 服务端扫描  %8.2f ms   %5.1fx\n\n", median(scan), median(client) / median(scan));
+    }
+
+    request(fd, rx, gplat::wire::makeHead(DELETETABLE, "", kTable), nullptr, 0, reply, nullptr, &error);
+    ::close(fd);
+    std::printf("Main thread exit\n");
+    return allSame ? 0 : 1;
+}
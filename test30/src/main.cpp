@@ -0,0 +1,265 @@
+// 1、数据库表的快照读
+// 一张 20 万条的库位表，写线程不断在相隔不远的两个库位间倒运钢卷（一次 REFRESHTB 改写两库位之间的各行，总重量不变）；
+// 读线程分页 SELECTTB 读完整张表并累加总重量（每页模拟一段处理时间）：
+//   不用快照时各页读到的是不同时刻的内容，倒运的两个库位分处已读、未读两侧时总重量对不上；
+//   用快照（OPENSNAPSHOT）时读到的是打开时刻的一致内容，总重量与初始值相同，读的同时写线程照常写入。
+// 最后用 SCANTB 在快照上统计，确认关闭快照前后结果一致
+// 需要 gplat_server，用法：test30 [服务端地址] [端口] [轮数]
+
+#include <algorithm> // max
+#include <atomic>    // 原子变量
+#include <chrono>    // 时间库
+#include <cstdio>    // C标准输入输出（printf）
+#include <cstdlib>   // atoi
+#include <cstring>   // memcpy / snprintf
+#include <thread>    // 线程
+#include <vector>    // 动态数组
+
+#include "gplat_wire.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int       kSlots     = 200000; // 库位数
+constexpr long long kWeight    = 25000;  // 每个库位的初始重量（kg）
+constexpr int       kProcessUs = 500;    // 读线程每页的处理时间
+
+const char *kTable = "YARD_SLOT";
+
+// 与类型描述同样字段顺序的 C 结构体，48 字节
+struct YardSlot
+{
+    char      location[16];
+    int       coils;
+    int       reserved;
+    long long weight; // kg
+    double    temps[2];
+};
+
+constexpr int kPage = MAXMSGLEN / sizeof(YardSlot); // 每次读写的最多条数
+
+const char *kType = "location:char[16];coils:int32;reserved:int32;weight:int64;temps:double[2]";
+
+bool request(int fd, gplat::wire::FrameBuffer &rx, MSGHEAD head, const void *body, int bodysize, MSGHEAD &reply,
+             std::vector<char> *out, unsigned int *error)
+{
+    if (!gplat::wire::call(fd, rx, head, body, bodysize, reply, out, error))
+    {
+        return false;
+    }
+    *error = reply.error;
+    return gplat::wire::replyOk(reply);
+}
+
+double msSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// 分页读完整张表，返回总重量；snapshot 为 0 时读当前内容
+bool sumWeights(int fd, gplat::wire::FrameBuffer &rx, int snapshot, long long &total, unsigned int *error)
+{
+    MSGHEAD           reply;
+    std::vector<char> out;
+    total = 0;
+    for (int start = 0; start < kSlots; start += kPage)
+    {
+        MSGHEAD head  = gplat::wire::makeHead(SELECTTB, "", kTable);
+        head.start    = start;
+        head.count    = kPage;
+        head.writeptr = snapshot;
+        if (!request(fd, rx, head, nullptr, 0, reply, &out, error))
+        {
+            return false;
+        }
+        for (int i = 0; i < reply.count; ++i)
+        {
+            YardSlot s;
+            std::memcpy(&s, out.data() + i * sizeof(YardSlot), sizeof(s));
+            total += s.weight;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(kProcessUs));
+    }
+    return true;
+}
+
+// 在快照（或当前内容）上 SCANTB 统计重量大于 kWeight 的库位数
+int countHeavy(int fd, gplat::wire::FrameBuffer &rx, int snapshot, unsigned int *error)
+{
+    struct
+    {
+        TBSCAN scan;
+        TBPRED pred;
+    } body;
+    std::memset(&body, 0, sizeof(body));
+    body.scan.npred = 1;
+    body.scan.flags = TBSEL_ROWIDS;
+    std::snprintf(body.pred.field, sizeof(body.pred.field), "weight");
+    body.pred.op = TBOP_GT;
+    std::memcpy(body.pred.value, &kWeight, sizeof(kWeight));
+
+    MSGHEAD           reply;
+    std::vector<char> out;
+    int               count = 0;
+    int               start = 0;
+    do
+    {
+        MSGHEAD head  = gplat::wire::makeHead(SCANTB, "", kTable);
+        head.start    = start;
+        head.writeptr = snapshot;
+        if (!request(fd, rx, head, &body, sizeof(body), reply, &out, error))
+        {
+            return -1;
+        }
+        count += reply.count;
+        start = reply.start;
+    } while (reply.readptr != 0);
+    return count;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *server = argc > 1 ? argv[1] : "127.0.0.1";
+    int         port   = argc > 2 ? std::atoi(argv[2]) : 8777;
+    int         rounds = argc > 3 ? std::atoi(argv[3]) : 3;
+    if (rounds <= 0)
+    {
+        rounds = 3;
+    }
+
+    int fd = gplat::wire::connectTcp(server, port, false);
+    if (fd < 0)
+    {
+        std::printf("连接 %s:%d 失败\n", server, port);
+        return 0;
+    }
+    gplat::wire::FrameBuffer rx;
+    MSGHEAD                  reply;
+    unsigned int             error = 0;
+
+    // --- 建表并插入记录（重复运行时先删除上次的表） ---
+    request(fd, rx, gplat::wire::makeHead(DELETETABLE, "", kTable), nullptr, 0, reply, nullptr, &error);
+    MSGHEAD head = gplat::wire::makeHead(CREATETABLE, "", kTable);
+    head.recsize = sizeof(YardSlot);
+    head.count   = kSlots;
+    if (!request(fd, rx, head, kType, static_cast<int>(std::strlen(kType)) + 1, reply, nullptr, &error))
+    {
+        std::printf("建表失败，error = %u（数据库空间不足时调大 database_size）\n", error);
+        return 1;
+    }
+    std::vector<YardSlot> batch;
+    for (int i = 0; i < kSlots; i += kPage)
+    {
+        batch.clear();
+        for (int j = i; j < kSlots && j < i + kPage; ++j)
+        {
+            YardSlot s{};
+            std::snprintf(s.location, sizeof(s.location), "Y%02d-%05d", j / 10000, j % 10000);
+            s.coils  = 1;
+            s.weight = kWeight;
+            batch.push_back(s);
+        }
+        request(fd, rx, gplat::wire::makeHead(INSERTTB, "", kTable), batch.data(),
+                static_cast<int>(batch.size() * sizeof(YardSlot)), reply, nullptr, &error);
+    }
+    const long long expected = kWeight * kSlots;
+
+    // --- 写线程：从库位 row 倒运到 row + span - 1，一次 REFRESHTB 改写其间的各行 ---
+    std::atomic<bool> stop{false};
+    std::atomic<long> moves{0};
+    std::atomic<long> worstUs{0};
+    std::thread       writer([&] {
+        int                      wfd = gplat::wire::connectTcp(server, port, false);
+        gplat::wire::FrameBuffer wrx;
+        MSGHEAD                  wreply;
+        unsigned int             werr = 0;
+        std::vector<char>        out;
+        unsigned int             seed = 20240117;
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            seed     = seed * 1103515245 + 12345;
+            int span = 2 + static_cast<int>(seed % (kPage - 1));
+            int row  = static_cast<int>((seed >> 8) % (kSlots - span + 1));
+
+            MSGHEAD read = gplat::wire::makeHead(SELECTTB, "", kTable);
+            read.start   = row;
+            read.count   = span;
+            if (!request(wfd, wrx, read, nullptr, 0, wreply, &out, &werr) || wreply.count != span)
+            {
+                break;
+            }
+            std::vector<YardSlot> range(span);
+            std::memcpy(range.data(), out.data(), sizeof(YardSlot) * span);
+            long long amount = std::min<long long>(range[0].weight, 1000 + seed % 5000);
+            range[0].weight -= amount;
+            range[span - 1].weight += amount;
+
+            MSGHEAD write = gplat::wire::makeHead(REFRESHTB, "", kTable);
+            write.start   = row;
+            auto t        = Clock::now();
+            request(wfd, wrx, write, range.data(), static_cast<int>(sizeof(YardSlot) * span), wreply, nullptr,
+                    &werr);
+            long us = static_cast<long>(msSince(t) * 1000);
+            if (us > worstUs.load(std::memory_order_relaxed))
+            {
+                worstUs.store(us, std::memory_order_relaxed);
+            }
+            moves.fetch_add(1, std::memory_order_relaxed);
+        }
+        ::close(wfd);
+    });
+
+    std::printf("%d 个库位，总重量 %lld kg；写线程持续倒运，读线程每轮分页读完整张表\n\n", kSlots, expected);
+    int badPlain = 0, badSnap = 0;
+    for (int r = 0; r < rounds; ++r)
+    {
+        long long total = 0;
+        long      m0    = moves.load();
+        auto      t     = Clock::now();
+        sumWeights(fd, rx, 0, total, &error);
+        badPlain += total != expected;
+        std::printf("不用快照  第 %d 轮：%7.1f ms，期间倒运 %5ld 次，总重量偏差 %+lld kg\n", r + 1, msSince(t),
+                    moves.load() - m0, total - expected);
+    }
+    std::printf("\n");
+    int heavyOpen = 0, heavyLater = 0;
+    for (int r = 0; r < rounds; ++r)
+    {
+        auto    t    = Clock::now();
+        MSGHEAD open = gplat::wire::makeHead(OPENSNAPSHOT, "", kTable);
+        if (!request(fd, rx, open, nullptr, 0, reply, nullptr, &error))
+        {
+            std::printf("OPENSNAPSHOT 失败，error = %u\n", error);
+            break;
+        }
+        int       snap  = reply.writeptr;
+        long long total = 0;
+        long      m0    = moves.load();
+        sumWeights(fd, rx, snap, total, &error);
+        badSnap += total != expected;
+        std::printf("快照 %2d   第 %d 轮：%7.1f ms，期间倒运 %5ld 次，总重量偏差 %+lld kg\n", snap, r + 1, msSince(t),
+                    moves.load() - m0, total - expected);
+        if (r == rounds - 1)
+        {
+            // 快照上的统计不随写入变化：隔一段时间再扫一次，结果相同
+            heavyOpen = countHeavy(fd, rx, snap, &error);
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            heavyLater = countHeavy(fd, rx, snap, &error);
+        }
+        MSGHEAD close  = gplat::wire::makeHead(CLOSESNAPSHOT, "", kTable);
+        close.writeptr = snap;
+        request(fd, rx, close, nullptr, 0, reply, nullptr, &error);
+    }
+    stop = true;
+    writer.join();
+    int heavyNow = countHeavy(fd, rx, 0, &error);
+
+    std::printf("\n快照上 SCANTB 重量 > %lld kg 的库位：%d → 200 ms 后 %d（当前表中 %d）\n", kWeight, heavyOpen,
+                heavyLater, heavyNow);
+    std::printf("写线程共倒运 %ld 次，单次 REFRESHTB 最长 %.2f ms\n", moves.load(), worstUs.load() / 1000.0);
+    std::printf("总重量不一致：不用快照 %d / %d 轮，用快照 %d / %d 轮\n", badPlain, rounds, badSnap, rounds);
+
+    request(fd, rx, gplat::wire::makeHead(DELETETABLE, "", kTable), nullptr, 0, reply, nullptr, &error);
+    ::close(fd);
+    std::printf("\nMain thread exit\n");
+    return badSnap == 0 && heavyOpen == heavyLater ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+// 1、对象登记表的并发读：读标签吞吐随线程数的扩展
+// 服务端每个请求都先按名称在登记表（inserttab / fetchtab）中找到看板 / 队列 / 数据库，再读写标签。
+// 进程内直接用 gplat_store 建 16 块看板，N 个线程各自读一块看板上的标签（相当于 N 个 IO 线程处理 READB），
+// 同时另一个线程不断登记新队列（相当于运行中有客户端打开新对象），按 1、2、4……个线程统计每秒读次数。
+// 登记表读取不加锁、读者之间不写共享数据，吞吐应随线程数（不超过 CPU 核数时）近似线性增长
+// 用法：test31 [每轮毫秒] [轮数]
+
+#include <algorithm> // 排序
+#include <atomic>    // 原子变量
+#include <chrono>    // 时间库
+#include <cstdio>    // C标准输入输出（printf）
+#include <cstdlib>   // atoi
+#include <string>    // 字符串
+#include <thread>    // 线程
+#include <vector>    // 动态数组
+
+#include "qbdstore.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kBoards = 16; // 看板数
+constexpr int kTags   = 64; // 每块看板的标签数
+
+std::string boardName(int i)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "SCALE_BOARD_%02d", i);
+    return name;
+}
+
+std::string tagName(int i)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "STAND_SPEED_%02d", i);
+    return name;
+}
+
+struct RunResult
+{
+    double opsPerSec;
+    long   registered; // 运行期间登记的新队列数
+};
+
+// threads 个线程读标签 ms 毫秒，同时一个线程不断建新队列
+RunResult runOnce(int threads, int ms, const std::vector<std::string> &boards, const std::vector<std::string> &tags,
+                  int &queueSeq)
+{
+    std::atomic<int>  ready{0};
+    std::atomic<bool> go{false}, stop{false};
+    std::vector<long> counts(threads, 0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t] {
+            const char  *board = boards[t % kBoards].c_str();
+            double       value = 0;
+            unsigned int error = 0;
+            long         n     = 0;
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                for (int i = 0; i < kTags; ++i)
+                {
+                    qbd::readItem(board, tags[i].c_str(), &value, sizeof(value), nullptr, &error);
+                }
+                n += kTags;
+            }
+            counts[t] = n;
+        });
+    }
+
+    long        registered = 0;
+    std::thread registrar([&] {
+        unsigned int error = 0;
+        while (!go.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "SCALE_Q_%05d", queueSeq++);
+            registered += qbd::createQueue(name, 16, 4, 0, 0, nullptr, 0, &error);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    });
+
+    while (ready.load() < threads)
+    {
+        std::this_thread::yield();
+    }
+    auto t0 = Clock::now();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    stop.store(true);
+    for (auto &w : workers)
+    {
+        w.join();
+    }
+    registrar.join();
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    long total = 0;
+    for (long c : counts)
+    {
+        total += c;
+    }
+    return {total / secs, registered};
+}
+
+int main(int argc, char *argv[])
+{
+    int ms     = argc > 1 ? std::atoi(argv[1]) : 1000;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 3;
+    if (ms <= 0)
+    {
+        ms = 1000;
+    }
+    if (rounds <= 0)
+    {
+        rounds = 3;
+    }
+
+    std::vector<std::string> boards, tags;
+    for (int i = 0; i < kTags; ++i)
+    {
+        tags.push_back(tagName(i));
+    }
+    unsigned int error = 0;
+    for (int b = 0; b < kBoards; ++b)
+    {
+        boards.push_back(boardName(b));
+        if (!qbd::createBoard(boards[b].c_str(), 1 << 20, 1 << 16, &error))
+        {
+            std::printf("建看板 %s 失败，error = %u\n", boards[b].c_str(), error);
+            return 1;
+        }
+        for (int i = 0; i < kTags; ++i)
+        {
+            double v = b * 100 + i;
+            if (!qbd::createItem(boards[b].c_str(), tags[i].c_str(), sizeof(v), nullptr, 0, &error) ||
+                !qbd::writeItem(boards[b].c_str(), tags[i].c_str(), &v, sizeof(v), nullptr, &error))
+            {
+                std::printf("建标签 %s 失败，error = %u\n", tags[i].c_str(), error);
+                return 1;
+            }
+        }
+    }
+
+    unsigned cores = std::thread::hardware_concurrency();
+    int      most  = static_cast<int>(std::max(8u, cores));
+    std::printf("%d 块看板 × %d 个标签，每轮 %d ms，%d 轮取中位数；本机 %u 个 CPU\n\n", kBoards, kTags, ms, rounds,
+                cores);
+    std::printf("线程数   读次数/秒      每线程/秒     相对 1 线程   期间登记队列\n");
+
+    int    queueSeq = 0;
+    double base     = 0;
+    for (int threads = 1; threads <= most; threads *= 2)
+    {
+        std::vector<double> ops;
+        long                registered = 0;
+        for (int r = 0; r < rounds; ++r)
+        {
+            RunResult res = runOnce(threads, ms, boards, tags, queueSeq);
+            ops.push_back(res.opsPerSec);
+            registered += res.registered;
+        }
+        std::sort(ops.begin(), ops.end());
+        double med = ops[ops.size() / 2];
+        if (threads == 1)
+        {
+            base = med;
+        }
+        std::printf("%4d   %12.0f   %12.0f   %9.2fx   %8ld%s\n", threads, med, med / threads, med / base, registered,
+                    cores != 0 && static_cast<unsigned>(threads) > cores ? "   （超过 CPU 数）" : "");
+    }
+
+    qbd::closeAll();
+    std::printf("\nMain thread exit\n");
+    return 0;
+}
@@ -0,0 +1,322 @@
+// 1、PLC 设定值批量下发
+// 一套轧制规程 600 个设定值（40 个区段 × 速度、辊缝、轧制力等 15 项，float / bool / short / int / 字符串混合）：
+//   逐个下发：每个值一个 WRITEBPLC / WRITEBSTRINGPLC 报文，等应答后再发下一个（write_plc_* 的方式）；
+//   批量下发：gplat_plcbatch.h 的 PlcBatch 把全部设定值打包进 WRITEBPLC（head.arraysize = 项数），
+//             超过 MAXMSGLEN 时拆成尽量少的几个报文，服务端一次处理完一个报文中的全部各项；
+// 两种方式交替运行多轮取中位数，每轮下发不同的值并逐个读回核对
+// 需要 gplat_server，用法：test32 [服务端地址] [端口] [轮数]
+
+#include <algorithm> // 排序
+#include <chrono>    // 时间库
+#include <cstdio>    // C标准输入输出（printf）
+#include <cstdlib>   // atoi
+#include <cstring>   // memcpy / snprintf
+#include <string>    // 字符串
+#include <vector>    // 动态数组
+
+#include "gplat_plcbatch.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kZones = 40; // 区段数，每个区段 15 个设定值
+
+// 一个设定值：标签名、类型，以及本轮要下发的值
+struct Setpoint
+{
+    std::string name;
+    int         valtype; // PLCVAL_*
+    char        value[8];
+    std::string text; // PLCVAL_STRING 时的值
+};
+
+struct Item
+{
+    const char *suffix;
+    int         valtype;
+};
+
+const Item kItems[] = {
+    {"SPEED_REF", PLCVAL_FLOAT}, {"GAP_REF", PLCVAL_FLOAT},   {"FORCE_REF", PLCVAL_FLOAT},
+    {"BEND_REF", PLCVAL_FLOAT},  {"SHIFT_REF", PLCVAL_FLOAT}, {"TENSION_REF", PLCVAL_FLOAT},
+    {"COOL_FLOW", PLCVAL_FLOAT}, {"LOOPER_ON", PLCVAL_BOOL},  {"SPRAY_ON", PLCVAL_BOOL},
+    {"MODE", PLCVAL_SHORT},      {"PASS_NO", PLCVAL_USHORT},  {"ROLL_COUNT", PLCVAL_INT},
+    {"LENGTH_MM", PLCVAL_UINT},  {"ROLL_ID", PLCVAL_STRING},  {"GRADE", PLCVAL_STRING},
+};
+
+int valueSize(int valtype)
+{
+    switch (valtype)
+    {
+    case PLCVAL_BOOL:
+        return sizeof(bool);
+    case PLCVAL_SHORT:
+    case PLCVAL_USHORT:
+        return sizeof(short);
+    default:
+        return sizeof(int);
+    }
+}
+
+// 第 round 轮第 i 个设定值的值
+void fillValue(Setpoint &s, int round, int i)
+{
+    std::memset(s.value, 0, sizeof(s.value));
+    int seed = round * 1000 + i;
+    switch (s.valtype)
+    {
+    case PLCVAL_BOOL:
+    {
+        bool v = seed % 2 == 0;
+        std::memcpy(s.value, &v, sizeof(v));
+        break;
+    }
+    case PLCVAL_SHORT:
+    case PLCVAL_USHORT:
+    {
+        short v = static_cast<short>(seed % 30000);
+        std::memcpy(s.value, &v, sizeof(v));
+        break;
+    }
+    case PLCVAL_INT:
+    case PLCVAL_UINT:
+    {
+        int v = seed * 7;
+        std::memcpy(s.value, &v, sizeof(v));
+        break;
+    }
+    case PLCVAL_FLOAT:
+    {
+        float v = 0.5f + static_cast<float>(seed % 9973) * 0.01f;
+        std::memcpy(s.value, &v, sizeof(v));
+        break;
+    }
+    default:
+    {
+        char text[32];
+        std::snprintf(text, sizeof(text), "R%02d-%06d", round, seed);
+        s.text = text;
+        break;
+    }
+    }
+}
+
+double msSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// 逐个下发：每个值一个报文，等应答后再发下一个
+bool sendOneByOne(int fd, gplat::wire::FrameBuffer &rx, const std::vector<Setpoint> &sps, unsigned int *error)
+{
+    MSGHEAD reply;
+    for (const Setpoint &s : sps)
+    {
+        bool ok;
+        if (s.valtype == PLCVAL_STRING)
+        {
+            MSGHEAD head  = gplat::wire::makeHead(WRITEBSTRINGPLC, "", s.name.c_str());
+            head.datasize = static_cast<int>(s.text.size());
+            ok            = gplat::wire::call(fd, rx, head, s.text.c_str(), static_cast<int>(s.text.size()) + 1, reply,
+                                              nullptr, error);
+        }
+        else
+        {
+            MSGHEAD head  = gplat::wire::makeHead(WRITEBPLC, "", s.name.c_str());
+            head.datasize = valueSize(s.valtype);
+            ok = gplat::wire::call(fd, rx, head, s.value, head.datasize, reply, nullptr, error);
+        }
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 批量下发
+bool sendBatch(int fd, gplat::wire::FrameBuffer &rx, const std::vector<Setpoint> &sps, gplat::PlcBatch &batch,
+               unsigned int *error)
+{
+    batch.clear();
+    for (const Setpoint &s : sps)
+    {
+        const char *name = s.name.c_str();
+        switch (s.valtype)
+        {
+        case PLCVAL_BOOL:
+        {
+            bool v;
+            std::memcpy(&v, s.value, sizeof(v));
+            batch.add(name, v);
+            break;
+        }
+        case PLCVAL_SHORT:
+        {
+            short v;
+            std::memcpy(&v, s.value, sizeof(v));
+            batch.add(name, v);
+            break;
+        }
+        case PLCVAL_USHORT:
+        {
+            unsigned short v;
+            std::memcpy(&v, s.value, sizeof(v));
+            batch.add(name, v);
+            break;
+        }
+        case PLCVAL_INT:
+        {
+            int v;
+            std::memcpy(&v, s.value, sizeof(v));
+            batch.add(name, v);
+            break;
+        }
+        case PLCVAL_UINT:
+        {
+            unsigned int v;
+            std::memcpy(&v, s.value, sizeof(v));
+            batch.add(name, v);
+            break;
+        }
+        case PLCVAL_FLOAT:
+        {
+            float v;
+            std::memcpy(&v, s.value, sizeof(v));
+            batch.add(name, v);
+            break;
+        }
+        default:
+            batch.addString(name, s.text);
+            break;
+        }
+    }
+    return batch.send(fd, rx, error);
+}
+
+// 逐个读回核对，返回不一致的个数
+int verify(int fd, gplat::wire::FrameBuffer &rx, const std::vector<Setpoint> &sps)
+{
+    int               bad = 0;
+    MSGHEAD           reply;
+    std::vector<char> out;
+    unsigned int      error = 0;
+    for (const Setpoint &s : sps)
+    {
+        if (s.valtype == PLCVAL_STRING)
+        {
+            MSGHEAD head = gplat::wire::makeHead(READBSTRING, "", s.name.c_str());
+            bool    ok   = gplat::wire::call(fd, rx, head, nullptr, 0, reply, &out, &error);
+            bad += !ok || out.empty() || s.text != out.data();
+        }
+        else
+        {
+            int     size  = valueSize(s.valtype);
+            MSGHEAD head  = gplat::wire::makeHead(READB, "", s.name.c_str());
+            head.datasize = size;
+            bool ok       = gplat::wire::call(fd, rx, head, nullptr, 0, reply, &out, &error);
+            bad += !ok || static_cast<int>(out.size()) != size || std::memcmp(out.data(), s.value, size) != 0;
+        }
+    }
+    return bad;
+}
+
+double median(std::vector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+int main(int argc, char *argv[])
+{
+    const char *server = argc > 1 ? argv[1] : "127.0.0.1";
+    int         port   = argc > 2 ? std::atoi(argv[2]) : 8777;
+    int         rounds = argc > 3 ? std::atoi(argv[3]) : 5;
+    if (rounds <= 0)
+    {
+        rounds = 5;
+    }
+
+    int fd = gplat::wire::connectTcp(server, port, false);
+    if (fd < 0)
+    {
+        std::printf("连接 %s:%d 失败\n", server, port);
+        return 0;
+    }
+    gplat::wire::FrameBuffer rx;
+    unsigned int             error = 0;
+
+    std::vector<Setpoint> sps;
+    for (int z = 0; z < kZones; ++z)
+    {
+        for (const Item &item : kItems)
+        {
+            Setpoint s;
+            char     name[40];
+            std::snprintf(name, sizeof(name), "Z%02d_%s", z + 1, item.suffix);
+            s.name    = name;
+            s.valtype = item.valtype;
+            sps.push_back(s);
+        }
+    }
+
+    // 先逐个下发一遍（不计时），服务端按需自动建标签
+    for (std::size_t i = 0; i < sps.size(); ++i)
+    {
+        fillValue(sps[i], 0, static_cast<int>(i));
+    }
+    if (!sendOneByOne(fd, rx, sps, &error))
+    {
+        std::printf("建标签失败，error = %u（服务端需开启 auto_create_tags）\n", error);
+        return 1;
+    }
+
+    gplat::PlcBatch     batch;
+    std::vector<double> single, batched;
+    int                 badSingle = 0, badBatch = 0;
+    for (int r = 1; r <= rounds; ++r)
+    {
+        for (std::size_t i = 0; i < sps.size(); ++i)
+        {
+            fillValue(sps[i], 2 * r, static_cast<int>(i));
+        }
+        auto t = Clock::now();
+        if (!sendOneByOne(fd, rx, sps, &error))
+        {
+            std::printf("逐个下发失败，error = %u\n", error);
+            return 1;
+        }
+        single.push_back(msSince(t));
+        badSingle += verify(fd, rx, sps);
+
+        for (std::size_t i = 0; i < sps.size(); ++i)
+        {
+            fillValue(sps[i], 2 * r + 1, static_cast<int>(i));
+        }
+        t = Clock::now();
+        if (!sendBatch(fd, rx, sps, batch, &error))
+        {
+            std::printf("批量下发失败，error = %u\n", error);
+            for (std::size_t i = 0; i < batch.size(); ++i)
+            {
+                if (batch.errorOf(i) != 0)
+                {
+                    std::printf("  %s：error = %u\n", sps[i].name.c_str(), batch.errorOf(i));
+                }
+            }
+            return 1;
+        }
+        batched.push_back(msSince(t));
+        badBatch += verify(fd, rx, sps);
+    }
+
+    std::printf("%zu 个设定值（%d 个区段 × %zu 项），%d 轮取中位数\n\n", sps.size(), kZones,
+                sizeof(kItems) / sizeof(kItems[0]), rounds);
+    std::printf("逐个下发  %4zu 个报文   %8.2f ms\n", sps.size(), median(single));
+    std::printf("批量下发  %4d 个报文   %8.2f ms   %5.1fx\n", batch.messages(), median(batched),
+                median(single) / median(batched));
+    std::printf("读回不一致：逐个下发 %d 个，批量下发 %d 个\n", badSingle, badBatch);
+
+    ::close(fd);
+    std::printf("\nMain thread exit\n");
+    return badSingle == 0 && badBatch == 0 ? 0 : 1;
+}
@@ -0,0 +1,246 @@
+// 1、大标签的部分读写与按变化范围推送
+// 一个 12 KB 的轧机设定结构体标签（24 个机架 × 512 字节），比较：
+//   改一个机架的辊缝：整体 WRITEB（12 KB）与 writeb_range（8 字节）的每次耗时；
+//   读一个机架的速度：整体 READB 与 readb_range 的每次耗时；
+// 同时两个订阅连接：普通订阅每次收到整个标签，SUBOPT_RANGE 订阅只收改变的字节（整体写入时为与原值不同的区间），
+// 统计两者收到的字节数，最后核对 SUBOPT_RANGE 订阅者用 applyPost 合并出的本地副本与服务端的值一致
+// 需要 gplat_server，用法：test33 [服务端地址] [端口] [次数]
+
+#include <sys/socket.h> // shutdown
+#include <unistd.h>     // close
+
+#include <algorithm> // 排序
+#include <atomic>    // 原子变量
+#include <chrono>    // 时间库
+#include <cstddef>   // offsetof
+#include <cstdio>    // C标准输入输出（printf）
+#include <cstdlib>   // atoi
+#include <cstring>   // memcmp
+#include <thread>    // 线程
+#include <vector>    // 动态数组
+
+#include "gplat_range.h"
+
+using Clock = std::chrono::steady_clock;
+
+const char *kTag = "MILL_SETUP";
+
+struct StandSetup
+{
+    double gap;   // mm
+    double speed; // m/s
+    double force; // kN
+    double bend;  // kN
+    double profile[60];
+};
+
+struct MillSetup
+{
+    char       scheduleid[32];
+    StandSetup stands[24];
+};
+
+double usSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+}
+
+// 订阅者：收到的 POST 个数、字节数，range 为 true 时合并进本地副本
+struct Subscriber
+{
+    int               fd = -1;
+    bool              range = false;
+    MillSetup         mirror{};
+    std::atomic<long> posts{0};
+    std::atomic<long> bytes{0};
+    std::thread       thread;
+
+    bool start(const char *server, int port, bool useRange, unsigned int *error)
+    {
+        range = useRange;
+        fd    = gplat::wire::connectTcp(server, port, false);
+        if (fd < 0)
+        {
+            *error = ERROR_SOCKET_NOT_CONNECTED;
+            return false;
+        }
+        gplat::wire::FrameBuffer rx;
+        MSGHEAD head  = gplat::wire::makeHead(SUBSCRIBE, "", kTag);
+        head.eventarg = SUBOPT_SNAPSHOT | (range ? SUBOPT_RANGE : 0); // 先补发整个值作为副本的起点
+        MSGHEAD reply;
+        if (!gplat::wire::call(fd, rx, head, nullptr, 0, reply, nullptr, error))
+        {
+            return false;
+        }
+        thread = std::thread([this, rx = std::move(rx)]() mutable {
+            gplat::wire::Frame frame;
+            for (;;)
+            {
+                while (rx.next(frame, nullptr))
+                {
+                    if (frame.head.id == POST)
+                    {
+                        posts.fetch_add(1, std::memory_order_relaxed);
+                        bytes.fetch_add(gplat::wire::kHeadSize + frame.head.bodysize, std::memory_order_relaxed);
+                        gplat::applyPost(frame.head, frame.body, &mirror, sizeof(mirror));
+                    }
+                }
+                if (rx.readFrom(fd) <= 0)
+                {
+                    return;
+                }
+            }
+        });
+        return true;
+    }
+
+    void stop()
+    {
+        ::shutdown(fd, SHUT_RDWR);
+        thread.join();
+        ::close(fd);
+    }
+};
+
+// 整体读写：与 higplat 的 readb / writeb 一样收发整个标签
+bool writeWhole(int fd, gplat::wire::FrameBuffer &rx, const MillSetup &value, unsigned int *error)
+{
+    MSGHEAD head  = gplat::wire::makeHead(WRITEB, "", kTag);
+    head.datasize = sizeof(value);
+    MSGHEAD reply;
+    return gplat::wire::call(fd, rx, head, &value, sizeof(value), reply, nullptr, error);
+}
+
+bool readWhole(int fd, gplat::wire::FrameBuffer &rx, MillSetup &value, std::vector<char> &out, unsigned int *error)
+{
+    MSGHEAD head  = gplat::wire::makeHead(READB, "", kTag);
+    head.datasize = sizeof(value);
+    MSGHEAD reply;
+    if (!gplat::wire::call(fd, rx, head, nullptr, 0, reply, &out, error) || out.size() != sizeof(value))
+    {
+        return false;
+    }
+    std::memcpy(&value, out.data(), sizeof(value));
+    return true;
+}
+
+double median(std::vector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+int main(int argc, char *argv[])
+{
+    const char *server = argc > 1 ? argv[1] : "127.0.0.1";
+    int         port   = argc > 2 ? std::atoi(argv[2]) : 8777;
+    int         times  = argc > 3 ? std::atoi(argv[3]) : 2000;
+    if (times <= 0)
+    {
+        times = 2000;
+    }
+
+    int fd = gplat::wire::connectTcp(server, port, false);
+    if (fd < 0)
+    {
+        std::printf("连接 %s:%d 失败\n", server, port);
+        return 0;
+    }
+    gplat::wire::FrameBuffer rx;
+    std::vector<char>        out;
+    unsigned int             error = 0;
+
+    // 整体写入一次：标签不存在时由服务端自动创建
+    static MillSetup setup;
+    std::snprintf(setup.scheduleid, sizeof(setup.scheduleid), "SCH-20240117-001");
+    for (int s = 0; s < 24; ++s)
+    {
+        setup.stands[s].gap   = 40.0 - s;
+        setup.stands[s].speed = 1.0 + s * 0.5;
+    }
+    if (!writeWhole(fd, rx, setup, &error))
+    {
+        std::printf("写 %s 失败，error = %u（服务端需开启 auto_create_tags）\n", kTag, error);
+        return 1;
+    }
+
+    Subscriber plain, ranged;
+    if (!plain.start(server, port, false, &error) || !ranged.start(server, port, true, &error))
+    {
+        std::printf("订阅失败，error = %u\n", error);
+        return 1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100)); // 等补发的快照到达
+    long plainBase = plain.bytes, rangedBase = ranged.bytes;
+
+    // --- 改一个机架的辊缝：整体写入 ---
+    std::vector<double> fullWrite, rangeWrite, fullRead, rangeRead;
+    for (int i = 0; i < times; ++i)
+    {
+        setup.stands[i % 24].gap += 0.01;
+        auto t = Clock::now();
+        if (!writeWhole(fd, rx, setup, &error))
+        {
+            std::printf("writeb 失败，error = %u\n", error);
+            return 1;
+        }
+        fullWrite.push_back(usSince(t));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    long plainFull = plain.bytes - plainBase, rangedFull = ranged.bytes - rangedBase;
+
+    // --- 改一个机架的辊缝：部分写入 ---
+    for (int i = 0; i < times; ++i)
+    {
+        StandSetup &st = setup.stands[i % 24];
+        st.gap += 0.01;
+        auto t = Clock::now();
+        if (!gplat::writeb_range(fd, kTag, static_cast<int>(offsetof(MillSetup, stands) + (i % 24) * sizeof(StandSetup)),
+                                 &st.gap, sizeof(st.gap), &error))
+        {
+            std::printf("writeb_range 失败，error = %u\n", error);
+            return 1;
+        }
+        rangeWrite.push_back(usSince(t));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    long plainRange  = plain.bytes - plainBase - plainFull;
+    long rangedRange = ranged.bytes - rangedBase - rangedFull;
+
+    // --- 读一个机架的速度 ---
+    static MillSetup whole;
+    int              wrong = 0;
+    for (int i = 0; i < times; ++i)
+    {
+        int    s     = i % 24;
+        double speed = 0;
+        auto   t     = Clock::now();
+        readWhole(fd, rx, whole, out, &error);
+        fullRead.push_back(usSince(t));
+        t = Clock::now();
+        gplat::readb_range(fd, kTag, static_cast<int>(offsetof(MillSetup, stands) + s * sizeof(StandSetup) +
+                                                      offsetof(StandSetup, speed)),
+                           &speed, sizeof(speed), &error);
+        rangeRead.push_back(usSince(t));
+        wrong += speed != whole.stands[s].speed;
+    }
+
+    plain.stop();
+    ranged.stop();
+    bool mirrorOk = std::memcmp(&ranged.mirror, &whole, sizeof(whole)) == 0 &&
+                    std::memcmp(&plain.mirror, &whole, sizeof(whole)) == 0;
+
+    std::printf("标签 %s：%zu 字节，每种操作 %d 次取中位数\n\n", kTag, sizeof(MillSetup), times);
+    std::printf("改一个机架的辊缝  整体 WRITEB   %7.1f us   writeb_range %7.1f us   %5.1fx\n", median(fullWrite),
+                median(rangeWrite), median(fullWrite) / median(rangeWrite));
+    std::printf("读一个机架的速度  整体 READB    %7.1f us   readb_range  %7.1f us   %5.1fx（读回不一致 %d 次）\n\n",
+                median(fullRead), median(rangeRead), median(fullRead) / median(rangeRead), wrong);
+    std::printf("订阅者收到的字节（含报文头）       整体写入期间    部分写入期间\n");
+    std::printf("  普通订阅                         %12ld    %12ld\n", plainFull, plainRange);
+    std::printf("  SUBOPT_RANGE 订阅                %12ld    %12ld\n", rangedFull, rangedRange);
+    std::printf("本地副本与服务端的值%s\n", mirrorOk ? "一致" : "不一致");
+
+    ::close(fd);
+    std::printf("\nMain thread exit\n");
+    return mirrorOk && wrong == 0 ? 0 : 1;
+}
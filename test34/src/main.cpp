@@ -0,0 +1,204 @@
+// 1、看板标签的压缩历史库
+// 进程内直接用 gplat_store：
+//   采集：16 个速度标签挂上 HistoryRecorder，比较 writeItem 带 / 不带记录器的每次耗时，确认每次变化都已记录；
+//   压缩：按 1 秒周期（时间戳带几毫秒抖动）生成若干天的数据写入三个序列 —— 带噪声的速度（float）、
+//         阶梯变化的辊缝设定、递增的计数，输出每点字节数和相对原始 16 字节（时间戳 + double）的压缩比；
+//   查询：最近 1 小时原始点、全部天数降采样成 1000 个桶、最近 1 天降采样成 1440 个桶，
+//         与解码全部原始点的耗时对比，并用原始点核对降采样结果
+// 数据目录为空时段在匿名内存中；给出目录时须为空目录，段文件为 <序列名>.hNNNNN
+// 用法：test34 [天数] [数据目录]
+
+#include <algorithm> // 排序
+#include <chrono>    // 时间库
+#include <cmath>     // sin
+#include <cstdio>    // C标准输入输出（printf）
+#include <cstdlib>   // atoi
+#include <random>    // 随机数
+#include <string>    // 字符串
+#include <vector>    // 动态数组
+
+#include "qbdstore.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int       kTags   = 16;
+constexpr int       kWrites = 200000;
+constexpr long long kSecond = 1000000; // 微秒
+constexpr long long kHour   = 3600 * kSecond;
+constexpr long long kDay    = 24 * kHour;
+
+double msSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+std::string tagName(int i)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "F%d_SPEED", i + 1);
+    return name;
+}
+
+// 采集：返回每次 writeItem 的纳秒数
+double writeLoop(const char *board, qbd::ItemObserver *observer)
+{
+    std::vector<std::string> names;
+    for (int i = 0; i < kTags; ++i)
+    {
+        names.push_back(tagName(i));
+    }
+    unsigned int error = 0;
+    auto         t     = Clock::now();
+    for (int i = 0; i < kWrites; ++i)
+    {
+        float speed = 3.0f + static_cast<float>(i % 977) * 0.001f;
+        qbd::writeItem(board, names[i % kTags].c_str(), &speed, sizeof(speed), observer, &error);
+    }
+    return msSince(t) * 1e6 / kWrites;
+}
+
+int main(int argc, char *argv[])
+{
+    int days = argc > 1 ? std::atoi(argv[1]) : 21;
+    if (days <= 0)
+    {
+        days = 21;
+    }
+    if (argc > 2)
+    {
+        qbd::setDataDir(argv[2]);
+    }
+    unsigned int error = 0;
+
+    // --- 采集 ---
+    const char *board = "HIST_BOARD";
+    if (!qbd::openBoard(board, 1 << 20, 1 << 16, &error))
+    {
+        std::printf("建看板失败，error = %u\n", error);
+        return 1;
+    }
+    qbd::HistoryRecorder recorder;
+    for (int i = 0; i < kTags; ++i)
+    {
+        std::string    name = tagName(i);
+        qbd::FieldSpec field;
+        field.type = qbd::KeyType::Float;
+        field.size = sizeof(float);
+        qbd::createItem(board, name.c_str(), sizeof(float), nullptr, 0, &error);
+        if (!qbd::openHistory(name.c_str(), 0, &error) || !recorder.add(board, name.c_str(), field, name.c_str(), &error))
+        {
+            std::printf("打开历史序列 %s 失败，error = %u\n", name.c_str(), error);
+            return 1;
+        }
+    }
+    qbd::HistoryInfo info;
+    qbd::historyInfo(tagName(0).c_str(), &info, &error);
+    if (info.points > 0)
+    {
+        std::printf("数据目录中已有历史序列，请换一个空目录\n");
+        return 1;
+    }
+    double    plain    = writeLoop(board, nullptr);
+    double    recorded = writeLoop(board, &recorder);
+    long long captured = 0;
+    for (int i = 0; i < kTags; ++i)
+    {
+        qbd::historyInfo(tagName(i).c_str(), &info, &error);
+        captured += info.points;
+    }
+
+    // --- 压缩 ---
+    const char *kSpeed = "HIST_SPEED", *kGap = "HIST_GAP", *kCount = "HIST_COUNT";
+    for (const char *s : {kSpeed, kGap, kCount})
+    {
+        if (!qbd::openHistory(s, 0, &error))
+        {
+            std::printf("打开历史序列 %s 失败，error = %u\n", s, error);
+            return 1;
+        }
+    }
+    std::mt19937                     rng(34);
+    std::normal_distribution<double> noise(0.0, 0.02);
+    std::uniform_int_distribution<>  jitter(-2000, 2000);
+    long long                        start  = 1700000000LL * kSecond;
+    long long                        points = static_cast<long long>(days) * 86400;
+    double                           gap    = 12.0;
+    auto                             t      = Clock::now();
+    for (long long i = 0; i < points; ++i)
+    {
+        long long ts    = start + i * kSecond + jitter(rng);
+        float     speed = static_cast<float>(5.0 + 2.0 * std::sin(i * 0.001) + noise(rng));
+        if (i % 600 == 0)
+        {
+            gap = 8.0 + static_cast<double>(rng() % 800) * 0.01;
+        }
+        qbd::appendHistory(kSpeed, ts, speed, &error);
+        qbd::appendHistory(kGap, ts, gap, &error);
+        qbd::appendHistory(kCount, ts, static_cast<double>(i / 7), &error);
+    }
+    qbd::flushHistory(nullptr, &error);
+    double appendMs = msSince(t);
+
+    // --- 查询 ---
+    long long                       end = start + points * kSecond;
+    std::vector<qbd::HistoryPoint>  raw;
+    std::vector<qbd::HistoryBucket> buckets;
+    bool                            more = false;
+
+    t = Clock::now();
+    qbd::readHistory(kSpeed, end - kHour, end, 0, 0, raw, &more, &error);
+    double hourMs  = msSince(t);
+    size_t hourPts = raw.size();
+
+    t = Clock::now();
+    qbd::readHistory(kSpeed, start, end, 0, 0, raw, &more, &error);
+    double allMs = msSince(t);
+
+    long long width = (end - start + 999) / 1000;
+    t               = Clock::now();
+    qbd::downsampleHistory(kSpeed, start, end, width, 0, buckets, &more, &error);
+    double trendMs = msSince(t);
+
+    // 用原始点核对
+    int    wrong = 0;
+    size_t k     = 0;
+    for (const qbd::HistoryBucket &b : buckets)
+    {
+        double vmin = 1e300, vmax = -1e300, sum = 0;
+        int    n    = 0;
+        for (; k < raw.size() && raw[k].t < b.start + width; ++k, ++n)
+        {
+            vmin = std::min(vmin, raw[k].value);
+            vmax = std::max(vmax, raw[k].value);
+            sum += raw[k].value;
+        }
+        wrong += n != b.count || vmin != b.min || vmax != b.max || std::fabs(sum / n - b.avg) > 1e-9;
+    }
+    size_t trendBuckets = buckets.size();
+
+    t = Clock::now();
+    qbd::downsampleHistory(kSpeed, end - kDay, end, 60 * kSecond, 0, buckets, &more, &error);
+    double dayMs = msSince(t);
+
+    std::printf("采集：%d 个标签各挂一个历史序列，%d 次 writeItem\n", kTags, kWrites);
+    std::printf("  不带记录器 %6.0f ns/次   带记录器 %6.0f ns/次   记录 %lld 点（值变化 %d 次）\n\n", plain, recorded,
+                captured, kWrites);
+    std::printf("压缩：%d 天 × 1 秒周期，每个序列 %lld 点，追加共 %.0f ms\n", days, points, appendMs);
+    std::printf("  序列          每点字节   压缩比   块数   段数\n");
+    for (const char *s : {kSpeed, kGap, kCount})
+    {
+        qbd::historyInfo(s, &info, &error);
+        std::printf("  %-12s %8.2f %7.1fx %6d %6d\n", s, static_cast<double>(info.bytes) / info.points,
+                    16.0 * info.points / info.bytes, info.blocks, info.segments);
+    }
+    std::printf("\n查询 %s：\n", kSpeed);
+    std::printf("  最近 1 小时原始点          %8zu 点   %8.2f ms\n", hourPts, hourMs);
+    std::printf("  %d 天降采样                %8zu 桶   %8.2f ms（核对不一致 %d 桶）\n", days, trendBuckets, trendMs,
+                wrong);
+    std::printf("  最近 1 天每分钟一个桶      %8zu 桶   %8.2f ms\n", buckets.size(), dayMs);
+    std::printf("  对照：解码全部原始点       %8zu 点   %8.2f ms\n", raw.size(), allMs);
+
+    qbd::closeAll();
+    std::printf("\nMain thread exit\n");
+    return wrong == 0 && captured == kWrites ? 0 : 1;
+}
@@ -0,0 +1,330 @@
+// 1、服务端计算的派生标签
+// 连铸机 8 个流的拉速标签 S1_SPEED ~ S8_SPEED（double），求总拉速，比较两种方式从写入一个流的拉速到订阅者收到新总和的时延：
+//   客户端方式：计算客户端订阅 8 个拉速，每收到一个变化就求和并 WRITEB 写回 CLIENT_SPEED_SUM；
+//   服务端方式：服务端按 derived_tags 的定义直接算出 CASTER_SPEED_SUM 并推送；
+// 两种方式各写入若干次取中位数和 99% 分位，最后核对总和与"全部在拉"联锁标签的值
+// 需要 gplat_server，配置中 derived_tags 为：
+//   "CASTER_SPEED_SUM:double = S1_SPEED:double + S2_SPEED:double + ... + S8_SPEED:double;
+//    CASTER_ALL_RUNNING:bool = min(S1_SPEED:double, S2_SPEED:double, ..., S8_SPEED:double) > 0"
+// 用法：test35 [服务端地址] [端口] [次数]
+
+#include <sys/socket.h> // shutdown
+#include <unistd.h>     // close
+
+#include <algorithm> // 排序
+#include <atomic>    // 原子变量
+#include <chrono>    // 时间库
+#include <cstdio>    // C标准输入输出（printf）
+#include <cstdlib>   // atoi
+#include <cstring>   // memcpy
+#include <string>    // 字符串
+#include <thread>    // 线程
+#include <vector>    // 动态数组
+
+#include "gplat_wire.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kStrands = 8;
+
+const char *kServerSum = "CASTER_SPEED_SUM";
+const char *kClientSum = "CLIENT_SPEED_SUM";
+const char *kRunning   = "CASTER_ALL_RUNNING";
+
+std::string strandTag(int i)
+{
+    return "S" + std::to_string(i + 1) + "_SPEED";
+}
+
+double usSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+}
+
+bool subscribe(int fd, gplat::wire::FrameBuffer &rx, const char *tag, unsigned int *error)
+{
+    MSGHEAD head  = gplat::wire::makeHead(SUBSCRIBE, "", tag);
+    head.eventarg = SUBOPT_SNAPSHOT; // 先补发当前值
+    MSGHEAD reply;
+    return gplat::wire::call(fd, rx, head, nullptr, 0, reply, nullptr, error);
+}
+
+bool writeDouble(int fd, gplat::wire::FrameBuffer &rx, const char *tag, double value, unsigned int *error)
+{
+    MSGHEAD head  = gplat::wire::makeHead(WRITEB, "", tag);
+    head.datasize = sizeof(value);
+    MSGHEAD reply;
+    return gplat::wire::call(fd, rx, head, &value, sizeof(value), reply, nullptr, error);
+}
+
+template <typename T>
+bool readValue(int fd, gplat::wire::FrameBuffer &rx, const char *tag, T &value, unsigned int *error)
+{
+    MSGHEAD           head = gplat::wire::makeHead(READB, "", tag);
+    MSGHEAD           reply;
+    std::vector<char> out;
+    if (!gplat::wire::call(fd, rx, head, nullptr, 0, reply, &out, error) || out.size() < sizeof(value))
+    {
+        return false;
+    }
+    std::memcpy(&value, out.data(), sizeof(value));
+    return true;
+}
+
+// 订阅一个 double 标签，记下最新的值
+struct Watcher
+{
+    int                 fd = -1;
+    std::atomic<double> value{-1};
+    std::atomic<long>   posts{0};
+    std::thread         thread;
+
+    bool start(const char *server, int port, const char *tag, unsigned int *error)
+    {
+        fd = gplat::wire::connectTcp(server, port, false);
+        gplat::wire::FrameBuffer rx;
+        if (fd < 0 || !subscribe(fd, rx, tag, error))
+        {
+            return false;
+        }
+        thread = std::thread([this, rx = std::move(rx)]() mutable {
+            gplat::wire::Frame frame;
+            for (;;)
+            {
+                while (rx.next(frame, nullptr))
+                {
+                    double v;
+                    if (frame.head.id == POST && gplat::wire::parsePost(frame.head, frame.body, nullptr, nullptr) ==
+                                                     static_cast<int>(sizeof(v)))
+                    {
+                        std::memcpy(&v, frame.body, sizeof(v));
+                        value.store(v);
+                        posts.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+                if (rx.readFrom(fd) <= 0)
+                {
+                    return;
+                }
+            }
+        });
+        return true;
+    }
+
+    void stop()
+    {
+        ::shutdown(fd, SHUT_RDWR);
+        thread.join();
+        ::close(fd);
+    }
+};
+
+// 客户端方式的计算客户端：订阅 8 个拉速，每个变化求和后写回
+struct Calculator
+{
+    int               fd = -1;
+    std::atomic<long> writes{0};
+    std::thread       thread;
+
+    bool start(const char *server, int port, unsigned int *error)
+    {
+        fd = gplat::wire::connectTcp(server, port, false);
+        if (fd < 0)
+        {
+            *error = ERROR_SOCKET_NOT_CONNECTED;
+            return false;
+        }
+        thread = std::thread([this]() {
+            gplat::wire::FrameBuffer rx;
+            gplat::wire::Frame       frame;
+            double                   speeds[kStrands] = {};
+            unsigned int             error            = 0;
+            for (int i = 0; i < kStrands; ++i)
+            {
+                subscribe(fd, rx, strandTag(i).c_str(), &error);
+            }
+            for (;;)
+            {
+                while (rx.next(frame, nullptr))
+                {
+                    std::string tag(frame.head.itemname, ::strnlen(frame.head.itemname, sizeof(frame.head.itemname)));
+                    for (int i = 0; i < kStrands; ++i)
+                    {
+                        if (frame.head.id == POST && tag == strandTag(i) &&
+                            gplat::wire::parsePost(frame.head, frame.body, nullptr, nullptr) ==
+                                static_cast<int>(sizeof(double)))
+                        {
+                            std::memcpy(&speeds[i], frame.body, sizeof(double));
+                            double sum = 0;
+                            for (double s : speeds)
+                            {
+                                sum += s;
+                            }
+                            // 同步写回：等待应答期间到达的 POST 留在 rx 中，下一圈处理
+                            if (!writeDouble(fd, rx, kClientSum, sum, &error))
+                            {
+                                return;
+                            }
+                            writes.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                }
+                if (rx.readFrom(fd) <= 0)
+                {
+                    return;
+                }
+            }
+        });
+        return true;
+    }
+
+    void stop()
+    {
+        ::shutdown(fd, SHUT_RDWR);
+        thread.join();
+        ::close(fd);
+    }
+};
+
+struct Result
+{
+    std::vector<double> us;
+    int                 lost = 0; // 1 秒内没有收到新总和
+};
+
+// 逐个写入拉速（每次的值都比之前的大，总和各不相同），等订阅者收到新的总和
+Result run(int fd, gplat::wire::FrameBuffer &rx, Watcher &watcher, double *speeds, double &next, int times)
+{
+    Result       r;
+    unsigned int error = 0;
+    for (int i = 0; i < times; ++i)
+    {
+        int s     = i % kStrands;
+        speeds[s] = next;
+        next += 1;
+        double expect = 0;
+        for (int k = 0; k < kStrands; ++k)
+        {
+            expect += speeds[k];
+        }
+        auto t = Clock::now();
+        writeDouble(fd, rx, strandTag(s).c_str(), speeds[s], &error);
+        while (watcher.value.load() != expect && usSince(t) < 1e6)
+        {
+            std::this_thread::yield();
+        }
+        if (watcher.value.load() == expect)
+        {
+            r.us.push_back(usSince(t));
+        }
+        else
+        {
+            ++r.lost;
+        }
+    }
+    std::sort(r.us.begin(), r.us.end());
+    return r;
+}
+
+void print(const char *name, const Result &r, long posts, long writes)
+{
+    if (r.us.empty())
+    {
+        std::printf("  %s 全部超时\n", name);
+        return;
+    }
+    std::printf("  %s 中位数 %7.1f us   99%% %7.1f us   超时 %d 次   订阅者收到 %ld 次   客户端写回 %ld 次\n", name,
+                r.us[r.us.size() / 2], r.us[r.us.size() * 99 / 100], r.lost, posts, writes);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *server = argc > 1 ? argv[1] : "127.0.0.1";
+    int         port   = argc > 2 ? std::atoi(argv[2]) : 8777;
+    int         times  = argc > 3 ? std::atoi(argv[3]) : 2000;
+    if (times <= 0)
+    {
+        times = 2000;
+    }
+
+    int fd = gplat::wire::connectTcp(server, port, false);
+    if (fd < 0)
+    {
+        std::printf("连接 %s:%d 失败\n", server, port);
+        return 0;
+    }
+    gplat::wire::FrameBuffer rx;
+    unsigned int             error = 0;
+
+    // 各流起步拉速，标签不存在时由服务端自动创建；8 个都存在后服务端算出第一个总和
+    double speeds[kStrands];
+    double next = 1;
+    for (int i = 0; i < kStrands; ++i)
+    {
+        speeds[i] = next++;
+        if (!writeDouble(fd, rx, strandTag(i).c_str(), speeds[i], &error))
+        {
+            std::printf("写 %s 失败，error = %u（服务端需开启 auto_create_tags）\n", strandTag(i).c_str(), error);
+            return 1;
+        }
+    }
+    double sum = 0;
+    if (!readValue(fd, rx, kServerSum, sum, &error))
+    {
+        std::printf("读 %s 失败，error = %u：服务端未配置 derived_tags（见本文件开头）\n", kServerSum, error);
+        return 0;
+    }
+
+    // --- 客户端方式 ---
+    Calculator calc;
+    Watcher    clientWatch;
+    if (!calc.start(server, port, &error) || !clientWatch.start(server, port, kClientSum, &error))
+    {
+        std::printf("订阅失败，error = %u\n", error);
+        return 1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200)); // 等计算客户端订阅完毕并写回第一个总和
+    long   clientPosts = clientWatch.posts;
+    long   calcWrites  = calc.writes;
+    Result client      = run(fd, rx, clientWatch, speeds, next, times);
+    clientPosts        = clientWatch.posts - clientPosts;
+    calcWrites         = calc.writes - calcWrites;
+    calc.stop();
+    clientWatch.stop();
+
+    // --- 服务端方式 ---
+    Watcher serverWatch;
+    if (!serverWatch.start(server, port, kServerSum, &error))
+    {
+        std::printf("订阅 %s 失败，error = %u\n", kServerSum, error);
+        return 1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100)); // 等补发的当前值
+    long   serverPosts = serverWatch.posts;
+    Result derived     = run(fd, rx, serverWatch, speeds, next, times);
+    serverPosts        = serverWatch.posts - serverPosts;
+    serverWatch.stop();
+
+    double expect = 0;
+    for (double s : speeds)
+    {
+        expect += s;
+    }
+    unsigned char running = 0;
+    bool ok = readValue(fd, rx, kServerSum, sum, &error) && readValue(fd, rx, kRunning, running, &error) &&
+              sum == expect && running == 1;
+
+    std::printf("%d 个流的拉速，每种方式写入 %d 次，从写入一个拉速到订阅者收到新的总拉速：\n", kStrands, times);
+    print("客户端订阅-计算-写回", client, clientPosts, calcWrites);
+    print("服务端派生标签      ", derived, serverPosts, 0);
+    if (!client.us.empty() && !derived.us.empty())
+    {
+        std::printf("  中位数之比 %.1fx\n", client.us[client.us.size() / 2] / derived.us[derived.us.size() / 2]);
+    }
+    std::printf("%s = %.0f（应为 %.0f），%s = %d：%s\n", kServerSum, sum, expect, kRunning, running,
+                ok ? "一致" : "不一致");
+
+    ::close(fd);
+    std::printf("\nMain thread exit\n");
+    return ok && client.lost == 0 && derived.lost == 0 ? 0 : 1;
+}
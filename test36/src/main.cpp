@@ -0,0 +1,260 @@
+// 1、多路等待多个队列
+// 一个消费线程服务 20 个指令队列 WAITQ01 ~ WAITQ20，生产者随机选队列、间隔 0.2 ~ 1.5 ms 写入一条带发送时刻的记录，
+// 比较两种消费方式：
+//   轮询方式：依次 READQ 每个队列，一圈都为空时 sleep 1 ms；
+//   多路等待：WAITMULTI 等 20 个队列中任一有记录，只 READQ 就绪的队列；
+// 输出从写入到消费者读出的时延（中位数、99% 分位）和平均每条记录消费者发出的请求数，
+// 最后核对每种方式都读出了全部记录、且读空后 WAITMULTI 按时超时
+// 需要 gplat_server（auto_create_queues 开启），用法：test36 [服务端地址] [端口] [每种方式的记录数]
+
+#include <unistd.h> // close
+
+#include <algorithm> // 排序
+#include <chrono>    // 时间库
+#include <cstdio>    // C标准输入输出（printf）
+#include <cstdlib>   // atoi
+#include <cstring>   // memcpy
+#include <random>    // 随机数
+#include <string>    // 字符串
+#include <thread>    // 线程
+#include <vector>    // 动态数组
+
+#include "gplat_waitmulti.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kQueues = 20;
+
+struct Record
+{
+    long long sent; // 写入时刻（steady_clock 纳秒）
+    int       seq;
+    int       reserved;
+};
+
+std::string queueName(int i)
+{
+    char name[24];
+    std::snprintf(name, sizeof(name), "WAITQ%02d", i + 1);
+    return name;
+}
+
+long long nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+bool writeRecord(int fd, gplat::wire::FrameBuffer &rx, const std::string &qname, const Record &rec,
+                 unsigned int *error)
+{
+    MSGHEAD head  = gplat::wire::makeHead(WRITEQ, qname.c_str(), "");
+    head.recsize  = sizeof(rec);
+    head.datasize = sizeof(rec);
+    MSGHEAD reply;
+    return gplat::wire::call(fd, rx, head, &rec, sizeof(rec), reply, nullptr, error);
+}
+
+// 读一条记录，队列为空时返回 false 且 *error 为 ERROR_DQ_EMPTY
+bool readRecord(int fd, gplat::wire::FrameBuffer &rx, const std::string &qname, Record &rec, unsigned int *error)
+{
+    MSGHEAD           head = gplat::wire::makeHead(READQ, qname.c_str(), "");
+    MSGHEAD           reply;
+    std::vector<char> out;
+    if (!gplat::wire::call(fd, rx, head, nullptr, 0, reply, &out, error) || out.size() < sizeof(rec))
+    {
+        return false;
+    }
+    std::memcpy(&rec, out.data(), sizeof(rec));
+    return true;
+}
+
+struct Result
+{
+    std::vector<double> us;           // 每条记录的时延
+    long                requests = 0; // 消费者发出的请求数
+};
+
+// 生产者：total 条记录随机写入各队列
+void produce(const char *server, int port, int total)
+{
+    int fd = gplat::wire::connectTcp(server, port, false);
+    if (fd < 0)
+    {
+        return;
+    }
+    gplat::wire::FrameBuffer        rx;
+    std::mt19937                    rng(36);
+    std::uniform_int_distribution<> pick(0, kQueues - 1);
+    std::uniform_int_distribution<> gap(200, 1500);
+    unsigned int                    error = 0;
+    for (int i = 0; i < total; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(gap(rng)));
+        Record rec{nowNs(), i, 0};
+        writeRecord(fd, rx, queueName(pick(rng)), rec, &error);
+    }
+    ::close(fd);
+}
+
+void take(Result &r, const Record &rec)
+{
+    r.us.push_back(static_cast<double>(nowNs() - rec.sent) / 1000.0);
+}
+
+// 轮询方式
+Result pollLoop(int fd, gplat::wire::FrameBuffer &rx, int total)
+{
+    Result       r;
+    unsigned int error = 0;
+    auto         t0    = Clock::now();
+    while (static_cast<int>(r.us.size()) < total && Clock::now() - t0 < std::chrono::seconds(60))
+    {
+        bool any = false;
+        for (int q = 0; q < kQueues; ++q)
+        {
+            Record rec;
+            ++r.requests;
+            if (readRecord(fd, rx, queueName(q), rec, &error))
+            {
+                take(r, rec);
+                any = true;
+            }
+        }
+        if (!any)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    return r;
+}
+
+// 多路等待方式
+Result waitLoop(int fd, gplat::wire::FrameBuffer &rx, int total)
+{
+    Result         r;
+    unsigned int   error = 0;
+    gplat::WaitSet set;
+    for (int q = 0; q < kQueues; ++q)
+    {
+        set.addQueue(queueName(q).c_str());
+    }
+    std::vector<WAITREADY> ready;
+    auto                   t0 = Clock::now();
+    while (static_cast<int>(r.us.size()) < total && Clock::now() - t0 < std::chrono::seconds(60))
+    {
+        ++r.requests;
+        if (!set.wait(fd, rx, 1000, ready, &error))
+        {
+            std::printf("WAITMULTI 失败，error = %u\n", error);
+            break;
+        }
+        for (const WAITREADY &w : ready)
+        {
+            // value 为就绪时的未读记录数，读完这些即可，之后写入的记录下一次 wait 会再报告
+            for (unsigned long long k = 0; k < w.value; ++k)
+            {
+                Record rec;
+                ++r.requests;
+                if (!readRecord(fd, rx, set.name(w.index), rec, &error))
+                {
+                    break;
+                }
+                take(r, rec);
+            }
+        }
+    }
+    return r;
+}
+
+Result runMode(const char *server, int port, int fd, gplat::wire::FrameBuffer &rx, int total, bool wait)
+{
+    std::thread producer(produce, server, port, total);
+    Result      r = wait ? waitLoop(fd, rx, total) : pollLoop(fd, rx, total);
+    producer.join();
+    std::sort(r.us.begin(), r.us.end());
+    return r;
+}
+
+void print(const char *name, const Result &r, int total)
+{
+    if (r.us.empty())
+    {
+        std::printf("  %s 没有读到记录\n", name);
+        return;
+    }
+    std::printf("  %s 读出 %5zu 条   中位数 %7.1f us   99%% %7.1f us   每条记录 %6.2f 个请求\n", name, r.us.size(),
+                r.us[r.us.size() / 2], r.us[r.us.size() * 99 / 100], static_cast<double>(r.requests) / total);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *server = argc > 1 ? argv[1] : "127.0.0.1";
+    int         port   = argc > 2 ? std::atoi(argv[2]) : 8777;
+    int         total  = argc > 3 ? std::atoi(argv[3]) : 3000;
+    if (total <= 0)
+    {
+        total = 3000;
+    }
+
+    int fd = gplat::wire::connectTcp(server, port, false);
+    if (fd < 0)
+    {
+        std::printf("连接 %s:%d 失败\n", server, port);
+        return 0;
+    }
+    gplat::wire::FrameBuffer rx;
+    unsigned int             error = 0;
+
+    // 建队列（不存在时由服务端按记录长度创建）并清空上次运行留下的记录
+    for (int q = 0; q < kQueues; ++q)
+    {
+        Record  rec{0, -1, 0};
+        MSGHEAD head = gplat::wire::makeHead(CLEARQ, queueName(q).c_str(), "");
+        MSGHEAD reply;
+        if (!writeRecord(fd, rx, queueName(q), rec, &error) ||
+            !gplat::wire::call(fd, rx, head, nullptr, 0, reply, nullptr, &error))
+        {
+            std::printf("建队列 %s 失败，error = %u（服务端需开启 auto_create_queues）\n", queueName(q).c_str(), error);
+            return 1;
+        }
+    }
+
+    // 服务端不支持 WAITMULTI 时应答 ERROR_INVALID_PARAMETER
+    gplat::WaitSet probe;
+    probe.addQueue(queueName(0).c_str());
+    std::vector<WAITREADY> ready;
+    if (!probe.wait(fd, rx, 0, ready, &error))
+    {
+        std::printf("WAITMULTI 失败，error = %u：服务端不支持多路等待\n", error);
+        return 0;
+    }
+
+    Result poll  = runMode(server, port, fd, rx, total, false);
+    Result multi = runMode(server, port, fd, rx, total, true);
+
+    // 全部读空后再等 50 ms 应超时返回空
+    gplat::WaitSet all;
+    for (int q = 0; q < kQueues; ++q)
+    {
+        all.addQueue(queueName(q).c_str());
+    }
+    auto   t       = Clock::now();
+    bool   waited  = all.wait(fd, rx, 50, ready, &error);
+    double ms      = std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+    bool   timeout = waited && ready.empty() && ms >= 45;
+
+    std::printf("%d 个队列，一个消费线程，每种方式 %d 条记录（写入间隔 0.2 ~ 1.5 ms）：\n", kQueues, total);
+    print("轮询 READQ + sleep 1 ms", poll, total);
+    print("WAITMULTI             ", multi, total);
+    if (!poll.us.empty() && !multi.us.empty())
+    {
+        std::printf("  中位时延之比 %.1fx，请求数之比 %.1fx\n", poll.us[poll.us.size() / 2] / multi.us[multi.us.size() / 2],
+                    static_cast<double>(poll.requests) / multi.requests);
+    }
+    std::printf("读空后等待 50 ms：%s（%.1f ms）\n", timeout ? "按时超时" : "异常", ms);
+
+    ::close(fd);
+    std::printf("\nMain thread exit\n");
+    bool ok = static_cast<int>(poll.us.size()) == total && static_cast<int>(multi.us.size()) == total && timeout;
+    return ok ? 0 : 1;
+}
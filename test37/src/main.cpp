@@ -0,0 +1,137 @@
+// 1、序号归零后的续订
+// SeqTracker 按标签记下最后收到的写入序号，断线重连后 subscribe_resume 带上它续订，服务端只补发序号有变化的标签。
+// 标签删除重建（或服务端以匿名内存看板重启）后序号从头计数，补发的当前值序号比已收到的小，仍应被接受：
+//   1）订阅标签，写入若干次，确认依次收到、没有丢失；
+//   2）断开，删除并重建标签（序号归零），写入一次新值；
+//   3）重连续订：补发的当前值应为 kSnapshot 且值为新值，之后的写入应为 kInOrder，序号接着新的计数
+// 需要 gplat_server，用法：test37 [服务端地址] [端口]
+
+#include <unistd.h> // close
+
+#include <cstdio>  // C标准输入输出（printf）
+#include <cstdlib> // atoi
+
+#include "gplat_post.h"
+
+const char *kTag = "SEQ_RESET_DEMO";
+
+const char *resultName(gplat::SeqTracker::Result r)
+{
+    switch (r)
+    {
+    case gplat::SeqTracker::kInOrder:
+        return "按序";
+    case gplat::SeqTracker::kSnapshot:
+        return "补发";
+    case gplat::SeqTracker::kGap:
+        return "有丢失";
+    case gplat::SeqTracker::kStale:
+        return "过期";
+    default:
+        return "无序号";
+    }
+}
+
+// datasize：WRITEB 为数值长度，CREATEITEM 为标签长度（此时不带类型名）
+bool request(int fd, gplat::wire::FrameBuffer &rx, int id, int datasize, const void *body, int size,
+             unsigned int *error)
+{
+    MSGHEAD head  = gplat::wire::makeHead(id, "", kTag);
+    head.datasize = datasize;
+    MSGHEAD reply;
+    return gplat::wire::call(fd, rx, head, body, size, reply, nullptr, error);
+}
+
+// 等一个推送，交给 tracker，返回其结果；1 秒内没有收到返回 false
+bool nextPost(int fd, gplat::PostReceiver &receiver, gplat::SeqTracker &tracker, gplat::SeqTracker::Result &result,
+              int &value, unsigned long long &seq)
+{
+    gplat::PostView ev;
+    unsigned int    error = 0;
+    if (gplat::waitpostdata_multi(fd, receiver, &ev, 1, 1000, &error) != 1)
+    {
+        return false;
+    }
+    result = tracker.update(ev);
+    value  = ev.as<int>();
+    seq    = ev.seq;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *server = argc > 1 ? argv[1] : "127.0.0.1";
+    int         port   = argc > 2 ? std::atoi(argv[2]) : 8777;
+
+    int writer = gplat::wire::connectTcp(server, port, false);
+    if (writer < 0)
+    {
+        std::printf("连接 %s:%d 失败\n", server, port);
+        return 0;
+    }
+    gplat::wire::FrameBuffer wrx;
+    unsigned int             error = 0;
+    int                      value = 0;
+    request(writer, wrx, DELETEITEM, 0, nullptr, 0, &error); // 上次运行留下的
+    if (!request(writer, wrx, CREATEITEM, sizeof(value), nullptr, 0, &error))
+    {
+        std::printf("建标签 %s 失败，error = %u\n", kTag, error);
+        return 1;
+    }
+
+    request(writer, wrx, WRITEB, sizeof(value), &value, sizeof(value), &error); // 订阅时有当前值可补发
+
+    gplat::SeqTracker tracker;
+    tracker.addPattern(kTag);
+
+    // --- 1）订阅并写入若干次 ---
+    int                 fd = gplat::wire::connectTcp(server, port, false);
+    gplat::PostReceiver receiver;
+    if (fd < 0 || !gplat::subscribe_resume(fd, receiver, tracker, SUBOPT_SEQ, &error))
+    {
+        std::printf("订阅失败，error = %u\n", error);
+        return 1;
+    }
+    gplat::SeqTracker::Result r   = gplat::SeqTracker::kUntracked;
+    int                       got = 0;
+    unsigned long long        seq = 0;
+    bool ok = nextPost(fd, receiver, tracker, r, got, seq) && r == gplat::SeqTracker::kSnapshot;
+    std::printf("首次订阅：补发 seq = %llu（%s）\n", seq, resultName(r));
+    for (value = 1; value <= 5; ++value)
+    {
+        request(writer, wrx, WRITEB, sizeof(value), &value, sizeof(value), &error);
+        bool step = nextPost(fd, receiver, tracker, r, got, seq) && r == gplat::SeqTracker::kInOrder && got == value;
+        ok        = ok && step;
+    }
+    unsigned long long before = tracker.lastSeq(kTag);
+    std::printf("写入 5 次：最后 seq = %llu，丢失 %llu 次\n", before, tracker.gaps());
+    ::close(fd);
+
+    // --- 2）删除重建，序号归零 ---
+    request(writer, wrx, DELETEITEM, 0, nullptr, 0, &error);
+    request(writer, wrx, CREATEITEM, sizeof(value), nullptr, 0, &error);
+    value = 100;
+    request(writer, wrx, WRITEB, sizeof(value), &value, sizeof(value), &error);
+
+    // --- 3）重连续订 ---
+    fd = gplat::wire::connectTcp(server, port, false);
+    gplat::PostReceiver receiver2;
+    if (fd < 0 || !gplat::subscribe_resume(fd, receiver2, tracker, SUBOPT_SEQ, &error))
+    {
+        std::printf("续订失败，error = %u\n", error);
+        return 1;
+    }
+    bool snap = nextPost(fd, receiver2, tracker, r, got, seq) && r == gplat::SeqTracker::kSnapshot && got == 100;
+    std::printf("删除重建后续订：补发 seq = %llu（%s），值 %d，应为 100：%s\n", seq, resultName(r), got,
+                snap ? "已接受" : "被丢弃");
+    value     = 101;
+    request(writer, wrx, WRITEB, sizeof(value), &value, sizeof(value), &error);
+    bool next = nextPost(fd, receiver2, tracker, r, got, seq) && r == gplat::SeqTracker::kInOrder && got == 101;
+    std::printf("之后的写入：seq = %llu（%s），值 %d：%s\n", seq, resultName(r), got, next ? "正常" : "异常");
+    ok = ok && snap && next && tracker.lastSeq(kTag) < before;
+
+    ::close(fd);
+    ::close(writer);
+    std::printf("%s\n\nMain thread exit\n", ok ? "一致" : "不一致");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+// 1、延时推送与撤销
+// 延时订阅（SUBSCRIBE 带事件名和 timeout）后，标签每被写入一次服务端就挂起一个定时器，到期推送 itemname = 事件名的 POST；
+// canceldelaypost 撤销本连接上该（标签, 事件）所有未到期的推送。依次核对：
+//   1）延时 100 ms：写入后约 100 ms 收到事件，值为写入的值；
+//   2）写入后立即撤销：之后不再收到事件；
+//   3）同一事件重新订阅改为较短的延时：先写一次（300 ms），改为 20 ms 再写一次，
+//      短的先到期推送；此时撤销，长的那个不应再推送
+// 需要 gplat_server，用法：test38 [服务端地址] [端口]
+
+#include <unistd.h> // close
+
+#include <chrono>  // 时间库
+#include <cstdio>  // C标准输入输出（printf）
+#include <cstdlib> // atoi
+#include <cstring> // strlen
+#include <string>  // 字符串
+
+#include "gplat_delaypost.h"
+#include "gplat_post.h"
+
+using Clock = std::chrono::steady_clock;
+
+const char *kTag   = "DELAY_DEMO";
+const char *kEvent = "DELAY_DEMO_EV";
+
+double msSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+bool writeValue(int fd, gplat::wire::FrameBuffer &rx, int value, unsigned int *error)
+{
+    MSGHEAD head  = gplat::wire::makeHead(WRITEB, "", kTag);
+    head.datasize = sizeof(value);
+    MSGHEAD reply;
+    return gplat::wire::call(fd, rx, head, &value, sizeof(value), reply, nullptr, error);
+}
+
+// 延时订阅（同一事件再次订阅时更新延时）。应答读在 rx 中，调用时不应有即将到期的推送
+bool subscribeDelay(int fd, gplat::wire::FrameBuffer &rx, int delay_ms, unsigned int *error)
+{
+    MSGHEAD head = gplat::wire::makeHead(SUBSCRIBE, "", kTag);
+    head.timeout = delay_ms;
+    MSGHEAD reply;
+    return gplat::wire::call(fd, rx, head, kEvent, static_cast<int>(std::strlen(kEvent)) + 1, reply, nullptr, error);
+}
+
+// 在 timeout_ms 内等一个事件，返回收到的事件数（0 或 1）
+int nextEvent(int fd, gplat::PostReceiver &receiver, int timeout_ms, int &value)
+{
+    gplat::PostView ev;
+    unsigned int    error = 0;
+    int             n     = gplat::waitpostdata_multi(fd, receiver, &ev, 1, timeout_ms, &error);
+    if (n == 1)
+    {
+        value = ev.tagname == kEvent ? ev.as<int>() : -1;
+    }
+    return n > 0 ? n : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *server = argc > 1 ? argv[1] : "127.0.0.1";
+    int         port   = argc > 2 ? std::atoi(argv[2]) : 8777;
+
+    int writer = gplat::wire::connectTcp(server, port, false);
+    int fd     = gplat::wire::connectTcp(server, port, false);
+    if (writer < 0 || fd < 0)
+    {
+        std::printf("连接 %s:%d 失败\n", server, port);
+        return 0;
+    }
+    gplat::wire::FrameBuffer wrx, srx;
+    gplat::PostReceiver      receiver;
+    unsigned int             error = 0;
+    int                      value = 0;
+
+    if (!writeValue(writer, wrx, 0, &error) || !subscribeDelay(fd, srx, 100, &error))
+    {
+        std::printf("建标签或延时订阅失败，error = %u\n", error);
+        return 1;
+    }
+
+    // --- 1）延时推送 ---
+    auto t0  = Clock::now();
+    writeValue(writer, wrx, 11, &error);
+    bool   got = nextEvent(fd, receiver, 1000, value) == 1;
+    double ms  = msSince(t0);
+    bool   one = got && value == 11 && ms >= 90 && ms < 500;
+    std::printf("延时 100 ms：%s，值 %d，%.1f ms 后收到\n", got ? "收到事件" : "没有收到", value, ms);
+
+    // --- 2）写入后立即撤销 ---
+    writeValue(writer, wrx, 22, &error);
+    gplat::canceldelaypost(fd, kTag, kEvent, &error);
+    bool two = nextEvent(fd, receiver, 300, value) == 0;
+    std::printf("写入后撤销：%s\n", two ? "未再推送" : "仍然推送");
+
+    // --- 3）重新订阅改短延时，短的先到期后撤销长的 ---
+    subscribeDelay(fd, srx, 300, &error);
+    writeValue(writer, wrx, 33, &error); // 300 ms 后到期
+    subscribeDelay(fd, srx, 20, &error);
+    writeValue(writer, wrx, 44, &error); // 20 ms 后到期
+    bool shortFired = nextEvent(fd, receiver, 200, value) == 1 && value == 44;
+    gplat::canceldelaypost(fd, kTag, kEvent, &error);
+    bool longCancelled = nextEvent(fd, receiver, 500, value) == 0;
+    std::printf("改短延时：短的先推送 %s，之后撤销长的 %s\n", shortFired ? "是" : "否",
+                longCancelled ? "未再推送" : "仍然推送");
+
+    ::close(fd);
+    ::close(writer);
+    bool ok = one && two && shortFired && longCancelled;
+    std::printf("%s\n\nMain thread exit\n", ok ? "一致" : "不一致");
+    return ok ? 0 : 1;
+}
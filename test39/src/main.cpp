@@ -0,0 +1,115 @@
+// 1、批量接收推送时的半个报文与超时
+// waitpostdata_multi 一次 recv 可能只读到半个报文或只有非 POST 报文，此时应在调用方给的时间内继续等待，
+// 只有时间确实用完才返回 0（ETIMEDOUT）。用一对本地套接字代替服务端，按下面的节奏发送并核对：
+//   1）一直等待（-1）：先发一个非 POST 应答，100 ms 后发 POST 的前 10 字节，再 100 ms 后发其余部分，应取到这个推送；
+//   2）等待 300 ms：50 ms 时只到半个报文，应在约 300 ms 时超时，半个报文留在缓冲区中；
+//      其余部分到达后，下一次只取已到达数据（0）的调用应取到完整推送
+// 不需要 gplat_server，用法：test39
+
+#include <sys/socket.h> // socketpair
+#include <unistd.h>     // close
+
+#include <cerrno>  // ETIMEDOUT
+#include <chrono>  // 时间库
+#include <cstdio>  // C标准输入输出（printf）
+#include <thread>  // 线程
+#include <vector>  // 动态数组
+
+#include "gplat_post.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kSplit = 10; // 先发出的字节数，小于报文头
+
+// 一个完整报文在线路上的字节
+std::vector<char> frameBytes(int id, int value)
+{
+    int sv[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+    {
+        return {};
+    }
+    MSGHEAD head  = gplat::wire::makeHead(id, "", "PARTIAL_DEMO");
+    head.datasize = sizeof(value);
+    gplat::wire::sendFrame(sv[0], head, &value, sizeof(value));
+    std::vector<char> bytes(gplat::wire::kHeadSize + sizeof(value));
+    ssize_t           n = ::recv(sv[1], bytes.data(), bytes.size(), MSG_WAITALL);
+    bytes.resize(n > 0 ? n : 0);
+    ::close(sv[0]);
+    ::close(sv[1]);
+    return bytes;
+}
+
+void sendBytes(int fd, const char *p, std::size_t n)
+{
+    ::send(fd, p, n, MSG_NOSIGNAL);
+}
+
+void sleepMs(int ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+double msSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+int main()
+{
+    std::vector<char> post  = frameBytes(POST, 42);
+    std::vector<char> other = frameBytes(SUCCEED, 1);
+    if (post.size() <= static_cast<std::size_t>(kSplit) || other.empty())
+    {
+        std::printf("组装报文失败\n");
+        return 1;
+    }
+
+    // --- 1）一直等待 ---
+    int sv[2];
+    ::socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    std::thread sender([&]() {
+        sendBytes(sv[0], other.data(), other.size());
+        sleepMs(100);
+        sendBytes(sv[0], post.data(), kSplit);
+        sleepMs(100);
+        sendBytes(sv[0], post.data() + kSplit, post.size() - kSplit);
+    });
+    gplat::PostReceiver receiver;
+    gplat::PostView     ev;
+    unsigned int        error = 0;
+    auto                t0    = Clock::now();
+    int                 n     = gplat::waitpostdata_multi(sv[1], receiver, &ev, 1, -1, &error);
+    double              ms    = msSince(t0);
+    sender.join();
+    bool forever = n == 1 && ev.as<int>() == 42;
+    std::printf("一直等待：返回 %d，error = %u，%.1f ms，%s\n", n, error, ms, forever ? "取到推送" : "提前返回");
+    ::close(sv[0]);
+    ::close(sv[1]);
+
+    // --- 2）等待 300 ms，只到半个报文 ---
+    ::socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    sender = std::thread([&]() {
+        sleepMs(50);
+        sendBytes(sv[0], post.data(), kSplit);
+    });
+    gplat::PostReceiver receiver2;
+    t0 = Clock::now();
+    n  = gplat::waitpostdata_multi(sv[1], receiver2, &ev, 1, 300, &error);
+    ms = msSince(t0);
+    sender.join();
+    bool timeout = n == 0 && error == ETIMEDOUT && ms >= 290;
+    std::printf("等待 300 ms：返回 %d，error = %u，%.1f ms，%s\n", n, error, ms, timeout ? "按时超时" : "异常");
+
+    sendBytes(sv[0], post.data() + kSplit, post.size() - kSplit);
+    sleepMs(20);
+    n           = gplat::waitpostdata_multi(sv[1], receiver2, &ev, 1, 0, &error);
+    bool resume = n == 1 && ev.as<int>() == 42;
+    std::printf("其余部分到达后：返回 %d，%s\n", n, resume ? "拼出完整推送" : "异常");
+    ::close(sv[0]);
+    ::close(sv[1]);
+
+    bool ok = forever && timeout && resume;
+    std::printf("%s\n\nMain thread exit\n", ok ? "一致" : "不一致");
+    return ok ? 0 : 1;
+}